@@ -0,0 +1,147 @@
+# Copyright (c) 2024 The gem5 contributors
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import argparse
+
+import m5
+from m5.objects import *
+from m5.util import addToPath, fatal
+
+addToPath("../")
+
+from common import ObjectList
+
+# this script evaluates a tiered memory made of local DRAM and a CXL
+# memory expander. A traffic generator hammers a hot region that starts
+# out in the expander, and the page migrator is expected to move it to
+# the local DRAM over a few epochs. Without tiering the expander adds
+# bandwidth but the hot region keeps paying for the link.
+
+parser = argparse.ArgumentParser()
+
+parser.add_argument(
+    "--mem-type",
+    default="DDR4_2400_8x8",
+    choices=ObjectList.mem_list.get_names(),
+    help="type of memory to use for both tiers",
+)
+parser.add_argument(
+    "--near-size", default="64MB", help="size of the local DRAM"
+)
+parser.add_argument(
+    "--far-size", default="192MB", help="size of the CXL expander"
+)
+parser.add_argument(
+    "--hot-size",
+    default="8MB",
+    help="size of the hot region, at the top of the expander",
+)
+parser.add_argument(
+    "--link-latency", default="35ns", help="one-way CXL link latency"
+)
+parser.add_argument(
+    "--link-bandwidth",
+    default="32GB/s",
+    help="CXL link bandwidth in each direction",
+)
+parser.add_argument(
+    "--epoch", default="20us", help="interval between migration decisions"
+)
+parser.add_argument(
+    "--no-tiering",
+    action="store_true",
+    help="connect the traffic generator without a page migrator",
+)
+parser.add_argument(
+    "--rd-perc", type=int, default=100, help="percentage of read commands"
+)
+parser.add_argument(
+    "--duration", default="1ms", help="simulated time to generate traffic"
+)
+
+args = parser.parse_args()
+
+system = System(membus=IOXBar(width=32))
+system.clk_domain = SrcClockDomain(
+    clock="2.0GHz", voltage_domain=VoltageDomain(voltage="1V")
+)
+
+near_range = AddrRange(0, size=args.near_size)
+far_range = AddrRange(int(near_range.end), size=args.far_size)
+system.mem_ranges = [near_range, far_range]
+system.mmap_using_noreserve = True
+
+mem_class = ObjectList.mem_list.get(args.mem_type)
+if not issubclass(mem_class, DRAMInterface):
+    fatal("This script assumes the memory is a DRAMInterface subclass")
+
+system.near_ctrl = MemCtrl(dram=mem_class(range=near_range))
+system.far_ctrl = CXLMemCtrl(
+    dram=mem_class(range=far_range),
+    link_latency=args.link_latency,
+    link_bandwidth=args.link_bandwidth,
+)
+system.near_ctrl.port = system.membus.mem_side_ports
+system.far_ctrl.port = system.membus.mem_side_ports
+
+system.tgen = PyTrafficGen()
+
+if args.no_tiering:
+    system.tgen.port = system.membus.cpu_side_ports
+else:
+    system.migrator = PageMigrator(
+        range=AddrRange(0, size=int(far_range.end)),
+        near_range=near_range,
+        far_range=far_range,
+        epoch=args.epoch,
+    )
+    system.tgen.port = system.migrator.cpu_side_port
+    system.migrator.mem_side_port = system.membus.cpu_side_ports
+
+system.system_port = system.membus.cpu_side_ports
+
+root = Root(full_system=False, system=system)
+root.system.mem_mode = "timing"
+
+m5.instantiate()
+
+duration = m5.ticks.fromSeconds(m5.util.convert.anyToLatency(args.duration))
+far_end = int(far_range.end)
+hot_start = far_end - m5.util.convert.toMemorySize(args.hot_size)
+
+
+def trace():
+    # issue a request every 2ns, around the bandwidth of a single tier
+    yield system.tgen.createRandom(
+        duration, hot_start, far_end, 64, 2000, 2000, args.rd_perc, 0
+    )
+    yield system.tgen.createExit(0)
+
+
+system.tgen.start(trace())
+
+m5.simulate()
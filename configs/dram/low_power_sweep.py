@@ -104,6 +104,18 @@ parser.add_argument(
     help="time in ps of an idle period at the end ",
 )
 
+parser.add_argument(
+    "--disable-powerdown",
+    action="store_true",
+    help="Do not use the DRAM low power states",
+)
+
+parser.add_argument(
+    "--lazy-refresh",
+    action="store_true",
+    help="Account for the refreshes of idle ranks when next needed",
+)
+
 args = parser.parse_args()
 
 # Start with the system itself, using a multi-layer 2.0 GHz
@@ -140,7 +152,8 @@ if not isinstance(system.mem_ctrls[0].dram, m5.objects.DRAMInterface):
 system.mem_ctrls[0].dram.null = True
 
 # enable DRAM low power states
-system.mem_ctrls[0].dram.enable_dram_powerdown = True
+system.mem_ctrls[0].dram.enable_dram_powerdown = not args.disable_powerdown
+system.mem_ctrls[0].dram.lazy_refresh = args.lazy_refresh
 
 # Set the address mapping based on input argument
 system.mem_ctrls[0].dram.addr_mapping = args.addr_map
@@ -86,6 +86,20 @@ parser.add_argument(
                           DRAM_ROTATE: Traffic rotating across banks and ranks",
 )
 
+parser.add_argument(
+    "--queue-size",
+    type=int,
+    default=None,
+    help="Size of the controller read and write queues (entries), "
+    "large queues stress the scheduler",
+)
+
+parser.add_argument(
+    "--check-scheduler",
+    action="store_true",
+    help="Check every FR-FCFS decision against a scan of the queue",
+)
+
 parser.add_argument(
     "--addr-map",
     choices=ObjectList.dram_addr_map_list.get_names(),
@@ -134,6 +148,12 @@ system.mem_ctrls[0].dram.null = True
 # Set the address mapping based on input argument
 system.mem_ctrls[0].dram.addr_mapping = args.addr_map
 
+if args.queue_size:
+    system.mem_ctrls[0].dram.read_buffer_size = args.queue_size
+    system.mem_ctrls[0].dram.write_buffer_size = args.queue_size
+
+system.mem_ctrls[0].dram.check_frfcfs = args.check_scheduler
+
 # stay in each state for 0.25 ms, long enough to warm things up, and
 # short enough to avoid hitting a refresh
 period = 250000000
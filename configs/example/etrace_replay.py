@@ -33,10 +33,12 @@
 # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
-# Basic elastic traces replay script that configures a Trace CPU
+# Basic elastic traces replay script that configures one Trace CPU per pair
+# of instruction and data traces
 
 import argparse
 
+import m5
 from m5.util import addToPath, fatal
 
 addToPath("../")
@@ -49,6 +51,24 @@ from common.Caches import *
 
 parser = argparse.ArgumentParser()
 Options.addCommonOptions(parser)
+parser.add_argument(
+    "--parallel-cpus",
+    action="store_true",
+    help="""Replay each Trace CPU and its private caches on its own
+                      event queue. The shared part of the memory system stays
+                      on event queue 0 and is reached through a ThreadBridge
+                      per CPU.""",
+)
+parser.add_argument(
+    "--bridge-delay",
+    action="store",
+    type=str,
+    default="1ns",
+    help="""Latency added in each direction by the bridges between
+                      the private caches and the shared memory system with
+                      --parallel-cpus. It is the lookahead of the parallel
+                      simulation and bounds the simulation quantum.""",
+)
 
 if "--ruby" in sys.argv:
     print(
@@ -67,8 +87,25 @@ if args.cpu_type != "TraceCPU":
         "--cpu-type=TraceCPU\n"
     )
 
-if args.num_cpus > 1:
-    fatal("This script does not support multi-processor trace replay.\n")
+# With multiple Trace CPUs the trace files are given as comma-separated
+# lists with one entry per CPU.
+inst_trace_files = args.inst_trace_file.split(",")
+data_trace_files = args.data_trace_file.split(",")
+if len(inst_trace_files) != args.num_cpus:
+    fatal(
+        "Expected %d instruction trace files, got %d.\n"
+        % (args.num_cpus, len(inst_trace_files))
+    )
+if len(data_trace_files) != args.num_cpus:
+    fatal(
+        "Expected %d data trace files, got %d.\n"
+        % (args.num_cpus, len(data_trace_files))
+    )
+
+if args.parallel_cpus and not args.caches:
+    fatal("--parallel-cpus requires private caches, use --caches.\n")
+if args.parallel_cpus and args.memchecker:
+    fatal("--parallel-cpus does not support --memchecker.\n")
 
 # In this case FutureClass will be None as there is not fast forwarding or
 # switching
@@ -76,7 +113,7 @@ if args.num_cpus > 1:
 CPUClass.numThreads = numThreads
 
 system = System(
-    cpu=CPUClass(cpu_id=0),
+    cpu=[CPUClass(cpu_id=i) for i in range(args.num_cpus)],
     mem_mode=test_mem_mode,
     mem_ranges=[AddrRange(args.mem_size)],
     cache_line_size=args.cacheline_size,
@@ -110,16 +147,82 @@ for cpu in system.cpu:
 for cpu in system.cpu:
     cpu.createThreads()
 
-# Assign input trace files to the Trace CPU
-system.cpu.instTraceFile = args.inst_trace_file
-system.cpu.dataTraceFile = args.data_trace_file
+# Assign input trace files to the Trace CPUs
+for cpu, inst_trace_file, data_trace_file in zip(
+    system.cpu, inst_trace_files, data_trace_files
+):
+    cpu.instTraceFile = inst_trace_file
+    cpu.dataTraceFile = data_trace_file
+
+
+def config_parallel_cache(args, system):
+    """Give each Trace CPU private L1 caches on its own event queue.
+
+    The L1 caches of a CPU share a crossbar on the CPU's event queue which
+    reaches the shared L2 or the memory bus on event queue 0 through a
+    ThreadBridge. The bridge delays are the only latency crossing between
+    threads, so the simulation quantum must not exceed them.
+    """
+    system.cache_line_size = args.cacheline_size
+
+    if args.l2cache:
+        system.l2 = L2Cache(
+            clk_domain=system.cpu_clk_domain,
+            size=args.l2_size,
+            assoc=args.l2_assoc,
+        )
+        system.tol2bus = L2XBar(clk_domain=system.cpu_clk_domain)
+        system.l2.cpu_side = system.tol2bus.mem_side_ports
+        system.l2.mem_side = system.membus.cpu_side_ports
+        shared_ports = system.tol2bus.cpu_side_ports
+    else:
+        shared_ports = system.membus.cpu_side_ports
+
+    for i, cpu in enumerate(system.cpu):
+        cpu.addPrivateSplitL1Caches(
+            L1_ICache(size=args.l1i_size, assoc=args.l1i_assoc),
+            L1_DCache(size=args.l1d_size, assoc=args.l1d_assoc),
+        )
+        cpu.l1bus = L2XBar(clk_domain=system.cpu_clk_domain)
+        cpu.connectCachedPorts(cpu.l1bus.cpu_side_ports)
+
+        # The bridge runs on the queue of the shared side, which is the one
+        # it hands requests over to.
+        cpu.bridge = ThreadBridge(
+            eventq_index=0,
+            request_delay=args.bridge_delay,
+            response_delay=args.bridge_delay,
+        )
+        cpu.l1bus.mem_side_ports = cpu.bridge.in_port
+        cpu.bridge.out_port = shared_ports
+
+        # The interrupt controller is not used by the Trace CPU but is
+        # wired to the memory bus, so keep it on the queue of the bus.
+        cpu.createInterruptController()
+        cpu.connectUncachedPorts(
+            system.membus.cpu_side_ports, system.membus.mem_side_ports
+        )
+        for obj in cpu.interrupts:
+            obj.eventq_index = 0
+
+        # The caches and the private crossbar are children of the CPU and
+        # inherit its event queue.
+        cpu.eventq_index = i + 1
+
 
 # Configure the classic memory system args
 MemClass = Simulation.setMemClass(args)
 system.membus = SystemXBar()
 system.system_port = system.membus.cpu_side_ports
-CacheConfig.config_cache(args, system)
+if args.parallel_cpus:
+    config_parallel_cache(args, system)
+else:
+    CacheConfig.config_cache(args, system)
 MemConfig.config_mem(args, system)
 
 root = Root(full_system=False, system=system)
+if args.parallel_cpus:
+    root.sim_quantum = m5.ticks.fromSeconds(
+        m5.util.convert.anyToLatency(args.bridge_delay)
+    )
 Simulation.run(args, root, system, FutureClass)
@@ -30,6 +30,7 @@ import m5
 from m5.objects import *
 from m5.defines import buildEnv
 from m5.util import addToPath
+from m5.util.convert import toFrequency
 import os, argparse, sys
 
 addToPath("../")
@@ -163,6 +164,8 @@ for ruby_port in system.ruby._cpu_ports:
     # Tie the cpu test ports to the ruby cpu port
     #
     cpus[i].test = ruby_port.in_ports
+    if args.ruby_partitions > 1:
+        cpus[i].eventq_index = ruby_port.get_parent().eventq_index
     i += 1
 
 # -----------------------
@@ -172,6 +175,18 @@ for ruby_port in system.ruby._cpu_ports:
 root = Root(full_system=False, system=system)
 root.system.mem_mode = "timing"
 
+# Partitions only synchronize once per quantum, which must not be longer
+# than the shortest link crossing partitions. Ticks are picoseconds.
+if args.ruby_partitions > 1:
+    lookahead = system.ruby._partition_lookahead
+    if lookahead is not None:
+        root.sim_quantum = int(
+            lookahead * 1e12 / toFrequency(args.ruby_clock)
+        )
+    else:
+        # No link crosses partitions, they never need to synchronize.
+        root.sim_quantum = int(args.abs_max_tick)
+
 # Not much point in this being higher than the L1 latency
 m5.ticks.setGlobalFrequency("1ps")
 
@@ -0,0 +1,119 @@
+# Copyright (c) 2024 The gem5 contributors
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+import m5
+from m5.objects import *
+from m5.util import addToPath
+import argparse
+
+addToPath("../")
+
+from common import Options
+from ruby import Ruby
+
+parser = argparse.ArgumentParser(
+    formatter_class=argparse.ArgumentDefaultsHelpFormatter
+)
+Options.addNoISAOptions(parser)
+
+parser.add_argument(
+    "--acquisitions",
+    type=int,
+    default=1000,
+    help="Stop after a tester acquired a lock N times",
+)
+parser.add_argument(
+    "--num-locks",
+    type=int,
+    default=1,
+    help="Number of locks the testers contend for",
+)
+parser.add_argument(
+    "--critical-section",
+    type=int,
+    default=10,
+    help="Cycles a lock is held for",
+)
+
+#
+# Add the ruby specific and protocol specific options
+#
+Ruby.define_options(parser)
+
+args = parser.parse_args()
+
+#
+# All testers contend for a handful of cache lines, which makes the
+# coherence controllers stall and wake up many requests to the same line.
+#
+cpus = [
+    LockTest(
+        num_locks=args.num_locks,
+        critical_section=args.critical_section,
+        max_acquisitions=args.acquisitions,
+    )
+    for i in range(args.num_cpus)
+]
+
+system = System(
+    cpu=cpus,
+    clk_domain=SrcClockDomain(clock=args.sys_clock),
+    mem_ranges=[AddrRange(args.mem_size)],
+)
+
+Ruby.create_system(args, False, system)
+
+# Create a top-level voltage domain and clock domain
+system.voltage_domain = VoltageDomain(voltage=args.sys_voltage)
+system.clk_domain = SrcClockDomain(
+    clock=args.sys_clock, voltage_domain=system.voltage_domain
+)
+# Create a seperate clock domain for Ruby
+system.ruby.clk_domain = SrcClockDomain(
+    clock=args.ruby_clock, voltage_domain=system.voltage_domain
+)
+
+assert len(cpus) == len(system.ruby._cpu_ports)
+
+for (i, cpu) in enumerate(cpus):
+    cpu.port = system.ruby._cpu_ports[i].in_ports
+
+# -----------------------
+# run simulation
+# -----------------------
+
+root = Root(full_system=False, system=system)
+root.system.mem_mode = "timing"
+
+m5.ticks.setGlobalFrequency("1ns")
+
+# instantiate configuration
+m5.instantiate()
+
+# simulate until program terminates
+exit_event = m5.simulate(args.abs_max_tick)
+
+print("Exiting @ tick", m5.curTick(), "because", exit_event.getCause())
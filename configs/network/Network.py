@@ -50,8 +50,9 @@ def define_options(parser):
     parser.add_argument(
         "--network",
         default="simple",
-        choices=["simple", "garnet"],
-        help="""'simple'|'garnet' (garnet2.0 will be deprecated.)""",
+        choices=["simple", "garnet", "analytical"],
+        help="""'simple'|'garnet'|'analytical' (garnet2.0 will be
+            deprecated.)""",
     )
     parser.add_argument(
         "--router-latency",
@@ -111,6 +112,39 @@ def define_options(parser):
         default=50000,
         help="network-level deadlock threshold.",
     )
+    parser.add_argument(
+        "--garnet-no-idle-sleep",
+        action="store_false",
+        dest="garnet_idle_sleep",
+        help="""poll garnet routers, NIs and links with stalled traffic
+            every cycle instead of letting them sleep.""",
+    )
+    parser.add_argument(
+        "--ruby-partitions",
+        action="store",
+        type=int,
+        default=1,
+        help="""number of event queues (host threads) the routers of a
+            garnet network and the controllers attached to them are
+            spread over. Links crossing partitions must be at least as
+            long as the simulation quantum.""",
+    )
+    parser.add_argument(
+        "--analytical-window",
+        action="store",
+        type=int,
+        default=1000,
+        help="""cycles over which the analytical network samples link
+            utilization to estimate contention.""",
+    )
+    parser.add_argument(
+        "--analytical-smoothing",
+        action="store",
+        type=float,
+        default=0.5,
+        help="""weight of the last sampling window in the smoothed link
+            utilization of the analytical network.""",
+    )
     parser.add_argument(
         "--simple-physical-channels",
         action="store_true",
@@ -140,6 +174,13 @@ def create_network(options, ruby):
         RouterClass = GarnetRouter
         InterfaceClass = GarnetNetworkInterface
 
+    elif options.network == "analytical":
+        NetworkClass = AnalyticalNetwork
+        IntLinkClass = BasicIntLink
+        ExtLinkClass = BasicExtLink
+        RouterClass = BasicRouter
+        InterfaceClass = None
+
     else:
         NetworkClass = SimpleNetwork
         IntLinkClass = SimpleIntLink
@@ -169,6 +210,7 @@ def init_network(options, network, InterfaceClass):
         network.ni_flit_size = options.link_width_bits / 8
         network.routing_algorithm = options.routing_algorithm
         network.garnet_deadlock_threshold = options.garnet_deadlock_threshold
+        network.idle_sleep = options.garnet_idle_sleep
 
         # Create Bridges and connect them to the corresponding links
         for intLink in network.int_links:
@@ -262,6 +304,10 @@ def init_network(options, network, InterfaceClass):
             )
             extLink.int_cred_bridge = int_cred_bridges
 
+    if options.network == "analytical":
+        network.utilization_window = options.analytical_window
+        network.utilization_smoothing = options.analytical_smoothing
+
     if options.network == "simple":
         if options.simple_physical_channels:
             network.physical_vnets_channels = [1] * int(
@@ -279,3 +325,62 @@ def init_network(options, network, InterfaceClass):
         assert options.network == "garnet"
         network.enable_fault_model = True
         network.fault_model = FaultModel()
+
+
+def partition_network(options, network):
+    """Spread the routers of a garnet network, along with the controllers,
+    network interfaces and links attached to them, over
+    options.ruby_partitions event queues. Routers are assigned in
+    contiguous blocks of router ids so that most links stay within a
+    partition (e.g., rows of a mesh are kept together).
+
+    Every link runs in the partition of the node it reads flits (or
+    credits) from. Its latency is the lookahead towards the partition of
+    the node it feeds. Returns the smallest latency, in cycles, of a link
+    crossing partitions; the simulation quantum must not exceed it.
+    """
+
+    if options.network != "garnet":
+        fatal("Ruby partitioning is only supported by the garnet network")
+
+    num_parts = options.ruby_partitions
+    routers = network.routers
+    part = {
+        r.router_id: r.router_id * num_parts // len(routers) for r in routers
+    }
+
+    for router in routers:
+        router.eventq_index = part[router.router_id]
+
+    lookahead = None
+    for intLink in network.int_links:
+        src = part[intLink.src_node.router_id]
+        dst = part[intLink.dst_node.router_id]
+        intLink.eventq_index = src
+        intLink.credit_link.eventq_index = dst
+        if src == dst:
+            continue
+
+        if (
+            intLink.src_cdc
+            or intLink.dst_cdc
+            or intLink.src_serdes
+            or intLink.dst_serdes
+        ):
+            fatal(
+                "Link %s crosses Ruby partitions and cannot use CDC or "
+                "SerDes units" % intLink.link_id
+            )
+        latency = int(intLink.latency)
+        if lookahead is None or latency < lookahead:
+            lookahead = latency
+
+    # Controllers and their network interfaces run with the router they
+    # are attached to, so external links never cross partitions.
+    for (i, extLink) in enumerate(network.ext_links):
+        p = part[extLink.int_node.router_id]
+        extLink.eventq_index = p
+        extLink.ext_node.eventq_index = p
+        network.netifs[i].eventq_index = p
+
+    return lookahead
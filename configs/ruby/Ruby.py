@@ -157,6 +157,8 @@ def setup_memory_controllers(system, ruby, dir_cntrls, options):
         if len(system.mem_ranges) > 1:
             crossbar = IOXBar()
             crossbars.append(crossbar)
+            if options.ruby_partitions > 1:
+                crossbar.eventq_index = dir_cntrl.eventq_index
             dir_cntrl.memory_out_port = crossbar.cpu_side_ports
 
         dir_ranges = []
@@ -186,6 +188,11 @@ def setup_memory_controllers(system, ruby, dir_cntrls, options):
             else:
                 mem_ctrl.port = dir_cntrl.memory_out_port
 
+            # Memory is accessed in timing mode by the directory, so it
+            # has to live in the same partition.
+            if options.ruby_partitions > 1:
+                mem_ctrl.eventq_index = dir_cntrl.eventq_index
+
             # Enable low-power DRAM states if option is set
             if issubclass(mem_type, DRAMInterface):
                 mem_ctrl.dram.enable_dram_powerdown = (
@@ -265,6 +272,14 @@ def create_system(
     # Initialize network based on topology
     Network.init_network(options, network, InterfaceClass)
 
+    # Spread controllers and routers over several event queues. The
+    # lookahead (in Ruby cycles) is kept so that scripts can derive the
+    # simulation quantum from it.
+    if options.ruby_partitions > 1:
+        ruby._partition_lookahead = Network.partition_network(
+            options, network
+        )
+
     # Create a port proxy for connecting the system port. This is
     # independent of the protocol and kept in the protocol-agnostic
     # part (i.e. here).
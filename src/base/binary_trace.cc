@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "base/binary_trace.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+
+namespace gem5
+{
+
+namespace trace
+{
+
+namespace
+{
+
+std::atomic<BinaryLogger *> binaryLogger(nullptr);
+
+} // anonymous namespace
+
+BinaryLogger::BinaryLogger(std::ostream &stream, size_t buffer_size)
+    : Recorder(buffer_size, true), stream(stream), lineBuf(*this),
+      lineStream(&lineBuf)
+{
+    recorder = this;
+
+    std::vector<uint8_t> header;
+    appendHeader(header);
+    stream.write(reinterpret_cast<const char *>(header.data()),
+                 header.size());
+
+    writer = std::thread([this]() { run(); });
+
+    static bool registered = false;
+    if (!registered) {
+        // Covers normal exits, exit events and fatal().
+        std::atexit([]() { flushBinaryTrace(); });
+        registered = true;
+    }
+    binaryLogger = this;
+}
+
+BinaryLogger::~BinaryLogger()
+{
+    BinaryLogger *self = this;
+    binaryLogger.compare_exchange_strong(self, nullptr);
+
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    writer.join();
+    flush();
+}
+
+void
+BinaryLogger::logMessage(Tick when, const std::string &name,
+        const std::string &flag, const std::string &message)
+{
+    if (!isEnabled(name))
+        return;
+    recordText(when, name, flag, message);
+}
+
+void
+BinaryLogger::committed(RecordBuffer &buffer)
+{
+    // Don't let the producer wait for the next poll of the writer.
+    if (buffer.used() > buffer.capacity() / 2)
+        wake.notify_one();
+}
+
+void
+BinaryLogger::run()
+{
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    while (!stopping) {
+        lock.unlock();
+        const bool wrote = writeBlocks();
+        lock.lock();
+        if (!wrote && !stopping)
+            wake.wait_for(lock, std::chrono::milliseconds(1));
+    }
+}
+
+bool
+BinaryLogger::writeBlocks(bool wait)
+{
+    std::vector<RecordBuffer *> current;
+    {
+        std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+        if (wait)
+            lock.lock();
+        else if (!lock.try_lock())
+            return false;
+        for (auto &buffer : buffers)
+            current.push_back(buffer.get());
+    }
+
+    std::unique_lock<std::mutex> lock(writeMutex, std::defer_lock);
+    if (wait)
+        lock.lock();
+    else if (!lock.try_lock())
+        return false;
+    bool wrote = false;
+    for (uint32_t thread = 0; thread < current.size(); ++thread) {
+        block.resize(2 * sizeof(uint32_t));
+        const uint32_t size = current[thread]->drain(block);
+        if (!size)
+            continue;
+        std::memcpy(block.data(), &thread, sizeof(thread));
+        std::memcpy(block.data() + sizeof(thread), &size, sizeof(size));
+        stream.write(reinterpret_cast<const char *>(block.data()),
+                     block.size());
+        wrote = true;
+    }
+    return wrote;
+}
+
+void
+BinaryLogger::flush(bool wait)
+{
+    writeBlocks(wait);
+    std::unique_lock<std::mutex> lock(writeMutex, std::defer_lock);
+    if (wait)
+        lock.lock();
+    else if (!lock.try_lock())
+        return;
+    stream.flush();
+}
+
+void
+flushBinaryTrace(bool wait)
+{
+    if (BinaryLogger *logger = binaryLogger)
+        logger->flush(wait);
+}
+
+} // namespace trace
+} // namespace gem5
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __BASE_BINARY_TRACE_HH__
+#define __BASE_BINARY_TRACE_HH__
+
+#include <condition_variable>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "base/trace.hh"
+#include "base/trace_record.hh"
+
+namespace gem5
+{
+
+namespace trace
+{
+
+/**
+ * Debug logger that writes a binary trace (see trace_record.hh).
+ * Messages are recorded in per-thread buffers which a background
+ * thread writes to the output stream, so the simulation threads
+ * neither format messages nor wait for I/O. FmtStackTrace isn't
+ * supported.
+ */
+class BinaryLogger : public Logger, public Recorder
+{
+  private:
+    std::ostream &stream;
+    RecorderStreamBuf lineBuf;
+    std::ostream lineStream;
+
+    /** Serializes writing blocks to the stream */
+    std::mutex writeMutex;
+    std::vector<uint8_t> block;
+
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::thread writer;
+
+    void run();
+    /**
+     * Write the records in all buffers, returns false if empty.
+     *
+     * @param wait Wait for the locks, rather than giving up if another
+     *             thread holds them.
+     */
+    bool writeBlocks(bool wait=true);
+
+  protected:
+    void committed(RecordBuffer &buffer) override;
+
+  public:
+    /**
+     * @param stream Binary stream to write the trace to.
+     * @param buffer_size Size of the per-thread buffers.
+     */
+    BinaryLogger(std::ostream &stream, size_t buffer_size = 4 << 20);
+    ~BinaryLogger();
+
+    void logMessage(Tick when, const std::string &name,
+            const std::string &flag, const std::string &message) override;
+
+    std::ostream &getOstream() override { return lineStream; }
+
+    /**
+     * Write all recorded messages to the stream.
+     *
+     * @param wait Wait for other threads writing to the stream. Crash
+     *             handlers don't, as the thread may have crashed with
+     *             the lock held.
+     */
+    void flush(bool wait=true);
+};
+
+/**
+ * Flush the binary trace, if there is one. Called on exit and by the
+ * handlers of fatal signals, which includes panics and failed
+ * assertions.
+ *
+ * @param wait See BinaryLogger::flush().
+ */
+void flushBinaryTrace(bool wait=true);
+
+} // namespace trace
+} // namespace gem5
+
+#endif // __BASE_BINARY_TRACE_HH__
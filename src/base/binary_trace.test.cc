@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "base/binary_trace.hh"
+#include "base/gtest/cur_tick_fake.hh"
+#include "base/trace.hh"
+#include "base/trace_reader.hh"
+
+using namespace gem5;
+
+GTestTickHandler tickHandler;
+
+namespace
+{
+
+/** A type that must be formatted when it is logged */
+struct Opaque
+{
+    int value;
+};
+
+std::ostream &
+operator<<(std::ostream &os, const Opaque &opaque)
+{
+    return os << "opaque(" << opaque.value << ")";
+}
+
+/** Log the same messages to any kind of logger. */
+void
+logMessages(trace::Logger &logger)
+{
+    const std::string str("a string");
+    int object;
+
+    logger.dprintf_flag(10, "system.cpu", "Flag", "int %d uint %#x\n",
+                        -42, 42u);
+    logger.dprintf_flag(11, "system.cpu", "Flag", "%c%c %3d\n",
+                        'o', (unsigned char)'k', (uint8_t)7);
+    logger.dprintf_flag(12, "system.mem", "Other", "%s, %s, %10.3f\n",
+                        str, "a literal", 3.14159);
+    logger.dprintf_flag(13, "system.mem", "Other", "%4d|%6s|\n",
+                        12, "left");
+    logger.dprintf_flag(14, "system.mem", "Other", "%d %s\n",
+                        true, Opaque{7});
+    logger.dprintf_flag(15, "system.mem", "Other", "%p\n", &object);
+    logger.dprintf_flag(MaxTick, "", "Raw", "raw %llu\n",
+                        0xffffffffffffull);
+    logger.dprintf_flag(16, "system.mem", "", "extra %d\n", 1, 2);
+    logger.logMessage(17, "system.cpu", "Dump", "preformatted\n");
+    logger.getOstream() << "line " << 1 << "\nline 2\n";
+}
+
+} // anonymous namespace
+
+/** Decoded binary traces match the text logger's output. */
+TEST(BinaryTraceTest, MatchesTextOutput)
+{
+    std::stringstream text;
+    trace::OstreamLogger text_logger(text);
+    logMessages(text_logger);
+
+    std::stringstream bin;
+    {
+        trace::BinaryLogger logger(bin);
+        logMessages(logger);
+    }
+
+    std::stringstream decoded;
+    trace::TraceReader reader(bin);
+    ASSERT_TRUE(reader.readHeader()) << reader.error();
+    ASSERT_TRUE(reader.render(decoded)) << reader.error();
+    EXPECT_EQ(text.str(), decoded.str());
+}
+
+/** Flushing the trace writes all messages logged so far. */
+TEST(BinaryTraceTest, Flush)
+{
+    std::stringstream text;
+    trace::OstreamLogger text_logger(text);
+    logMessages(text_logger);
+
+    for (bool wait : { true, false }) {
+        std::stringstream bin;
+        trace::BinaryLogger logger(bin);
+        logMessages(logger);
+        trace::flushBinaryTrace(wait);
+
+        std::stringstream decoded;
+        trace::TraceReader reader(bin);
+        ASSERT_TRUE(reader.readHeader()) << reader.error();
+        ASSERT_TRUE(reader.render(decoded)) << reader.error();
+        EXPECT_EQ(text.str(), decoded.str());
+    }
+}
+
+/** The trace is flushed when the process exits. */
+TEST(BinaryTraceTest, FlushOnExit)
+{
+    char path[] = "/tmp/binary_trace.test.XXXXXX";
+    const int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    close(fd);
+
+    EXPECT_EXIT({
+        // Neither the logger nor the stream are ever destroyed.
+        auto *file = new std::ofstream(path, std::ios::binary);
+        auto *logger = new trace::BinaryLogger(*file);
+        logMessages(*logger);
+        std::exit(0);
+    }, ::testing::ExitedWithCode(0), "");
+
+    std::stringstream text;
+    trace::OstreamLogger text_logger(text);
+    logMessages(text_logger);
+
+    std::ifstream bin(path, std::ios::binary);
+    std::stringstream decoded;
+    trace::TraceReader reader(bin);
+    ASSERT_TRUE(reader.readHeader()) << reader.error();
+    ASSERT_TRUE(reader.render(decoded)) << reader.error();
+    EXPECT_EQ(text.str(), decoded.str());
+    std::remove(path);
+}
+
+/** Messages can be selected by tick and flag. */
+TEST(BinaryTraceTest, Filter)
+{
+    std::stringstream bin;
+    {
+        trace::BinaryLogger logger(bin);
+        logMessages(logger);
+    }
+
+    trace::TraceFilter filter;
+    filter.start = 12;
+    filter.end = 14;
+    filter.flags = { "Other" };
+
+    std::stringstream decoded;
+    trace::TraceReader reader(bin);
+    ASSERT_TRUE(reader.readHeader());
+    ASSERT_TRUE(reader.render(decoded, filter));
+    EXPECT_EQ("     12: system.mem: a string, a literal,      3.142\n"
+              "     13: system.mem:   12|  left|\n"
+              "     14: system.mem: 1 opaque(7)\n",
+              decoded.str());
+}
+
+/** Files that aren't binary traces are rejected. */
+TEST(BinaryTraceTest, BadHeader)
+{
+    std::stringstream bin("this is not a trace");
+    trace::TraceReader reader(bin);
+    EXPECT_FALSE(reader.readHeader());
+    EXPECT_FALSE(reader.error().empty());
+}
+
+/** Buffers that aren't lossless keep the most recent records. */
+TEST(BinaryTraceTest, OverwriteOldest)
+{
+    trace::RecordBuffer buffer(4096, false);
+    std::vector<uint8_t> record(1000);
+    for (uint32_t i = 0; i < 10; ++i) {
+        const uint32_t size = record.size();
+        std::memcpy(record.data(), &size, sizeof(size));
+        record[sizeof(size)] = i;
+        ASSERT_TRUE(buffer.push(record.data(), record.size()));
+    }
+
+    std::vector<uint8_t> contents;
+    buffer.snapshot(contents);
+    ASSERT_EQ(4000, contents.size());
+    for (uint32_t i = 0; i < 4; ++i)
+        EXPECT_EQ(6 + i, contents[i * 1000 + sizeof(uint32_t)]);
+
+    // Records larger than half the buffer are dropped.
+    std::vector<uint8_t> large(3000);
+    EXPECT_FALSE(buffer.push(large.data(), large.size()));
+}
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "base/flight_recorder.hh"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#include "base/atomicio.hh"
+
+namespace gem5
+{
+
+namespace trace
+{
+
+namespace
+{
+
+std::atomic<FlightRecorder *> flightRecorder(nullptr);
+
+/** Buffers small writes to a file without allocating memory. */
+class FdWriter
+{
+  private:
+    const int fd;
+    uint8_t buf[4096];
+    size_t used = 0;
+    bool ok = true;
+
+  public:
+    FdWriter(int fd) : fd(fd) {}
+
+    void
+    flush()
+    {
+        if (used && atomic_write(fd, buf, used) != (ssize_t)used)
+            ok = false;
+        used = 0;
+    }
+
+    void
+    write(const void *data, size_t size)
+    {
+        if (used + size > sizeof(buf)) {
+            flush();
+            if (size > sizeof(buf)) {
+                if (atomic_write(fd, data, size) != (ssize_t)size)
+                    ok = false;
+                return;
+            }
+        }
+        std::memcpy(buf + used, data, size);
+        used += size;
+    }
+
+    template <typename T>
+    void write(const T &value) { write(&value, sizeof(value)); }
+
+    bool good() const { return ok; }
+};
+
+} // anonymous namespace
+
+FlightRecorder::FlightRecorder(const std::string &path, size_t buffer_size)
+    : Recorder(buffer_size, false), path(path), lineBuf(*this),
+      lineStream(&lineBuf), dumped(false)
+{
+    recorder = this;
+
+    static bool registered = false;
+    if (!registered) {
+        // Covers normal exits, exit events and fatal().
+        std::atexit([]() { dumpFlightRecorder(); });
+        registered = true;
+    }
+    flightRecorder = this;
+}
+
+FlightRecorder::~FlightRecorder()
+{
+    FlightRecorder *self = this;
+    flightRecorder.compare_exchange_strong(self, nullptr);
+}
+
+void
+FlightRecorder::logMessage(Tick when, const std::string &name,
+        const std::string &flag, const std::string &message)
+{
+    if (!isEnabled(name))
+        return;
+    recordText(when, name, flag, message);
+}
+
+bool
+FlightRecorder::dump()
+{
+    if (dumped.exchange(true))
+        return false;
+
+    const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+
+    FdWriter out(fd);
+    out.write(binary::FileHeader());
+
+    // Don't wait for a thread that crashed with the lock held.
+    std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+
+    // The records that defined the strings may have been dropped.
+    uint32_t strings_size = 0;
+    for (const auto &str : strings)
+        strings_size += sizeof(uint32_t) + 1 + sizeof(uint32_t) + str.size();
+    out.write<uint32_t>(~0U);
+    out.write(strings_size);
+    for (uint32_t id = 0; id < strings.size(); ++id) {
+        out.write<uint32_t>(sizeof(uint32_t) + 1 + sizeof(uint32_t) +
+                            strings[id].size());
+        out.write<uint8_t>(binary::String);
+        out.write(id);
+        out.write(strings[id].data(), strings[id].size());
+    }
+
+    for (uint32_t thread = 0; thread < buffers.size(); ++thread) {
+        const auto spans = buffers[thread]->spans();
+        const uint32_t size = spans[0].size + spans[1].size;
+        if (!size)
+            continue;
+        out.write(thread);
+        out.write(size);
+        for (const auto &span : spans)
+            out.write(span.data, span.size);
+    }
+
+    out.flush();
+    close(fd);
+    return out.good();
+}
+
+const char *
+dumpFlightRecorder()
+{
+    FlightRecorder *recorder = flightRecorder;
+    if (recorder && recorder->dump())
+        return recorder->dumpPath().c_str();
+    return nullptr;
+}
+
+} // namespace trace
+} // namespace gem5
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __BASE_FLIGHT_RECORDER_HH__
+#define __BASE_FLIGHT_RECORDER_HH__
+
+#include <atomic>
+#include <ostream>
+#include <string>
+
+#include "base/trace.hh"
+#include "base/trace_record.hh"
+
+namespace gem5
+{
+
+namespace trace
+{
+
+/**
+ * Debug logger that keeps the most recent messages of every thread in
+ * memory, in binary form, and writes them to a binary trace (see
+ * trace_record.hh) when the simulator exits or crashes. Since old
+ * records are dropped, the dump starts with a block that defines all
+ * strings.
+ */
+class FlightRecorder : public Logger, public Recorder
+{
+  private:
+    const std::string path;
+    RecorderStreamBuf lineBuf;
+    std::ostream lineStream;
+    std::atomic<bool> dumped;
+
+  public:
+    /**
+     * @param path File to dump the messages to.
+     * @param buffer_size Size of the per-thread buffers.
+     */
+    FlightRecorder(const std::string &path, size_t buffer_size);
+    ~FlightRecorder();
+
+    void logMessage(Tick when, const std::string &name,
+            const std::string &flag, const std::string &message) override;
+
+    std::ostream &getOstream() override { return lineStream; }
+
+    const std::string &dumpPath() const { return path; }
+
+    /**
+     * Write the messages in the buffers to the dump file, unless they
+     * were dumped already. This doesn't allocate memory or wait for
+     * other threads, so it is safe to call from signal handlers.
+     *
+     * @return true if the file was written.
+     */
+    bool dump();
+};
+
+/**
+ * Dump the flight recorder, if there is one. Called on exit and by
+ * the handlers of fatal signals, which includes panics and failed
+ * assertions.
+ *
+ * @return Path of the dump, or nullptr if nothing was written.
+ */
+const char *dumpFlightRecorder();
+
+} // namespace trace
+} // namespace gem5
+
+#endif // __BASE_FLIGHT_RECORDER_HH__
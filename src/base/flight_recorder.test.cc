@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "base/flight_recorder.hh"
+#include "base/gtest/cur_tick_fake.hh"
+#include "base/trace_reader.hh"
+
+using namespace gem5;
+
+GTestTickHandler tickHandler;
+
+namespace
+{
+
+std::string
+tempPath()
+{
+    char path[] = "/tmp/flight_recorder.test.XXXXXX";
+    const int fd = mkstemp(path);
+    close(fd);
+    return path;
+}
+
+std::string
+decode(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    trace::TraceReader reader(in);
+    std::ostringstream out;
+    EXPECT_TRUE(reader.readHeader()) << reader.error();
+    EXPECT_TRUE(reader.render(out)) << reader.error();
+    return out.str();
+}
+
+} // anonymous namespace
+
+/** Only the most recent messages are dumped. */
+TEST(FlightRecorderTest, DumpLastMessages)
+{
+    const std::string path = tempPath();
+    trace::FlightRecorder recorder(path, 4096);
+    for (int i = 0; i < 1000; ++i)
+        recorder.dprintf_flag(i, "system.cpu", "Flag", "message %d\n", i);
+    recorder.logMessage(1000, "system.cpu", "Flag", "last\n");
+
+    ASSERT_STREQ(path.c_str(), trace::dumpFlightRecorder());
+    const std::string text = decode(path);
+    EXPECT_EQ(std::string::npos, text.find("message 0\n"));
+    EXPECT_NE(std::string::npos,
+              text.find("    999: system.cpu: message 999\n"
+                        "   1000: system.cpu: last\n"));
+    EXPECT_LT(std::count(text.begin(), text.end(), '\n'), 200);
+
+    // There is a single dump.
+    EXPECT_EQ(nullptr, trace::dumpFlightRecorder());
+    std::remove(path.c_str());
+}
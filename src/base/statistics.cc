@@ -141,6 +141,29 @@ InfoAccess::newStyleStats() const
     return _info != nullptr;
 }
 
+int SamplingScope::depth = 0;
+uint64_t InfoAccess::changeCount = 0;
+
+void
+InfoAccess::setChanged(bool changed)
+{
+    if (changed)
+        _changeStamp = ++changeCount;
+
+    if (SamplingScope::active()) {
+        // Keep the change for the next dump.
+        _pending = _pending || changed;
+        return;
+    }
+
+    // Several outputs may prepare the same stat in a single dump. Keep
+    // changes seen by the first prepare() visible to the later ones.
+    _changed = changed || _pending ||
+        (_changed && _preparedAt == curTick());
+    _pending = false;
+    _preparedAt = curTick();
+}
+
 Formula::Formula(Group *parent, const char *name, const char *desc)
     : DataWrapVec<Formula, FormulaInfoProxy>(
             parent, name, units::Unspecified::get(), desc)
@@ -169,6 +192,99 @@ Formula::Formula(Group *parent, const char *name, const units::Base *unit,
     *this = r;
 }
 
+void
+Node::compile(FormulaProgram &prog) const
+{
+    prog.pushNode(this);
+}
+
+void
+FormulaProgram::evaluate(VResult &vec) const
+{
+    size_t depth = 0;
+    auto push = [this, &depth]() -> VResult & {
+        if (stack.size() == depth)
+            stack.emplace_back();
+        return stack[depth++];
+    };
+
+    for (const auto &instr : code) {
+        switch (instr.op) {
+          case PushScalar:
+            push().assign(1, instr.scalar->result());
+            break;
+          case PushVector: {
+              const VResult &values = instr.vector->result();
+              push().assign(values.begin(), values.end());
+              break;
+          }
+          case PushConst: {
+              const VResult &values = constants[instr.constant];
+              push().assign(values.begin(), values.end());
+              break;
+          }
+          case PushNode: {
+              const VResult &values = instr.node->result();
+              push().assign(values.begin(), values.end());
+              break;
+          }
+          case Negate: {
+              assert(depth >= 1);
+              for (auto &v : stack[depth - 1])
+                  v = -v;
+              break;
+          }
+          case Sum: {
+              assert(depth >= 1);
+              VResult &l = stack[depth - 1];
+              Result sum = 0.0;
+              for (auto v : l)
+                  sum += v;
+              l.assign(1, sum);
+              break;
+          }
+          default: {
+              // Binary operators, same broadcasting rules as BinaryNode.
+              assert(depth >= 2);
+              VResult &l = stack[depth - 2];
+              const VResult &r = stack[depth - 1];
+              --depth;
+              assert(l.size() > 0 && r.size() > 0);
+              assert(l.size() == r.size() || l.size() == 1 || r.size() == 1);
+
+              if (l.size() == 1 && r.size() > 1) {
+                  const Result lv = l[0];
+                  l.assign(r.size(), lv);
+              }
+
+              const size_t size = l.size();
+              const bool scalar_r = r.size() == 1;
+              auto apply = [&](auto op) {
+                  if (scalar_r) {
+                      const Result rv = r[0];
+                      for (size_t i = 0; i < size; ++i)
+                          l[i] = op(l[i], rv);
+                  } else {
+                      for (size_t i = 0; i < size; ++i)
+                          l[i] = op(l[i], r[i]);
+                  }
+              };
+
+              switch (instr.op) {
+                case Add: apply(std::plus<Result>()); break;
+                case Sub: apply(std::minus<Result>()); break;
+                case Mul: apply(std::multiplies<Result>()); break;
+                case Div: apply(std::divides<Result>()); break;
+                default: panic("Invalid formula opcode %d.\n", instr.op);
+              }
+          }
+        }
+    }
+
+    assert(depth == 1);
+    vec.assign(stack[0].begin(), stack[0].end());
+}
+
 const Formula &
 Formula::operator=(const Temp &r)
 {
@@ -182,6 +298,8 @@ Formula::operator=(const Temp &r)
 const Formula &
 Formula::operator+=(Temp r)
 {
+    program.clear();
+    cacheValid = false;
     if (root)
         root = NodePtr(new BinaryNode<std::plus<Result> >(root, r));
     else {
@@ -198,17 +316,37 @@ Formula::operator/=(Temp r)
 {
     assert (root);
     root = NodePtr(new BinaryNode<std::divides<Result> >(root, r));
+    program.clear();
+    cacheValid = false;
 
     assert(size());
     return *this;
 }
 
 
+void
+Formula::evaluate() const
+{
+    // Operands that changed are either still dirty, or were stamped by
+    // the prepare() that cleaned them
+    if (cacheValid && !root->changedSince(cacheStamp))
+        return;
+
+    if (program.empty())
+        root->compile(program);
+
+    program.evaluate(cache);
+    cacheValid = true;
+    cacheStamp = InfoAccess::changeStamp();
+}
+
 void
 Formula::result(VResult &vec) const
 {
-    if (root)
-        vec = root->result();
+    if (root) {
+        evaluate();
+        vec = cache;
+    }
 }
 
 Result
@@ -234,14 +372,28 @@ Formula::reset()
 bool
 Formula::zero() const
 {
-    VResult vec;
-    result(vec);
-    for (VResult::size_type i = 0; i < vec.size(); ++i)
-        if (vec[i] != 0.0)
+    if (!root)
+        return true;
+
+    evaluate();
+    for (VResult::size_type i = 0; i < cache.size(); ++i)
+        if (cache[i] != 0.0)
             return false;
     return true;
 }
 
+bool
+Formula::changed() const
+{
+    return root && root->changed();
+}
+
+bool
+Formula::changedSince(uint64_t stamp) const
+{
+    return root && root->changedSince(stamp);
+}
+
 std::string
 Formula::str() const
 {
@@ -71,6 +71,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include "base/cast.hh"
@@ -112,6 +113,8 @@ class InfoProxy : public Base
         visitor.visit(*static_cast<Base *>(this));
     }
     bool zero() const { return s.zero(); }
+    bool changed() const { return s.changed(); }
+    bool changedSince(uint64_t stamp) const { return s.changedSince(stamp); }
 };
 
 template <class Stat>
@@ -179,10 +182,42 @@ class Vector2dInfoProxy : public InfoProxy<Stat, Vector2dInfo>
     Result total() const { return this->s.total(); }
 };
 
+/**
+ * Stats prepared while an instance of this class exists don't update
+ * what changed() reports. The changes seen by such a prepare() are
+ * reported by the next regular dump instead. Used by outputs that
+ * sample stats between dumps.
+ */
+class SamplingScope
+{
+  private:
+    static int depth;
+
+  public:
+    SamplingScope() { ++depth; }
+    ~SamplingScope() { --depth; }
+
+    SamplingScope(const SamplingScope &other) = delete;
+    SamplingScope &operator=(const SamplingScope &other) = delete;
+
+    static bool active() { return depth > 0; }
+};
+
 class InfoAccess
 {
   private:
     Info *_info;
+    /** Did the storage change before the last prepare()? */
+    bool _changed;
+    /** Changes seen by prepare() calls in a SamplingScope */
+    bool _pending;
+    /** Tick of the last prepare() */
+    Tick _preparedAt;
+    /** Value of changeCount when prepare() last saw a change */
+    uint64_t _changeStamp;
+
+    /** Number of changes seen by prepare(), over all stats */
+    static uint64_t changeCount;
 
   protected:
     /** Set up an info class for this statistic */
@@ -200,9 +235,29 @@ class InfoAccess
     /** Check if the info is new style stats */
     bool newStyleStats() const;
 
+    /** Record whether the storage changed, called by prepare(). */
+    void setChanged(bool changed);
+
+    /**
+     * @return true if a prepare() after the stamp was taken saw the
+     * storage change
+     */
+    bool
+    preparedChangeSince(uint64_t stamp) const
+    {
+        return _changeStamp > stamp;
+    }
+
   public:
     InfoAccess()
-        : _info(nullptr) {};
+        : _info(nullptr), _changed(true), _pending(false), _preparedAt(0),
+          _changeStamp(0)
+    {}
+
+    /**
+     * @return A stamp to compare with changedSince() later on.
+     */
+    static uint64_t changeStamp() { return changeCount; }
 
     /**
      * Reset the stat to the default state.
@@ -215,6 +270,20 @@ class InfoAccess
      */
     bool zero() const { return true; }
 
+    /**
+     * @return true if the stat changed between the two last calls to
+     * prepare(), i.e., since the previous stat dump. Stats that don't
+     * track their updates always report a change.
+     */
+    bool changed() const { return _changed; }
+
+    /**
+     * @return true if the stat may have changed since the stamp was
+     * taken. Stats that don't track their updates always report a
+     * change.
+     */
+    bool changedSince(uint64_t stamp) const { return true; }
+
     /**
      * Check that this stat has been set up properly and is ready for
      * use
@@ -440,9 +509,13 @@ class DataWrapVec : public DataWrap<Derived, InfoProxyType>
         Derived &self = this->self();
         Info *info = this->info();
 
+        bool changed = false;
         size_t size = self.size();
-        for (off_type i = 0; i < size; ++i)
+        for (off_type i = 0; i < size; ++i) {
+            changed |= self.data(i)->changed();
             self.data(i)->prepare(info->getStorageParams());
+        }
+        this->setChanged(changed);
     }
 
     void
@@ -627,7 +700,18 @@ class ScalarBase : public DataWrap<Derived, ScalarInfoProxy>
     bool zero() const { return result() == 0.0; }
 
     void reset() { data()->reset(this->info()->getStorageParams()); }
-    void prepare() { data()->prepare(this->info()->getStorageParams()); }
+    void
+    prepare()
+    {
+        this->setChanged(data()->changed());
+        data()->prepare(this->info()->getStorageParams());
+    }
+
+    bool
+    changedSince(uint64_t stamp) const
+    {
+        return this->preparedChangeSince(stamp) || data()->changed();
+    }
 };
 
 class ProxyInfo : public ScalarInfo
@@ -814,6 +898,22 @@ class ScalarProxy
      */
     Result result() const { return stat.data(index)->result(); }
 
+    /**
+     * Return whether the parent stat changed before it was last prepared.
+     * @return true if the parent stat changed.
+     */
+    bool changed() const { return stat.changed(); }
+
+    /**
+     * Return whether the parent stat changed since the stamp was taken.
+     * @return true if the parent stat changed.
+     */
+    bool
+    changedSince(uint64_t stamp) const
+    {
+        return stat.changedSince(stamp);
+    }
+
   public:
     /**
      * Create and initialize this proxy, do not register it with the database.
@@ -1232,14 +1332,32 @@ class Vector2dBase : public DataWrapVec2d<Derived, Vector2dInfoProxy>
         Info *info = this->info();
         size_type size = this->size();
 
-        for (off_type i = 0; i < size; ++i)
+        bool changed = false;
+        for (off_type i = 0; i < size; ++i) {
+            changed |= data(i)->changed();
             data(i)->prepare(info->getStorageParams());
+        }
+        this->setChanged(changed);
+        if (!changed && info->cvec.size() == size)
+            return;
 
         info->cvec.resize(size);
         for (off_type i = 0; i < size; ++i)
             info->cvec[i] = data(i)->value();
     }
 
+    bool
+    changedSince(uint64_t stamp) const
+    {
+        if (this->preparedChangeSince(stamp))
+            return true;
+        for (off_type i = 0; i < size(); ++i) {
+            if (data(i)->changed())
+                return true;
+        }
+        return false;
+    }
+
     /**
      * Reset stat value to default
      */
@@ -1341,6 +1459,7 @@ class DistBase : public DataWrap<Derived, DistInfoProxy>
     prepare()
     {
         Info *info = this->info();
+        this->setChanged(data()->changed());
         data()->prepare(info->getStorageParams(), info->data);
     }
 
@@ -1444,8 +1563,12 @@ class VectorDistBase : public DataWrapVec<Derived, VectorDistInfoProxy>
         Info *info = this->info();
         size_type size = this->size();
         info->data.resize(size);
-        for (off_type i = 0; i < size; ++i)
+        bool changed = false;
+        for (off_type i = 0; i < size; ++i) {
+            changed |= data(i)->changed();
             data(i)->prepare(info->getStorageParams(), info->data[i]);
+        }
+        this->setChanged(changed);
     }
 
     bool
@@ -1515,6 +1638,8 @@ class DistProxy
 //
 //////////////////////////////////////////////////////////////////////
 
+class FormulaProgram;
+
 /**
  * Base class for formula statistic node. These nodes are used to build a tree
  * that represents the formula.
@@ -1543,12 +1668,127 @@ class Node
      */
     virtual std::string str() const = 0;
 
+    /**
+     * Return whether any stat in the subtree changed before it was
+     * last prepared. Nodes that can't tell report a change.
+     * @return true if the result of this subtree may have changed.
+     */
+    virtual bool changed() const { return true; }
+
+    /**
+     * Return whether any stat in the subtree may have changed since
+     * the stamp was taken. Nodes that can't tell report a change.
+     * @param stamp A value of InfoAccess::changeStamp().
+     * @return true if the result of this subtree may have changed.
+     */
+    virtual bool changedSince(uint64_t stamp) const { return true; }
+
+    /**
+     * Append the postfix form of the subtree to a program. Nodes that
+     * don't know how to compile themselves are evaluated through
+     * result() when the program runs.
+     * @param prog The program to append to.
+     */
+    virtual void compile(FormulaProgram &prog) const;
+
     virtual ~Node() {};
 };
 
 /** Shared pointer to a function Node. */
 typedef std::shared_ptr<Node> NodePtr;
 
+/**
+ * A formula tree flattened to postfix form. Running the program pushes
+ * operands to a stack of result vectors and applies operators in place,
+ * which avoids the virtual calls and temporary vectors of a tree walk.
+ * The stack is kept between runs, so evaluating a formula doesn't
+ * allocate once it has been run.
+ */
+class FormulaProgram
+{
+  public:
+    enum Opcode
+    {
+        PushScalar,
+        PushVector,
+        PushConst,
+        PushNode,
+        Negate,
+        Add,
+        Sub,
+        Mul,
+        Div,
+        Sum,
+    };
+
+  private:
+    struct Instr
+    {
+        Opcode op;
+        union
+        {
+            const ScalarInfo *scalar;
+            const VectorInfo *vector;
+            const Node *node;
+            size_t constant;
+        };
+    };
+
+    std::vector<Instr> code;
+    std::vector<VResult> constants;
+    mutable std::vector<VResult> stack;
+
+  public:
+    bool empty() const { return code.empty(); }
+    void clear() { code.clear(); constants.clear(); }
+
+    void
+    pushScalar(const ScalarInfo *info)
+    {
+        Instr instr{PushScalar};
+        instr.scalar = info;
+        code.push_back(instr);
+    }
+
+    void
+    pushVector(const VectorInfo *info)
+    {
+        Instr instr{PushVector};
+        instr.vector = info;
+        code.push_back(instr);
+    }
+
+    void
+    pushConst(const VResult &values)
+    {
+        Instr instr{PushConst};
+        instr.constant = constants.size();
+        constants.push_back(values);
+        code.push_back(instr);
+    }
+
+    void
+    pushNode(const Node *node)
+    {
+        Instr instr{PushNode};
+        instr.node = node;
+        code.push_back(instr);
+    }
+
+    void
+    push(Opcode op)
+    {
+        assert(op >= Negate);
+        code.push_back(Instr{op});
+    }
+
+    /**
+     * Run the program.
+     * @param vec Set to the result vector.
+     */
+    void evaluate(VResult &vec) const;
+};
+
 class ScalarStatNode : public Node
 {
   private:
@@ -1569,6 +1809,14 @@ class ScalarStatNode : public Node
 
     size_type size() const { return 1; }
 
+    bool changed() const { return data->changed(); }
+    bool
+    changedSince(uint64_t stamp) const
+    {
+        return data->changedSince(stamp);
+    }
+    void compile(FormulaProgram &prog) const { prog.pushScalar(data); }
+
     /**
      *
      */
@@ -1606,6 +1854,13 @@ class ScalarProxyNode : public Node
         return 1;
     }
 
+    bool changed() const { return proxy.changed(); }
+    bool
+    changedSince(uint64_t stamp) const
+    {
+        return proxy.changedSince(stamp);
+    }
+
     /**
      *
      */
@@ -1627,6 +1882,13 @@ class VectorStatNode : public Node
     Result total() const { return data->total(); };
 
     size_type size() const { return data->size(); }
+    bool changed() const { return data->changed(); }
+    bool
+    changedSince(uint64_t stamp) const
+    {
+        return data->changedSince(stamp);
+    }
+    void compile(FormulaProgram &prog) const { prog.pushVector(data); }
 
     std::string str() const { return data->name; }
 };
@@ -1642,6 +1904,9 @@ class ConstNode : public Node
     const VResult &result() const { return vresult; }
     Result total() const { return vresult[0]; };
     size_type size() const { return 1; }
+    bool changed() const { return false; }
+    bool changedSince(uint64_t stamp) const { return false; }
+    void compile(FormulaProgram &prog) const { prog.pushConst(vresult); }
     std::string str() const { return std::to_string(vresult[0]); }
 };
 
@@ -1666,6 +1931,9 @@ class ConstVectorNode : public Node
     }
 
     size_type size() const { return vresult.size(); }
+    bool changed() const { return false; }
+    bool changedSince(uint64_t stamp) const { return false; }
+    void compile(FormulaProgram &prog) const { prog.pushConst(vresult); }
     std::string
     str() const
     {
@@ -1717,6 +1985,39 @@ struct OpString<std::negate<Result> >
     static std::string str() { return "-"; }
 };
 
+template <class Op>
+struct OpCode;
+
+template<>
+struct OpCode<std::plus<Result> >
+{
+    static const FormulaProgram::Opcode code = FormulaProgram::Add;
+};
+
+template<>
+struct OpCode<std::minus<Result> >
+{
+    static const FormulaProgram::Opcode code = FormulaProgram::Sub;
+};
+
+template<>
+struct OpCode<std::multiplies<Result> >
+{
+    static const FormulaProgram::Opcode code = FormulaProgram::Mul;
+};
+
+template<>
+struct OpCode<std::divides<Result> >
+{
+    static const FormulaProgram::Opcode code = FormulaProgram::Div;
+};
+
+template<>
+struct OpCode<std::negate<Result> >
+{
+    static const FormulaProgram::Opcode code = FormulaProgram::Negate;
+};
+
 template <class Op>
 class UnaryNode : public Node
 {
@@ -1754,6 +2055,19 @@ class UnaryNode : public Node
     }
 
     size_type size() const { return l->size(); }
+    bool changed() const { return l->changed(); }
+    bool
+    changedSince(uint64_t stamp) const
+    {
+        return l->changedSince(stamp);
+    }
+
+    void
+    compile(FormulaProgram &prog) const
+    {
+        l->compile(prog);
+        prog.push(OpCode<Op>::code);
+    }
 
     std::string
     str() const
@@ -1852,6 +2166,26 @@ class BinaryNode : public Node
         }
     }
 
+    bool
+    changed() const override
+    {
+        return l->changed() || r->changed();
+    }
+
+    bool
+    changedSince(uint64_t stamp) const override
+    {
+        return l->changedSince(stamp) || r->changedSince(stamp);
+    }
+
+    void
+    compile(FormulaProgram &prog) const override
+    {
+        l->compile(prog);
+        r->compile(prog);
+        prog.push(OpCode<Op>::code);
+    }
+
     std::string
     str() const override
     {
@@ -1902,6 +2236,23 @@ class SumNode : public Node
     }
 
     size_type size() const { return 1; }
+    bool changed() const { return l->changed(); }
+    bool
+    changedSince(uint64_t stamp) const
+    {
+        return l->changedSince(stamp);
+    }
+
+    void
+    compile(FormulaProgram &prog) const
+    {
+        if constexpr (std::is_same_v<Op, std::plus<Result>>) {
+            l->compile(prog);
+            prog.push(FormulaProgram::Sum);
+        } else {
+            prog.pushNode(this);
+        }
+    }
 
     std::string
     str() const
@@ -2478,6 +2829,7 @@ class SparseHistBase : public DataWrap<Derived, SparseHistInfoProxy>
     prepare()
     {
         Info *info = this->info();
+        this->setChanged(data()->changed());
         data()->prepare(info->getStorageParams(), info->data);
     }
 
@@ -2542,6 +2894,21 @@ class Formula : public DataWrapVec<Formula, FormulaInfoProxy>
     NodePtr root;
     friend class Temp;
 
+    /** The tree in postfix form, compiled on first use */
+    mutable FormulaProgram program;
+
+    /**
+     * Result of the last evaluation. It is reused until an operand
+     * changes, within a dump and across dumps.
+     */
+    mutable VResult cache;
+    mutable bool cacheValid = false;
+    /** Change stamp taken by the last evaluation */
+    mutable uint64_t cacheStamp = 0;
+
+    /** Make sure the cache holds the current result. */
+    void evaluate() const;
+
   public:
     /**
      * Create and initialize thie formula, and register it with the database.
@@ -2624,6 +2991,17 @@ class Formula : public DataWrapVec<Formula, FormulaInfoProxy>
      */
     bool zero() const;
 
+    /**
+     * Return whether any operand changed before it was last prepared.
+     */
+    bool changed() const;
+
+    /**
+     * Return whether any operand may have changed since the stamp was
+     * taken.
+     */
+    bool changedSince(uint64_t stamp) const;
+
     std::string str() const;
 };
 
@@ -2639,6 +3017,12 @@ class FormulaNode : public Node
     size_type size() const { return formula.size(); }
     const VResult &result() const { formula.result(vec); return vec; }
     Result total() const { return formula.total(); }
+    bool changed() const { return formula.changed(); }
+    bool
+    changedSince(uint64_t stamp) const
+    {
+        return formula.changedSince(stamp);
+    }
 
     std::string str() const { return formula.str(); }
 };
@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include "base/gtest/cur_tick_fake.hh"
+#include "base/gtest/logging.hh"
+#include "base/statistics.hh"
+#include "base/stats/group.hh"
+#include "sim/root.hh"
+
+using namespace gem5;
+using namespace gem5::statistics;
+
+// statistics.cc resolves unknown stat names through the root object,
+// which these tests don't create
+Root *Root::_root = nullptr;
+
+// Instantiate the fake class to have a valid curTick of 0
+GTestTickHandler tickHandler;
+
+class StatsFormulaTest : public testing::Test
+{
+  protected:
+    Group group;
+    Scalar a;
+    Scalar b;
+    Vector v;
+    Vector w;
+
+    StatsFormulaTest()
+        : group(nullptr),
+          a(&group, "a"), b(&group, "b"), v(&group, "v"), w(&group, "w")
+    {
+        v.init(3);
+        w.init(3);
+
+        a = 2;
+        b = -5;
+        v[0] = 1;
+        v[1] = 4;
+        v[2] = 9;
+        w[0] = 3;
+        w[1] = 0.5;
+        w[2] = -7;
+    }
+
+    /** Prepare the operands, as a stat dump does. */
+    void
+    prepare()
+    {
+        a.prepare();
+        b.prepare();
+        v.prepare();
+        w.prepare();
+    }
+
+    /**
+     * Check that the compiled program of a tree computes the same
+     * result as the tree itself. Programs are run twice to check that
+     * the stack is reused correctly.
+     */
+    void
+    checkProgram(const Temp &t)
+    {
+        const NodePtr node = t.getNodePtr();
+        const VResult expected = node->result();
+
+        FormulaProgram prog;
+        node->compile(prog);
+        ASSERT_FALSE(prog.empty());
+
+        VResult vec;
+        prog.evaluate(vec);
+        ASSERT_EQ(vec, expected) << node->str();
+        prog.evaluate(vec);
+        ASSERT_EQ(vec, expected) << node->str();
+    }
+};
+
+/** Test arithmetic between scalars and constants. */
+TEST_F(StatsFormulaTest, ProgramScalar)
+{
+    checkProgram(a + b);
+    checkProgram(a - b);
+    checkProgram(a * b);
+    checkProgram(a / b);
+    checkProgram(a / 4);
+    checkProgram(3 - a * b + constant(7.5));
+    checkProgram(a / (b - b));
+}
+
+/** Test that scalars are broadcast to vectors on both sides. */
+TEST_F(StatsFormulaTest, ProgramBroadcast)
+{
+    checkProgram(v + w);
+    checkProgram(v / w);
+    checkProgram(a * v);
+    checkProgram(v - a);
+    checkProgram(2 / v);
+    checkProgram(v * constantVector(std::vector<int>{1, 2, 3}));
+    checkProgram((a + v) * (w - b) / (v + 1));
+}
+
+/** Test the unary operators. */
+TEST_F(StatsFormulaTest, ProgramUnary)
+{
+    checkProgram(-a);
+    checkProgram(-v);
+    checkProgram(sum(v));
+    checkProgram(sum(v * w) / sum(w));
+    checkProgram(-(sum(v) + a) * w);
+    checkProgram(sum(a));
+}
+
+/** Test nodes evaluated through their tree, mixed with compiled ones. */
+TEST_F(StatsFormulaTest, ProgramPushNode)
+{
+    checkProgram(v[1]);
+    checkProgram(v[2] * w - a);
+    checkProgram(sum(w) / v[0]);
+
+    Formula f(&group, "f");
+    f = v / a;
+    checkProgram(f);
+    checkProgram(-f + w[2]);
+}
+
+/** Test that formulas see operand updates between evaluations. */
+TEST_F(StatsFormulaTest, CacheUpdate)
+{
+    Formula f(&group, "f");
+    f = a * v;
+
+    VResult vec;
+    f.result(vec);
+    ASSERT_EQ(vec, VResult({2, 8, 18}));
+
+    // Updated before the operands are prepared
+    a = 3;
+    f.result(vec);
+    ASSERT_EQ(vec, VResult({3, 12, 27}));
+
+    // Updated and prepared before the next evaluation
+    v[0] = 10;
+    prepare();
+    f.result(vec);
+    ASSERT_EQ(vec, VResult({30, 12, 27}));
+
+    // Nothing changed
+    prepare();
+    f.result(vec);
+    ASSERT_EQ(vec, VResult({30, 12, 27}));
+    ASSERT_FALSE(f.zero());
+}
+
+/**
+ * Test a reset between two dumps of the same tick. Nothing is left
+ * to tell the dumps apart but the operand changes.
+ */
+TEST_F(StatsFormulaTest, CacheResetSameTick)
+{
+    Formula f(&group, "f");
+    f = a + sum(v);
+
+    VResult vec;
+    prepare();
+    f.prepare();
+    f.result(vec);
+    ASSERT_EQ(vec, VResult({16}));
+
+    a.reset();
+    v.reset();
+    prepare();
+    f.prepare();
+    ASSERT_TRUE(f.zero());
+    f.result(vec);
+    ASSERT_EQ(vec, VResult({0}));
+}
+
+/** Test that changes seen by a sampling prepare reach the formula. */
+TEST_F(StatsFormulaTest, CacheSampling)
+{
+    Formula f(&group, "f");
+    f = b * w[1];
+
+    VResult vec;
+    f.result(vec);
+    ASSERT_EQ(vec, VResult({-2.5}));
+
+    w[1] = 2;
+    {
+        SamplingScope scope;
+        prepare();
+    }
+    f.result(vec);
+    ASSERT_EQ(vec, VResult({-10}));
+}
+
+/** Test that formulas are recomputed after they are extended. */
+TEST_F(StatsFormulaTest, CacheExtended)
+{
+    Formula f(&group, "f");
+    f = a;
+
+    VResult vec;
+    f.result(vec);
+    ASSERT_EQ(vec, VResult({2}));
+
+    f += b;
+    f.result(vec);
+    ASSERT_EQ(vec, VResult({-3}));
+
+    f /= 2;
+    f.result(vec);
+    ASSERT_EQ(vec, VResult({-1.5}));
+}
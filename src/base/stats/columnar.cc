@@ -0,0 +1,460 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "base/stats/columnar.hh"
+
+#include <cassert>
+#include <cstring>
+#include <ostream>
+
+#include "base/logging.hh"
+#include "base/output.hh"
+#include "base/stats/info.hh"
+#include "config/have_zstd.hh"
+#include "sim/cur_tick.hh"
+
+#if HAVE_ZSTD
+#include <zstd.h>
+
+#endif
+
+namespace gem5
+{
+
+namespace statistics
+{
+
+Columnar::Columnar(const std::string &file, bool formulas, int compression)
+    : Columnar(simout.create(file, true, true), formulas, compression)
+{
+    std::vector<char> header;
+    appendHeader(header);
+    stream->stream()->write(header.data(), header.size());
+}
+
+Columnar::Columnar(OutputStream *os, bool formulas, int compression)
+    : stream(os),
+      enableFormula(formulas), compressionLevel(compression),
+      cursor(0), schemaChanged(false), zstdCtx(nullptr)
+{
+    if (compressionLevel > 0) {
+#if HAVE_ZSTD
+        zstdCtx = ZSTD_createCCtx();
+        fatal_if(!zstdCtx, "Failed to create a zstd context.\n");
+        ZSTD_CCtx_setParameter(static_cast<ZSTD_CCtx *>(zstdCtx),
+                               ZSTD_c_compressionLevel, compressionLevel);
+#else
+        warn("gem5 was built without zstd, stats will not be "
+             "compressed.\n");
+#endif
+    }
+}
+
+Columnar::~Columnar()
+{
+#if HAVE_ZSTD
+    ZSTD_freeCCtx(static_cast<ZSTD_CCtx *>(zstdCtx));
+#endif
+    if (stream)
+        simout.close(stream);
+}
+
+void
+Columnar::appendHeader(std::vector<char> &buf)
+{
+    const uint32_t bom = 0x01020304;
+    buf.insert(buf.end(), magic, magic + sizeof(magic));
+    buf.insert(buf.end(), reinterpret_cast<const char *>(&version),
+               reinterpret_cast<const char *>(&version) + sizeof(version));
+    buf.insert(buf.end(), reinterpret_cast<const char *>(&bom),
+               reinterpret_cast<const char *>(&bom) + sizeof(bom));
+}
+
+void
+Columnar::emit(uint32_t kind, const char *data, size_t size)
+{
+    stream->stream()->write(data, size);
+}
+
+void
+Columnar::flush()
+{
+    stream->stream()->flush();
+}
+
+void
+Columnar::begin()
+{
+    assert(path.empty());
+    cursor = 0;
+    schemaChanged = false;
+}
+
+void
+Columnar::end()
+{
+    assert(valid());
+
+    // Stats at the end of the schema didn't show up in this dump.
+    if (cursor < entries.size()) {
+        const size_t first = entries[cursor].first;
+        entries.resize(cursor);
+        columnNames.resize(first);
+        row.resize(first);
+        schemaChanged = true;
+    }
+
+    if (schemaChanged)
+        writeSchema();
+
+    const uint64_t tick = curTick();
+    payload.resize(sizeof(tick) + row.size() * sizeof(double));
+    std::memcpy(payload.data(), &tick, sizeof(tick));
+    std::memcpy(payload.data() + sizeof(tick), row.data(),
+                row.size() * sizeof(double));
+    writeRecord(Row, payload.data(), payload.size());
+
+    flush();
+}
+
+bool
+Columnar::valid() const
+{
+    return !stream || stream->stream()->good();
+}
+
+void
+Columnar::beginGroup(const char *name)
+{
+    path.push_back(name);
+}
+
+void
+Columnar::endGroup()
+{
+    assert(!path.empty());
+    path.pop_back();
+}
+
+std::string
+Columnar::statName(const Info &info) const
+{
+    std::string name;
+    for (const char *group : path) {
+        name += group;
+        name += '.';
+    }
+    return name + info.name;
+}
+
+size_t
+Columnar::slot(const Info &info, size_t count, const DistData *dists,
+               size_t num_dists)
+{
+    if (schemaChanged || cursor >= entries.size())
+        return noSlot;
+
+    const Entry &entry = entries[cursor];
+    if (entry.info != &info || entry.count != count ||
+        entry.buckets.size() != 2 * num_dists) {
+        return noSlot;
+    }
+
+    // The bucket columns are named after their lower bound
+    for (size_t i = 0; i < num_dists; ++i) {
+        if (entry.buckets[2 * i] != dists[i].min ||
+            entry.buckets[2 * i + 1] != dists[i].bucket_size) {
+            return noSlot;
+        }
+    }
+
+    ++cursor;
+    return entry.selected ? entry.first : skipSlot;
+}
+
+size_t
+Columnar::addEntry(const Info &info,
+                   const std::vector<std::string> &suffixes,
+                   const DistData *dists, size_t num_dists)
+{
+    if (!schemaChanged) {
+        const size_t first = cursor < entries.size() ?
+            entries[cursor].first : columnNames.size();
+        entries.resize(cursor);
+        columnNames.resize(first);
+        row.resize(first);
+        schemaChanged = true;
+    }
+
+    const size_t first = columnNames.size();
+    const std::string name = statName(info);
+    const bool enabled = selected(name);
+    entries.push_back({ &info, first, suffixes.size(), {}, enabled });
+    for (size_t i = 0; i < num_dists; ++i) {
+        entries.back().buckets.push_back(dists[i].min);
+        entries.back().buckets.push_back(dists[i].bucket_size);
+    }
+    ++cursor;
+    if (!enabled)
+        return skipSlot;
+
+    for (const auto &suffix : suffixes)
+        columnNames.push_back(name + suffix);
+    row.resize(columnNames.size());
+
+    return first;
+}
+
+void
+Columnar::visit(const ScalarInfo &info)
+{
+    if (!info.flags.isSet(display))
+        return;
+
+    size_t first = slot(info, 1);
+    if (first == noSlot)
+        first = addEntry(info, { "" });
+    if (first == skipSlot)
+        return;
+
+    row[first] = info.result();
+}
+
+void
+Columnar::visit(const VectorInfo &info)
+{
+    if (!info.flags.isSet(display))
+        return;
+
+    const VResult &vr = info.result();
+    size_t first = slot(info, vr.size());
+    if (first == noSlot) {
+        std::vector<std::string> suffixes(vr.size());
+        for (size_t i = 0; i < vr.size(); ++i) {
+            suffixes[i] = "::" + (i < info.subnames.size() &&
+                                  !info.subnames[i].empty() ?
+                                  info.subnames[i] : std::to_string(i));
+        }
+        first = addEntry(info, suffixes);
+    }
+    if (first == skipSlot)
+        return;
+
+    std::copy(vr.begin(), vr.end(), row.begin() + first);
+}
+
+void
+Columnar::visit(const Vector2dInfo &info)
+{
+    if (!info.flags.isSet(display))
+        return;
+
+    const size_t count = info.x * info.y;
+    size_t first = slot(info, count);
+    if (first == noSlot) {
+        std::vector<std::string> suffixes;
+        suffixes.reserve(count);
+        for (size_t x = 0; x < info.x; ++x) {
+            const std::string xname = "::" +
+                (x < info.subnames.size() && !info.subnames[x].empty() ?
+                 info.subnames[x] : std::to_string(x));
+            for (size_t y = 0; y < info.y; ++y) {
+                suffixes.push_back(xname + "::" +
+                    (y < info.y_subnames.size() &&
+                     !info.y_subnames[y].empty() ?
+                     info.y_subnames[y] : std::to_string(y)));
+            }
+        }
+        first = addEntry(info, suffixes);
+    }
+    if (first == skipSlot)
+        return;
+
+    std::copy(info.cvec.begin(), info.cvec.begin() + count,
+              row.begin() + first);
+}
+
+void
+Columnar::visit(const FormulaInfo &info)
+{
+    if (!enableFormula)
+        return;
+
+    visit(static_cast<const VectorInfo &>(info));
+}
+
+size_t
+Columnar::distSize(const DistData &data)
+{
+    // samples, sum, squares, min_value, max_value, underflows,
+    // overflows followed by the buckets.
+    return 7 + data.cvec.size();
+}
+
+void
+Columnar::distNames(const DistData &data, const std::string &prefix,
+                    std::vector<std::string> &suffixes)
+{
+    for (const char *field : { "samples", "sum", "squares", "min_value",
+                               "max_value", "underflows", "overflows" }) {
+        suffixes.push_back(prefix + "::" + field);
+    }
+
+    for (size_t i = 0; i < data.cvec.size(); ++i) {
+        const Counter low = data.min + i * data.bucket_size;
+        suffixes.push_back(prefix + "::" + std::to_string((int64_t)low));
+    }
+}
+
+void
+Columnar::appendDist(const DistData &data, size_t first)
+{
+    double *dst = row.data() + first;
+    *dst++ = data.samples;
+    *dst++ = data.sum;
+    *dst++ = data.squares;
+    *dst++ = data.min_val;
+    *dst++ = data.max_val;
+    *dst++ = data.underflow;
+    *dst++ = data.overflow;
+    std::copy(data.cvec.begin(), data.cvec.end(), dst);
+}
+
+void
+Columnar::visit(const DistInfo &info)
+{
+    if (!info.flags.isSet(display))
+        return;
+
+    size_t first = slot(info, distSize(info.data), &info.data, 1);
+    if (first == noSlot) {
+        std::vector<std::string> suffixes;
+        distNames(info.data, "", suffixes);
+        first = addEntry(info, suffixes, &info.data, 1);
+    }
+    if (first == skipSlot)
+        return;
+
+    appendDist(info.data, first);
+}
+
+void
+Columnar::visit(const VectorDistInfo &info)
+{
+    if (!info.flags.isSet(display))
+        return;
+
+    size_t count = 0;
+    for (const auto &data : info.data)
+        count += distSize(data);
+
+    size_t first = slot(info, count, info.data.data(), info.data.size());
+    if (first == noSlot) {
+        std::vector<std::string> suffixes;
+        for (size_t i = 0; i < info.data.size(); ++i) {
+            distNames(info.data[i], "::" +
+                      (i < info.subnames.size() &&
+                       !info.subnames[i].empty() ?
+                       info.subnames[i] : std::to_string(i)),
+                      suffixes);
+        }
+        first = addEntry(info, suffixes, info.data.data(),
+                         info.data.size());
+    }
+    if (first == skipSlot)
+        return;
+
+    for (const auto &data : info.data) {
+        appendDist(data, first);
+        first += distSize(data);
+    }
+}
+
+void
+Columnar::visit(const SparseHistInfo &info)
+{
+    warn_once("Columnar stat files don't support sparse histograms.\n");
+}
+
+void
+Columnar::writeSchema()
+{
+    payload.clear();
+    auto put = [this](const void *data, size_t size) {
+        const char *bytes = static_cast<const char *>(data);
+        payload.insert(payload.end(), bytes, bytes + size);
+    };
+
+    const uint32_t count = columnNames.size();
+    put(&count, sizeof(count));
+    for (const auto &name : columnNames) {
+        const uint32_t length = name.size();
+        put(&length, sizeof(length));
+        put(name.data(), length);
+    }
+
+    writeRecord(Schema, payload.data(), payload.size());
+}
+
+void
+Columnar::writeRecord(uint32_t kind, const void *data, size_t size)
+{
+    const uint32_t raw_size = size;
+
+#if HAVE_ZSTD
+    if (zstdCtx) {
+        compressed.resize(ZSTD_compressBound(size));
+        const size_t csize = ZSTD_compress2(
+            static_cast<ZSTD_CCtx *>(zstdCtx), compressed.data(),
+            compressed.size(), data, size);
+        panic_if(ZSTD_isError(csize), "zstd compression failed: %s\n",
+                 ZSTD_getErrorName(csize));
+
+        kind |= Compressed;
+        data = compressed.data();
+        size = csize;
+    }
+#endif
+
+    const uint32_t header[3] = { kind, (uint32_t)size, raw_size };
+    record.resize(sizeof(header) + size);
+    std::memcpy(record.data(), header, sizeof(header));
+    std::memcpy(record.data() + sizeof(header), data, size);
+    emit(kind, record.data(), record.size());
+}
+
+std::unique_ptr<Output>
+initColumnar(const std::string &filename, bool formulas, int compression)
+{
+    return std::unique_ptr<Output>(
+        new Columnar(filename, formulas, compression));
+}
+
+} // namespace statistics
+} // namespace gem5
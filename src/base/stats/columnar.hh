@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __BASE_STATS_COLUMNAR_HH__
+#define __BASE_STATS_COLUMNAR_HH__
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/stats/output.hh"
+#include "base/stats/types.hh"
+
+namespace gem5
+{
+
+class OutputStream;
+
+namespace statistics
+{
+
+/**
+ * Binary, columnar stat output intended for periodic dumps.
+ *
+ * The file starts with a short header and is followed by a sequence
+ * of records. A schema record lists the name of every column (one
+ * per stat value) and is only written on the first dump, or when the
+ * set of stats or the buckets of a histogram change between two
+ * dumps. Every dump appends a row
+ * record holding the current tick and one double per column. Rows
+ * are optionally compressed with zstd, one frame per row, so the
+ * file can be read while the simulation is still running.
+ *
+ * The per-dump cost is a walk over the stats and a memcpy of their
+ * values; stat names are only formatted when the schema is built.
+ *
+ * Record layout (host byte order, see the header's byte order mark):
+ *   uint32 kind; uint32 stored size; uint32 raw size; payload
+ *
+ * A Python reader lives in m5.stats.columnar.
+ */
+class Columnar : public Output
+{
+  public:
+    enum RecordKind : uint32_t
+    {
+        Schema = 1,
+        Row = 2,
+        /** Set in the kind field if the payload is zstd compressed */
+        Compressed = 0x100,
+    };
+
+    static constexpr char magic[8] = { 'g', 'e', 'm', '5', 'c', 'o', 'l',
+                                       '\0' };
+    static constexpr uint32_t version = 1;
+
+    Columnar(const std::string &file, bool formulas, int compression);
+    ~Columnar();
+
+    Columnar() = delete;
+    Columnar(const Columnar &other) = delete;
+
+  public: // Output interface
+    void begin() override;
+    void end() override;
+    bool valid() const override;
+
+    void beginGroup(const char *name) override;
+    void endGroup() override;
+
+    void visit(const ScalarInfo &info) override;
+    void visit(const VectorInfo &info) override;
+    void visit(const DistInfo &info) override;
+    void visit(const VectorDistInfo &info) override;
+    void visit(const Vector2dInfo &info) override;
+    void visit(const FormulaInfo &info) override;
+    void visit(const SparseHistInfo &info) override;
+
+  protected:
+    /**
+     * Create an output without writing a file header. Subclasses
+     * that don't write to a file pass a null stream and override
+     * emit() and flush().
+     */
+    Columnar(OutputStream *os, bool formulas, int compression);
+
+    /** Append the file header to a buffer. */
+    static void appendHeader(std::vector<char> &buf);
+
+    /**
+     * Write an encoded record.
+     *
+     * @param kind Record kind, including the Compressed flag.
+     * @param data Complete record, including its header.
+     * @param size Size of the record in bytes.
+     */
+    virtual void emit(uint32_t kind, const char *data, size_t size);
+
+    /** Called at the end of every dump. */
+    virtual void flush();
+
+    /**
+     * Select the stats to output. The decision is made when the
+     * schema is built, so it is only called once per stat.
+     *
+     * @param name Full name of the stat.
+     */
+    virtual bool selected(const std::string &name) const { return true; }
+
+    /** A stat and the columns it occupies in a row. */
+    struct Entry
+    {
+        const Info *info;
+        size_t first;
+        size_t count;
+        /**
+         * min and bucket_size of every distribution of the stat, as
+         * histograms keep their bucket count when they are rescaled
+         */
+        std::vector<Counter> buckets;
+        bool selected;
+    };
+
+    static constexpr size_t noSlot = (size_t)-1;
+    /** Returned for stats that are in the schema but not selected */
+    static constexpr size_t skipSlot = (size_t)-2;
+
+    /**
+     * Look up the row slot of the next stat if it matches the schema
+     * of the previous dump.
+     *
+     * @param dists Distributions of the stat, if any.
+     * @param num_dists Number of distributions.
+     * @return Index of the first column of the stat, or noSlot.
+     */
+    size_t slot(const Info &info, size_t count,
+                const DistData *dists = nullptr, size_t num_dists = 0);
+
+    /**
+     * Add a stat to the schema. The first call in a dump drops the
+     * part of the old schema that follows the current position.
+     *
+     * @param info Stat to add.
+     * @param suffixes Column name suffixes, one per value.
+     * @param dists Distributions of the stat, if any.
+     * @param num_dists Number of distributions.
+     * @return Index of the first column of the stat, or skipSlot if
+     * the stat isn't selected.
+     */
+    size_t addEntry(const Info &info,
+                    const std::vector<std::string> &suffixes,
+                    const DistData *dists = nullptr, size_t num_dists = 0);
+
+    /** Number of columns used to store a distribution. */
+    static size_t distSize(const DistData &data);
+    /** Column name suffixes of a distribution. */
+    static void distNames(const DistData &data, const std::string &prefix,
+                          std::vector<std::string> &suffixes);
+    /** Copy the values of a distribution to the row. */
+    void appendDist(const DistData &data, size_t first);
+
+    /** Full name of a stat in the current group. */
+    std::string statName(const Info &info) const;
+
+    void writeRecord(uint32_t kind, const void *data, size_t size);
+    void writeSchema();
+
+  protected:
+    OutputStream *const stream;
+    const bool enableFormula;
+    const int compressionLevel;
+
+    /** Group names from the root to the current group */
+    std::vector<const char *> path;
+
+    /** Stats in row order */
+    std::vector<Entry> entries;
+    /** Column names, one per row value */
+    std::vector<std::string> columnNames;
+    /** Position in entries of the next visited stat */
+    size_t cursor;
+    /** Has the schema been changed by the current dump? */
+    bool schemaChanged;
+
+    /** Values of the row under construction */
+    std::vector<double> row;
+    /** Record payload, compression and encoded record buffers */
+    std::vector<char> payload;
+    std::vector<char> compressed;
+    std::vector<char> record;
+    /** Reused zstd compression context, if compression is enabled */
+    void *zstdCtx;
+};
+
+std::unique_ptr<Output> initColumnar(const std::string &filename,
+                                     bool formulas = true,
+                                     int compression = 0);
+
+} // namespace statistics
+} // namespace gem5
+
+#endif // __BASE_STATS_COLUMNAR_HH__
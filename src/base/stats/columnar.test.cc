@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "base/gtest/cur_tick_fake.hh"
+#include "base/stats/columnar.hh"
+#include "base/stats/info.hh"
+
+using namespace gem5;
+
+// Instantiate the fake class to have a valid curTick of 0
+GTestTickHandler tickHandler;
+
+namespace
+{
+
+class TestDistInfo : public statistics::DistInfo
+{
+  public:
+    TestDistInfo()
+    {
+        setName("hist", false);
+        flags = statistics::display;
+        data.type = statistics::Hist;
+        data.min = 0;
+        data.bucket_size = 1;
+        data.cvec.assign(4, 0);
+        data.min_val = data.max_val = data.underflow = data.overflow = 0;
+        data.sum = data.squares = data.logs = data.samples = 0;
+    }
+
+    bool check() const override { return true; }
+    void prepare() override {}
+    void reset() override {}
+    bool zero() const override { return false; }
+    void visit(statistics::Output &visitor) override { visitor.visit(*this); }
+};
+
+/** Columnar output that keeps the kind of every record. */
+class TestColumnar : public statistics::Columnar
+{
+  public:
+    TestColumnar() : Columnar(nullptr, true, 0) {}
+
+    std::vector<uint32_t> kinds;
+
+    void
+    dump(statistics::Info &info)
+    {
+        begin();
+        info.visit(*this);
+        end();
+    }
+
+  protected:
+    void
+    emit(uint32_t kind, const char *data, size_t size) override
+    {
+        kinds.push_back(kind);
+    }
+
+    void flush() override {}
+};
+
+} // anonymous namespace
+
+/** The schema is only written again when the stats change. */
+TEST(StatsColumnarTest, SchemaWrittenOnce)
+{
+    TestDistInfo info;
+    TestColumnar output;
+    output.dump(info);
+    output.dump(info);
+    EXPECT_EQ(output.kinds, (std::vector<uint32_t>{
+        statistics::Columnar::Schema, statistics::Columnar::Row,
+        statistics::Columnar::Row }));
+}
+
+/**
+ * A rescaled histogram keeps its number of buckets, but their bounds,
+ * and so the column names, change.
+ */
+TEST(StatsColumnarTest, HistogramRescale)
+{
+    TestDistInfo info;
+    TestColumnar output;
+    output.dump(info);
+
+    info.data.bucket_size = 2;
+    output.dump(info);
+
+    info.data.min = -4;
+    output.dump(info);
+
+    EXPECT_EQ(output.kinds, (std::vector<uint32_t>{
+        statistics::Columnar::Schema, statistics::Columnar::Row,
+        statistics::Columnar::Schema, statistics::Columnar::Row,
+        statistics::Columnar::Schema, statistics::Columnar::Row }));
+}
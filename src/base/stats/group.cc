@@ -105,6 +105,17 @@ Group::preDumpStats()
         g.second->preDumpStats();
 }
 
+void
+Group::prepareStats()
+{
+    // Stats of merged groups are also registered with this group.
+    for (auto &s : stats)
+        s->prepare();
+
+    for (auto &g : statGroups)
+        g.second->prepareStats();
+}
+
 void
 Group::addStat(statistics::Info *info)
 {
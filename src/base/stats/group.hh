@@ -154,6 +154,13 @@ class Group
      */
     virtual void preDumpStats();
 
+    /**
+     * Prepare all stats in this group and its sub-groups for
+     * dumping. This walks the tree in C++ instead of visiting every
+     * stat from Python.
+     */
+    void prepareStats();
+
     /**
      * Register a stat with this group. This method is normally called
      * automatically when a stat is instantiated.
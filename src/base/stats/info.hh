@@ -156,6 +156,19 @@ class Info
      */
     virtual bool zero() const = 0;
 
+    /**
+     * @return true if the stat may have changed between the two most
+     * recent calls to prepare(), i.e., since the previous stat dump
+     */
+    virtual bool changed() const { return true; }
+
+    /**
+     * @param stamp A value of InfoAccess::changeStamp().
+     * @return true if the stat may have changed since the stamp was
+     * taken, whether or not it has been prepared since
+     */
+    virtual bool changedSince(uint64_t stamp) const { return true; }
+
     /**
      * Visitor entry for outputing statistics data
      */
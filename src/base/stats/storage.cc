@@ -70,6 +70,7 @@ DistStor::sample(Counter val, int number)
     sum += val * number;
     squares += val * val * number;
     samples += number;
+    dirty = true;
 }
 
 void
@@ -203,6 +204,7 @@ HistStor::sample(Counter val, int number)
     squares += val * val * number;
     logs += std::log(val) * number;
     samples += number;
+    dirty = true;
 }
 
 void
@@ -217,13 +219,17 @@ HistStor::add(HistStor *hs)
     squares += hs->squares;
     samples += hs->samples;
 
-    while (bucket_size > hs->bucket_size)
+    while (bucket_size > hs->bucket_size) {
         hs->growUp();
+        hs->dirty = true;
+    }
     while (bucket_size < hs->bucket_size)
         growUp();
 
     for (uint32_t i = 0; i < b_size; i++)
         cvec[i] += hs->cvec[i];
+
+    dirty = true;
 }
 
 } // namespace statistics
@@ -58,6 +58,8 @@ class StatStor
   private:
     /** The statistic value. */
     Counter data;
+    /** Has the value been updated since the last prepare()? */
+    bool dirty;
 
   public:
     struct Params : public StorageParams {};
@@ -67,26 +69,26 @@ class StatStor
      * datatype.
      */
     StatStor(const StorageParams* const storage_params)
-        : data(Counter())
+        : data(Counter()), dirty(true)
     { }
 
     /**
      * The the stat to the given value.
      * @param val The new value.
      */
-    void set(Counter val) { data = val; }
+    void set(Counter val) { data = val; dirty = true; }
 
     /**
      * Increment the stat by the given value.
      * @param val The new value.
      */
-    void inc(Counter val) { data += val; }
+    void inc(Counter val) { data += val; dirty = true; }
 
     /**
      * Decrement the stat by the given value.
      * @param val The new value.
      */
-    void dec(Counter val) { data -= val; }
+    void dec(Counter val) { data -= val; dirty = true; }
 
     /**
      * Return the value of this stat as its base type.
@@ -100,15 +102,26 @@ class StatStor
      */
     Result result() const { return (Result)data; }
 
+    /**
+     * @return true if the value may have changed since the last call
+     * to prepare()
+     */
+    bool changed() const { return dirty; }
+
     /**
      * Prepare stat data for dumping or serialization
      */
-    void prepare(const StorageParams* const storage_params) { }
+    void prepare(const StorageParams* const storage_params) { dirty = false; }
 
     /**
      * Reset stat value to default
      */
-    void reset(const StorageParams* const storage_params) { data = Counter(); }
+    void
+    reset(const StorageParams* const storage_params)
+    {
+        dirty = dirty || data != Counter();
+        data = Counter();
+    }
 
     /**
      * @return true if zero value
@@ -192,6 +205,15 @@ class AvgStor
      */
     bool zero() const { return total == 0.0; }
 
+    /**
+     * The average changes with time unless nothing has been counted
+     * since the last reset.
+     *
+     * @return true if the value may have changed since the last call
+     * to prepare()
+     */
+    bool changed() const { return total != 0.0 || current != Counter(); }
+
     /**
      * Prepare stat data for dumping or serialization
      */
@@ -255,6 +277,8 @@ class DistStor
     Counter samples;
     /** Counter for each bucket. */
     VCounter cvec;
+    /** Has a sample been added since the last prepare()? */
+    bool dirty;
 
   public:
     /** The parameters for a distribution stat. */
@@ -285,7 +309,8 @@ class DistStor
     };
 
     DistStor(const StorageParams* const storage_params)
-        : cvec(safe_cast<const Params *>(storage_params)->buckets)
+        : cvec(safe_cast<const Params *>(storage_params)->buckets),
+          dirty(true)
     {
         reset(storage_params);
     }
@@ -313,9 +338,24 @@ class DistStor
         return samples == Counter();
     }
 
+    /**
+     * @return true if samples may have been added since the last call
+     * to prepare()
+     */
+    bool changed() const { return dirty; }
+
+    /**
+     * Copy the distribution to data. The copy is skipped if nothing
+     * has been sampled since the last call, in which case data is
+     * expected to hold the result of that call.
+     */
     void
     prepare(const StorageParams* const storage_params, DistData &data)
     {
+        if (!dirty)
+            return;
+        dirty = false;
+
         const Params *params = safe_cast<const Params *>(storage_params);
 
         assert(params->type == Dist);
@@ -344,6 +384,8 @@ class DistStor
     void
     reset(const StorageParams* const storage_params)
     {
+        dirty = dirty || samples != Counter();
+
         const Params *params = safe_cast<const Params *>(storage_params);
         min_track = params->min;
         max_track = params->max;
@@ -415,6 +457,8 @@ class HistStor
     Counter samples;
     /** Counter for each bucket. */
     VCounter cvec;
+    /** Has a sample been added since the last prepare()? */
+    bool dirty;
 
     /**
      * Given a bucket size B, and a range of values [0, N], this function
@@ -471,7 +515,8 @@ class HistStor
     };
 
     HistStor(const StorageParams* const storage_params)
-        : cvec(safe_cast<const Params *>(storage_params)->buckets)
+        : cvec(safe_cast<const Params *>(storage_params)->buckets),
+          dirty(true)
     {
         reset(storage_params);
     }
@@ -505,9 +550,24 @@ class HistStor
         return samples == Counter();
     }
 
+    /**
+     * @return true if samples may have been added since the last call
+     * to prepare()
+     */
+    bool changed() const { return dirty; }
+
+    /**
+     * Copy the distribution to data. The copy is skipped if nothing
+     * has been sampled since the last call, in which case data is
+     * expected to hold the result of that call.
+     */
     void
     prepare(const StorageParams* const storage_params, DistData &data)
     {
+        if (!dirty)
+            return;
+        dirty = false;
+
         const Params *params = safe_cast<const Params *>(storage_params);
 
         assert(params->type == Hist);
@@ -536,6 +596,10 @@ class HistStor
     void
     reset(const StorageParams* const storage_params)
     {
+        // merging a histogram may have grown the buckets without samples
+        dirty = dirty || samples != Counter() || min_bucket != 0 ||
+            bucket_size != 1;
+
         const Params *params = safe_cast<const Params *>(storage_params);
         min_bucket = 0;
         max_bucket = params->buckets - 1;
@@ -565,6 +629,8 @@ class SampleStor
     Counter squares;
     /** The number of samples. */
     Counter samples;
+    /** Has a sample been added since the last prepare()? */
+    bool dirty;
 
   public:
     struct Params : public DistParams
@@ -576,7 +642,7 @@ class SampleStor
      * Create and initialize this storage.
      */
     SampleStor(const StorageParams* const storage_params)
-        : sum(Counter()), squares(Counter()), samples(Counter())
+        : sum(Counter()), squares(Counter()), samples(Counter()), dirty(true)
     { }
 
     /**
@@ -592,6 +658,7 @@ class SampleStor
         sum += val * number;
         squares += val * val * number;
         samples += number;
+        dirty = true;
     }
 
     /**
@@ -606,6 +673,12 @@ class SampleStor
      */
     bool zero() const { return samples == Counter(); }
 
+    /**
+     * @return true if samples may have been added since the last call
+     * to prepare()
+     */
+    bool changed() const { return dirty; }
+
     void
     prepare(const StorageParams* const storage_params, DistData &data)
     {
@@ -616,6 +689,7 @@ class SampleStor
         data.sum = sum;
         data.squares = squares;
         data.samples = samples;
+        dirty = false;
     }
 
     /**
@@ -624,6 +698,7 @@ class SampleStor
     void
     reset(const StorageParams* const storage_params)
     {
+        dirty = dirty || samples != Counter();
         sum = Counter();
         squares = Counter();
         samples = Counter();
@@ -680,6 +755,15 @@ class AvgSampleStor
      */
     bool zero() const { return sum == Counter(); }
 
+    /**
+     * The per-tick mean and variance change with time unless nothing
+     * has been sampled since the last reset.
+     *
+     * @return true if the value may have changed since the last call
+     * to prepare()
+     */
+    bool changed() const { return sum != Counter(); }
+
     void
     prepare(const StorageParams* const storage_params, DistData &data)
     {
@@ -717,6 +801,8 @@ class SparseHistStor
     Counter samples;
     /** Counter for each bucket. */
     MCounter cmap;
+    /** Has a sample been added since the last prepare()? */
+    bool dirty;
 
   public:
     /** The parameters for a sparse histogram stat. */
@@ -726,6 +812,7 @@ class SparseHistStor
     };
 
     SparseHistStor(const StorageParams* const storage_params)
+        : dirty(true)
     {
         reset(storage_params);
     }
@@ -740,6 +827,7 @@ class SparseHistStor
     {
         cmap[val] += number;
         samples += number;
+        dirty = true;
     }
 
     /**
@@ -758,9 +846,23 @@ class SparseHistStor
         return samples == Counter();
     }
 
+    /**
+     * @return true if samples may have been added since the last call
+     * to prepare()
+     */
+    bool changed() const { return dirty; }
+
+    /**
+     * Copy the histogram to data unless nothing has been sampled since
+     * the last call.
+     */
     void
     prepare(const StorageParams* const storage_params, SparseHistData &data)
     {
+        if (!dirty)
+            return;
+        dirty = false;
+
         MCounter::iterator it;
         data.cmap.clear();
         for (it = cmap.begin(); it != cmap.end(); it++) {
@@ -776,6 +878,7 @@ class SparseHistStor
     void
     reset(const StorageParams* const storage_params)
     {
+        dirty = dirty || samples != Counter();
         cmap.clear();
         samples = 0;
     }
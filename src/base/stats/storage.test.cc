@@ -129,6 +129,37 @@ TEST(StatsStatStorTest, ZeroReset)
     ASSERT_FALSE(stor.zero());
 }
 
+/**
+ * Test that updates mark the storage as changed until the next prepare,
+ * and that resetting an unchanged zero value doesn't.
+ */
+TEST(StatsStatStorTest, Changed)
+{
+    statistics::StatStor stor(nullptr);
+
+    // New storage must be reported at least once
+    ASSERT_TRUE(stor.changed());
+    stor.prepare(nullptr);
+    ASSERT_FALSE(stor.changed());
+
+    stor.reset(nullptr);
+    ASSERT_FALSE(stor.changed());
+
+    stor.inc(1);
+    ASSERT_TRUE(stor.changed());
+    stor.prepare(nullptr);
+    ASSERT_FALSE(stor.changed());
+
+    stor.set(5);
+    ASSERT_TRUE(stor.changed());
+    stor.prepare(nullptr);
+
+    stor.reset(nullptr);
+    ASSERT_TRUE(stor.changed());
+    stor.prepare(nullptr);
+    ASSERT_FALSE(stor.changed());
+}
+
 /** Test setting and getting a value to the storage. */
 TEST(StatsAvgStorTest, SetValueResult)
 {
@@ -471,6 +502,41 @@ TEST(StatsDistStorTest, Reset)
     checkExpectedDistData(data, expected_data, true);
 }
 
+/**
+ * Test that samples mark the storage as changed, and that preparing an
+ * unchanged storage leaves the previously prepared data untouched.
+ */
+TEST(StatsDistStorTest, Changed)
+{
+    statistics::DistStor::Params params(0, 99, 5);
+    statistics::DistStor stor(&params);
+    statistics::DistData data;
+
+    ASSERT_TRUE(stor.changed());
+    stor.prepare(&params, data);
+    ASSERT_FALSE(stor.changed());
+
+    stor.sample(10, 3);
+    ASSERT_TRUE(stor.changed());
+    stor.prepare(&params, data);
+    ASSERT_FALSE(stor.changed());
+    ASSERT_EQ(data.samples, 3);
+
+    // Clobber the prepared data; it must not be rewritten
+    data.samples = 1234;
+    stor.prepare(&params, data);
+    ASSERT_EQ(data.samples, 1234);
+
+    stor.reset(&params);
+    ASSERT_TRUE(stor.changed());
+    stor.prepare(&params, data);
+    ASSERT_EQ(data.samples, 0);
+
+    // Resetting an empty storage leaves nothing to prepare
+    stor.reset(&params);
+    ASSERT_FALSE(stor.changed());
+}
+
 #if TRACING_ON
 /** Test that an assertion is thrown when not enough buckets are provided. */
 TEST(StatsHistStorDeathTest, NotEnoughBuckets0)
@@ -970,6 +1036,55 @@ TEST(StatsHistStorTest, Add)
     checkExpectedDistData(merge_data, expected_data, false);
 }
 
+/** Test that merging storages marks both as changed. */
+TEST(StatsHistStorTest, AddChanged)
+{
+    statistics::HistStor::Params params(4);
+    statistics::DistData data;
+
+    statistics::HistStor stor(&params);
+    stor.sample(3, 1);
+    stor.prepare(&params, data);
+
+    statistics::HistStor stor2(&params);
+    stor2.sample(95, 1);
+    stor2.prepare(&params, data);
+
+    ASSERT_FALSE(stor.changed());
+    ASSERT_FALSE(stor2.changed());
+
+    // The buckets of stor are grown to match stor2, and stor2 itself is
+    // left unchanged
+    stor.add(&stor2);
+    ASSERT_TRUE(stor.changed());
+    ASSERT_FALSE(stor2.changed());
+}
+
+/** Test that only resetting a sampled histogram marks it as changed. */
+TEST(StatsHistStorTest, ResetChanged)
+{
+    statistics::HistStor::Params params(4);
+    statistics::HistStor stor(&params);
+    statistics::DistData data;
+
+    stor.prepare(&params, data);
+    stor.reset(&params);
+    ASSERT_FALSE(stor.changed());
+
+    // Grow the buckets, so that the reset must shrink them back
+    stor.sample(95, 1);
+    stor.prepare(&params, data);
+    ASSERT_FALSE(stor.changed());
+    stor.reset(&params);
+    ASSERT_TRUE(stor.changed());
+    stor.prepare(&params, data);
+    ASSERT_EQ(data.samples, 0);
+    ASSERT_EQ(data.bucket_size, 1);
+
+    stor.reset(&params);
+    ASSERT_FALSE(stor.changed());
+}
+
 /**
  * Test whether zero is correctly set as the reset value. The test order is
  * to check if it is initially zero on creation, then it is made non zero,
@@ -1214,3 +1329,22 @@ TEST(StatsSparseHistStorTest, SamplePrepare)
     }
     ASSERT_EQ(data.samples, total_samples);
 }
+
+/** Test that only resetting a sampled histogram marks it as changed. */
+TEST(StatsSparseHistStorTest, ResetChanged)
+{
+    statistics::SparseHistStor stor(nullptr);
+    statistics::SparseHistData data;
+
+    stor.prepare(nullptr, data);
+    stor.reset(nullptr);
+    ASSERT_FALSE(stor.changed());
+
+    stor.sample(10, 5);
+    stor.prepare(nullptr, data);
+    stor.reset(nullptr);
+    ASSERT_TRUE(stor.changed());
+    stor.prepare(nullptr, data);
+    ASSERT_EQ(data.cmap.size(), 0);
+    ASSERT_EQ(data.samples, 0);
+}
@@ -73,7 +73,8 @@ namespace statistics
 std::list<Info *> &statsList();
 
 Text::Text()
-    : mystream(false), stream(NULL), descriptions(false), spaces(false)
+    : mystream(false), stream(NULL), descriptions(false), spaces(false),
+      changedOnly(false)
 {
 }
 
@@ -174,6 +175,9 @@ Text::noOutput(const Info &info)
     if (info.prereq && info.prereq->zero())
         return true;
 
+    if (changedOnly && !info.changed())
+        return true;
+
     return false;
 }
 
@@ -801,7 +805,8 @@ Text::visit(const SparseHistInfo &info)
 }
 
 Output *
-initText(const std::string &filename, bool desc, bool spaces)
+initText(const std::string &filename, bool desc, bool spaces,
+         bool changed_only)
 {
     static Text text;
     static bool connected = false;
@@ -811,6 +816,7 @@ initText(const std::string &filename, bool desc, bool spaces)
         text.descriptions = desc;
         text.enableUnits = desc; // the units are printed if descs are
         text.spaces = spaces;
+        text.changedOnly = changed_only;
         connected = true;
     }
 
@@ -41,6 +41,7 @@
 #include "base/debug.hh"
 #include "base/logging.hh"
 #include "base/match.hh"
+#include "base/trace_record.hh"
 #include "base/types.hh"
 #include "sim/cur_tick.hh"
 
@@ -63,6 +64,9 @@ class Logger
     ObjectMatch ignore;
     /** Name match for objects to activate log */
     ObjectMatch activate;
+    /** If set, messages are recorded in binary form instead of being
+     *  formatted */
+    Recorder *recorder = nullptr;
 
     bool isEnabled(const std::string &name) const
     {
@@ -96,6 +100,10 @@ class Logger
     {
         if (!isEnabled(name))
             return;
+        if (recorder) {
+            recorder->record(when, name, flag, fmt, args...);
+            return;
+        }
         std::ostringstream line;
         ccprintf(line, fmt, args...);
         logMessage(when, name, flag, line.str());
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ * Renders a binary debug trace, written with --debug-format=binary, to
+ * text:
+ *
+ *   tracedecode [--start TICK] [--end TICK] [--flags FLAG[,FLAG]] TRACE
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "base/trace_reader.hh"
+
+namespace
+{
+
+void
+usage(const char *prog)
+{
+    std::cerr << "Usage: " << prog
+              << " [--start TICK] [--end TICK] [--flags FLAG[,FLAG]] TRACE"
+              << std::endl;
+    std::exit(2);
+}
+
+} // anonymous namespace
+
+int
+main(int argc, char *argv[])
+{
+    gem5::trace::TraceFilter filter;
+    const char *path = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--start" && i + 1 < argc) {
+            filter.start = std::strtoull(argv[++i], nullptr, 0);
+        } else if (arg == "--end" && i + 1 < argc) {
+            filter.end = std::strtoull(argv[++i], nullptr, 0);
+        } else if (arg == "--flags" && i + 1 < argc) {
+            std::istringstream flags(argv[++i]);
+            std::string flag;
+            while (std::getline(flags, flag, ','))
+                filter.flags.insert(flag);
+        } else if (!path && arg[0] != '-') {
+            path = argv[i];
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (!path)
+        usage(argv[0]);
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::cerr << "Can't open " << path << std::endl;
+        return 1;
+    }
+
+    gem5::trace::TraceReader reader(in);
+    if (!reader.readHeader() || !reader.render(std::cout, filter)) {
+        std::cout.flush();
+        std::cerr << path << ": " << reader.error() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,295 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "base/trace_reader.hh"
+
+#include <cstring>
+
+#include "base/cprintf.hh"
+#include "base/trace_record.hh"
+
+namespace gem5
+{
+
+namespace trace
+{
+
+namespace
+{
+
+/** Reads values from a record, checking its bounds. */
+class Cursor
+{
+  private:
+    const uint8_t *pos;
+    const uint8_t *end;
+
+  public:
+    Cursor(const uint8_t *data, size_t size) : pos(data), end(data + size)
+    {}
+
+    const uint8_t *data() const { return pos; }
+    size_t left() const { return end - pos; }
+
+    template <typename T>
+    bool
+    get(T &value)
+    {
+        if (left() < sizeof(T))
+            return false;
+        std::memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    bool
+    getString(std::string &str, size_t len)
+    {
+        if (left() < len)
+            return false;
+        str.assign(reinterpret_cast<const char *>(pos), len);
+        pos += len;
+        return true;
+    }
+};
+
+template <typename T>
+bool
+addArg(cp::Print &print, Cursor &cursor)
+{
+    T value;
+    if (!cursor.get(value))
+        return false;
+    print.addArg(value);
+    return true;
+}
+
+} // anonymous namespace
+
+bool
+TraceReader::fail(const std::string &msg)
+{
+    _error = msg;
+    return false;
+}
+
+bool
+TraceReader::readHeader()
+{
+    binary::FileHeader header;
+    in.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!in || std::memcmp(header.magic, binary::magic,
+                           sizeof(header.magic)) != 0) {
+        return fail("Not a binary debug trace");
+    }
+    if (header.version != binary::version) {
+        return fail(csprintf("Unsupported trace version %d",
+                             header.version));
+    }
+    if (header.byteOrderMark != binary::byteOrderMark ||
+            header.longSize != sizeof(long)) {
+        return fail("Trace was written on a host with a different ABI");
+    }
+    return true;
+}
+
+void
+TraceReader::addString(uint32_t id, const std::string &str)
+{
+    strings[id] = str;
+}
+
+const std::string &
+TraceReader::lookup(uint32_t id)
+{
+    static const std::string unknown("<unknown>");
+    auto it = strings.find(id);
+    return it == strings.end() ? unknown : it->second;
+}
+
+bool
+TraceReader::render(std::ostream &out, const TraceFilter &filter)
+{
+    std::vector<uint8_t> block;
+    while (true) {
+        uint32_t thread, size;
+        in.read(reinterpret_cast<char *>(&thread), sizeof(thread));
+        if (in.gcount() == 0 && in.eof())
+            return true;
+        in.read(reinterpret_cast<char *>(&size), sizeof(size));
+        if (!in)
+            return fail("Truncated block header");
+        block.resize(size);
+        in.read(reinterpret_cast<char *>(block.data()), size);
+        if (!in)
+            return fail("Truncated block");
+        if (!renderRecords(out, filter, block.data(), size))
+            return false;
+    }
+}
+
+bool
+TraceReader::renderRecords(std::ostream &out, const TraceFilter &filter,
+                           const uint8_t *data, size_t size)
+{
+    size_t offset = 0;
+    while (offset < size) {
+        uint32_t record_size;
+        if (size - offset < sizeof(record_size))
+            return fail("Corrupt record");
+        std::memcpy(&record_size, data + offset, sizeof(record_size));
+        if (record_size <= sizeof(record_size) ||
+                record_size > size - offset) {
+            return fail("Corrupt record");
+        }
+        Cursor cursor(data + offset + sizeof(record_size),
+                      record_size - sizeof(record_size));
+        offset += record_size;
+
+        uint8_t kind;
+        cursor.get(kind);
+        if (kind == binary::String) {
+            uint32_t id;
+            std::string str;
+            if (!cursor.get(id) || !cursor.getString(str, cursor.left()))
+                return fail("Corrupt string record");
+            strings[id] = str;
+            continue;
+        }
+
+        uint8_t flags;
+        uint64_t when;
+        uint32_t name_id, flag_id, fmt_id = 0;
+        if ((kind != binary::Message && kind != binary::Text) ||
+                !cursor.get(flags) || !cursor.get(when) ||
+                !cursor.get(name_id) || !cursor.get(flag_id) ||
+                (kind == binary::Message && !cursor.get(fmt_id))) {
+            return fail("Corrupt message record");
+        }
+
+        const std::string &flag = lookup(flag_id);
+        if (when != MaxTick && (when < filter.start || when > filter.end))
+            continue;
+        if (!filter.flags.empty() && !filter.flags.count(flag))
+            continue;
+
+        // Same layout as OstreamLogger::logMessage().
+        if (!(flags & binary::TicksOff) && when != MaxTick)
+            ccprintf(out, "%7d: ", when);
+        if ((flags & binary::ShowFlag) && !flag.empty())
+            out << flag << ": ";
+        const std::string &name = lookup(name_id);
+        if (!name.empty())
+            out << name << ": ";
+
+        if (kind == binary::Text) {
+            out.write(reinterpret_cast<const char *>(cursor.data()),
+                      cursor.left());
+        } else if (!renderMessage(out, lookup(fmt_id), cursor.data(),
+                                  cursor.left())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+TraceReader::renderMessage(std::ostream &out, const std::string &fmt,
+                           const uint8_t *data, size_t size)
+{
+    Cursor cursor(data, size);
+    uint8_t count;
+    if (!cursor.get(count))
+        return fail("Corrupt message record");
+
+    cp::Print print(out, fmt);
+    for (int i = 0; i < count; ++i) {
+        uint8_t type;
+        bool ok = cursor.get(type);
+        switch (ok ? type : 0) {
+          case binary::Bool: ok = addArg<bool>(print, cursor); break;
+          case binary::Char: ok = addArg<char>(print, cursor); break;
+          case binary::SignedChar:
+            ok = addArg<signed char>(print, cursor);
+            break;
+          case binary::UnsignedChar:
+            ok = addArg<unsigned char>(print, cursor);
+            break;
+          case binary::Short: ok = addArg<short>(print, cursor); break;
+          case binary::UnsignedShort:
+            ok = addArg<unsigned short>(print, cursor);
+            break;
+          case binary::Int: ok = addArg<int>(print, cursor); break;
+          case binary::UnsignedInt:
+            ok = addArg<unsigned int>(print, cursor);
+            break;
+          case binary::Long: ok = addArg<long>(print, cursor); break;
+          case binary::UnsignedLong:
+            ok = addArg<unsigned long>(print, cursor);
+            break;
+          case binary::LongLong:
+            ok = addArg<long long>(print, cursor);
+            break;
+          case binary::UnsignedLongLong:
+            ok = addArg<unsigned long long>(print, cursor);
+            break;
+          case binary::Float: ok = addArg<float>(print, cursor); break;
+          case binary::Double: ok = addArg<double>(print, cursor); break;
+          case binary::CString:
+            {
+                uint32_t len;
+                std::string str;
+                ok = cursor.get(len) && cursor.getString(str, len);
+                if (ok)
+                    print.addArg(str.c_str());
+            }
+            break;
+          case binary::Pointer:
+            {
+                uint64_t addr;
+                ok = cursor.get(addr);
+                if (ok) {
+                    print.addArg(reinterpret_cast<const void *>(
+                                (uintptr_t)addr));
+                }
+            }
+            break;
+          default:
+            ok = false;
+            break;
+        }
+        if (!ok)
+            return fail("Corrupt message arguments");
+    }
+    print.endArgs();
+    return true;
+}
+
+} // namespace trace
+} // namespace gem5
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __BASE_TRACE_READER_HH__
+#define __BASE_TRACE_READER_HH__
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "base/types.hh"
+
+namespace gem5
+{
+
+namespace trace
+{
+
+/** Messages to render, all of them by default */
+struct TraceFilter
+{
+    Tick start = 0;
+    Tick end = MaxTick;
+    /** Render messages with these flags only, if not empty */
+    std::set<std::string> flags;
+};
+
+/**
+ * Renders binary debug traces (see trace_record.hh) to the text that
+ * the OstreamLogger would have written. Messages are formatted with
+ * cprintf, using the types the arguments were logged with. Records
+ * of different threads are rendered in the order their blocks were
+ * written.
+ */
+class TraceReader
+{
+  private:
+    std::istream &in;
+    std::string _error;
+    std::unordered_map<uint32_t, std::string> strings;
+
+    bool fail(const std::string &msg);
+    const std::string &lookup(uint32_t id);
+    bool renderRecords(std::ostream &out, const TraceFilter &filter,
+                       const uint8_t *data, size_t size);
+    bool renderMessage(std::ostream &out, const std::string &fmt,
+                       const uint8_t *data, size_t size);
+
+  public:
+    TraceReader(std::istream &in) : in(in) {}
+
+    /**
+     * Check the header of the trace. Records may come from another
+     * trace, e.g., a dump of a flight recorder, if the strings they
+     * use were defined with addString().
+     */
+    bool readHeader();
+
+    /** Define a string used by the records that follow. */
+    void addString(uint32_t id, const std::string &str);
+
+    /** Render all remaining blocks. */
+    bool render(std::ostream &out, const TraceFilter &filter=TraceFilter());
+
+    /** Render a sequence of records, e.g., the contents of a buffer. */
+    bool
+    render(std::ostream &out, const std::vector<uint8_t> &records,
+           const TraceFilter &filter=TraceFilter())
+    {
+        return renderRecords(out, filter, records.data(), records.size());
+    }
+
+    /** Description of the last error */
+    const std::string &error() const { return _error; }
+};
+
+} // namespace trace
+} // namespace gem5
+
+#endif // __BASE_TRACE_READER_HH__
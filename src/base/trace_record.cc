@@ -0,0 +1,315 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "base/trace_record.hh"
+
+#include <algorithm>
+#include <thread>
+
+#include "base/intmath.hh"
+#include "base/logging.hh"
+#include "debug/FmtFlag.hh"
+#include "debug/FmtTicksOff.hh"
+
+namespace gem5
+{
+
+namespace trace
+{
+
+RecordBuffer::RecordBuffer(size_t capacity, bool lossless)
+    : data(1ULL << ceilLog2(std::max<size_t>(capacity, 4096))),
+      mask(data.size() - 1), lossless(lossless), head(0), tail(0)
+{
+}
+
+void
+RecordBuffer::copyIn(uint64_t pos, const uint8_t *src, size_t size)
+{
+    const size_t offset = pos & mask;
+    const size_t first = std::min(size, data.size() - offset);
+    std::memcpy(data.data() + offset, src, first);
+    std::memcpy(data.data(), src + first, size - first);
+}
+
+void
+RecordBuffer::copyOut(uint64_t pos, uint8_t *dst, size_t size) const
+{
+    const size_t offset = pos & mask;
+    const size_t first = std::min(size, data.size() - offset);
+    std::memcpy(dst, data.data() + offset, first);
+    std::memcpy(dst + first, data.data(), size - first);
+}
+
+bool
+RecordBuffer::push(const uint8_t *src, size_t size)
+{
+    if (size > data.size() / 2)
+        return false;
+
+    const uint64_t pos = head.load(std::memory_order_relaxed);
+    if (lossless) {
+        // Wait for the consumer to make room.
+        while (pos + size - tail.load(std::memory_order_acquire) >
+               data.size()) {
+            std::this_thread::yield();
+        }
+    } else {
+        // Drop the oldest records.
+        uint64_t first = tail.load(std::memory_order_relaxed);
+        while (pos + size - first > data.size()) {
+            uint32_t record_size;
+            copyOut(first, reinterpret_cast<uint8_t *>(&record_size),
+                    sizeof(record_size));
+            first += record_size;
+        }
+        tail.store(first, std::memory_order_release);
+    }
+
+    copyIn(pos, src, size);
+    head.store(pos + size, std::memory_order_release);
+    return true;
+}
+
+size_t
+RecordBuffer::drain(std::vector<uint8_t> &out)
+{
+    const uint64_t first = tail.load(std::memory_order_relaxed);
+    const uint64_t last = head.load(std::memory_order_acquire);
+    const size_t size = last - first;
+    if (size) {
+        const size_t pos = out.size();
+        out.resize(pos + size);
+        copyOut(first, out.data() + pos, size);
+        tail.store(last, std::memory_order_release);
+    }
+    return size;
+}
+
+void
+RecordBuffer::snapshot(std::vector<uint8_t> &out) const
+{
+    const uint64_t last = head.load(std::memory_order_acquire);
+    const uint64_t first = tail.load(std::memory_order_acquire);
+    const size_t pos = out.size();
+    out.resize(pos + (last - first));
+    copyOut(first, out.data() + pos, last - first);
+}
+
+std::array<RecordBuffer::Span, 2>
+RecordBuffer::spans() const
+{
+    const uint64_t last = head.load(std::memory_order_acquire);
+    const uint64_t first = tail.load(std::memory_order_acquire);
+    const size_t size = last - first;
+    const size_t offset = first & mask;
+    const size_t first_size = std::min(size, data.size() - offset);
+    return {{ { data.data() + offset, first_size },
+              { data.data(), size - first_size } }};
+}
+
+namespace
+{
+
+std::atomic<uint64_t> nextSerial(1);
+
+} // anonymous namespace
+
+Recorder::Recorder(size_t buffer_size, bool lossless)
+    : serial(nextSerial++), bufferSize(buffer_size), lossless(lossless)
+{
+}
+
+Recorder::~Recorder()
+{
+}
+
+Recorder::ThreadState &
+Recorder::threadState()
+{
+    // A thread may log to several recorders, e.g., a trace file and
+    // a flight recorder.
+    thread_local std::unordered_map<uint64_t, ThreadState> states;
+    thread_local ThreadState *last = nullptr;
+    if (last && last->owner == serial)
+        return *last;
+
+    ThreadState &state = states[serial];
+    if (state.owner != serial) {
+        // First message of this thread.
+        std::lock_guard<std::mutex> lock(mutex);
+        state.owner = serial;
+        state.thread = buffers.size();
+        buffers.emplace_back(new RecordBuffer(bufferSize, lossless));
+        state.buffer = buffers.back().get();
+    }
+    last = &state;
+    return state;
+}
+
+uint32_t
+Recorder::intern(ThreadState &ts, const std::string &str)
+{
+    auto it = ts.ids.find(str);
+    if (it != ts.ids.end())
+        return it->second;
+
+    uint32_t id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto res = stringIds.emplace(str, strings.size());
+        if (res.second)
+            strings.push_back(str);
+        id = res.first->second;
+    }
+    ts.ids.emplace(str, id);
+
+    // Define the string for the decoder.
+    const size_t start = beginRecord(ts.scratch, binary::String);
+    put<uint32_t>(ts.scratch, id);
+    putBytes(ts.scratch, str.data(), str.size());
+    endRecord(ts.scratch, start);
+    return id;
+}
+
+uint32_t
+Recorder::internFormat(ThreadState &ts, const char *fmt)
+{
+    // Format strings are almost always literals, look them up by
+    // address. Check the contents in case a buffer was reused.
+    auto it = ts.formats.find(fmt);
+    if (it != ts.formats.end() && it->second.second == fmt)
+        return it->second.first;
+
+    const uint32_t id = intern(ts, fmt);
+    ts.formats[fmt] = std::make_pair(id, std::string(fmt));
+    return id;
+}
+
+void
+Recorder::commit(ThreadState &ts)
+{
+    if (ts.buffer->push(ts.scratch.data(), ts.scratch.size())) {
+        committed(*ts.buffer);
+    } else {
+        warn_once("Dropped a debug message that is too large for the "
+                  "trace buffer.\n");
+        // The strings it defined are lost too.
+        ts.ids.clear();
+        ts.formats.clear();
+    }
+}
+
+void
+Recorder::recordText(Tick when, const std::string &name,
+                     const std::string &flag, const std::string &text)
+{
+    ThreadState &ts = threadState();
+    ts.scratch.clear();
+    appendText(ts, when, name, flag, text);
+    commit(ts);
+}
+
+void
+Recorder::appendText(ThreadState &ts, Tick when, const std::string &name,
+                     const std::string &flag, const std::string &text)
+{
+    std::vector<uint8_t> &buf = ts.scratch;
+    const uint32_t name_id = intern(ts, name);
+    const uint32_t flag_id = intern(ts, flag);
+
+    const size_t start = beginRecord(buf, binary::Text);
+    put<uint8_t>(buf, messageFlags());
+    put<uint64_t>(buf, when);
+    put<uint32_t>(buf, name_id);
+    put<uint32_t>(buf, flag_id);
+    putBytes(buf, text.data(), text.size());
+    endRecord(buf, start);
+}
+
+void
+Recorder::appendHeader(std::vector<uint8_t> &out)
+{
+    put(out, binary::FileHeader());
+}
+
+uint8_t
+Recorder::messageFlags()
+{
+    return (debug::FmtTicksOff ? binary::TicksOff : 0) |
+        (debug::FmtFlag ? binary::ShowFlag : 0);
+}
+
+void
+Recorder::putBytes(std::vector<uint8_t> &buf, const char *data, size_t size)
+{
+    buf.insert(buf.end(), data, data + size);
+}
+
+size_t
+Recorder::beginRecord(std::vector<uint8_t> &buf, binary::RecordKind kind)
+{
+    const size_t start = buf.size();
+    put<uint32_t>(buf, 0);
+    put<uint8_t>(buf, kind);
+    return start;
+}
+
+void
+Recorder::endRecord(std::vector<uint8_t> &buf, size_t start)
+{
+    const uint32_t size = buf.size() - start;
+    std::memcpy(buf.data() + start, &size, sizeof(size));
+}
+
+RecorderStreamBuf::int_type
+RecorderStreamBuf::overflow(int_type c)
+{
+    if (traits_type::eq_int_type(c, traits_type::eof()))
+        return traits_type::not_eof(c);
+    const char ch = traits_type::to_char_type(c);
+    xsputn(&ch, 1);
+    return c;
+}
+
+std::streamsize
+RecorderStreamBuf::xsputn(const char *s, std::streamsize n)
+{
+    for (std::streamsize i = 0; i < n; ++i) {
+        line += s[i];
+        if (s[i] == '\n') {
+            recorder.recordText(MaxTick, "", "", line);
+            line.clear();
+        }
+    }
+    return n;
+}
+
+} // namespace trace
+} // namespace gem5
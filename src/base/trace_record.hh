@@ -0,0 +1,441 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __BASE_TRACE_RECORD_HH__
+#define __BASE_TRACE_RECORD_HH__
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "base/cprintf.hh"
+#include "base/types.hh"
+
+namespace gem5
+{
+
+namespace trace
+{
+
+/**
+ * Binary debug trace format. A trace file starts with a header and
+ * is followed by blocks of records written by one thread each:
+ *
+ *   header: char magic[8]; uint32 version; uint32 byte order mark;
+ *           uint32 sizeof(long)
+ *   block:  uint32 thread; uint32 size; records...
+ *   record: uint32 size; uint8 kind; payload
+ *
+ * String records define the strings (object names, flags and format
+ * strings) used by the records that follow them in the same thread,
+ * or by all records if they are in a block of their own:
+ *   uint32 id; char string[]
+ *
+ * Message records hold the raw arguments of a DPRINTF:
+ *   uint8 flags; uint64 tick; uint32 name; uint32 flag; uint32 format;
+ *   uint8 count; { uint8 type; value }[count]
+ *
+ * Text records hold messages that were formatted when they were
+ * logged, e.g., because an argument isn't a basic type:
+ *   uint8 flags; uint64 tick; uint32 name; uint32 flag; char text[]
+ *
+ * All values are in host byte order. Traces are rendered to text by
+ * the tracedecode tool.
+ */
+namespace binary
+{
+
+constexpr char magic[8] = { 'g', 'e', 'm', '5', 'd', 'b', 'g', '\0' };
+constexpr uint32_t version = 1;
+constexpr uint32_t byteOrderMark = 0x01020304;
+
+struct FileHeader
+{
+    char magic[8] = { 'g', 'e', 'm', '5', 'd', 'b', 'g', '\0' };
+    uint32_t version = binary::version;
+    uint32_t byteOrderMark = binary::byteOrderMark;
+    uint32_t longSize = sizeof(long);
+};
+
+enum RecordKind : uint8_t
+{
+    String = 1,
+    Message = 2,
+    Text = 3,
+};
+
+/** Output options in effect when a message was logged */
+enum MessageFlags : uint8_t
+{
+    TicksOff = 0x1,
+    ShowFlag = 0x2,
+};
+
+/**
+ * Types of the arguments that are stored in binary form. Arguments
+ * are decoded to the type they were logged with so that they are
+ * formatted exactly like cprintf would.
+ */
+enum ArgType : uint8_t
+{
+    Bool = 1,
+    Char,
+    SignedChar,
+    UnsignedChar,
+    Short,
+    UnsignedShort,
+    Int,
+    UnsignedInt,
+    Long,
+    UnsignedLong,
+    LongLong,
+    UnsignedLongLong,
+    Float,
+    Double,
+    /** uint32 length; char string[] */
+    CString,
+    /** uint64 address */
+    Pointer,
+};
+
+template <ArgType Type>
+struct SupportedArg
+{
+    static constexpr bool supported = true;
+    static constexpr ArgType type = Type;
+};
+
+struct UnsupportedArg
+{
+    static constexpr bool supported = false;
+};
+
+/** Other types are formatted when they are logged. */
+template <typename T>
+struct ArgTraits : UnsupportedArg {};
+
+/**
+ * Object pointers are printed as addresses. Pointers to unsigned and
+ * signed char are strings to cprintf, and function pointers aren't
+ * addresses to ostreams.
+ */
+template <typename T>
+struct ArgTraits<T *>
+    : std::conditional_t<!std::is_function_v<T> &&
+                         !std::is_same_v<std::remove_cv_t<T>, char> &&
+                         !std::is_same_v<std::remove_cv_t<T>, signed char> &&
+                         !std::is_same_v<std::remove_cv_t<T>, unsigned char>,
+                         SupportedArg<Pointer>, UnsupportedArg> {};
+
+template <> struct ArgTraits<bool> : SupportedArg<Bool> {};
+template <> struct ArgTraits<char> : SupportedArg<Char> {};
+template <> struct ArgTraits<signed char> : SupportedArg<SignedChar> {};
+template <> struct ArgTraits<unsigned char> : SupportedArg<UnsignedChar> {};
+template <> struct ArgTraits<short> : SupportedArg<Short> {};
+template <> struct ArgTraits<unsigned short> : SupportedArg<UnsignedShort> {};
+template <> struct ArgTraits<int> : SupportedArg<Int> {};
+template <> struct ArgTraits<unsigned int> : SupportedArg<UnsignedInt> {};
+template <> struct ArgTraits<long> : SupportedArg<Long> {};
+template <> struct ArgTraits<unsigned long> : SupportedArg<UnsignedLong> {};
+template <> struct ArgTraits<long long> : SupportedArg<LongLong> {};
+template <>
+struct ArgTraits<unsigned long long> : SupportedArg<UnsignedLongLong> {};
+template <> struct ArgTraits<float> : SupportedArg<Float> {};
+template <> struct ArgTraits<double> : SupportedArg<Double> {};
+template <> struct ArgTraits<char *> : SupportedArg<CString> {};
+template <> struct ArgTraits<const char *> : SupportedArg<CString> {};
+template <> struct ArgTraits<std::string> : SupportedArg<CString> {};
+
+} // namespace binary
+
+/**
+ * Per-thread buffer of binary trace records. Every buffer has a
+ * single producer, the thread that owns it. In lossless mode, a
+ * consumer drains the buffer concurrently and the producer waits
+ * when the buffer is full. Otherwise, the oldest records are
+ * dropped to make room for new ones.
+ */
+class RecordBuffer
+{
+  private:
+    std::vector<uint8_t> data;
+    const uint64_t mask;
+    const bool lossless;
+
+    /** Total number of bytes written */
+    std::atomic<uint64_t> head;
+    /** Total number of bytes consumed or dropped */
+    std::atomic<uint64_t> tail;
+
+    void copyIn(uint64_t pos, const uint8_t *src, size_t size);
+    void copyOut(uint64_t pos, uint8_t *dst, size_t size) const;
+
+  public:
+    /**
+     * @param capacity Buffer size, rounded up to a power of two.
+     * @param lossless Wait for a consumer rather than dropping old
+     * records.
+     */
+    RecordBuffer(size_t capacity, bool lossless);
+
+    size_t capacity() const { return data.size(); }
+
+    /** Number of bytes in the buffer */
+    size_t
+    used() const
+    {
+        return head.load(std::memory_order_acquire) -
+            tail.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Append complete records. Records that don't fit in half of the
+     * buffer are dropped.
+     *
+     * @return false if the records were dropped.
+     */
+    bool push(const uint8_t *src, size_t size);
+
+    /**
+     * Move the records that haven't been consumed yet to a vector.
+     *
+     * @return Number of bytes appended to out.
+     */
+    size_t drain(std::vector<uint8_t> &out);
+
+    /**
+     * Copy the records in the buffer, oldest first, without
+     * consuming them.
+     */
+    void snapshot(std::vector<uint8_t> &out) const;
+
+    struct Span
+    {
+        const uint8_t *data;
+        size_t size;
+    };
+
+    /**
+     * Locate the records in the buffer without copying them, e.g., in
+     * a signal handler. The records are the concatenation of the two
+     * spans.
+     */
+    std::array<Span, 2> spans() const;
+};
+
+/**
+ * Records debug messages in binary form: the tick, object name,
+ * flag and format string (which are replaced by ids) and the raw
+ * arguments. Formatting is deferred until the trace is decoded, which
+ * makes logging a message much cheaper than with cprintf.
+ *
+ * Every thread records to its own buffer, subclasses decide what to
+ * do with the buffers.
+ */
+class Recorder
+{
+  public:
+    /**
+     * @param buffer_size Size of the per-thread buffers.
+     * @param lossless See RecordBuffer.
+     */
+    Recorder(size_t buffer_size, bool lossless);
+    virtual ~Recorder();
+
+    Recorder(const Recorder &) = delete;
+    Recorder &operator=(const Recorder &) = delete;
+
+    /** Record a message. */
+    template <typename ...Args>
+    void
+    record(Tick when, const std::string &name, const std::string &flag,
+           const char *fmt, const Args &...args)
+    {
+        if constexpr ((binary::ArgTraits<std::decay_t<Args>>::supported &&
+                       ...)) {
+            ThreadState &ts = threadState();
+            std::vector<uint8_t> &buf = ts.scratch;
+            buf.clear();
+
+            // String records, if any, go before the message.
+            const uint32_t name_id = intern(ts, name);
+            const uint32_t flag_id = intern(ts, flag);
+            const uint32_t fmt_id = internFormat(ts, fmt);
+
+            const size_t start = beginRecord(buf, binary::Message);
+            put<uint8_t>(buf, messageFlags());
+            put<uint64_t>(buf, when);
+            put<uint32_t>(buf, name_id);
+            put<uint32_t>(buf, flag_id);
+            put<uint32_t>(buf, fmt_id);
+            put<uint8_t>(buf, sizeof...(Args));
+            if ((putArg(buf, args) && ...)) {
+                endRecord(buf, start);
+            } else {
+                // Keep the strings defined above.
+                buf.resize(start);
+                std::ostringstream line;
+                ccprintf(line, fmt, args...);
+                appendText(ts, when, name, flag, line.str());
+            }
+            commit(ts);
+        } else {
+            std::ostringstream line;
+            ccprintf(line, fmt, args...);
+            recordText(when, name, flag, line.str());
+        }
+    }
+
+    /** Record a message that has already been formatted. */
+    void recordText(Tick when, const std::string &name,
+                    const std::string &flag, const std::string &text);
+
+    /** Append the file header of binary traces to a vector. */
+    static void appendHeader(std::vector<uint8_t> &out);
+
+  protected:
+    struct ThreadState
+    {
+        /** Serial number of the recorder that owns this state */
+        uint64_t owner = 0;
+        uint32_t thread = 0;
+        RecordBuffer *buffer = nullptr;
+        /** Ids of the strings this thread has defined */
+        std::unordered_map<std::string, uint32_t> ids;
+        /** Ids and contents of format strings, by address */
+        std::unordered_map<const char *,
+                           std::pair<uint32_t, std::string>> formats;
+        /** Records under construction */
+        std::vector<uint8_t> scratch;
+    };
+
+    /** Buffers of all threads, indexed by ThreadState::thread */
+    std::vector<std::unique_ptr<RecordBuffer>> buffers;
+    /** Protects buffers and the string table */
+    mutable std::mutex mutex;
+
+    /** All strings, indexed by id */
+    std::vector<std::string> strings;
+
+    /** Called after records were appended to a thread's buffer. */
+    virtual void committed(RecordBuffer &buffer) {}
+
+  private:
+    const uint64_t serial;
+    const size_t bufferSize;
+    const bool lossless;
+    std::unordered_map<std::string, uint32_t> stringIds;
+
+    /** State of the calling thread, set up on first use. */
+    ThreadState &threadState();
+
+    uint32_t intern(ThreadState &ts, const std::string &str);
+    uint32_t internFormat(ThreadState &ts, const char *fmt);
+    void appendText(ThreadState &ts, Tick when, const std::string &name,
+                    const std::string &flag, const std::string &text);
+    void commit(ThreadState &ts);
+
+    /** Current MessageFlags, from the Fmt* debug flags */
+    static uint8_t messageFlags();
+
+    template <typename T>
+    static void
+    put(std::vector<uint8_t> &buf, const T &value)
+    {
+        const size_t pos = buf.size();
+        buf.resize(pos + sizeof(T));
+        std::memcpy(buf.data() + pos, &value, sizeof(T));
+    }
+
+    static void putBytes(std::vector<uint8_t> &buf, const char *data,
+                         size_t size);
+
+    template <typename T>
+    static bool
+    putArg(std::vector<uint8_t> &buf, const T &arg)
+    {
+        using Type = std::decay_t<T>;
+        constexpr binary::ArgType type = binary::ArgTraits<Type>::type;
+        put<uint8_t>(buf, type);
+        if constexpr (std::is_same_v<Type, std::string>) {
+            put<uint32_t>(buf, arg.size());
+            putBytes(buf, arg.data(), arg.size());
+        } else if constexpr (type == binary::CString) {
+            // Let cprintf deal with null strings.
+            if (!arg)
+                return false;
+            const size_t len = std::strlen(arg);
+            put<uint32_t>(buf, len);
+            putBytes(buf, arg, len);
+        } else if constexpr (type == binary::Pointer) {
+            put<uint64_t>(buf, reinterpret_cast<uintptr_t>(
+                        static_cast<const volatile void *>(arg)));
+        } else {
+            put<Type>(buf, arg);
+        }
+        return true;
+    }
+
+    /** Start a record, returns the position of its size field. */
+    static size_t beginRecord(std::vector<uint8_t> &buf,
+                              binary::RecordKind kind);
+    static void endRecord(std::vector<uint8_t> &buf, size_t start);
+};
+
+/**
+ * Stream buffer that records every line written to it as a message
+ * without a tick or name, for the getOstream() of recording loggers.
+ */
+class RecorderStreamBuf : public std::streambuf
+{
+  private:
+    Recorder &recorder;
+    std::string line;
+
+  protected:
+    int_type overflow(int_type c) override;
+    std::streamsize xsputn(const char *s, std::streamsize n) override;
+
+  public:
+    RecorderStreamBuf(Recorder &recorder) : recorder(recorder) {}
+};
+
+} // namespace trace
+} // namespace gem5
+
+#endif // __BASE_TRACE_RECORD_HH__
@@ -46,3 +46,17 @@ class NativeTrace(ExeTracer):
     type = "NativeTrace"
     cxx_class = "gem5::trace::NativeTrace"
     cxx_header = "cpu/nativetrace.hh"
+
+
+class CompactInstTrace(InstTracer):
+    type = "CompactInstTrace"
+    cxx_class = "gem5::trace::CompactInstTrace"
+    cxx_header = "cpu/compact_inst_trace.hh"
+
+    file_name = Param.String(
+        "insttrace.bin", "Instruction trace output file, may be shared"
+    )
+    chunk_insts = Param.Unsigned(
+        65536, "Number of instructions per compressed chunk"
+    )
+    compression = Param.Int(1, "zstd compression level, 0 to disable")
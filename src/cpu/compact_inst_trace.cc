@@ -0,0 +1,559 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "cpu/compact_inst_trace.hh"
+
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "base/loader/symtab.hh"
+#include "base/logging.hh"
+#include "base/output.hh"
+#include "config/have_zstd.hh"
+#include "cpu/base.hh"
+#include "cpu/static_inst.hh"
+#include "cpu/thread_context.hh"
+#include "debug/ExecEnable.hh"
+#include "enums/OpClass.hh"
+#include "sim/byteswap.hh"
+#include "sim/core.hh"
+
+#if HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace gem5
+{
+
+namespace trace {
+
+namespace
+{
+
+constexpr char magic[8] = { 'g', 'e', 'm', '5', 'i', 't', 'r', '\0' };
+constexpr uint32_t version = 1;
+
+enum RecordKind : uint8_t
+{
+    StreamRecord = 1,
+    ChunkRecord = 2,
+};
+
+enum Codec : uint8_t
+{
+    Raw = 0,
+    Zstd = 1,
+};
+
+/** Result kinds, as in InstRecord */
+constexpr uint8_t noData = 0;
+constexpr uint8_t dataDouble = 3;
+constexpr uint8_t dataReg = 5;
+
+/** Chunks waiting to be written, per file */
+constexpr size_t maxQueuedChunks = 8;
+
+template <typename T>
+void
+put(std::vector<uint8_t> &out, T value)
+{
+    value = htole(value);
+    const size_t pos = out.size();
+    out.resize(pos + sizeof(T));
+    std::memcpy(out.data() + pos, &value, sizeof(T));
+}
+
+/** Maximum size of a varint */
+constexpr size_t maxVarint = 10;
+
+uint8_t *
+encodeVarint(uint8_t *out, uint64_t value)
+{
+    while (value >= 0x80) {
+        *out++ = value | 0x80;
+        value >>= 7;
+    }
+    *out++ = value;
+    return out;
+}
+
+uint8_t *
+encodeDelta(uint8_t *out, uint64_t value, uint64_t base)
+{
+    const int64_t delta = value - base;
+    return encodeVarint(out,
+            ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+}
+
+/** Records freed for reuse */
+thread_local std::vector<void *> freeRecords;
+constexpr size_t maxFreeRecords = 4096;
+
+template <typename Column>
+void
+putVarint(Column &column, uint64_t value)
+{
+    column.commit(encodeVarint(column.reserve(maxVarint), value));
+}
+
+template <typename Column>
+void
+putDelta(Column &column, uint64_t value, uint64_t base)
+{
+    column.commit(encodeDelta(column.reserve(maxVarint), value, base));
+}
+
+template <typename Column>
+void
+putString(Column &column, const std::string &str)
+{
+    putVarint(column, str.size());
+    uint8_t *out = column.reserve(str.size());
+    std::memcpy(out, str.data(), str.size());
+    column.commit(out + str.size());
+}
+
+} // anonymous namespace
+
+/**
+ * Compresses and writes the chunks of all the tracers that share a
+ * file on a background thread.
+ */
+class CompactInstTrace::Writer
+{
+  private:
+    struct Task
+    {
+        RecordKind kind;
+        uint32_t stream;
+        uint32_t count;
+        std::vector<uint8_t> data;
+    };
+
+    const std::string path;
+    const int level;
+    std::ofstream out;
+    uint32_t streams = 0;
+
+    std::mutex mutex;
+    std::condition_variable work;
+    std::condition_variable space;
+    std::deque<Task> queue;
+    bool stopping = false;
+    std::thread thread;
+
+    void
+    run()
+    {
+        std::vector<uint8_t> record;
+        std::vector<uint8_t> buf;
+#if HAVE_ZSTD
+        ZSTD_CCtx *ctx = level > 0 ? ZSTD_createCCtx() : nullptr;
+        if (ctx)
+            ZSTD_CCtx_setParameter(ctx, ZSTD_c_compressionLevel, level);
+#endif
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            work.wait(lock, [this]() { return stopping || !queue.empty(); });
+            if (queue.empty())
+                break;
+            Task task = std::move(queue.front());
+            queue.pop_front();
+            lock.unlock();
+            space.notify_one();
+
+            record.clear();
+            put<uint8_t>(record, task.kind);
+            put<uint32_t>(record, task.stream);
+            if (task.kind == StreamRecord) {
+                put<uint32_t>(record, task.data.size());
+                record.insert(record.end(), task.data.begin(),
+                              task.data.end());
+            } else {
+                const uint8_t *data = task.data.data();
+                size_t size = task.data.size();
+                Codec codec = Raw;
+#if HAVE_ZSTD
+                if (ctx) {
+                    buf.resize(ZSTD_compressBound(size));
+                    const size_t ret = ZSTD_compress2(ctx, buf.data(),
+                            buf.size(), data, size);
+                    if (!ZSTD_isError(ret) && ret < size) {
+                        data = buf.data();
+                        size = ret;
+                        codec = Zstd;
+                    }
+                }
+#endif
+                put<uint32_t>(record, task.count);
+                put<uint8_t>(record, codec);
+                put<uint32_t>(record, task.data.size());
+                put<uint32_t>(record, size);
+                record.insert(record.end(), data, data + size);
+            }
+            out.write(reinterpret_cast<const char *>(record.data()),
+                      record.size());
+
+            lock.lock();
+        }
+#if HAVE_ZSTD
+        ZSTD_freeCCtx(ctx);
+#endif
+    }
+
+  public:
+    Writer(const std::string &path, int level)
+        : path(path), level(level),
+          out(path, std::ios::out | std::ios::binary | std::ios::trunc)
+    {
+        fatal_if(!out, "Can't open instruction trace file %s.", path);
+#if !HAVE_ZSTD
+        if (level > 0) {
+            warn("gem5 was built without zstd, the instruction trace %s "
+                 "won't be compressed.", path);
+        }
+#endif
+        std::vector<uint8_t> header(magic, magic + sizeof(magic));
+        put<uint32_t>(header, version);
+        put<uint64_t>(header, sim_clock::Frequency);
+        out.write(reinterpret_cast<const char *>(header.data()),
+                  header.size());
+
+        thread = std::thread([this]() { run(); });
+    }
+
+    ~Writer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        work.notify_one();
+        thread.join();
+        out.close();
+        fatal_if(!out, "Failed to write instruction trace file %s.", path);
+    }
+
+    /** Get the writer of a file, shared by the tracers that use it. */
+    static std::shared_ptr<Writer>
+    get(const std::string &path, int level)
+    {
+        static std::mutex writersMutex;
+        static std::map<std::string, std::weak_ptr<Writer>> writers;
+
+        std::lock_guard<std::mutex> lock(writersMutex);
+        std::shared_ptr<Writer> writer = writers[path].lock();
+        if (!writer) {
+            writer = std::make_shared<Writer>(path, level);
+            writers[path] = writer;
+        }
+        return writer;
+    }
+
+    uint32_t
+    newStream()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return streams++;
+    }
+
+    void
+    submit(RecordKind kind, uint32_t stream, uint32_t count,
+           std::vector<uint8_t> &&data)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        space.wait(lock, [this]() { return queue.size() < maxQueuedChunks; });
+        queue.push_back({kind, stream, count, std::move(data)});
+        lock.unlock();
+        work.notify_one();
+    }
+};
+
+void
+CompactInstTrace::Record::dump()
+{
+    // Trace macro-ops and instructions that aren't micro-ops, like
+    // InstPBTrace does.
+    if ((macroStaticInst && staticInst->isFirstMicroop()) ||
+            !staticInst->isMicroop()) {
+        tracer.beginInst(when, thread,
+                         macroStaticInst ? macroStaticInst : staticInst,
+                         pc->instAddr());
+    }
+    if (!tracer.pending)
+        return;
+
+    if (mem_valid)
+        tracer.pendingMem.push_back({addr, size, flags});
+
+    // Keep the result of the last micro-op that has one.
+    if (dataStatus == DataInvalid && predicate && !faulting)
+        return;
+
+    tracer.pendingStatus =
+        dataStatus | (predicate ? 0 : 0x10) | (faulting ? 0x20 : 0);
+    if (dataStatus == DataReg) {
+        if (data.asReg.isBlob()) {
+            tracer.pendingStatus |= 0x40;
+            tracer.pendingText = data.asReg.asString();
+        } else {
+            tracer.pendingValue = data.asReg.asRegVal();
+        }
+    } else {
+        tracer.pendingValue = data.asInt;
+    }
+}
+
+void *
+CompactInstTrace::Record::operator new(size_t size)
+{
+    if (size == sizeof(Record) && !freeRecords.empty()) {
+        void *ptr = freeRecords.back();
+        freeRecords.pop_back();
+        return ptr;
+    }
+    return ::operator new(size);
+}
+
+void
+CompactInstTrace::Record::operator delete(void *ptr, size_t size)
+{
+    if (size == sizeof(Record) && freeRecords.size() < maxFreeRecords)
+        freeRecords.push_back(ptr);
+    else
+        ::operator delete(ptr);
+}
+
+CompactInstTrace::CompactInstTrace(const CompactInstTraceParams &p)
+    : InstTracer(p), chunkInsts(p.chunk_insts),
+      writer(Writer::get(simout.resolve(p.file_name), p.compression))
+{
+    fatal_if(!chunkInsts, "%s: chunk_insts must not be 0.", name());
+    stream = writer->newStream();
+
+    // Write the last chunk and close the file on exit.
+    registerExitCallback([this]() { close(); });
+}
+
+CompactInstTrace::~CompactInstTrace()
+{
+    close();
+}
+
+InstRecord *
+CompactInstTrace::getInstRecord(Tick when, ThreadContext *tc,
+                                const StaticInstPtr si,
+                                const PCStateBase &pc, const StaticInstPtr mi)
+{
+    // Only record the trace if Exec debugging is enabled
+    if (!debug::ExecEnable || !writer)
+        return nullptr;
+
+    return new Record(*this, when, tc, si, pc, mi);
+}
+
+uint32_t
+CompactInstTrace::lookup(const StaticInstPtr &inst, Addr pc)
+{
+    // Most of the time, the next instruction is the one that followed
+    // the last one before.
+    if (nextId < dictInsts.size() && dictInsts[nextId].get() == inst.get() &&
+            dictPCs[nextId] == pc) {
+        return nextId;
+    }
+
+    auto it = dict.find(DictKey{inst.get(), pc});
+    return it != dict.end() ? it->second : define(inst, pc);
+}
+
+uint32_t
+CompactInstTrace::define(const StaticInstPtr &inst, Addr pc)
+{
+    const uint32_t id = dictInsts.size();
+    dict.emplace(DictKey{inst.get(), pc}, id);
+    dictInsts.push_back(inst);
+    dictPCs.push_back(pc);
+
+    ColumnBuffer &out = columns[Defs];
+    putDelta(out, pc, lastDefPC);
+    lastDefPC = pc;
+
+    uint8_t bytes[16];
+    std::vector<uint8_t> large;
+    uint8_t *code = bytes;
+    size_t size = inst->asBytes(bytes, sizeof(bytes));
+    if (size > sizeof(bytes)) {
+        large.resize(size);
+        code = large.data();
+        size = inst->asBytes(code, size);
+    }
+    putVarint(out, size);
+    uint8_t *dst = out.reserve(size);
+    std::memcpy(dst, code, size);
+    out.commit(dst + size);
+
+    putString(out, enums::OpClassStrings[inst->opClass()]);
+
+    putVarint(out, inst->numSrcRegs());
+    for (int i = 0; i < inst->numSrcRegs(); ++i) {
+        const RegId &reg = inst->srcRegIdx(i);
+        putString(out, reg.className());
+        putVarint(out, reg.index());
+    }
+    putVarint(out, inst->numDestRegs());
+    for (int i = 0; i < inst->numDestRegs(); ++i) {
+        const RegId &reg = inst->destRegIdx(i);
+        putString(out, reg.className());
+        putVarint(out, reg.index());
+    }
+
+    putString(out, inst->disassemble(pc, &loader::debugSymbolTable));
+    return id;
+}
+
+void
+CompactInstTrace::beginInst(Tick when, ThreadContext *tc,
+                            const StaticInstPtr &inst, Addr pc)
+{
+    if (pending)
+        endInst();
+
+    if (!named) {
+        const std::string &cpu = tc->getCpuPtr()->name();
+        writer->submit(StreamRecord, stream, 0,
+                       std::vector<uint8_t>(cpu.begin(), cpu.end()));
+        named = true;
+    }
+
+    const uint64_t id = lookup(inst, pc);
+    putDelta(columns[Ids], id, lastId + 1);
+    lastId = id;
+    nextId = id + 1;
+    putDelta(columns[Ticks], when, lastTick);
+    lastTick = when;
+    putVarint(columns[Contexts], tc->contextId());
+    pending = true;
+}
+
+void
+CompactInstTrace::endInst()
+{
+    ColumnBuffer &mem = columns[Mem];
+    putVarint(mem, pendingMem.size());
+    for (const auto &access : pendingMem) {
+        uint8_t *out = mem.reserve(3 * maxVarint);
+        out = encodeDelta(out, access.addr, lastMemEnd);
+        out = encodeVarint(out, access.size);
+        out = encodeVarint(out, access.flags);
+        mem.commit(out);
+        lastMemEnd = access.addr + access.size;
+    }
+    pendingMem.clear();
+
+    ColumnBuffer &data = columns[Data];
+    uint8_t *out = data.reserve(2 + maxVarint);
+    *out++ = pendingStatus & ~0x40;
+    switch (pendingStatus & 0xf) {
+      case noData:
+        data.commit(out);
+        break;
+      case dataDouble:
+        {
+            const uint64_t value = htole(pendingValue);
+            std::memcpy(out, &value, sizeof(value));
+            data.commit(out + sizeof(value));
+        }
+        break;
+      case dataReg:
+        *out++ = (pendingStatus & 0x40) ? 1 : 0;
+        if (pendingStatus & 0x40) {
+            data.commit(out);
+            putString(data, pendingText);
+        } else {
+            data.commit(encodeVarint(out, pendingValue));
+        }
+        break;
+      default:
+        data.commit(encodeVarint(out, pendingValue));
+        break;
+    }
+    pendingStatus = noData;
+
+    pending = false;
+    if (++count == chunkInsts)
+        flushChunk();
+}
+
+void
+CompactInstTrace::flushChunk()
+{
+    if (!count && !columns[Defs].size())
+        return;
+
+    size_t size = NumColumns * sizeof(uint32_t);
+    for (const auto &column : columns)
+        size += column.size();
+
+    std::vector<uint8_t> chunk;
+    chunk.reserve(size);
+    for (const auto &column : columns)
+        put<uint32_t>(chunk, column.size());
+    for (auto &column : columns) {
+        chunk.insert(chunk.end(), column.data(),
+                     column.data() + column.size());
+        column.clear();
+    }
+    writer->submit(ChunkRecord, stream, count, std::move(chunk));
+
+    count = 0;
+    lastId = -1;
+    lastTick = 0;
+    lastDefPC = 0;
+    lastMemEnd = 0;
+}
+
+void
+CompactInstTrace::close()
+{
+    if (!writer)
+        return;
+    if (pending)
+        endInst();
+    flushChunk();
+    writer.reset();
+}
+
+} // namespace trace
+} // namespace gem5
@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __CPU_COMPACT_INST_TRACE_HH__
+#define __CPU_COMPACT_INST_TRACE_HH__
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "arch/generic/pcstate.hh"
+#include "base/types.hh"
+#include "cpu/static_inst_fwd.hh"
+#include "params/CompactInstTrace.hh"
+#include "sim/insttracer.hh"
+
+namespace gem5
+{
+
+class ThreadContext;
+
+namespace trace {
+
+/**
+ * Instruction tracer that writes a compact, columnar binary trace. It
+ * is much cheaper than the ExeTracer, which formats every instruction,
+ * and the InstPBTrace, which builds a protobuf message for each of
+ * them. util/decode_compact_inst_trace.py converts traces to text and
+ * to the protobuf format of InstPBTrace.
+ *
+ * Like InstPBTrace, it records macro-ops and instructions that aren't
+ * micro-ops, with the memory accesses of all their micro-ops.
+ *
+ * File format, all integers little endian:
+ *
+ *   header: char magic[8] "gem5itr"; uint32 version; uint64 tick freq
+ *   record: uint8 kind; uint32 stream; payload
+ *
+ * Every tracer writes its own stream. Stream records name the CPU a
+ * stream belongs to:
+ *   uint32 length; char name[]
+ *
+ * Chunk records hold a number of consecutive instructions of a
+ * stream, compressed with zstd if the codec is 1:
+ *   uint32 count; uint8 codec; uint32 raw size; uint32 size; data
+ *
+ * The data of a chunk is a list of columns, each one prefixed by its
+ * size as an uint32. Columns are sequences of values, mostly
+ * LEB128 varints (v) and zigzag encoded varints for signed deltas (z):
+ *
+ *   Defs: new entries of the instruction dictionary of the stream,
+ *     one per distinct static instruction and PC:
+ *       z pc delta; v length, machine code; v length, op class name;
+ *       v count, {v length, register class name; v index}[count] for
+ *       the sources and again for the destinations; v length,
+ *       disassembly
+ *   Ids: z dictionary index delta, relative to the previous index
+ *     plus one (to 0 for the first instruction of a chunk) so that
+ *     straight line code is a sequence of zeros
+ *   Ticks: z tick delta
+ *   Contexts: v context id
+ *   Mem: v count, {z address delta; v size; v flags}[count], the
+ *     delta is relative to the end of the previous access
+ *   Data: uint8 status (InstRecord::DataStatus, 0x10 if not executed,
+ *     0x20 if faulting); v value for integers; 8 bytes for doubles;
+ *     for registers, uint8 0 and v value, or uint8 1 and v length,
+ *     text for vector registers
+ *
+ * Deltas reset at the start of every chunk, the dictionary does not.
+ */
+class CompactInstTrace : public InstTracer
+{
+  public:
+    class Writer;
+
+    enum Column
+    {
+        Defs,
+        Ids,
+        Ticks,
+        Contexts,
+        Mem,
+        Data,
+        NumColumns
+    };
+
+  private:
+    class Record : public InstRecord
+    {
+      private:
+        CompactInstTrace &tracer;
+
+      public:
+        Record(CompactInstTrace &tracer, Tick when, ThreadContext *tc,
+               const StaticInstPtr si, const PCStateBase &pc,
+               const StaticInstPtr mi)
+            : InstRecord(when, tc, si, pc, mi), tracer(tracer)
+        {}
+
+        /** Records are recycled, there is one per instruction. */
+        static void *operator new(size_t size);
+        static void operator delete(void *ptr, size_t size);
+
+        void dump() override;
+    };
+
+    /** Append-only buffer of a column */
+    class ColumnBuffer
+    {
+      private:
+        std::vector<uint8_t> buf;
+        size_t used = 0;
+
+      public:
+        /** Make room for n more bytes, returns where they go. */
+        uint8_t *
+        reserve(size_t n)
+        {
+            if (used + n > buf.size())
+                buf.resize(std::max(2 * buf.size(), used + n));
+            return buf.data() + used;
+        }
+
+        /** Add the bytes up to end. */
+        void commit(const uint8_t *end) { used = end - buf.data(); }
+
+        const uint8_t *data() const { return buf.data(); }
+        size_t size() const { return used; }
+        void clear() { used = 0; }
+    };
+
+    struct DictKey
+    {
+        const StaticInst *inst;
+        Addr pc;
+
+        bool
+        operator==(const DictKey &other) const
+        {
+            return inst == other.inst && pc == other.pc;
+        }
+    };
+
+    struct DictKeyHash
+    {
+        size_t
+        operator()(const DictKey &key) const
+        {
+            return std::hash<const StaticInst *>()(key.inst) ^
+                (key.pc * 0x9e3779b97f4a7c15ULL);
+        }
+    };
+
+    const size_t chunkInsts;
+    std::shared_ptr<Writer> writer;
+    uint32_t stream = 0;
+    bool named = false;
+
+    /** Instruction dictionary, which keeps its instructions alive */
+    std::unordered_map<DictKey, uint32_t, DictKeyHash> dict;
+    std::vector<StaticInstPtr> dictInsts;
+    std::vector<Addr> dictPCs;
+    /** Likely index of the next instruction, to skip the lookup */
+    uint64_t nextId = 0;
+
+    std::array<ColumnBuffer, NumColumns> columns;
+    size_t count = 0;
+
+    /** Delta state */
+    uint64_t lastId = -1;
+    Tick lastTick = 0;
+    Addr lastDefPC = 0;
+    Addr lastMemEnd = 0;
+
+    /** The mem and data columns of the last instruction are pending */
+    bool pending = false;
+    struct MemAccess
+    {
+        Addr addr;
+        Addr size;
+        unsigned flags;
+    };
+    std::vector<MemAccess> pendingMem;
+    /** Data column entry of the last instruction */
+    uint8_t pendingStatus = 0;
+    uint64_t pendingValue = 0;
+    std::string pendingText;
+
+    uint32_t lookup(const StaticInstPtr &inst, Addr pc);
+    uint32_t define(const StaticInstPtr &inst, Addr pc);
+    void beginInst(Tick when, ThreadContext *tc, const StaticInstPtr &inst,
+                   Addr pc);
+    void endInst();
+    void flushChunk();
+    void close();
+
+  public:
+    CompactInstTrace(const CompactInstTraceParams &p);
+    ~CompactInstTrace();
+
+    InstRecord *getInstRecord(Tick when, ThreadContext *tc,
+                              const StaticInstPtr si, const PCStateBase &pc,
+                              const StaticInstPtr mi=nullptr) override;
+};
+
+} // namespace trace
+} // namespace gem5
+
+#endif // __CPU_COMPACT_INST_TRACE_HH__
@@ -31,6 +31,7 @@
 
 #include <set>
 
+#include "base/random.hh"
 #include "base/statistics.hh"
 #include "mem/port.hh"
 #include "params/GarnetSyntheticTraffic.hh"
@@ -112,6 +113,12 @@ class GarnetSyntheticTraffic : public ClockedObject
     unsigned size;
     int id;
 
+    /**
+     * Random numbers of this tester. Testers can run on different event
+     * queues, so they don't share the global generator.
+     */
+    Random rng;
+
     std::map<std::string, TrafficType> trafficStringToEnum;
 
     unsigned blockSizeBits;
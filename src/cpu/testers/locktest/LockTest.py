@@ -0,0 +1,56 @@
+# Copyright (c) 2024 The gem5 contributors
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+from m5.params import *
+from m5.proxy import *
+
+from m5.objects.ClockedObject import ClockedObject
+
+
+class LockTest(ClockedObject):
+    type = "LockTest"
+    cxx_header = "cpu/testers/locktest/locktest.hh"
+    cxx_class = "gem5::LockTest"
+
+    # The locks are placed in consecutive cache lines starting at
+    # base_addr and the testers are spread over them round-robin
+    base_addr = Param.Addr(0x100000, "Address of the first lock")
+    num_locks = Param.Unsigned(1, "Number of locks shared by the testers")
+
+    critical_section = Param.Cycles(10, "Cycles a lock is held for")
+    backoff = Param.Cycles(
+        1, "Cycles between a failed attempt and the next one"
+    )
+
+    max_acquisitions = Param.Counter(
+        0, "Number of acquisitions to complete before exiting"
+    )
+    progress_check = Param.Cycles(
+        5000000, "Cycles before exiting due to lack of progress"
+    )
+
+    port = RequestPort("Port to the memory system")
+    system = Param.System(Parent.any, "System this tester is part of")
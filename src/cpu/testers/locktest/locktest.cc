@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "cpu/testers/locktest/locktest.hh"
+
+#include <unordered_map>
+
+#include "base/logging.hh"
+#include "base/trace.hh"
+#include "debug/LockTest.hh"
+#include "sim/sim_exit.hh"
+#include "sim/system.hh"
+
+namespace gem5
+{
+
+static unsigned int TESTER_ALLOCATOR = 0;
+
+// The tester holding each lock, used to check mutual exclusion
+static std::unordered_map<Addr, unsigned int> lockOwners;
+
+bool
+LockTest::CpuPort::recvTimingResp(PacketPtr pkt)
+{
+    locktest.completeRequest(pkt);
+    return true;
+}
+
+void
+LockTest::CpuPort::recvReqRetry()
+{
+    locktest.recvRetry();
+}
+
+LockTest::LockTest(const Params &p)
+    : ClockedObject(p),
+      tickEvent([this]{ tick(); }, name()),
+      noProgressEvent([this]{ noProgress(); }, name()),
+      port("port", *this),
+      retryPkt(nullptr),
+      state(State::Spinning),
+      requestorId(p.system->getRequestorId(this)),
+      acquireStart(0),
+      baseAddr(p.base_addr),
+      numLocks(p.num_locks),
+      criticalSection(p.critical_section),
+      backoff(p.backoff),
+      progressCheck(p.progress_check),
+      maxAcquisitions(p.max_acquisitions),
+      blockSize(p.system->cacheLineSize()),
+      numAcquisitions(0),
+      stats(this)
+{
+    fatal_if(numLocks == 0, "%s: At least one lock is required\n", name());
+    fatal_if(p.system->isAtomicMode(),
+             "%s: LockTest requires timing mode\n", name());
+
+    id = TESTER_ALLOCATOR++;
+
+    // Testers are spread round-robin over the locks, each of which is
+    // in a cache line of its own
+    lockAddr = baseAddr + (id % numLocks) * blockSize;
+
+    // kick things into action
+    schedule(tickEvent, curTick());
+    schedule(noProgressEvent, clockEdge(progressCheck));
+}
+
+Port &
+LockTest::getPort(const std::string &if_name, PortID idx)
+{
+    if (if_name == "port")
+        return port;
+    else
+        return ClockedObject::getPort(if_name, idx);
+}
+
+void
+LockTest::tick()
+{
+    Request::Flags flags;
+    MemCmd cmd;
+    uint8_t data = 0;
+
+    switch (state) {
+      case State::Spinning:
+        // Test: read the lock and get a reservation for the line
+        flags.set(Request::LLSC);
+        cmd = MemCmd::LoadLockedReq;
+        break;
+      case State::Acquiring:
+        // Test-and-set: only succeeds if nobody wrote the lock since
+        flags.set(Request::LLSC);
+        cmd = MemCmd::StoreCondReq;
+        data = 1;
+        break;
+      case State::Releasing:
+        cmd = MemCmd::WriteReq;
+        break;
+      default:
+        panic("%s: Unexpected state when issuing a request\n", name());
+    }
+
+    RequestPtr req = std::make_shared<Request>(lockAddr, 1, flags,
+                                               requestorId);
+    req->setContext(id);
+
+    PacketPtr pkt = new Packet(req, cmd);
+    pkt->allocate();
+    if (pkt->isWrite())
+        pkt->setLE<uint8_t>(data);
+
+    DPRINTF(LockTest, "Initiating %s of lock %#x\n", pkt->cmdString(),
+            lockAddr);
+
+    sendPkt(pkt);
+}
+
+void
+LockTest::completeRequest(PacketPtr pkt)
+{
+    DPRINTF(LockTest, "Completing %s of lock %#x\n", pkt->cmdString(),
+            lockAddr);
+
+    switch (state) {
+      case State::Spinning:
+        if (pkt->getLE<uint8_t>() != 0) {
+            // The lock is taken, spin on it
+            stats.numSpins++;
+            schedule(tickEvent, clockEdge(backoff));
+        } else {
+            state = State::Acquiring;
+            schedule(tickEvent, clockEdge());
+        }
+        break;
+      case State::Acquiring:
+        if (pkt->req->getExtraData() == 0) {
+            // Somebody else got the line in between
+            stats.numFailedStoreConds++;
+            state = State::Spinning;
+            schedule(tickEvent, clockEdge(backoff));
+        } else {
+            auto owner = lockOwners.find(lockAddr);
+            panic_if(owner != lockOwners.end(),
+                     "%s: Acquired lock %#x held by tester %d\n",
+                     name(), lockAddr, owner->second);
+            lockOwners[lockAddr] = id;
+
+            stats.acquireLatency.sample(curTick() - acquireStart);
+            state = State::Releasing;
+            schedule(tickEvent, clockEdge(criticalSection));
+        }
+        break;
+      case State::Releasing:
+        // Nobody can take the lock before the release is performed
+        lockOwners.erase(lockAddr);
+
+        numAcquisitions++;
+        stats.numAcquisitions++;
+        reschedule(noProgressEvent, clockEdge(progressCheck), true);
+
+        if (maxAcquisitions != 0 && numAcquisitions >= maxAcquisitions) {
+            exitSimLoop("maximum number of lock acquisitions reached");
+        }
+
+        state = State::Spinning;
+        acquireStart = clockEdge(backoff);
+        schedule(tickEvent, acquireStart);
+        break;
+      default:
+        panic("%s: Unexpected response\n", name());
+    }
+
+    delete pkt;
+}
+
+void
+LockTest::sendPkt(PacketPtr pkt)
+{
+    assert(!retryPkt);
+    if (!port.sendTimingReq(pkt)) {
+        DPRINTF(LockTest, "Waiting for retry\n");
+        retryPkt = pkt;
+    }
+}
+
+void
+LockTest::recvRetry()
+{
+    assert(retryPkt);
+    if (port.sendTimingReq(retryPkt)) {
+        DPRINTF(LockTest, "Proceeding after successful retry\n");
+        retryPkt = nullptr;
+    }
+}
+
+void
+LockTest::noProgress()
+{
+    panic("%s did not acquire lock %#x for %d cycles", name(), lockAddr,
+          progressCheck);
+}
+
+LockTest::LockTestStats::LockTestStats(statistics::Group *parent)
+      : statistics::Group(parent),
+      ADD_STAT(numAcquisitions, statistics::units::Count::get(),
+               "number of lock acquisitions completed"),
+      ADD_STAT(numSpins, statistics::units::Count::get(),
+               "number of times the lock was found taken"),
+      ADD_STAT(numFailedStoreConds, statistics::units::Count::get(),
+               "number of failed store-conditionals"),
+      ADD_STAT(acquireLatency, statistics::units::Tick::get(),
+               "ticks from the first attempt to acquiring the lock")
+{
+    acquireLatency.init(16);
+}
+
+} // namespace gem5
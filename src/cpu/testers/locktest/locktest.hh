@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __CPU_LOCKTEST_LOCKTEST_HH__
+#define __CPU_LOCKTEST_LOCKTEST_HH__
+
+#include "base/statistics.hh"
+#include "mem/port.hh"
+#include "params/LockTest.hh"
+#include "sim/clocked_object.hh"
+#include "sim/eventq.hh"
+#include "sim/stats.hh"
+
+namespace gem5
+{
+
+/**
+ * The LockTest class is a microbenchmark for highly contended cache
+ * lines. Each tester repeatedly acquires one of a small number of
+ * test-and-test-and-set spin locks using load-linked/store-conditional,
+ * holds it for a fixed number of cycles and releases it with a plain
+ * store. With many testers sharing a lock, the coherence controllers
+ * stall and wake up a large number of requests to the same line, which
+ * is the case the stall handling of the memory system has to scale to.
+ *
+ * The tester also checks mutual exclusion, i.e., that a store-conditional
+ * never succeeds on a lock that another tester holds.
+ */
+class LockTest : public ClockedObject
+{
+  public:
+    typedef LockTestParams Params;
+    LockTest(const Params &p);
+
+    Port &getPort(const std::string &if_name,
+                  PortID idx=InvalidPortID) override;
+
+  protected:
+    enum class State
+    {
+        Spinning,   // Load-linked of the lock is outstanding
+        Acquiring,  // Store-conditional of the lock is outstanding
+        Holding,    // In the critical section
+        Releasing   // Store releasing the lock is outstanding
+    };
+
+    class CpuPort : public RequestPort
+    {
+        LockTest &locktest;
+
+      public:
+        CpuPort(const std::string &_name, LockTest &_locktest)
+            : RequestPort(_name), locktest(_locktest)
+        { }
+
+      protected:
+        bool recvTimingResp(PacketPtr pkt);
+
+        void recvTimingSnoopReq(PacketPtr pkt) { }
+
+        void recvFunctionalSnoop(PacketPtr pkt) { }
+
+        Tick recvAtomicSnoop(PacketPtr pkt) { return 0; }
+
+        void recvReqRetry();
+    };
+
+    /** Issue the next request of the acquire/release sequence. */
+    void tick();
+
+    EventFunctionWrapper tickEvent;
+
+    void noProgress();
+
+    EventFunctionWrapper noProgressEvent;
+
+    void completeRequest(PacketPtr pkt);
+
+    void sendPkt(PacketPtr pkt);
+
+    void recvRetry();
+
+    CpuPort port;
+
+    PacketPtr retryPkt;
+
+    State state;
+
+    /** Request id for all generated traffic */
+    RequestorID requestorId;
+
+    unsigned int id;
+
+    /** Address of the lock currently being acquired */
+    Addr lockAddr;
+
+    /** Tick at which the current acquisition started */
+    Tick acquireStart;
+
+    const Addr baseAddr;
+    const unsigned numLocks;
+    const Cycles criticalSection;
+    const Cycles backoff;
+    const Cycles progressCheck;
+    const uint64_t maxAcquisitions;
+
+    const unsigned blockSize;
+
+    uint64_t numAcquisitions;
+
+    struct LockTestStats : public statistics::Group
+    {
+        LockTestStats(statistics::Group *parent);
+        statistics::Scalar numAcquisitions;
+        statistics::Scalar numSpins;
+        statistics::Scalar numFailedStoreConds;
+        statistics::Histogram acquireLatency;
+    } stats;
+};
+
+} // namespace gem5
+
+#endif // __CPU_LOCKTEST_LOCKTEST_HH__
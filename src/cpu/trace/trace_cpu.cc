@@ -44,7 +44,7 @@ namespace gem5
 {
 
 // Declare and initialize the static counter for number of trace CPUs.
-int TraceCPU::numTraceCPUs = 0;
+std::atomic<int> TraceCPU::numTraceCPUs(0);
 
 TraceCPU::TraceCPU(const TraceCPUParams &params)
     :   BaseCPU(params),
@@ -61,7 +61,6 @@ TraceCPU::TraceCPU(const TraceCPUParams &params)
         dcacheNextEvent([this]{ schedDcacheNext(); }, name()),
         oneTraceComplete(false),
         traceOffset(0),
-        execCompleteEvent(nullptr),
         enableEarlyExit(params.enableEarlyExit),
         progressMsgInterval(params.progressMsgInterval),
         progressMsgThreshold(params.progressMsgInterval), traceStats(this)
@@ -131,17 +130,6 @@ TraceCPU::init()
     // send its first request at the first event and schedule subsequent
     // events using a relative tick delta
     dcacheGen.adjustInitTraceOffset(traceOffset);
-
-    // If the Trace CPU simulation is configured to exit on any one trace
-    // completion then we don't need a counted event to count down all Trace
-    // CPUs in the system. If not then instantiate a counted event.
-    if (!enableEarlyExit) {
-        // The static counter for number of Trace CPUs is correctly set at
-        // this point so create an event and pass it.
-        execCompleteEvent = new CountedExitEvent("end of all traces reached.",
-                                                 numTraceCPUs);
-    }
-
 }
 
 void
@@ -195,12 +183,14 @@ TraceCPU::checkAndSchedExitEvent()
         inform("%s: Execution complete.", name());
         // If the replay is configured to exit early, that is when any one
         // execution is complete then exit immediately and return. Otherwise,
-        // schedule the counted exit that counts down completion of each Trace
-        // CPU.
+        // count down the completion of each Trace CPU and exit when the last
+        // one is done. exitSimLoop() schedules a global event, which is safe
+        // from any event queue, whereas a CountedExitEvent shared between
+        // queues would race on its counter.
         if (enableEarlyExit) {
             exitSimLoop("End of trace reached");
-        } else {
-            schedule(*execCompleteEvent, curTick());
+        } else if (--numTraceCPUs == 0) {
+            exitSimLoop("end of all traces reached.");
         }
     }
 }
@@ -311,14 +301,15 @@ TraceCPU::ElasticDataGen::readNextWindow()
     uint32_t num_read = 0;
     while (num_read != windowSize) {
 
-        // Create a new graph node
-        GraphNode* new_node = new GraphNode;
+        // Get a graph node to fill in
+        GraphNode* new_node = depGraph.allocate();
 
         // Read the next line to get the next record. If that fails then end of
         // trace has been reached and traceComplete needs to be set in addition
         // to returning false.
         if (!trace.read(new_node)) {
             DPRINTF(TraceCPUData, "\tTrace complete!\n");
+            depGraph.release(new_node);
             traceComplete = true;
             return false;
         }
@@ -330,8 +321,8 @@ TraceCPU::ElasticDataGen::readNextWindow()
         addDepsOnParent(new_node, new_node->regDep);
 
         num_read++;
-        // Add to map
-        depGraph[new_node->seqNum] = new_node;
+        // Add to graph
+        depGraph.insert(new_node);
         if (new_node->robDep.empty() && new_node->regDep.empty()) {
             // Source dependencies are already complete, check if resources
             // are available and issue. The execution time is approximated
@@ -352,13 +343,13 @@ TraceCPU::ElasticDataGen::addDepsOnParent(GraphNode *new_node, T& dep_list)
     auto dep_it = dep_list.begin();
     while (dep_it != dep_list.end()) {
         // We look up the valid dependency, i.e. the parent of this node
-        auto parent_itr = depGraph.find(*dep_it);
-        if (parent_itr != depGraph.end()) {
+        GraphNode* parent = depGraph.find(*dep_it);
+        if (parent) {
             // If the parent is found, it is yet to be executed. Append a
             // pointer to the new node to the dependents list of the parent
             // node.
-            parent_itr->second->dependents.push_back(new_node);
-            auto num_depts = parent_itr->second->dependents.size();
+            parent->dependents.push_back(new_node);
+            auto num_depts = parent->dependents.size();
             elasticStats.maxDependents = std::max<double>(num_depts,
                                         elasticStats.maxDependents.value());
             dep_it++;
@@ -401,16 +392,14 @@ TraceCPU::ElasticDataGen::execute()
         }
     }
     // Proceed to execute from readyList
-    auto graph_itr = depGraph.begin();
     auto free_itr = readyList.begin();
     // Iterate through readyList until the next free node has its execute
     // tick later than curTick or the end of readyList is reached
     while (free_itr->execTick <= curTick() && free_itr != readyList.end()) {
 
         // Get pointer to the node to be executed
-        graph_itr = depGraph.find(free_itr->seqNum);
-        assert(graph_itr != depGraph.end());
-        GraphNode* node_ptr = graph_itr->second;
+        GraphNode* node_ptr = depGraph.find(free_itr->seqNum);
+        assert(node_ptr);
 
         // If there is a retryPkt send that else execute the load
         if (retryPkt) {
@@ -505,14 +494,10 @@ TraceCPU::ElasticDataGen::execute()
         if (!node_ptr->isLoad() || node_ptr->isStrictlyOrdered()) {
             // Release all resources occupied by the completed node
             hwResource.release(node_ptr);
-            // clear the dynamically allocated set of dependents
-            (node_ptr->dependents).clear();
             // Update the stat for numOps simulated
             owner.updateNumOps(node_ptr->robNum);
-            // delete node
-            delete node_ptr;
-            // remove from graph
-            depGraph.erase(graph_itr);
+            // remove from graph and recycle the node
+            depGraph.erase(node_ptr);
         }
         // Point to first node to continue to next iteration of while loop
         free_itr = readyList.begin();
@@ -697,9 +682,8 @@ TraceCPU::ElasticDataGen::completeMemAccess(PacketPtr pkt)
     } else {
         // If it is a load response then release the dependents waiting on it.
         // Get pointer to the completed load
-        auto graph_itr = depGraph.find(pkt->req->getReqInstSeqNum());
-        assert(graph_itr != depGraph.end());
-        GraphNode* node_ptr = graph_itr->second;
+        GraphNode* node_ptr = depGraph.find(pkt->req->getReqInstSeqNum());
+        assert(node_ptr);
 
         // Release resources occupied by the load
         hwResource.release(node_ptr);
@@ -713,14 +697,10 @@ TraceCPU::ElasticDataGen::completeMemAccess(PacketPtr pkt)
             }
         }
 
-        // clear the dynamically allocated set of dependents
-        (node_ptr->dependents).clear();
         // Update the stat for numOps completed
         owner.updateNumOps(node_ptr->robNum);
-        // delete node
-        delete node_ptr;
-        // remove from graph
-        depGraph.erase(graph_itr);
+        // remove from graph and recycle the node
+        depGraph.erase(node_ptr);
     }
 
     if (debug::TraceCPUData) {
@@ -820,14 +800,115 @@ TraceCPU::ElasticDataGen::printReadyList()
     }
     DPRINTF(TraceCPUData, "Printing readyList:\n");
     while (itr != readyList.end()) {
-        auto graph_itr = depGraph.find(itr->seqNum);
-        [[maybe_unused]] GraphNode* node_ptr = graph_itr->second;
+        [[maybe_unused]] GraphNode* node_ptr = depGraph.find(itr->seqNum);
         DPRINTFR(TraceCPUData, "\t%lld(%s), %lld\n", itr->seqNum,
             node_ptr->typeToStr(), itr->execTick);
         itr++;
     }
 }
 
+TraceCPU::ElasticDataGen::DepGraph::DepGraph() :
+    ring(1024), mask(ring.size() - 1), head(0), used(0), numNodes(0)
+{}
+
+TraceCPU::ElasticDataGen::GraphNode*
+TraceCPU::ElasticDataGen::DepGraph::allocate()
+{
+    if (freeNodes.empty()) {
+        pool.emplace_back();
+        return &pool.back();
+    }
+    GraphNode* node = freeNodes.back();
+    freeNodes.pop_back();
+    return node;
+}
+
+void
+TraceCPU::ElasticDataGen::DepGraph::release(GraphNode* node)
+{
+    // Keep the capacity of the arrays for the next use of the node
+    node->dependents.clear();
+    freeNodes.push_back(node);
+}
+
+void
+TraceCPU::ElasticDataGen::DepGraph::insert(GraphNode* node)
+{
+    fatal_if(used && node->seqNum <= slot(used - 1).seqNum,
+             "Elastic trace nodes are not in sequence number order, node "
+             "%lli follows node %lli.\n", node->seqNum,
+             slot(used - 1).seqNum);
+
+    if (used == ring.size()) {
+        // Double the size of the ring, moving the slots to the start
+        std::vector<Slot> new_ring(2 * ring.size());
+        for (size_t pos = 0; pos < used; ++pos)
+            new_ring[pos] = slot(pos);
+        ring.swap(new_ring);
+        mask = ring.size() - 1;
+        head = 0;
+    }
+
+    slot(used++) = {node->seqNum, node};
+    ++numNodes;
+}
+
+size_t
+TraceCPU::ElasticDataGen::DepGraph::position(NodeSeqNum seq_num) const
+{
+    // Sequence numbers have few gaps, so interpolate between the bounds
+    // to guess where the node is. Every other step bisects so that the
+    // search is never slower than a binary search.
+    size_t low = 0;
+    size_t high = used;
+    bool interpolate = true;
+    while (low < high) {
+        const NodeSeqNum low_seq = slot(low).seqNum;
+        const NodeSeqNum high_seq = slot(high - 1).seqNum;
+        if (seq_num < low_seq || seq_num > high_seq)
+            return used;
+
+        size_t mid = low + (high - low) / 2;
+        if (interpolate && high_seq != low_seq) {
+            mid = low + (size_t)((double)(seq_num - low_seq) *
+                                 (high - 1 - low) / (high_seq - low_seq));
+        }
+        interpolate = !interpolate;
+
+        const NodeSeqNum mid_seq = slot(mid).seqNum;
+        if (mid_seq == seq_num)
+            return mid;
+        else if (mid_seq < seq_num)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return used;
+}
+
+TraceCPU::ElasticDataGen::GraphNode*
+TraceCPU::ElasticDataGen::DepGraph::find(NodeSeqNum seq_num) const
+{
+    const size_t pos = position(seq_num);
+    return pos < used ? slot(pos).node : nullptr;
+}
+
+void
+TraceCPU::ElasticDataGen::DepGraph::erase(GraphNode* node)
+{
+    const size_t pos = position(node->seqNum);
+    assert(pos < used && slot(pos).node == node);
+    slot(pos).node = nullptr;
+    --numNodes;
+    release(node);
+
+    // Drop the completed nodes at the start of the ring
+    while (used && !slot(0).node) {
+        head = (head + 1) & mask;
+        --used;
+    }
+}
+
 TraceCPU::ElasticDataGen::HardwareResource::HardwareResource(
         uint16_t max_rob, uint16_t max_stores, uint16_t max_loads) :
     sizeROB(max_rob),
@@ -1225,64 +1306,63 @@ TraceCPU::ElasticDataGen::InputStream::reset()
 bool
 TraceCPU::ElasticDataGen::InputStream::read(GraphNode* element)
 {
-    ProtoMessage::InstDepRecord pkt_msg;
-    if (trace.read(pkt_msg)) {
+    if (trace.read(msg)) {
         // Required fields
-        element->seqNum = pkt_msg.seq_num();
-        element->type = pkt_msg.type();
+        element->seqNum = msg.seq_num();
+        element->type = msg.type();
         // Scale the compute delay to effectively scale the Trace CPU frequency
-        element->compDelay = pkt_msg.comp_delay() * timeMultiplier;
+        element->compDelay = msg.comp_delay() * timeMultiplier;
 
         // Repeated field robDepList
         element->robDep.clear();
-        for (int i = 0; i < (pkt_msg.rob_dep()).size(); i++) {
-            element->robDep.push_back(pkt_msg.rob_dep(i));
+        for (int i = 0; i < (msg.rob_dep()).size(); i++) {
+            element->robDep.push_back(msg.rob_dep(i));
         }
 
         // Repeated field
         element->regDep.clear();
-        for (int i = 0; i < (pkt_msg.reg_dep()).size(); i++) {
+        for (int i = 0; i < (msg.reg_dep()).size(); i++) {
             // There is a possibility that an instruction has both, a register
             // and order dependency on an instruction. In such a case, the
             // register dependency is omitted
             bool duplicate = false;
             for (auto &dep: element->robDep) {
-                duplicate |= (pkt_msg.reg_dep(i) == dep);
+                duplicate |= (msg.reg_dep(i) == dep);
             }
             if (!duplicate)
-                element->regDep.push_back(pkt_msg.reg_dep(i));
+                element->regDep.push_back(msg.reg_dep(i));
         }
 
         // Optional fields
-        if (pkt_msg.has_p_addr())
-            element->physAddr = pkt_msg.p_addr();
+        if (msg.has_p_addr())
+            element->physAddr = msg.p_addr();
         else
             element->physAddr = 0;
 
-        if (pkt_msg.has_v_addr())
-            element->virtAddr = pkt_msg.v_addr();
+        if (msg.has_v_addr())
+            element->virtAddr = msg.v_addr();
         else
             element->virtAddr = 0;
 
-        if (pkt_msg.has_size())
-            element->size = pkt_msg.size();
+        if (msg.has_size())
+            element->size = msg.size();
         else
             element->size = 0;
 
-        if (pkt_msg.has_flags())
-            element->flags = pkt_msg.flags();
+        if (msg.has_flags())
+            element->flags = msg.flags();
         else
             element->flags = 0;
 
-        if (pkt_msg.has_pc())
-            element->pc = pkt_msg.pc();
+        if (msg.has_pc())
+            element->pc = msg.pc();
         else
             element->pc = 0;
 
         // ROB occupancy number
         ++microOpCount;
-        if (pkt_msg.has_weight()) {
-            microOpCount += pkt_msg.weight();
+        if (msg.has_weight()) {
+            microOpCount += msg.weight();
         }
         element->robNum = microOpCount;
         return true;
@@ -38,11 +38,13 @@
 #ifndef __CPU_TRACE_TRACE_CPU_HH__
 #define __CPU_TRACE_TRACE_CPU_HH__
 
+#include <atomic>
 #include <cstdint>
+#include <deque>
 #include <list>
 #include <queue>
 #include <set>
-#include <unordered_map>
+#include <vector>
 
 #include "base/statistics.hh"
 #include "cpu/base.hh"
@@ -134,9 +136,10 @@ namespace gem5
  * Strictly-ordered requests are skipped and the dependencies on such requests
  * are handled by simply marking them complete immediately.
  *
- * A CountedExitEvent that contains a static int belonging to the Trace CPU
- * class as a down counter is used to implement multi Trace CPU simulation
- * exit.
+ * A static atomic down counter belonging to the Trace CPU class is used to
+ * implement multi Trace CPU simulation exit. It is safe to decrement from
+ * any event queue, so Trace CPUs can be replayed in parallel with each one
+ * on its own queue.
  */
 
 class TraceCPU : public BaseCPU
@@ -557,11 +560,14 @@ class TraceCPU : public BaseCPU
         class GraphNode
         {
           public:
-            /** Typedef for the list containing the ROB dependencies */
-            typedef std::list<NodeSeqNum> RobDepList;
+            /**
+             * Typedef for the array containing the ROB dependencies. Nodes
+             * are recycled, so the array keeps its capacity.
+             */
+            typedef std::vector<NodeSeqNum> RobDepList;
 
-            /** Typedef for the list containing the register dependencies */
-            typedef std::list<NodeSeqNum> RegDepList;
+            /** Typedef for the array containing the register dependencies */
+            typedef std::vector<NodeSeqNum> RegDepList;
 
             /** Instruction sequence number */
             NodeSeqNum seqNum;
@@ -643,6 +649,91 @@ class TraceCPU : public BaseCPU
             std::string typeToStr() const;
         };
 
+        /**
+         * The DepGraph holds the nodes read from the trace that are not yet
+         * complete. They are kept in trace order, which is ascending
+         * sequence number order, in a ring buffer so that a node can be
+         * found by searching for its sequence number. A node that completes
+         * leaves a hole in the ring until all the nodes before it complete
+         * too. The ring only grows if the oldest node stays incomplete for
+         * longer than its capacity.
+         *
+         * Completed nodes are kept in a pool and reused for the nodes read
+         * next, along with the capacity of their arrays, so that replaying a
+         * trace does not allocate memory once the window is full.
+         */
+        class DepGraph
+        {
+          public:
+            DepGraph();
+
+            /** Get an unused node to read a trace record into. */
+            GraphNode* allocate();
+
+            /** Return a node that was allocated but not inserted. */
+            void release(GraphNode* node);
+
+            /**
+             * Add a node to the graph, its sequence number must be larger
+             * than that of all the other nodes.
+             */
+            void insert(GraphNode* node);
+
+            /** Remove a completed node from the graph and recycle it. */
+            void erase(GraphNode* node);
+
+            /**
+             * Find a node in the graph.
+             *
+             * @param seq_num sequence number of the node
+             * @return the node, or nullptr if it is not in the graph
+             */
+            GraphNode* find(NodeSeqNum seq_num) const;
+
+            /** Number of nodes in the graph */
+            size_t size() const { return numNodes; }
+
+            bool empty() const { return numNodes == 0; }
+
+          private:
+            /** An entry of the ring, node is nullptr once it completed. */
+            struct Slot
+            {
+                NodeSeqNum seqNum;
+                GraphNode* node;
+            };
+
+            /** Slot at a position relative to the oldest one. */
+            Slot& slot(size_t pos) { return ring[(head + pos) & mask]; }
+            const Slot&
+            slot(size_t pos) const
+            {
+                return ring[(head + pos) & mask];
+            }
+
+            /** Position of a node in the ring, or used if not found. */
+            size_t position(NodeSeqNum seq_num) const;
+
+            /** Ring of nodes, its size is a power of two. */
+            std::vector<Slot> ring;
+            size_t mask;
+
+            /** Position of the oldest slot in the ring */
+            size_t head;
+
+            /** Number of slots used, including the ones of completed nodes */
+            size_t used;
+
+            /** Number of nodes in the graph */
+            size_t numNodes;
+
+            /** Storage of all the nodes ever allocated */
+            std::deque<GraphNode> pool;
+
+            /** Nodes that can be reused */
+            std::vector<GraphNode*> freeNodes;
+        };
+
         /** Struct to store a ready-to-execute node and its execution tick. */
         struct ReadyNode
         {
@@ -781,6 +872,9 @@ class TraceCPU : public BaseCPU
              */
             uint32_t windowSize;
 
+            /** Message reused for every record to keep its buffers */
+            Record msg;
+
           public:
             /**
              * Create a trace input stream for a given file name.
@@ -991,7 +1085,7 @@ class TraceCPU : public BaseCPU
         HardwareResource hwResource;
 
         /** Store the depGraph of GraphNodes */
-        std::unordered_map<NodeSeqNum, GraphNode*> depGraph;
+        DepGraph depGraph;
 
         /**
          * Queue of dependency-free nodes that are pending issue because
@@ -1072,23 +1166,18 @@ class TraceCPU : public BaseCPU
     Tick traceOffset;
 
     /**
-     * Number of Trace CPUs in the system used as a shared variable and passed
-     * to the CountedExitEvent event used for counting down exit events.  It is
-     * incremented in the constructor call so that the total is arrived at
-     * automatically.
+     * Number of Trace CPUs in the system that have not yet completed both
+     * traces. It is incremented in the constructor call so that the total is
+     * arrived at automatically, and decremented by each Trace CPU when its
+     * replay completes. The CPU that brings it to zero exits the simulation
+     * loop. The counter is atomic as Trace CPUs on different event queues
+     * may complete concurrently in parallel mode.
      */
-    static int numTraceCPUs;
-
-   /**
-    * A CountedExitEvent which when serviced decrements the counter. A sim
-    * exit event is scheduled when the counter equals zero, that is all
-    * instances of Trace CPU have had their execCompleteEvent serviced.
-    */
-    CountedExitEvent *execCompleteEvent;
+    static std::atomic<int> numTraceCPUs;
 
     /**
      * Exit when any one Trace CPU completes its execution. If this is
-     * configured true then the execCompleteEvent is not scheduled.
+     * configured true then the counter is not decremented.
      */
     const bool enableEarlyExit;
 
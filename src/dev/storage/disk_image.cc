@@ -32,15 +32,19 @@
 
 #include "dev/storage/disk_image.hh"
 
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/uio.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cerrno>
 #include <cstring>
 #include <fstream>
 #include <string>
 
+#include "base/bitfield.hh"
 #include "base/callback.hh"
 #include "base/logging.hh"
 #include "base/trace.hh"
@@ -53,12 +57,46 @@
 namespace gem5
 {
 
+////////////////////////////////////////////////////////////////////////
+//
+// Disk image
+//
+std::streampos
+DiskImage::readSectors(uint8_t *data, std::streampos offset,
+                       uint64_t count, bool trace) const
+{
+    uint64_t bytes = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+        const std::streampos n = read(data + i * SectorSize,
+                                      offset + std::streamoff(i));
+        bytes += n;
+        if (n != SectorSize)
+            break;
+    }
+    return bytes;
+}
+
+std::streampos
+DiskImage::writeSectors(const uint8_t *data, std::streampos offset,
+                        uint64_t count, bool trace)
+{
+    uint64_t bytes = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+        const std::streampos n = write(data + i * SectorSize,
+                                       offset + std::streamoff(i));
+        bytes += n;
+        if (n != SectorSize)
+            break;
+    }
+    return bytes;
+}
+
 ////////////////////////////////////////////////////////////////////////
 //
 // Raw Disk image
 //
 RawDiskImage::RawDiskImage(const Params &p)
-    : DiskImage(p), disk_size(0)
+    : DiskImage(p), fd(-1), disk_size(0), mapping(nullptr)
 {
     open(p.image_file, p.read_only);
 }
@@ -87,58 +125,147 @@ RawDiskImage::open(const std::string &filename, bool rd_only)
         readonly = rd_only;
         file = filename;
 
-        std::ios::openmode mode = std::ios::in | std::ios::binary;
-        if (!readonly)
-            mode |= std::ios::out;
-        stream.open(file.c_str(), mode);
-        if (!stream.is_open())
-            panic("Error opening %s", filename);
+        fd = ::open(file.c_str(), readonly ? O_RDONLY : O_RDWR);
+        if (fd < 0)
+            panic("Error opening %s: %s", filename, strerror(errno));
+
+        // Use lseek rather than fstat so that block devices report
+        // their size too
+        const off_t end = lseek(fd, 0, SEEK_END);
+        if (end < 0)
+            panic("Could not get the size of %s: %s", filename,
+                  strerror(errno));
+        disk_size = end;
+
+        // Map the whole image. Writes go straight to the file through
+        // the shared mapping, as they did through the stream. If the
+        // file cannot be mapped fall back to positioned reads and
+        // writes.
+        if (disk_size != 0) {
+            void *addr = mmap(nullptr, disk_size,
+                              readonly ? PROT_READ : PROT_READ | PROT_WRITE,
+                              MAP_SHARED, fd, 0);
+            if (addr != MAP_FAILED) {
+                mapping = static_cast<uint8_t *>(addr);
+                madvise(mapping, disk_size, MADV_RANDOM);
+            } else {
+                warn("Could not map %s (%s), using file I/O instead.",
+                     filename, strerror(errno));
+            }
+        }
     }
 }
 
 void
 RawDiskImage::close()
 {
-    stream.close();
+    if (mapping) {
+        munmap(mapping, disk_size);
+        mapping = nullptr;
+    }
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    disk_size = 0;
 }
 
 std::streampos
 RawDiskImage::size() const
 {
-    if (disk_size == 0) {
-        if (!stream.is_open())
-            panic("file not open!\n");
-        stream.seekg(0, std::ios::end);
-        disk_size = stream.tellg();
-    }
+    if (fd < 0)
+        panic("file not open!\n");
 
     return disk_size / SectorSize;
 }
 
+uint64_t
+RawDiskImage::readBytes(uint8_t *buf, uint64_t pos, uint64_t len) const
+{
+    if (pos >= disk_size)
+        return 0;
+    len = std::min(len, disk_size - pos);
+
+    if (mapping) {
+        std::memcpy(buf, mapping + pos, len);
+        return len;
+    }
+
+    uint64_t done = 0;
+    while (done < len) {
+        const ssize_t n = pread(fd, buf + done, len - done, pos + done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        done += n;
+    }
+    return done;
+}
+
+uint64_t
+RawDiskImage::writeBytes(const uint8_t *buf, uint64_t pos, uint64_t len)
+{
+    // The image does not grow, as a mapping cannot be written past its
+    // end
+    if (pos >= disk_size)
+        return 0;
+    len = std::min(len, disk_size - pos);
+
+    if (mapping) {
+        std::memcpy(mapping + pos, buf, len);
+        return len;
+    }
+
+    uint64_t done = 0;
+    while (done < len) {
+        const ssize_t n = pwrite(fd, buf + done, len - done, pos + done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        done += n;
+    }
+    return done;
+}
+
 std::streampos
 RawDiskImage::read(uint8_t *data, std::streampos offset) const
+{
+    return readSectors(data, offset, 1);
+}
+
+std::streampos
+RawDiskImage::write(const uint8_t *data, std::streampos offset)
+{
+    return writeSectors(data, offset, 1);
+}
+
+std::streampos
+RawDiskImage::readSectors(uint8_t *data, std::streampos offset,
+                          uint64_t count, bool trace) const
 {
     if (!initialized)
         panic("RawDiskImage not initialized");
 
-    if (!stream.is_open())
+    if (fd < 0)
         panic("file not open!\n");
 
-    stream.seekg(offset * SectorSize, std::ios::beg);
-    if (!stream.good())
-        panic("Could not seek to location in file");
-
-    std::streampos pos = stream.tellg();
-    stream.read((char *)data, SectorSize);
+    const uint64_t bytes = readBytes(data, (uint64_t)offset * SectorSize,
+                                     count * SectorSize);
 
-    DPRINTF(DiskImageRead, "read: offset=%d\n", (uint64_t)offset);
-    DDUMP(DiskImageRead, data, SectorSize);
+    if (trace) {
+        DPRINTF(DiskImageRead, "read: offset=%d count=%d\n",
+                (uint64_t)offset, count);
+        DDUMP(DiskImageRead, data, bytes);
+    }
 
-    return stream.tellg() - pos;
+    return bytes;
 }
 
 std::streampos
-RawDiskImage::write(const uint8_t *data, std::streampos offset)
+RawDiskImage::writeSectors(const uint8_t *data, std::streampos offset,
+                           uint64_t count, bool trace)
 {
     if (!initialized)
         panic("RawDiskImage not initialized");
@@ -146,19 +273,17 @@ RawDiskImage::write(const uint8_t *data, std::streampos offset)
     if (readonly)
         panic("Cannot write to a read only disk image");
 
-    if (!stream.is_open())
+    if (fd < 0)
         panic("file not open!\n");
 
-    stream.seekp(offset * SectorSize, std::ios::beg);
-    if (!stream.good())
-        panic("Could not seek to location in file");
-
-    DPRINTF(DiskImageWrite, "write: offset=%d\n", (uint64_t)offset);
-    DDUMP(DiskImageWrite, data, SectorSize);
+    if (trace) {
+        DPRINTF(DiskImageWrite, "write: offset=%d count=%d\n",
+                (uint64_t)offset, count);
+        DDUMP(DiskImageWrite, data, count * SectorSize);
+    }
 
-    std::streampos pos = stream.tellp();
-    stream.write((const char *)data, SectorSize);
-    return stream.tellp() - pos;
+    return writeBytes(data, (uint64_t)offset * SectorSize,
+                      count * SectorSize);
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -169,7 +294,7 @@ const uint32_t CowDiskImage::VersionMajor = 1;
 const uint32_t CowDiskImage::VersionMinor = 0;
 
 CowDiskImage::CowDiskImage(const Params &p)
-    : DiskImage(p), filename(p.image_file), child(p.child), table(NULL)
+    : DiskImage(p), filename(p.image_file), child(p.child), numSectors(0)
 {
     if (filename.empty()) {
         initSectorTable(p.table_size);
@@ -179,21 +304,24 @@ CowDiskImage::CowDiskImage(const Params &p)
                 fatal("could not open read-only file");
             initSectorTable(p.table_size);
         }
-
-        if (!p.read_only)
-            registerExitCallback([this]() { save(); });
     }
 }
 
-CowDiskImage::~CowDiskImage()
+void
+CowDiskImage::init()
 {
-    SectorTable::iterator i = table->begin();
-    SectorTable::iterator end = table->end();
+    DiskImage::init();
 
-    while (i != end) {
-        delete (*i).second;
-        ++i;
-    }
+    // Register the callback once all the objects are constructed, so
+    // that it runs after the exit callbacks of the devices using the
+    // image, which let their pending accesses finish.
+    const Params &p = dynamic_cast<const Params &>(params());
+    if (!filename.empty() && !p.read_only)
+        registerExitCallback([this]() { save(); });
+}
+
+CowDiskImage::~CowDiskImage()
+{
 }
 
 void
@@ -261,18 +389,18 @@ CowDiskImage::open(const std::string &file)
 
     uint64_t sector_count;
     SafeReadSwap(stream, sector_count);
-    table = new SectorTable(sector_count);
-
+    clear();
+    table.reserve(sector_count / SectorsPerPage);
 
     for (uint64_t i = 0; i < sector_count; i++) {
         uint64_t offset;
         SafeReadSwap(stream, offset);
 
-        Sector *sector = new Sector;
-        SafeRead(stream, sector, sizeof(Sector));
+        uint8_t sector[SectorSize];
+        SafeRead(stream, sector, sizeof(sector));
 
-        assert(table->find(offset) == table->end());
-        (*table)[offset] = sector;
+        assert(!findSector(offset));
+        storeSectors(sector, offset, 1);
     }
 
     stream.close();
@@ -284,11 +412,39 @@ CowDiskImage::open(const std::string &file)
 void
 CowDiskImage::initSectorTable(int hash_size)
 {
-    table = new SectorTable(hash_size);
+    clear();
+    table.reserve(hash_size / SectorsPerPage);
 
     initialized = true;
 }
 
+void
+CowDiskImage::clear()
+{
+    table.clear();
+    extents.clear();
+    numSectors = 0;
+}
+
+const uint8_t *
+CowDiskImage::findSector(uint64_t sector) const
+{
+    auto i = table.find(sector / SectorsPerPage);
+    const unsigned idx = sector % SectorsPerPage;
+    if (i == table.end() || !bits(i->second.valid, idx))
+        return nullptr;
+    return sectorData(i->second.slot[idx]);
+}
+
+CowDiskImage::Page &
+CowDiskImage::allocPage(uint64_t page)
+{
+    auto [i, inserted] = table.try_emplace(page);
+    if (inserted)
+        i->second.valid = 0;
+    return i->second;
+}
+
 void
 SafeWrite(std::ofstream &stream, const void *data, int count)
 {
@@ -331,7 +487,7 @@ void
 CowDiskImage::save(const std::string &file) const
 {
     if (!initialized)
-        panic("RawDiskImage not initialized");
+        panic("CowDiskImage not initialized");
 
     std::ofstream stream(file.c_str());
     if (!stream.is_open() || stream.fail() || stream.bad())
@@ -343,33 +499,47 @@ CowDiskImage::save(const std::string &file) const
 
     SafeWriteSwap(stream, (uint32_t)VersionMajor);
     SafeWriteSwap(stream, (uint32_t)VersionMinor);
-    SafeWriteSwap(stream, (uint64_t)table->size());
-
-    uint64_t size = table->size();
-    SectorTable::iterator iter = table->begin();
-    SectorTable::iterator end = table->end();
-
-    for (uint64_t i = 0; i < size; i++) {
-        if (iter == end)
-            panic("Incorrect Table Size during save of COW disk image");
-
-        SafeWriteSwap(stream, (uint64_t)(*iter).first);
-        SafeWrite(stream, (*iter).second->data, sizeof(Sector));
-        ++iter;
+    SafeWriteSwap(stream, numSectors);
+
+    uint64_t saved = 0;
+    for (const auto &[page, entry] : table) {
+        for (unsigned idx = 0; idx < SectorsPerPage; ++idx) {
+            if (!bits(entry.valid, idx))
+                continue;
+            SafeWriteSwap(stream, page * SectorsPerPage + idx);
+            SafeWrite(stream, sectorData(entry.slot[idx]), SectorSize);
+            ++saved;
+        }
     }
 
+    if (saved != numSectors)
+        panic("Incorrect Table Size during save of COW disk image");
+
     stream.close();
 }
 
 void
 CowDiskImage::writeback()
 {
-    SectorTable::iterator i = table->begin();
-    SectorTable::iterator end = table->end();
-
-    while (i != end) {
-        child->write((*i).second->data, (*i).first);
-        ++i;
+    // Write each run of present sectors in a page that are also
+    // contiguous in the extents in one request
+    for (const auto &[page, entry] : table) {
+        unsigned idx = 0;
+        while (idx < SectorsPerPage) {
+            if (!bits(entry.valid, idx)) {
+                ++idx;
+                continue;
+            }
+            unsigned end = idx + 1;
+            while (end < SectorsPerPage && bits(entry.valid, end) &&
+                   entry.slot[end] == entry.slot[end - 1] + 1 &&
+                   entry.slot[end] % SectorsPerExtent != 0) {
+                ++end;
+            }
+            child->writeSectors(sectorData(entry.slot[idx]),
+                                page * SectorsPerPage + idx, end - idx);
+            idx = end;
+        }
     }
 }
 
@@ -379,46 +549,110 @@ CowDiskImage::size() const
 
 std::streampos
 CowDiskImage::read(uint8_t *data, std::streampos offset) const
+{
+    return readSectors(data, offset, 1);
+}
+
+std::streampos
+CowDiskImage::write(const uint8_t *data, std::streampos offset)
+{
+    return writeSectors(data, offset, 1);
+}
+
+std::streampos
+CowDiskImage::readSectors(uint8_t *data, std::streampos offset,
+                          uint64_t count, bool trace) const
 {
     if (!initialized)
         panic("CowDiskImage not initialized");
 
-    if (offset > size())
+    const uint64_t first = offset;
+    if (count != 0 && first + count - 1 > (uint64_t)size())
         panic("access out of bounds");
 
-    SectorTable::const_iterator i = table->find(offset);
-    if (i == table->end())
-        return child->read(data, offset);
-    else {
-        memcpy(data, (*i).second->data, SectorSize);
-        DPRINTF(DiskImageRead, "read: offset=%d\n", (uint64_t)offset);
-        DDUMP(DiskImageRead, data, SectorSize);
-        return SectorSize;
+    if (table.empty())
+        return child->readSectors(data, offset, count, trace);
+
+    uint64_t done = 0;
+    while (done < count) {
+        const uint64_t sector = first + done;
+        uint8_t *dst = data + done * SectorSize;
+
+        if (const uint8_t *src = findSector(sector)) {
+            memcpy(dst, src, SectorSize);
+            if (trace) {
+                DPRINTF(DiskImageRead, "read: offset=%d\n", sector);
+                DDUMP(DiskImageRead, dst, SectorSize);
+            }
+            ++done;
+            continue;
+        }
+
+        // Read the run of sectors that are not in this layer from the
+        // child in one request
+        uint64_t run = 1;
+        while (done + run < count && !findSector(sector + run))
+            ++run;
+
+        const uint64_t bytes = child->readSectors(dst, sector, run, trace);
+        if (bytes != run * SectorSize)
+            return done * SectorSize + bytes;
+        done += run;
+    }
+
+    return count * SectorSize;
+}
+
+void
+CowDiskImage::storeSectors(const uint8_t *data, uint64_t first,
+                           uint64_t count)
+{
+    uint64_t done = 0;
+    while (done < count) {
+        const uint64_t sector = first + done;
+        const unsigned idx = sector % SectorsPerPage;
+        const unsigned n = std::min<uint64_t>(SectorsPerPage - idx,
+                                              count - done);
+
+        Page &page = allocPage(sector / SectorsPerPage);
+        for (unsigned i = idx; i < idx + n; ++i) {
+            // Sectors only take space once they are written
+            if (!bits(page.valid, i)) {
+                if (numSectors % SectorsPerExtent == 0) {
+                    extents.emplace_back(
+                        new uint8_t[SectorsPerExtent * SectorSize]);
+                }
+                page.slot[i] = numSectors++;
+                page.valid |= 1 << i;
+            }
+            memcpy(sectorData(page.slot[i]),
+                   data + (done + i - idx) * SectorSize, SectorSize);
+        }
+
+        done += n;
     }
 }
 
 std::streampos
-CowDiskImage::write(const uint8_t *data, std::streampos offset)
+CowDiskImage::writeSectors(const uint8_t *data, std::streampos offset,
+                           uint64_t count, bool trace)
 {
     if (!initialized)
-        panic("RawDiskImage not initialized");
+        panic("CowDiskImage not initialized");
 
-    if (offset > size())
+    const uint64_t first = offset;
+    if (count != 0 && first + count - 1 > (uint64_t)size())
         panic("access out of bounds");
 
-    SectorTable::iterator i = table->find(offset);
-    if (i == table->end()) {
-        Sector *sector = new Sector;
-        memcpy(sector, data, SectorSize);
-        table->insert(make_pair(offset, sector));
-    } else {
-        memcpy((*i).second->data, data, SectorSize);
-    }
+    storeSectors(data, first, count);
 
-    DPRINTF(DiskImageWrite, "write: offset=%d\n", (uint64_t)offset);
-    DDUMP(DiskImageWrite, data, SectorSize);
+    if (trace) {
+        DPRINTF(DiskImageWrite, "write: offset=%d count=%d\n", first,
+                count);
+        DDUMP(DiskImageWrite, data, count * SectorSize);
+    }
 
-    return SectorSize;
+    return count * SectorSize;
 }
 
 void
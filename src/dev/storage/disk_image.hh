@@ -33,8 +33,11 @@
 #ifndef __DEV_STORAGE_DISK_IMAGE_HH__
 #define __DEV_STORAGE_DISK_IMAGE_HH__
 
+#include <cstdint>
 #include <fstream>
+#include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include "params/CowDiskImage.hh"
 #include "params/DiskImage.hh"
@@ -65,18 +68,47 @@ class DiskImage : public SimObject
                                 std::streampos offset) const = 0;
     virtual std::streampos write(const uint8_t *data,
                                  std::streampos offset) = 0;
+
+    /**
+     * Read or write a run of consecutive sectors in one request. The
+     * default implementation accesses one sector at a time through
+     * read() and write(), which always trace.
+     *
+     * @param data Buffer of count sectors
+     * @param offset First sector to access
+     * @param count Number of sectors to access
+     * @param trace Trace the access. Threads other than the simulation
+     *              threads must not trace, as tracing uses curTick().
+     * @return The number of bytes accessed
+     */
+    virtual std::streampos readSectors(uint8_t *data, std::streampos offset,
+                                       uint64_t count,
+                                       bool trace=true) const;
+    virtual std::streampos writeSectors(const uint8_t *data,
+                                        std::streampos offset,
+                                        uint64_t count, bool trace=true);
 };
 
 /**
- * Specialization for accessing a raw disk image
+ * Specialization for accessing a raw disk image. The image is mapped
+ * into memory, so that accesses are copies to or from the mapping,
+ * and writes reach the file through the page cache. Files that cannot
+ * be mapped are accessed with pread() and pwrite().
  */
 class RawDiskImage : public DiskImage
 {
   protected:
-    mutable std::fstream stream;
+    int fd;
     std::string file;
     bool readonly;
-    mutable std::streampos disk_size;
+    /** Size of the image in bytes */
+    uint64_t disk_size;
+    /** Mapping of the whole image, or nullptr if it is not mapped */
+    uint8_t *mapping;
+
+    /** Copy bytes of the image, returning the number copied */
+    uint64_t readBytes(uint8_t *buf, uint64_t pos, uint64_t len) const;
+    uint64_t writeBytes(const uint8_t *buf, uint64_t pos, uint64_t len);
 
   public:
     typedef RawDiskImageParams Params;
@@ -92,6 +124,12 @@ class RawDiskImage : public DiskImage
 
     std::streampos read(uint8_t *data, std::streampos offset) const override;
     std::streampos write(const uint8_t *data, std::streampos offset) override;
+
+    std::streampos readSectors(uint8_t *data, std::streampos offset,
+                               uint64_t count,
+                               bool trace=true) const override;
+    std::streampos writeSectors(const uint8_t *data, std::streampos offset,
+                                uint64_t count, bool trace=true) override;
 };
 
 /**
@@ -103,6 +141,15 @@ class RawDiskImage : public DiskImage
  * This object is designed to provide a mechanism for persistant
  * changes to a main disk image, or to provide a place for temporary
  * changes to the image to take place that later may be thrown away.
+ *
+ * The written sectors are indexed by pages of SectorsPerPage sectors,
+ * each with a bitmap of the sectors it holds. The sector data is
+ * carved out of large extents rather than allocated one sector at a
+ * time, and only the sectors that are written take space, so sparse
+ * writes don't pay for whole pages. Runs of sectors that are not in
+ * this layer are read from the child in one request. The saved image
+ * still lists individual sectors, so it is compatible with existing
+ * COW files.
  */
 class CowDiskImage : public DiskImage
 {
@@ -111,16 +158,50 @@ class CowDiskImage : public DiskImage
     static const uint32_t VersionMinor;
 
   protected:
-    struct Sector
+    /** Sectors in a page of the layer, one per bit of the bitmap */
+    static constexpr unsigned SectorsPerPage = 8;
+    /** Sectors allocated at once */
+    static constexpr unsigned SectorsPerExtent = 2048;
+    static_assert(SectorsPerPage <= 8, "The page bitmap is 8 bits wide");
+
+    struct Page
     {
-        uint8_t data[SectorSize];
+        /** Index in the extents of the data of each present sector */
+        uint32_t slot[SectorsPerPage];
+        /** Bitmap of the sectors present in the page */
+        uint8_t valid;
     };
-    typedef std::unordered_map<uint64_t, Sector *> SectorTable;
+    typedef std::unordered_map<uint64_t, Page> PageTable;
 
   protected:
     std::string filename;
     DiskImage *child;
-    SectorTable *table;
+    PageTable table;
+    std::vector<std::unique_ptr<uint8_t[]>> extents;
+    /**
+     * Number of sectors present in the layer, which is also the number
+     * of sectors allocated in the extents
+     */
+    uint64_t numSectors;
+
+    uint8_t *
+    sectorData(uint32_t slot) const
+    {
+        return extents[slot / SectorsPerExtent].get() +
+            (slot % SectorsPerExtent) * SectorSize;
+    }
+
+    /** Data of a sector in this layer, or nullptr if it is not here */
+    const uint8_t *findSector(uint64_t sector) const;
+
+    /** Find the page, allocating it if it is not in the layer yet */
+    Page &allocPage(uint64_t page);
+
+    /** Copy a run of sectors into the layer */
+    void storeSectors(const uint8_t *data, uint64_t first, uint64_t count);
+
+    /** Drop all the sectors of the layer */
+    void clear();
 
   public:
     typedef CowDiskImageParams Params;
@@ -128,6 +209,7 @@ class CowDiskImage : public DiskImage
     ~CowDiskImage();
 
     void notifyFork() override;
+    void init() override;
 
     void initSectorTable(int hash_size);
     bool open(const std::string &file);
@@ -142,6 +224,12 @@ class CowDiskImage : public DiskImage
 
     std::streampos read(uint8_t *data, std::streampos offset) const override;
     std::streampos write(const uint8_t *data, std::streampos offset) override;
+
+    std::streampos readSectors(uint8_t *data, std::streampos offset,
+                               uint64_t count,
+                               bool trace=true) const override;
+    std::streampos writeSectors(const uint8_t *data, std::streampos offset,
+                                uint64_t count, bool trace=true) override;
 };
 
 void SafeRead(std::ifstream &stream, void *data, int count);
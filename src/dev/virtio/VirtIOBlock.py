@@ -48,3 +48,10 @@ class VirtIOBlock(VirtIODeviceBase):
     queueSize = Param.Unsigned(128, "Output queue size (pages)")
 
     image = Param.DiskImage("Disk image")
+
+    latency = Param.Latency(
+        "0ns",
+        "Latency of a request. With a non-zero latency the disk image is "
+        "accessed by a host I/O thread in the background and requests "
+        "complete after the latency, otherwise they complete at once.",
+    )
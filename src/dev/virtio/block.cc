@@ -39,6 +39,7 @@
 
 #include "debug/VIOBlock.hh"
 #include "params/VirtIOBlock.hh"
+#include "sim/sim_exit.hh"
 #include "sim/system.hh"
 
 namespace gem5
@@ -48,16 +49,24 @@ VirtIOBlock::VirtIOBlock(const Params &params)
     : VirtIODeviceBase(params, ID_BLOCK, sizeof(Config), 0),
       qRequests(params.system->physProxy, byteOrder,
                 params.queueSize, *this),
-      image(*params.image)
+      image(*params.image),
+      latency(params.latency),
+      completeEvent([this]{ completeRequests(); }, name())
 {
     registerQueue(qRequests);
 
     config.capacity = image.size();
+
+    // Let the I/O thread finish its accesses before the exit callbacks
+    // of the disk images save them
+    if (latency != 0)
+        registerExitCallback([this]{ stopIOThread(); });
 }
 
 
 VirtIOBlock::~VirtIOBlock()
 {
+    stopIOThread();
 }
 
 void
@@ -69,58 +78,219 @@ VirtIOBlock::readConfig(PacketPtr pkt, Addr cfgOffset)
     readConfigBlob(pkt, cfgOffset, (uint8_t *)&cfg_out);
 }
 
-VirtIOBlock::Status
-VirtIOBlock::read(const BlkRequest &req, VirtDescriptor *desc_chain,
-                  size_t off_data, size_t size)
+void
+VirtIOBlock::reset()
 {
-    std::vector<uint8_t> data(size);
-    uint64_t sector(req.sector);
+    // Let the I/O thread finish with the requests in flight, since it
+    // uses their buffers, then drop them. Their descriptor chains are
+    // never returned to the guest: the reset makes the device forget
+    // the queues, and the driver has to reclaim the buffers it posted
+    // before the reset itself.
+    if (!inFlight.empty()) {
+        DPRINTF(VIOBlock, "Reset drops %i requests in flight, their "
+                "descriptors are not returned to the guest\n",
+                inFlight.size());
+        std::unique_lock<std::mutex> lock(ioMutex);
+        doneCond.wait(lock, [this]{ return inFlight.back()->done; });
+        inFlight.clear();
+    }
+    if (completeEvent.scheduled())
+        deschedule(completeEvent);
 
-    DPRINTF(VIOBlock, "Read request starting @ sector %i (size: %i)\n",
-            sector, size);
+    VirtIODeviceBase::reset();
+}
 
-    if (size % SectorSize != 0)
-        panic("Unexpected request/sector size relationship\n");
+DrainState
+VirtIOBlock::drain()
+{
+    if (!inFlight.empty())
+        return DrainState::Draining;
 
-    for (Addr offset = 0; offset < size; offset += SectorSize) {
-        if (image.read(&data[offset], sector) != SectorSize) {
-            warn("Failed to read sector %i\n", sector);
-            return S_IOERR;
-        }
-        ++sector;
-    }
+    stopIOThread();
+    return DrainState::Drained;
+}
 
-    desc_chain->chainWrite(off_data, &data[0], size);
+void
+VirtIOBlock::notifyFork()
+{
+    // The simulator drains before it forks, which stops the I/O
+    // thread. The child starts its own thread on its first request.
+    panic_if(ioThread.joinable(), "Forking with a running I/O thread");
+}
+
+VirtIOBlock::Status
+VirtIOBlock::read(const BlkRequest &req, uint8_t *data, size_t size,
+                  bool trace)
+{
+    if (image.readSectors(data, req.sector, size / SectorSize,
+                          trace) != size) {
+        return S_IOERR;
+    }
 
     return S_OK;
 }
 
 VirtIOBlock::Status
-VirtIOBlock::write(const BlkRequest &req, VirtDescriptor *desc_chain,
-                  size_t off_data, size_t size)
+VirtIOBlock::write(const BlkRequest &req, const uint8_t *data, size_t size,
+                   bool trace)
+{
+    if (image.writeSectors(data, req.sector, size / SectorSize,
+                           trace) != size) {
+        return S_IOERR;
+    }
+
+    return S_OK;
+}
+
+void
+VirtIOBlock::submit(std::unique_ptr<IORequest> io)
+{
+    if (io->req.type == T_IN || io->req.type == T_OUT) {
+        DPRINTF(VIOBlock, "%s request starting @ sector %i (size: %i)\n",
+                io->req.type == T_IN ? "Read" : "Write", io->req.sector,
+                io->size);
+    }
+
+    if (latency == 0) {
+        execute(*io, true);
+        finish(*io);
+        kick();
+        return;
+    }
+
+    // Requests complete in order as they all have the same latency
+    io->when = curTick() + latency;
+    if (!completeEvent.scheduled())
+        schedule(completeEvent, io->when);
+
+    startIOThread();
+    {
+        std::lock_guard<std::mutex> lock(ioMutex);
+        ioQueue.push_back(io.get());
+    }
+    ioCond.notify_one();
+
+    inFlight.push_back(std::move(io));
+}
+
+void
+VirtIOBlock::execute(IORequest &io, bool trace)
+{
+    switch (io.req.type) {
+      case T_IN:
+        io.status = read(io.req, io.data.data(), io.data.size(), trace);
+        break;
+
+      case T_OUT:
+        io.status = write(io.req, io.data.data(), io.data.size(), trace);
+        break;
+
+      case T_FLUSH:
+        io.status = S_OK;
+        break;
+
+      default:
+        io.status = S_UNSUPP;
+        break;
+    }
+}
+
+void
+VirtIOBlock::finish(IORequest &io)
 {
-    std::vector<uint8_t> data(size);
-    uint64_t sector(req.sector);
+    const size_t data_size(io.size);
 
-    DPRINTF(VIOBlock, "Write request starting @ sector %i (size: %i)\n",
-            sector, size);
+    if (io.status == S_IOERR) {
+        warn("Failed to %s sectors %i-%i\n",
+             io.req.type == T_IN ? "read" : "write", io.req.sector,
+             io.req.sector + data_size / SectorSize - 1);
+    }
+    DPRINTF(VIOBlock, "Request @ sector %i completed (status: %i)\n",
+            io.req.sector, io.status);
 
-    if (size % SectorSize != 0)
-        panic("Unexpected request/sector size relationship\n");
+    if (io.req.type == T_IN && io.status == S_OK)
+        io.desc->chainWrite(sizeof(BlkRequest), io.data.data(), data_size);
 
+    io.desc->chainWrite(sizeof(BlkRequest) + data_size,
+                        &io.status, sizeof(io.status));
 
-    desc_chain->chainRead(off_data, &data[0], size);
+    // Tell the guest that we are done with this descriptor.
+    qRequests.produceDescriptor(
+        io.desc, sizeof(BlkRequest) + data_size + sizeof(Status));
+}
+
+void
+VirtIOBlock::completeRequests()
+{
+    bool produced = false;
+
+    while (!inFlight.empty() && inFlight.front()->when <= curTick()) {
+        IORequest &io = *inFlight.front();
 
-    for (Addr offset = 0; offset < size; offset += SectorSize) {
-        if (image.write(&data[offset], sector) != SectorSize) {
-            warn("Failed to write sector %i\n", sector);
-            return S_IOERR;
+        // Only stall the simulation if the host has not caught up with
+        // the simulated latency
+        {
+            std::unique_lock<std::mutex> lock(ioMutex);
+            doneCond.wait(lock, [&io]{ return io.done; });
         }
-        ++sector;
+
+        finish(io);
+        inFlight.pop_front();
+        produced = true;
     }
 
-    return S_OK;
+    if (produced)
+        kick();
 
+    if (!inFlight.empty()) {
+        schedule(completeEvent, inFlight.front()->when);
+    } else if (drainState() == DrainState::Draining) {
+        stopIOThread();
+        signalDrainDone();
+    }
+}
+
+void
+VirtIOBlock::ioLoop()
+{
+    std::unique_lock<std::mutex> lock(ioMutex);
+    while (true) {
+        ioCond.wait(lock, [this]{ return ioStop || !ioQueue.empty(); });
+        if (ioQueue.empty())
+            return;
+
+        IORequest *io = ioQueue.front();
+        ioQueue.pop_front();
+
+        lock.unlock();
+        execute(*io, false);
+        lock.lock();
+
+        io->done = true;
+        doneCond.notify_one();
+    }
+}
+
+void
+VirtIOBlock::startIOThread()
+{
+    if (!ioThread.joinable())
+        ioThread = std::thread([this]{ ioLoop(); });
+}
+
+void
+VirtIOBlock::stopIOThread()
+{
+    if (!ioThread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(ioMutex);
+        ioStop = true;
+    }
+    ioCond.notify_one();
+    ioThread.join();
+    ioStop = false;
 }
 
 void
@@ -132,40 +302,39 @@ VirtIOBlock::RequestQueue::onNotifyDescriptor(VirtDescriptor *desc)
      * Read the request structure and do endian conversion if
      * necessary.
      */
-    BlkRequest req;
+    auto io = std::make_unique<IORequest>();
+    io->desc = desc;
+    BlkRequest &req = io->req;
     desc->chainRead(0, (uint8_t *)&req, sizeof(req));
     req.type = htog(req.type, byteOrder);
     req.sector = htog(req.sector, byteOrder);
 
-    Status status;
     const size_t data_size(desc->chainSize()
                            - sizeof(BlkRequest) - sizeof(Status));
+    io->size = data_size;
 
     switch (req.type) {
       case T_IN:
-        status = parent.read(req, desc, sizeof(BlkRequest), data_size);
-        break;
-
       case T_OUT:
-        status = parent.write(req, desc, sizeof(BlkRequest), data_size);
+        if (data_size % SectorSize != 0)
+            panic("Unexpected request/sector size relationship\n");
+
+        io->data.resize(data_size);
+        // The data to write is taken from the guest when the request
+        // is submitted
+        if (req.type == T_OUT)
+            desc->chainRead(sizeof(BlkRequest), io->data.data(), data_size);
         break;
 
       case T_FLUSH:
-        status = S_OK;
         break;
 
       default:
         warn("Unsupported IO request: %i\n", req.type);
-        status = S_UNSUPP;
         break;
     }
 
-    desc->chainWrite(sizeof(BlkRequest) + data_size,
-                     &status, sizeof(status));
-
-    // Tell the guest that we are done with this descriptor.
-    produceDescriptor(desc, sizeof(BlkRequest) + data_size + sizeof(Status));
-    parent.kick();
+    parent.submit(std::move(io));
 }
 
 } // namespace gem5
@@ -38,9 +38,17 @@
 #ifndef __DEV_VIRTIO_BLOCK_HH__
 #define __DEV_VIRTIO_BLOCK_HH__
 
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include "base/compiler.hh"
 #include "dev/storage/disk_image.hh"
 #include "dev/virtio/base.hh"
+#include "sim/eventq.hh"
 
 namespace gem5
 {
@@ -62,7 +70,15 @@ struct VirtIOBlockParams;
  *
  * The protocol supports asynchronous request completion by returning
  * descriptor chains when they have been populated by the backing
- * store. However, there is little point in doing so here.
+ * store. With a zero latency, requests are served synchronously when
+ * the guest notifies the queue. With a non-zero latency, the disk
+ * image is accessed by a host I/O thread in the background, and each
+ * request completes, with an interrupt to the guest, after the
+ * latency. The simulation only waits for the host if the access has
+ * not finished by then. Requests are served in order by the single
+ * I/O thread, as the disk images are not thread safe. The I/O thread
+ * doesn't trace its accesses to the disk image, the requests are
+ * traced on the simulation thread when they start and finish.
  *
  * @see https://github.com/rustyrussell/virtio-spec
  * @see http://docs.oasis-open.org/virtio/virtio/v1.0/virtio-v1.0.html
@@ -76,6 +92,11 @@ class VirtIOBlock : public VirtIODeviceBase
 
     void readConfig(PacketPtr pkt, Addr cfgOffset);
 
+    void reset() override;
+
+    DrainState drain() override;
+    void notifyFork() override;
+
   protected:
     static const DeviceId ID_BLOCK = 0x02;
 
@@ -134,30 +155,74 @@ class VirtIOBlock : public VirtIODeviceBase
         uint64_t sector;
     };
 
+    /**
+     * A request in flight, from the time the guest notified it to the
+     * time its descriptor chain is returned.
+     */
+    struct IORequest
+    {
+        /** Request descriptor chain */
+        VirtDescriptor *desc;
+        /** Disk request from guest */
+        BlkRequest req;
+        /** Request data size */
+        size_t size = 0;
+        /** Request data, copied from or to the descriptor chain */
+        std::vector<uint8_t> data;
+        /** Result of the request */
+        Status status = S_OK;
+        /** Tick at which the request completes */
+        Tick when = 0;
+        /** Set by the I/O thread once the disk image was accessed */
+        bool done = false;
+    };
+
     /**
      * Device read request.
      *
      * @param req Disk request from guest.
-     * @param desc_chain Request descriptor chain (from start of
-     *                   request)
-     * @param off_data Offset into the descriptor chain where data
-     *                 should be written.
+     * @param data Buffer the sectors are read to.
      * @param size Request data size.
+     * @param trace Trace the access to the disk image.
      */
-    Status read(const BlkRequest &req, VirtDescriptor *desc_chain,
-                size_t off_data, size_t size);
+    Status read(const BlkRequest &req, uint8_t *data, size_t size,
+                bool trace);
     /**
      * Device write request.
      *
      * @param req Disk request from guest.
-     * @param desc_chain Request descriptor chain (from start of
-     *                   request)
-     * @param off_data Offset into the descriptor chain where data
-     *                 should be read.
+     * @param data Buffer the sectors are written from.
      * @param size Request data size.
+     * @param trace Trace the access to the disk image.
+     */
+    Status write(const BlkRequest &req, const uint8_t *data, size_t size,
+                 bool trace);
+
+    /**
+     * Start a request read from the queue, serving it at once or
+     * handing it to the I/O thread.
+     */
+    void submit(std::unique_ptr<IORequest> io);
+
+    /**
+     * Access the disk image for a request. This doesn't use curTick()
+     * or trace unless trace is set, as it runs on the I/O thread.
      */
-    Status write(const BlkRequest &req, VirtDescriptor *desc_chain,
-                 size_t off_data, size_t size);
+    void execute(IORequest &io, bool trace);
+
+    /** Write the result of a request to the guest and return its chain */
+    void finish(IORequest &io);
+
+    /** Finish the requests whose latency has elapsed */
+    void completeRequests();
+
+    /** Main loop of the I/O thread */
+    void ioLoop();
+
+    /** Start the I/O thread, unless it is running */
+    void startIOThread();
+    /** Stop the I/O thread once it has served the queued requests */
+    void stopIOThread();
 
   protected:
     /**
@@ -185,6 +250,36 @@ class VirtIOBlock : public VirtIODeviceBase
 
     /** Image backing this device */
     DiskImage &image;
+
+    /** Latency of a request, zero to serve requests synchronously */
+    const Tick latency;
+
+    /** Requests in flight, in the order they complete */
+    std::deque<std::unique_ptr<IORequest>> inFlight;
+
+    /** Event finishing the oldest request in flight */
+    EventFunctionWrapper completeEvent;
+
+    /** @{
+     * @name I/O thread state, protected by ioMutex
+     */
+    std::mutex ioMutex;
+    /** Signalled when a request is queued or the thread should stop */
+    std::condition_variable ioCond;
+    /** Signalled when the I/O thread has served a request */
+    std::condition_variable doneCond;
+    /** Requests queued for the I/O thread */
+    std::deque<IORequest *> ioQueue;
+    bool ioStop = false;
+    /** @} */
+
+    /**
+     * Host I/O thread. It is started by the first request, and stopped
+     * when the device drains and when the simulator exits, so that no
+     * thread is running when the simulator forks or saves the disk
+     * images.
+     */
+    std::thread ioThread;
 };
 
 } // namespace gem5
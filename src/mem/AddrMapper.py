@@ -34,6 +34,7 @@
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 from m5.params import *
+from m5.proxy import *
 from m5.SimObject import SimObject
 
 # An address mapper changes the packet addresses in going from the
@@ -82,3 +83,27 @@ class RangeAddrMapper(AddrMapper):
     remapped_ranges = VectorParam.AddrRange(
         "Ranges of memory that are being mapped to"
     )
+
+
+# Page migrator that backs a range with a near and a far memory, and
+# moves the most frequently accessed pages to near memory. Both memories
+# are reached through the request port, typically behind a crossbar.
+class PageMigrator(AddrMapper):
+    type = "PageMigrator"
+    cxx_header = "mem/page_migrator.hh"
+    cxx_class = "gem5::PageMigrator"
+
+    system = Param.System(Parent.any, "System the migrator belongs to")
+
+    range = Param.AddrRange("Range exposed to the requestors")
+    near_range = Param.AddrRange("Range of the near memory")
+    far_range = Param.AddrRange("Range of the far memory")
+
+    page_size = Param.MemorySize("4KiB", "Granularity of the migrations")
+    epoch = Param.Latency("100us", "Interval between migration decisions")
+    hot_threshold = Param.Unsigned(
+        8, "Minimum access count for a far page to be promoted"
+    )
+    max_migrations = Param.Unsigned(
+        16, "Maximum number of page swaps per epoch"
+    )
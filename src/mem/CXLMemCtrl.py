@@ -0,0 +1,59 @@
+# Copyright (c) 2024 The gem5 contributors
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+from m5.params import *
+from m5.proxy import *
+from m5.objects.MemCtrl import *
+
+
+# CXLMemCtrl models a CXL.mem type 3 memory expander. The memory
+# controller and the interface `dram` defined in MemCtrl are the media
+# side of the device, reached through a CXL link.
+class CXLMemCtrl(MemCtrl):
+    type = "CXLMemCtrl"
+    cxx_header = "mem/cxl_mem_ctrl.hh"
+    cxx_class = "gem5::memory::CXLMemCtrl"
+
+    # One-way latency of the link including the host and device ports,
+    # the PHY and the retimers, if any
+    link_latency = Param.Latency("35ns", "One-way link latency")
+
+    # Defaults to a x8 PCIe 5.0 link in each direction
+    link_bandwidth = Param.MemoryBandwidth(
+        "32GB/s", "Link bandwidth in each direction"
+    )
+
+    # A 68B flit is made of 4 slots of 16B plus 4B of CRC and protocol
+    # identifier. Each message takes a header slot and its data, if
+    # any, takes further slots.
+    flit_slots = Param.Unsigned(4, "Number of slots in a flit")
+    slot_size = Param.Unsigned(16, "Size of a flit slot in bytes")
+    flit_overhead = Param.Unsigned(4, "Bytes of a flit not in any slot")
+
+    request_credits = Param.Unsigned(
+        32, "Number of requests the device accepts onto the link"
+    )
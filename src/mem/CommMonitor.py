@@ -64,6 +64,26 @@ class CommMonitor(SimObject):
     # control the sample period window length of this monitor
     sample_period = Param.Clock("1ms", "Sample period for histograms")
 
+    # sample the per-transaction distributions (burst length, latency,
+    # ITT and address) to reduce the overhead of the monitor, the
+    # bandwidth, transaction and outstanding request counts are not
+    # affected
+    sample_ratio = Param.Unsigned(
+        1, "Sample the distributions for one in this many requests"
+    )
+    sample_window = Param.Latency(
+        "0ns",
+        "Only sample the distributions for requests in this window at "
+        "the start of each sample period (0 samples the whole period)",
+    )
+
+    # count the burst lengths, latencies and ITTs in pre-allocated
+    # log-linear buckets (as an HDR histogram with 5 significant bits)
+    # and only fold them into the histograms when the stats are dumped
+    bucketed_hists = Param.Bool(
+        False, "Fold bucketed distributions into the stats at dump time"
+    )
+
     # for each histogram, set the number of bins and enable the user
     # to disable the measurement, reads and writes use the same
     # parameters
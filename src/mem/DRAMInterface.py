@@ -70,6 +70,21 @@ class DRAMInterface(MemInterface):
     # performance being lower when enabled
     enable_dram_powerdown = Param.Bool(False, "Enable powerdown states")
 
+    # Without powerdown states, idle ranks keep refreshing and every
+    # refresh takes several events. If enabled, the refreshes of an idle
+    # channel are instead accounted for when it is next accessed or the
+    # stats are dumped
+    lazy_refresh = Param.Bool(
+        False, "Compute the refreshes of idle ranks when next needed"
+    )
+
+    # Check every scheduling decision of the indexed FR-FCFS scheduler
+    # against a scan of the whole queue, which is slow and only meant for
+    # testing
+    check_frfcfs = Param.Bool(
+        False, "Check FR-FCFS decisions against a scan of the queue"
+    )
+
     # For power modelling we need to know if the DRAM has a DLL or not
     dll = Param.Bool(True, "DRAM has DLL or not")
 
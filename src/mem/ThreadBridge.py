@@ -39,8 +39,13 @@ class ThreadBridge(SimObject):
     the issue. The receiver side is expected to use the same EventQueue that
     the ThreadBridge is using.
 
-    Given that this is only used for simulation speed accelerating, only the
-    atomic and functional access are supported.
+    Atomic and functional accesses migrate to the bridge's EventQueue and
+    complete immediately. Timing requests are handed over to the bridge's
+    EventQueue after request_delay and responses back to the requestor's
+    EventQueue after response_delay. When the two sides run on different
+    threads the delays act as the lookahead and must not be shorter than
+    the simulation quantum. The bridge never refuses a timing request,
+    since the requestor cannot observe the state of the other thread.
 
     Example:
 
@@ -58,3 +63,6 @@ class ThreadBridge(SimObject):
 
     in_port = ResponsePort("Incoming port")
     out_port = RequestPort("Outgoing port")
+
+    request_delay = Param.Latency("0ns", "Timing request crossing delay")
+    response_delay = Param.Latency("0ns", "Timing response crossing delay")
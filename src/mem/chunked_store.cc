@@ -0,0 +1,674 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "mem/chunked_store.hh"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "base/cprintf.hh"
+#include "base/intmath.hh"
+#include "base/logging.hh"
+#include "config/have_zstd.hh"
+
+#if HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace gem5
+{
+
+namespace memory
+{
+
+namespace chunked_store
+{
+
+namespace
+{
+
+constexpr char magic[8] = { 'g', 'e', 'm', '5', 'p', 'm', 'c', '\0' };
+constexpr uint32_t version = 2;
+constexpr uint32_t byteOrderMark = 0x01020304;
+
+/** Limit on the length of a chain of incremental files */
+constexpr size_t maxChain = 4096;
+
+enum Encoding : uint32_t
+{
+    /** The chunk only contains zeros and isn't stored */
+    Zero = 0,
+    Raw = 1,
+    Zstd = 2,
+    /** The chunk is the same as in the parent file */
+    Parent = 3,
+};
+
+struct Header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrderMark;
+    uint64_t size;
+    uint64_t chunkSize;
+    uint64_t chunks;
+    uint64_t indexOffset;
+};
+
+struct IndexEntry
+{
+    uint64_t offset;
+    uint32_t stored;
+    uint32_t encoding;
+    uint64_t hash;
+};
+
+/** Index entry of version 1 files */
+struct IndexEntryV1
+{
+    uint64_t offset;
+    uint32_t stored;
+    uint32_t encoding;
+};
+
+static_assert(sizeof(Header) == 48, "Unexpected chunked store header size");
+static_assert(sizeof(IndexEntry) == 24, "Unexpected index entry size");
+static_assert(sizeof(IndexEntryV1) == 16, "Unexpected index entry size");
+
+bool
+isZero(const uint8_t *data, size_t size)
+{
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        if (word)
+            return false;
+    }
+    for (; i < size; ++i) {
+        if (data[i])
+            return false;
+    }
+    return true;
+}
+
+inline uint64_t
+rotl(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+/**
+ * Hash the contents of a chunk. This is a multiply-rotate hash over
+ * four independent lanes (the structure of XXH64), which is fast
+ * enough not to slow down checkpointing. Zero is reserved for chunks
+ * that only contain zeros.
+ */
+uint64_t
+hashChunk(const uint8_t *data, size_t size)
+{
+    constexpr uint64_t p1 = 0x9E3779B185EBCA87ULL;
+    constexpr uint64_t p2 = 0xC2B2AE3D27D4EB4FULL;
+    constexpr uint64_t p3 = 0x165667B19E3779F9ULL;
+
+    uint64_t lanes[4] = { p1 + p2, p2, 0, -p1 };
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (int l = 0; l < 4; ++l) {
+            uint64_t word;
+            std::memcpy(&word, data + i + l * 8, sizeof(word));
+            lanes[l] = rotl(lanes[l] + word * p2, 31) * p1;
+        }
+    }
+
+    uint64_t h = size * p3;
+    for (int l = 0; l < 4; ++l)
+        h = rotl(h ^ (rotl(lanes[l] * p2, 31) * p1), 27) * p1 + p3;
+    for (; i < size; ++i)
+        h = rotl(h ^ (data[i] * p3), 11) * p1;
+
+    h ^= h >> 33;
+    h *= p2;
+    h ^= h >> 29;
+    h *= p3;
+    h ^= h >> 32;
+    return h ? h : 1;
+}
+
+bool
+writeAll(int fd, const void *data, size_t size, off_t offset)
+{
+    auto *ptr = static_cast<const char *>(data);
+    while (size) {
+        const ssize_t ret = pwrite(fd, ptr, size, offset);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            return false;
+        ptr += ret;
+        offset += ret;
+        size -= ret;
+    }
+    return true;
+}
+
+bool
+readAll(int fd, void *data, size_t size, off_t offset)
+{
+    auto *ptr = static_cast<char *>(data);
+    while (size) {
+        const ssize_t ret = pread(fd, ptr, size, offset);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            return false;
+        ptr += ret;
+        offset += ret;
+        size -= ret;
+    }
+    return true;
+}
+
+/**
+ * State shared by the worker threads. Workers stop at the first
+ * error, which is reported by the calling thread once they are done.
+ */
+class Workers
+{
+  private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::string error;
+    std::atomic<bool> _failed;
+
+  public:
+    /** Next chunk to process */
+    std::atomic<uint64_t> next;
+
+    Workers() : _failed(false), next(0) {}
+
+    bool failed() const { return _failed; }
+
+    void
+    fail(const std::string &msg)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!_failed)
+                error = msg;
+            _failed = true;
+        }
+        cv.notify_all();
+    }
+
+    /**
+     * Run a critical section once the predicate is true, or give up
+     * if a worker failed.
+     */
+    template <class Pred, class Func>
+    bool
+    inOrder(Pred pred, Func func)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&]() { return _failed || pred(); });
+            if (_failed)
+                return false;
+            func();
+        }
+        cv.notify_all();
+        return true;
+    }
+
+    /** Run a function on several threads and wait for all of them. */
+    void
+    run(unsigned threads, uint64_t chunks, const std::function<void()> &work)
+    {
+        if (threads == 0)
+            threads = std::max(std::thread::hardware_concurrency(), 1U);
+        threads = std::max<uint64_t>(std::min<uint64_t>(threads, chunks), 1);
+
+        std::vector<std::thread> pool;
+        for (unsigned i = 1; i < threads; ++i)
+            pool.emplace_back(work);
+        work();
+        for (auto &t : pool)
+            t.join();
+    }
+
+    const std::string &message() const { return error; }
+};
+
+/** An open file of a chain of incremental files. */
+struct File
+{
+    std::string path;
+    int fd;
+    Header header;
+    std::vector<IndexEntry> index;
+    /** Path of the parent file, empty if there is none */
+    std::string parent;
+};
+
+/** Open a file and read its header and index. */
+void
+openFile(File &file, uint64_t size)
+{
+    const std::string &path = file.path;
+    file.fd = open(path.c_str(), O_RDONLY);
+    fatal_if(file.fd == -1, "Can't open physical memory checkpoint file "
+             "'%s': %s\n", path, strerror(errno));
+
+    Header &header = file.header;
+    fatal_if(!readAll(file.fd, &header, sizeof(header), 0) ||
+             std::memcmp(header.magic, magic, sizeof(magic)) != 0,
+             "'%s' isn't a chunked physical memory checkpoint.\n", path);
+    fatal_if(header.byteOrderMark != byteOrderMark,
+             "'%s' was written on a host with a different byte order.\n",
+             path);
+    fatal_if(header.version < 1 || header.version > version,
+             "Unsupported chunked memory checkpoint version %d in '%s'.\n",
+             header.version, path);
+    fatal_if(header.size != size,
+             "Memory range size has changed! Saw %lld, expected %lld\n",
+             header.size, size);
+    fatal_if(header.chunkSize == 0 || header.chunkSize > (1ULL << 31) ||
+             header.chunks != divCeil(size, header.chunkSize),
+             "Corrupt chunk index in '%s'.\n", path);
+
+    file.index.resize(header.chunks);
+    bool ok = true;
+    if (header.version == 1) {
+        std::vector<IndexEntryV1> index(header.chunks);
+        ok = readAll(file.fd, index.data(),
+                     index.size() * sizeof(IndexEntryV1), header.indexOffset);
+        for (size_t i = 0; i < index.size(); ++i) {
+            file.index[i] = IndexEntry{ index[i].offset, index[i].stored,
+                                        index[i].encoding, 0 };
+        }
+    } else {
+        uint32_t length = 0;
+        ok = readAll(file.fd, &length, sizeof(length), sizeof(header));
+        if (ok && length) {
+            std::string parent(length, '\0');
+            ok = readAll(file.fd, &parent[0], length,
+                         sizeof(header) + sizeof(length));
+            file.parent = (std::filesystem::path(path).parent_path() /
+                           parent).string();
+        }
+        ok = ok && readAll(file.fd, file.index.data(),
+                           file.index.size() * sizeof(IndexEntry),
+                           header.indexOffset);
+    }
+    fatal_if(!ok, "Failed to read the chunk index of '%s'.\n", path);
+}
+
+/** Open a file and all of its ancestors. */
+void
+openChain(std::vector<File> &chain, const std::string &path, uint64_t size)
+{
+    for (std::string next = path; !next.empty(); next = chain.back().parent) {
+        fatal_if(chain.size() == maxChain,
+                 "Too many incremental memory checkpoints in the chain of "
+                 "'%s'.\n", path);
+        chain.emplace_back();
+        chain.back().path = next;
+        openFile(chain.back(), size);
+        fatal_if(chain.back().header.chunkSize != chain[0].header.chunkSize,
+                 "'%s' and its parent '%s' use different chunk sizes.\n",
+                 chain[chain.size() - 2].path, next);
+    }
+}
+
+/** Close the files of a chain. */
+void
+closeChain(std::vector<File> &chain)
+{
+    for (auto &file : chain) {
+        fatal_if(close(file.fd) != 0,
+                 "Close failed on physical memory checkpoint file '%s'\n",
+                 file.path);
+    }
+    chain.clear();
+}
+
+/** Buffers and decompression context of a thread reading chunks. */
+struct ChunkReader
+{
+    std::vector<uint8_t> chunk;
+    std::vector<char> buf;
+#if HAVE_ZSTD
+    ZSTD_DCtx *ctx = nullptr;
+#endif
+
+    ChunkReader(uint64_t chunk_size) : chunk(chunk_size) {}
+
+    ~ChunkReader()
+    {
+#if HAVE_ZSTD
+        ZSTD_freeDCtx(ctx);
+#endif
+    }
+
+    /**
+     * Read chunk i of a chain into the chunk buffer.
+     *
+     * @param zero Set if the chunk only contains zeros, which isn't
+     * read.
+     * @return An error message, empty if the chunk was read.
+     */
+    std::string
+    load(const std::vector<File> &chain, uint64_t i, uint64_t size,
+         bool &zero)
+    {
+        // Find the file that stores the chunk.
+        size_t f = 0;
+        while (f < chain.size() && chain[f].index[i].encoding == Parent)
+            ++f;
+        if (f == chain.size())
+            return csprintf("Chunk %d isn't in any parent", i);
+
+        const int fd = chain[f].fd;
+        const IndexEntry &entry = chain[f].index[i];
+        const uint64_t chunk_size = chain[f].header.chunkSize;
+        const uint64_t base = i * chunk_size;
+        const size_t len = std::min(chunk_size, size - base);
+
+        zero = entry.encoding == Zero;
+        if (zero) {
+            return "";
+        } else if (entry.encoding == Raw && entry.stored == len) {
+            if (!readAll(fd, chunk.data(), len, entry.offset))
+                return strerror(errno);
+        } else if (entry.encoding == Zstd) {
+#if HAVE_ZSTD
+            if (!ctx && !(ctx = ZSTD_createDCtx()))
+                return "Failed to create a zstd context";
+            buf.resize(entry.stored);
+            if (!readAll(fd, buf.data(), entry.stored, entry.offset))
+                return strerror(errno);
+            const size_t ret = ZSTD_decompressDCtx(
+                ctx, chunk.data(), len, buf.data(), entry.stored);
+            if (ZSTD_isError(ret) || ret != len)
+                return csprintf("Corrupt chunk %d in '%s'", i, chain[f].path);
+#else
+            return "gem5 was built without zstd";
+#endif
+        } else {
+            return csprintf("Corrupt chunk %d in '%s'", i, chain[f].path);
+        }
+        return "";
+    }
+};
+
+} // anonymous namespace
+
+Digest
+write(const std::string &path, const uint8_t *pmem, uint64_t size,
+      unsigned threads, int level, const Digest *parent, bool verify)
+{
+#if !HAVE_ZSTD
+    if (level > 0) {
+        warn_once("gem5 was built without zstd, memory checkpoints will "
+                  "not be compressed.\n");
+    }
+#endif
+
+    Header header;
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.byteOrderMark = byteOrderMark;
+    header.size = size;
+    header.chunkSize = chunkSize;
+    header.chunks = divCeil(size, chunkSize);
+
+    // The parent is referred to relative to this file so that a chain
+    // of checkpoints can be moved as a whole. Its chain is kept open to
+    // verify the chunks that have the same hash.
+    std::string parent_path;
+    std::vector<File> parent_chain;
+    if (parent && parent->valid()) {
+        namespace fs = std::filesystem;
+        std::error_code ec;
+        const fs::path dir = fs::path(path).parent_path();
+        if (parent->hashes.size() != header.chunks ||
+            !fs::exists(parent->path, ec)) {
+            warn("Parent memory checkpoint '%s' is unusable, writing a "
+                 "complete checkpoint.\n", parent->path);
+            parent = nullptr;
+        } else {
+            openChain(parent_chain, parent->path, size);
+            for (const auto &file : parent_chain) {
+                // Overwriting a file of the chain would lose its chunks
+                if (fs::exists(path, ec) &&
+                    fs::equivalent(path, file.path, ec)) {
+                    closeChain(parent_chain);
+                    parent = nullptr;
+                    break;
+                }
+            }
+        }
+
+        if (parent) {
+            const fs::path rel = fs::relative(parent->path,
+                                              dir.empty() ? "." : dir, ec);
+            parent_path = ec ? fs::absolute(parent->path).string() :
+                               rel.string();
+        }
+    } else {
+        parent = nullptr;
+    }
+
+    const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    fatal_if(fd == -1, "Can't open physical memory checkpoint file '%s': "
+             "%s\n", path, strerror(errno));
+
+    Digest digest;
+    digest.path = path;
+    digest.hashes.resize(header.chunks);
+
+    std::vector<IndexEntry> index(header.chunks);
+    // Chunks are laid out in address order. Workers reserve space in
+    // the file in chunk order, but compress and write concurrently.
+    uint64_t reserved = 0;
+    uint64_t end = sizeof(header) + sizeof(uint32_t) + parent_path.size();
+
+    Workers workers;
+    workers.run(threads, header.chunks, [&]() {
+        std::vector<char> buf;
+        ChunkReader parent_reader(parent && verify ? chunkSize : 0);
+#if HAVE_ZSTD
+        ZSTD_CCtx *ctx = nullptr;
+        if (level > 0) {
+            ctx = ZSTD_createCCtx();
+            if (!ctx) {
+                workers.fail("Failed to create a zstd context");
+                return;
+            }
+            ZSTD_CCtx_setParameter(ctx, ZSTD_c_compressionLevel, level);
+            buf.resize(ZSTD_compressBound(chunkSize));
+        }
+#endif
+
+        uint64_t i;
+        while (!workers.failed() && (i = workers.next++) < header.chunks) {
+            const uint8_t *data = pmem + i * chunkSize;
+            const size_t len = std::min(chunkSize, size - i * chunkSize);
+
+            IndexEntry &entry = index[i];
+            entry.stored = 0;
+            entry.encoding = Zero;
+            entry.hash = 0;
+            const void *out = nullptr;
+            if (!isZero(data, len)) {
+                entry.hash = hashChunk(data, len);
+                // Reading the parent back costs about as much as
+                // storing the chunk, so a matching hash is trusted
+                // unless asked otherwise. When verifying, chunks the
+                // parent fails to provide are stored.
+                bool zero = true;
+                if (parent && parent->hashes[i] == entry.hash &&
+                    (!verify ||
+                     (parent_reader.load(parent_chain, i, size,
+                                         zero).empty() &&
+                      !zero &&
+                      std::memcmp(parent_reader.chunk.data(), data,
+                                  len) == 0))) {
+                    entry.encoding = Parent;
+                } else {
+                    entry.stored = len;
+                    entry.encoding = Raw;
+                    out = data;
+                }
+            }
+#if HAVE_ZSTD
+            if (ctx && entry.encoding == Raw) {
+                const size_t ret = ZSTD_compress2(ctx, buf.data(),
+                                                  buf.size(), data, len);
+                if (ZSTD_isError(ret)) {
+                    workers.fail(ZSTD_getErrorName(ret));
+                    break;
+                }
+                if (ret < len) {
+                    entry.stored = ret;
+                    entry.encoding = Zstd;
+                    out = buf.data();
+                }
+            }
+#endif
+            digest.hashes[i] = entry.hash;
+
+            const bool ok = workers.inOrder(
+                [&]() { return reserved == i; },
+                [&]() {
+                    entry.offset = end;
+                    end += entry.stored;
+                    ++reserved;
+                });
+            if (!ok)
+                break;
+
+            if (entry.stored && !writeAll(fd, out, entry.stored, entry.offset))
+                workers.fail(strerror(errno));
+        }
+
+#if HAVE_ZSTD
+        ZSTD_freeCCtx(ctx);
+#endif
+    });
+
+    header.indexOffset = end;
+    const uint32_t parent_length = parent_path.size();
+    fatal_if(workers.failed() ||
+             !writeAll(fd, index.data(), index.size() * sizeof(IndexEntry),
+                       header.indexOffset) ||
+             !writeAll(fd, &header, sizeof(header), 0) ||
+             !writeAll(fd, &parent_length, sizeof(parent_length),
+                       sizeof(header)) ||
+             !writeAll(fd, parent_path.data(), parent_path.size(),
+                       sizeof(header) + sizeof(parent_length)),
+             "Write failed on physical memory checkpoint file '%s': %s\n",
+             path, workers.failed() ? workers.message() : strerror(errno));
+
+    fatal_if(close(fd) != 0,
+             "Close failed on physical memory checkpoint file '%s'\n", path);
+    closeChain(parent_chain);
+
+    return digest;
+}
+
+Digest
+read(const std::string &path, uint8_t *pmem, uint64_t size,
+     unsigned threads, size_t page_size)
+{
+    std::vector<File> chain;
+    openChain(chain, path, size);
+
+    const Header &header = chain[0].header;
+
+    Workers workers;
+    workers.run(threads, header.chunks, [&]() {
+        ChunkReader reader(header.chunkSize);
+
+        uint64_t i;
+        while (!workers.failed() && (i = workers.next++) < header.chunks) {
+            bool zero;
+            const std::string error = reader.load(chain, i, size, zero);
+            if (!error.empty()) {
+                workers.fail(error);
+                break;
+            }
+            if (zero)
+                continue;
+
+            // Only copy pages that are non-zero, so we don't give the
+            // VM system hell
+            const uint64_t base = i * header.chunkSize;
+            const size_t len = std::min(header.chunkSize, size - base);
+            const uint8_t *chunk = reader.chunk.data();
+            for (size_t off = 0; off < len; off += page_size) {
+                const size_t n = std::min(page_size, len - off);
+                if (!isZero(chunk + off, n))
+                    std::memcpy(pmem + base + off, chunk + off, n);
+            }
+        }
+    });
+
+    fatal_if(workers.failed(),
+             "Failed to read physical memory checkpoint file '%s': %s\n",
+             path, workers.message());
+
+    Digest digest;
+    digest.path = path;
+    // Version 1 files don't record hashes.
+    if (header.version > 1 && header.chunkSize == chunkSize) {
+        digest.hashes.resize(header.chunks);
+        for (size_t i = 0; i < header.chunks; ++i)
+            digest.hashes[i] = chain[0].index[i].hash;
+    }
+
+    closeChain(chain);
+    return digest;
+}
+
+} // namespace chunked_store
+} // namespace memory
+} // namespace gem5
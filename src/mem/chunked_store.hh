@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __MEM_CHUNKED_STORE_HH__
+#define __MEM_CHUNKED_STORE_HH__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gem5
+{
+
+namespace memory
+{
+
+/**
+ * Checkpoint format for the contents of a backing store that can be
+ * written and read by several threads.
+ *
+ * The store is split into fixed size chunks that are compressed
+ * independently with zstd (or stored uncompressed if gem5 was built
+ * without it). Chunks that only contain zeros are not stored at all.
+ *
+ * A file can be incremental: chunks that are identical to the same
+ * chunk of a parent file are not stored either, and are read from the
+ * parent (or one of its ancestors) when the file is restored. Chunks
+ * are compared by a hash of their contents recorded in the index, so
+ * changes are detected no matter how memory was written (timing and
+ * functional accesses, backdoors, KVM). Chunks with the same hash
+ * can optionally be compared with the chunk read back from the parent
+ * before they are left out.
+ *
+ * The file starts with a header and the path of the parent file
+ * relative to the directory of the file (empty if there is no
+ * parent), followed by the chunk data in address order and an index
+ * describing every chunk:
+ *
+ *   char magic[8]; uint32 version; uint32 byte order mark;
+ *   uint64 store size; uint64 chunk size; uint64 chunk count;
+ *   uint64 index offset;
+ *   uint32 parent path length; char parent path[];
+ *   chunk data...
+ *   index: { uint64 offset; uint32 stored size; uint32 encoding;
+ *            uint64 hash }[]
+ *
+ * Version 1 files have no parent and no hashes.
+ */
+namespace chunked_store
+{
+
+/** Size of a chunk, the unit of compression and parallelism */
+constexpr uint64_t chunkSize = 1024 * 1024;
+
+/**
+ * Chunk hashes of a file, used as the parent of an incremental file.
+ * The hashes match the contents of the backing store right after the
+ * file was written or read.
+ */
+struct Digest
+{
+    /** Path of the file */
+    std::string path;
+    /** Hash of every chunk, empty if unknown */
+    std::vector<uint64_t> hashes;
+
+    bool valid() const { return !hashes.empty(); }
+};
+
+/**
+ * Write the contents of a backing store.
+ *
+ * @param path File to write.
+ * @param pmem Contents of the backing store.
+ * @param size Size of the backing store.
+ * @param threads Number of threads, 0 to use one per host core.
+ * @param level zstd compression level, 0 to store the chunks
+ * uncompressed.
+ * @param parent Write an incremental file against this file, or
+ * nullptr to write a complete file.
+ * @param verify Read back the chunks whose hash matches the parent and
+ * store them if their contents differ, rather than trusting the hash.
+ * @return The digest of the new file.
+ */
+Digest write(const std::string &path, const uint8_t *pmem, uint64_t size,
+             unsigned threads, int level, const Digest *parent = nullptr,
+             bool verify = false);
+
+/**
+ * Restore the contents of a backing store. The backing store is
+ * expected to be zeroed, pages that only contain zeros are left
+ * untouched to keep sparse memories sparse. Incremental files are
+ * read together with their ancestors.
+ *
+ * @param path File to read.
+ * @param pmem Backing store to fill.
+ * @param size Size of the backing store.
+ * @param threads Number of threads, 0 to use one per host core.
+ * @param page_size Host page size.
+ * @return The digest of the file.
+ */
+Digest read(const std::string &path, uint8_t *pmem, uint64_t size,
+            unsigned threads, size_t page_size);
+
+} // namespace chunked_store
+} // namespace memory
+} // namespace gem5
+
+#endif // __MEM_CHUNKED_STORE_HH__
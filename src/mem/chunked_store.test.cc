@@ -0,0 +1,296 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "config/have_zstd.hh"
+#include "mem/chunked_store.hh"
+
+using namespace gem5;
+using namespace gem5::memory;
+
+namespace
+{
+
+constexpr uint64_t chunkSize = chunked_store::chunkSize;
+constexpr size_t pageSize = 4096;
+
+/** Chunk encodings, as recorded in the index of a file */
+enum Encoding : uint32_t { Zero = 0, Raw = 1, Zstd = 2, Parent = 3 };
+
+class ChunkedStoreTest : public testing::Test
+{
+  protected:
+    std::filesystem::path dir;
+
+    void
+    SetUp() override
+    {
+        char tmpl[] = "/tmp/chunked_store_test.XXXXXX";
+        ASSERT_NE(mkdtemp(tmpl), nullptr);
+        dir = tmpl;
+    }
+
+    void TearDown() override { std::filesystem::remove_all(dir); }
+
+    std::string path(const std::string &name) { return dir / name; }
+
+    /**
+     * A store with a zero chunk, a chunk of random data, a compressible
+     * chunk, another zero chunk and a partial chunk at the end.
+     */
+    static std::vector<uint8_t>
+    makeStore()
+    {
+        std::vector<uint8_t> store(4 * chunkSize + chunkSize / 2 + 100, 0);
+
+        std::mt19937_64 rng(42);
+        for (uint64_t i = chunkSize; i < 2 * chunkSize; ++i)
+            store[i] = rng();
+
+        for (uint64_t i = 2 * chunkSize; i < 3 * chunkSize; i += 64)
+            store[i] = i / 64;
+
+        store[4 * chunkSize + 3] = 0xaa;
+        store.back() = 0x55;
+        return store;
+    }
+
+    /** Read back the encoding of every chunk from the index of a file. */
+    static std::vector<uint32_t>
+    encodings(const std::string &path)
+    {
+        struct
+        {
+            char magic[8];
+            uint32_t version;
+            uint32_t byteOrderMark;
+            uint64_t size;
+            uint64_t chunkSize;
+            uint64_t chunks;
+            uint64_t indexOffset;
+        } header;
+        struct
+        {
+            uint64_t offset;
+            uint32_t stored;
+            uint32_t encoding;
+            uint64_t hash;
+        } entry;
+
+        std::vector<uint32_t> result;
+        const int fd = open(path.c_str(), O_RDONLY);
+        EXPECT_NE(fd, -1);
+        if (pread(fd, &header, sizeof(header), 0) == sizeof(header)) {
+            for (uint64_t i = 0; i < header.chunks; ++i) {
+                const off_t offset = header.indexOffset + i * sizeof(entry);
+                if (pread(fd, &entry, sizeof(entry), offset) != sizeof(entry))
+                    break;
+                result.push_back(entry.encoding);
+            }
+        }
+        close(fd);
+        return result;
+    }
+
+    /** Restore a file into a zeroed store. */
+    static std::vector<uint8_t>
+    restore(const std::string &path, size_t size, unsigned threads = 2)
+    {
+        std::vector<uint8_t> store(size, 0);
+        chunked_store::read(path, store.data(), store.size(), threads,
+                            pageSize);
+        return store;
+    }
+};
+
+} // anonymous namespace
+
+/** Test a store that only contains zeros, nothing is stored. */
+TEST_F(ChunkedStoreTest, ZeroChunks)
+{
+    std::vector<uint8_t> store(3 * chunkSize, 0);
+    const auto digest = chunked_store::write(path("zero.pmemc"), store.data(),
+                                             store.size(), 2, 1);
+    ASSERT_EQ(digest.hashes, std::vector<uint64_t>(3, 0));
+    ASSERT_EQ(encodings(path("zero.pmemc")),
+              std::vector<uint32_t>({Zero, Zero, Zero}));
+    ASSERT_LT(std::filesystem::file_size(path("zero.pmemc")), pageSize);
+
+    ASSERT_EQ(restore(path("zero.pmemc"), store.size()), store);
+}
+
+/** Test uncompressed chunks. */
+TEST_F(ChunkedStoreTest, RawChunks)
+{
+    const auto store = makeStore();
+    const auto digest = chunked_store::write(path("raw.pmemc"), store.data(),
+                                             store.size(), 3, 0);
+    ASSERT_EQ(digest.hashes.size(), 5);
+    ASSERT_EQ(encodings(path("raw.pmemc")),
+              std::vector<uint32_t>({Zero, Raw, Raw, Zero, Raw}));
+
+    const auto restored = restore(path("raw.pmemc"), store.size());
+    ASSERT_EQ(restored, store);
+
+    // Restoring records the same digest as writing
+    std::vector<uint8_t> copy(store.size(), 0);
+    ASSERT_EQ(chunked_store::read(path("raw.pmemc"), copy.data(),
+                                  copy.size(), 1, pageSize).hashes,
+              digest.hashes);
+}
+
+/**
+ * Test compressed chunks. Chunks that don't compress are stored raw,
+ * and all chunks are raw if gem5 is built without zstd.
+ */
+TEST_F(ChunkedStoreTest, ZstdChunks)
+{
+    const auto store = makeStore();
+    chunked_store::write(path("zstd.pmemc"), store.data(), store.size(), 0, 3);
+    const uint32_t packed = HAVE_ZSTD ? Zstd : Raw;
+    ASSERT_EQ(encodings(path("zstd.pmemc")),
+              std::vector<uint32_t>({Zero, Raw, packed, Zero, packed}));
+
+    ASSERT_EQ(restore(path("zstd.pmemc"), store.size(), 1), store);
+    ASSERT_EQ(restore(path("zstd.pmemc"), store.size(), 8), store);
+}
+
+/** Test that a restore keeps the pages that only contain zeros. */
+TEST_F(ChunkedStoreTest, SparseRestore)
+{
+    const auto store = makeStore();
+    chunked_store::write(path("sparse.pmemc"), store.data(), store.size(),
+                         1, 1);
+
+    // Pages that are zero in the file aren't written, anything already
+    // in the store is left in place.
+    std::vector<uint8_t> target(store.size(), 0);
+    target[3 * chunkSize + 10] = 1;
+    chunked_store::read(path("sparse.pmemc"), target.data(), target.size(),
+                        2, pageSize);
+    ASSERT_EQ(target[3 * chunkSize + 10], 1);
+    target[3 * chunkSize + 10] = 0;
+    ASSERT_EQ(target, store);
+}
+
+/**
+ * Test a chain of incremental files that refer to their parents with
+ * relative paths, restored through two levels of parents after the
+ * chain has been moved.
+ */
+TEST_F(ChunkedStoreTest, IncrementalChain)
+{
+    std::filesystem::create_directory(dir / "a");
+    std::filesystem::create_directory(dir / "b");
+
+    auto store = makeStore();
+    const auto base = chunked_store::write(path("a/base.pmemc"),
+                                           store.data(), store.size(), 2, 1);
+
+    // Change the compressible chunk
+    store[2 * chunkSize + 1] = 1;
+    const auto inc1 = chunked_store::write(path("b/inc1.pmemc"),
+                                           store.data(), store.size(), 2, 1,
+                                           &base);
+    ASSERT_EQ(encodings(path("b/inc1.pmemc"))[1], Parent);
+    ASSERT_NE(encodings(path("b/inc1.pmemc"))[2], Parent);
+
+    // Change the random chunk, the others come from both parents
+    store[chunkSize + 7] ^= 0xff;
+    const auto inc2 = chunked_store::write(path("b/inc2.pmemc"),
+                                           store.data(), store.size(), 2, 1,
+                                           &inc1);
+    ASSERT_EQ(encodings(path("b/inc2.pmemc")),
+              std::vector<uint32_t>({Zero, Raw, Parent, Zero, Parent}));
+
+    const std::filesystem::path moved = dir.string() + ".moved";
+    std::filesystem::rename(dir, moved);
+    dir = moved;
+    ASSERT_EQ(restore(path("b/inc2.pmemc"), store.size()), store);
+}
+
+/**
+ * Test that chunks with the same hash as the parent are trusted, unless
+ * they are verified.
+ */
+TEST_F(ChunkedStoreTest, IncrementalHashCollision)
+{
+    const auto store = makeStore();
+    auto parent = chunked_store::write(path("parent.pmemc"), store.data(),
+                                       store.size(), 2, 0);
+
+    auto changed = store;
+    changed[chunkSize + 100] ^= 1;
+    changed[4 * chunkSize + 3] ^= 1;
+    const auto scratch = chunked_store::write(path("scratch.pmemc"),
+                                              changed.data(), changed.size(),
+                                              2, 0);
+
+    // Pretend the hashes of the changed chunks didn't change
+    parent.hashes[1] = scratch.hashes[1];
+    parent.hashes[4] = scratch.hashes[4];
+    chunked_store::write(path("trusted.pmemc"), changed.data(),
+                         changed.size(), 2, 0, &parent);
+    ASSERT_EQ(encodings(path("trusted.pmemc")),
+              std::vector<uint32_t>({Zero, Parent, Parent, Zero, Parent}));
+
+    chunked_store::write(path("child.pmemc"), changed.data(), changed.size(),
+                         2, 0, &parent, true);
+    ASSERT_EQ(encodings(path("child.pmemc")),
+              std::vector<uint32_t>({Zero, Raw, Parent, Zero, Raw}));
+    ASSERT_EQ(restore(path("child.pmemc"), changed.size()), changed);
+}
+
+/** Test that overwriting a file of the chain writes a complete file. */
+TEST_F(ChunkedStoreTest, IncrementalOverwriteParent)
+{
+    auto store = makeStore();
+    const auto base = chunked_store::write(path("base.pmemc"), store.data(),
+                                           store.size(), 2, 0);
+    const auto inc = chunked_store::write(path("inc.pmemc"), store.data(),
+                                          store.size(), 2, 0, &base);
+
+    store[5] = 5;
+    chunked_store::write(path("base.pmemc"), store.data(), store.size(), 2, 0,
+                         &inc);
+    ASSERT_EQ(encodings(path("base.pmemc")),
+              std::vector<uint32_t>({Raw, Raw, Raw, Zero, Raw}));
+    ASSERT_EQ(restore(path("base.pmemc"), store.size()), store);
+}
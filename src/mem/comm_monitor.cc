@@ -55,8 +55,16 @@ CommMonitor::CommMonitor(const Params &params)
       samplePeriodicEvent([this]{ samplePeriodic(); }, name()),
       samplePeriodTicks(params.sample_period),
       samplePeriod(params.sample_period / sim_clock::as_float::s),
+      sampleRatio(params.sample_ratio),
+      sampleWindowTicks(params.sample_window),
+      sampling(sampleRatio > 1 || sampleWindowTicks != 0),
+      sampleCountdown(1),
+      periodStart(0),
       stats(this, params)
 {
+    fatal_if(sampleRatio == 0, "%s: sample_ratio must be at least 1.",
+             name());
+
     DPRINTF(CommMonitor,
             "Created monitor %s with sample period %d ticks (%f ms)\n",
             name(), samplePeriodTicks, samplePeriod * 1E3);
@@ -172,7 +180,9 @@ CommMonitor::MonitorStats::MonitorStats(statistics::Group *parent,
       ADD_STAT(readAddrDist, statistics::units::Count::get(),
                "Read address distribution"),
       ADD_STAT(writeAddrDist, statistics::units::Count::get(),
-               "Write address distribution")
+               "Write address distribution"),
+
+      bucketedHists(params.bucketed_hists)
 {
     using namespace statistics;
 
@@ -253,12 +263,62 @@ CommMonitor::MonitorStats::MonitorStats(statistics::Group *parent,
     writeAddrDist
         .init(0)
         .flags(disableAddrDists ? nozero : pdf);
+
+    if (bucketedHists) {
+        if (!disableBurstLengthHists) {
+            readBurstLengthBuckets.init();
+            writeBurstLengthBuckets.init();
+        }
+        if (!disableLatencyHists) {
+            readLatencyBuckets.init();
+            writeLatencyBuckets.init();
+        }
+        if (!disableITTDists) {
+            ittReadReadBuckets.init();
+            ittWriteWriteBuckets.init();
+            ittReqReqBuckets.init();
+        }
+    }
+}
+
+void
+CommMonitor::MonitorStats::preDumpStats()
+{
+    statistics::Group::preDumpStats();
+
+    if (!bucketedHists)
+        return;
+
+    readBurstLengthBuckets.fold(readBurstLengthHist);
+    writeBurstLengthBuckets.fold(writeBurstLengthHist);
+    readLatencyBuckets.fold(readLatencyHist);
+    writeLatencyBuckets.fold(writeLatencyHist);
+    ittReadReadBuckets.fold(ittReadRead);
+    ittWriteWriteBuckets.fold(ittWriteWrite);
+    ittReqReqBuckets.fold(ittReqReq);
+}
+
+void
+CommMonitor::MonitorStats::resetStats()
+{
+    statistics::Group::resetStats();
+
+    if (!bucketedHists)
+        return;
+
+    readBurstLengthBuckets.reset();
+    writeBurstLengthBuckets.reset();
+    readLatencyBuckets.reset();
+    writeLatencyBuckets.reset();
+    ittReadReadBuckets.reset();
+    ittWriteWriteBuckets.reset();
+    ittReqReqBuckets.reset();
 }
 
 void
 CommMonitor::MonitorStats::updateReqStats(
     const probing::PacketInfo& pkt_info, bool is_atomic,
-    bool expects_response)
+    bool expects_response, bool sampled)
 {
     if (pkt_info.cmd.isRead()) {
         // Increment number of observed read transactions
@@ -266,22 +326,28 @@ CommMonitor::MonitorStats::updateReqStats(
             ++readTrans;
 
         // Get sample of burst length
-        if (!disableBurstLengthHists)
-            readBurstLengthHist.sample(pkt_info.size);
+        if (!disableBurstLengthHists && sampled)
+            sample(readBurstLengthHist, readBurstLengthBuckets,
+                   pkt_info.size);
 
         // Sample the masked address
-        if (!disableAddrDists)
+        if (!disableAddrDists && sampled)
             readAddrDist.sample(pkt_info.addr & readAddrMask);
 
         if (!disableITTDists) {
-            // Sample value of read-read inter transaction time
-            if (timeOfLastRead != 0)
-                ittReadRead.sample(curTick() - timeOfLastRead);
+            // Sample value of read-read inter transaction time. The
+            // time of the last transaction is tracked whether or not
+            // it was sampled, so that a sampled time is still the
+            // time between two consecutive transactions.
+            if (timeOfLastRead != 0 && sampled)
+                sample(ittReadRead, ittReadReadBuckets,
+                       curTick() - timeOfLastRead);
             timeOfLastRead = curTick();
 
             // Sample value of req-req inter transaction time
-            if (timeOfLastReq != 0)
-                ittReqReq.sample(curTick() - timeOfLastReq);
+            if (timeOfLastReq != 0 && sampled)
+                sample(ittReqReq, ittReqReqBuckets,
+                       curTick() - timeOfLastReq);
             timeOfLastReq = curTick();
         }
         if (!is_atomic && !disableOutstandingHists && expects_response)
@@ -292,8 +358,9 @@ CommMonitor::MonitorStats::updateReqStats(
         if (!disableTransactionHists)
             ++writeTrans;
 
-        if (!disableBurstLengthHists)
-            writeBurstLengthHist.sample(pkt_info.size);
+        if (!disableBurstLengthHists && sampled)
+            sample(writeBurstLengthHist, writeBurstLengthBuckets,
+                   pkt_info.size);
 
         // Update the bandwidth stats on the request
         if (!disableBandwidthHists) {
@@ -302,18 +369,20 @@ CommMonitor::MonitorStats::updateReqStats(
         }
 
         // Sample the masked write address
-        if (!disableAddrDists)
+        if (!disableAddrDists && sampled)
             writeAddrDist.sample(pkt_info.addr & writeAddrMask);
 
         if (!disableITTDists) {
             // Sample value of write-to-write inter transaction time
-            if (timeOfLastWrite != 0)
-                ittWriteWrite.sample(curTick() - timeOfLastWrite);
+            if (timeOfLastWrite != 0 && sampled)
+                sample(ittWriteWrite, ittWriteWriteBuckets,
+                       curTick() - timeOfLastWrite);
             timeOfLastWrite = curTick();
 
             // Sample value of req-to-req inter transaction time
-            if (timeOfLastReq != 0)
-                ittReqReq.sample(curTick() - timeOfLastReq);
+            if (timeOfLastReq != 0 && sampled)
+                sample(ittReqReq, ittReqReqBuckets,
+                       curTick() - timeOfLastReq);
             timeOfLastReq = curTick();
         }
 
@@ -324,7 +393,8 @@ CommMonitor::MonitorStats::updateReqStats(
 
 void
 CommMonitor::MonitorStats::updateRespStats(
-    const probing::PacketInfo& pkt_info, Tick latency, bool is_atomic)
+    const probing::PacketInfo& pkt_info, Tick latency, bool is_atomic,
+    bool sampled)
 {
     if (pkt_info.cmd.isRead()) {
         // Decrement number of outstanding read requests
@@ -333,8 +403,8 @@ CommMonitor::MonitorStats::updateRespStats(
             --outstandingReadReqs;
         }
 
-        if (!disableLatencyHists)
-            readLatencyHist.sample(latency);
+        if (!disableLatencyHists && sampled)
+            sample(readLatencyHist, readLatencyBuckets, latency);
 
         // Update the bandwidth stats based on responses for reads
         if (!disableBandwidthHists) {
@@ -349,8 +419,8 @@ CommMonitor::MonitorStats::updateRespStats(
             --outstandingWriteReqs;
         }
 
-        if (!disableLatencyHists)
-            writeLatencyHist.sample(latency);
+        if (!disableLatencyHists && sampled)
+            sample(writeLatencyHist, writeLatencyBuckets, latency);
     }
 }
 
@@ -364,9 +434,10 @@ CommMonitor::recvAtomic(PacketPtr pkt)
 
     const Tick delay(memSidePort.sendAtomic(pkt));
 
-    stats.updateReqStats(req_pkt_info, true, expects_response);
+    const bool sampled(sampleRequest());
+    stats.updateReqStats(req_pkt_info, true, expects_response, sampled);
     if (expects_response)
-        stats.updateRespStats(req_pkt_info, delay, true);
+        stats.updateRespStats(req_pkt_info, delay, true, sampled);
 
     // Some packets, such as WritebackDirty, don't need response.
     assert(pkt->isResponse() || !expects_response);
@@ -394,19 +465,27 @@ CommMonitor::recvTimingReq(PacketPtr pkt)
     const bool expects_response(pkt->needsResponse() &&
                                 !pkt->cacheResponding());
 
+    // Only requests that are sampled carry a sender state to measure
+    // their latency. The decision is made before knowing if the
+    // request is accepted, and a refused request will be sampled
+    // again when it is retried.
+    const bool sampled(sampleRequest());
+
     // If a cache miss is served by a cache, a monitor near the memory
     // would see a request which needs a response, but this response
     // would not come back from the memory. Therefore we additionally
     // have to check the cacheResponding flag
-    if (expects_response && !stats.disableLatencyHists) {
-        pkt->pushSenderState(new CommMonitorSenderState(curTick()));
+    const bool track_latency(expects_response && sampled &&
+                             !stats.disableLatencyHists);
+    if (track_latency) {
+        pkt->pushSenderState(new CommMonitorSenderState(this, curTick()));
     }
 
     // Attempt to send the packet
     bool successful = memSidePort.sendTimingReq(pkt);
 
     // If not successful, restore the sender state
-    if (!successful && expects_response && !stats.disableLatencyHists) {
+    if (!successful && track_latency) {
         delete pkt->popSenderState();
     }
 
@@ -417,7 +496,7 @@ CommMonitor::recvTimingReq(PacketPtr pkt)
     if (successful) {
         DPRINTF(CommMonitor, "Forwarded %s request\n", pkt->isRead() ? "read" :
                 pkt->isWrite() ? "write" : "non read/write");
-        stats.updateReqStats(pkt_info, false, expects_response);
+        stats.updateReqStats(pkt_info, false, expects_response, sampled);
     }
     return successful;
 }
@@ -436,19 +515,26 @@ CommMonitor::recvTimingResp(PacketPtr pkt)
     CommMonitorSenderState* received_state =
         dynamic_cast<CommMonitorSenderState*>(pkt->senderState);
 
+    // When sampling, a response without a sender state of this monitor
+    // belongs to a request that was not sampled
+    if (received_state && received_state->monitor != this)
+        received_state = nullptr;
+    const bool sampled(received_state != nullptr);
+
     if (!stats.disableLatencyHists) {
         // Restore initial sender state
-        if (received_state == NULL)
+        if (received_state == NULL && !sampling)
             panic("Monitor got a response without monitor sender state\n");
 
         // Restore the sate
-        pkt->senderState = received_state->predecessor;
+        if (sampled)
+            pkt->senderState = received_state->predecessor;
     }
 
     // Attempt to send the packet
     bool successful = cpuSidePort.sendTimingResp(pkt);
 
-    if (!stats.disableLatencyHists) {
+    if (!stats.disableLatencyHists && sampled) {
         // If packet successfully send, sample value of latency,
         // afterwards delete sender state, otherwise restore state
         if (successful) {
@@ -466,7 +552,7 @@ CommMonitor::recvTimingResp(PacketPtr pkt)
         ppPktResp->notify(pkt_info);
         DPRINTF(CommMonitor, "Received %s response\n", pkt->isRead() ? "read" :
                 pkt->isWrite() ?  "write" : "non read/write");
-        stats.updateRespStats(pkt_info, latency, false);
+        stats.updateRespStats(pkt_info, latency, false, sampled);
     }
     return successful;
 }
@@ -562,12 +648,29 @@ CommMonitor::samplePeriodic()
     stats.readBytes = 0;
     stats.writtenBytes = 0;
 
+    periodStart = curTick();
     schedule(samplePeriodicEvent, curTick() + samplePeriodTicks);
 }
 
+bool
+CommMonitor::sampleRequest()
+{
+    if (sampleWindowTicks != 0 &&
+        curTick() - periodStart >= sampleWindowTicks) {
+        return false;
+    }
+
+    if (--sampleCountdown != 0)
+        return false;
+
+    sampleCountdown = sampleRatio;
+    return true;
+}
+
 void
 CommMonitor::startup()
 {
+    periodStart = curTick();
     schedule(samplePeriodicEvent, curTick() + samplePeriodTicks);
 }
 
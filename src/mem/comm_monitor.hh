@@ -40,6 +40,12 @@
 #ifndef __MEM_COMM_MONITOR_HH__
 #define __MEM_COMM_MONITOR_HH__
 
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <vector>
+
+#include "base/intmath.hh"
 #include "base/statistics.hh"
 #include "mem/port.hh"
 #include "params/CommMonitor.hh"
@@ -59,6 +65,16 @@ namespace gem5
  * (read-read, write-write, read/write-read/write). Furthermore it allows
  * to capture the number of accesses to an address over time ("heat map").
  * All stats can be disabled from Python.
+ *
+ * To keep the overhead low enough for a monitor to stay on a busy link,
+ * the per-transaction distributions (burst length, latency, inter
+ * transaction time and address) can be sampled, measuring only one in N
+ * requests and/or only the requests in a window at the start of each
+ * sample period. The counters behind the bandwidth, transaction and
+ * outstanding request stats are always exact. The burst length, latency
+ * and inter transaction time values can furthermore be counted in
+ * pre-allocated log-linear buckets, and only folded into the
+ * histograms when the stats are dumped.
  */
 class CommMonitor : public SimObject
 {
@@ -98,15 +114,23 @@ class CommMonitor : public SimObject
          * Construct a new sender state and store the time so we can
          * calculate round-trip latency.
          *
+         * @param _monitor Monitor pushing the sender state
          * @param _transmitTime Time of packet transmission
          */
-        CommMonitorSenderState(Tick _transmitTime)
-            : transmitTime(_transmitTime)
+        CommMonitorSenderState(const CommMonitor *_monitor,
+                               Tick _transmitTime)
+            : monitor(_monitor), transmitTime(_transmitTime)
         { }
 
         /** Destructor */
         ~CommMonitorSenderState() { }
 
+        /**
+         * Monitor that pushed the state, as a monitor that samples
+         * requests may see the state of another monitor on responses
+         */
+        const CommMonitor *monitor;
+
         /** Tick when request is transmitted */
         Tick transmitTime;
 
@@ -269,6 +293,102 @@ class CommMonitor : public SimObject
 
     bool tryTiming(PacketPtr pkt);
 
+    /**
+     * Pre-allocated counters for a distribution of unsigned values,
+     * bucketed in the style of an HDR histogram: values below
+     * 2^SigBits have a bucket each, and larger values are bucketed on
+     * their SigBits most significant bits, which bounds the relative
+     * error of a bucket by 2^(1 - SigBits). Sampling a value is an
+     * increment, and the buckets are folded into a stat in bulk.
+     */
+    class BucketedSamples
+    {
+      public:
+
+        /** Significant bits kept for each value */
+        static constexpr unsigned SigBits = 5;
+
+        /** Allocate the buckets, which are not used until then */
+        void init() { counts.assign(NumBuckets, 0); }
+
+        void
+        sample(uint64_t val)
+        {
+            const unsigned idx = index(val);
+            ++counts[idx];
+            minIdx = std::min(minIdx, idx);
+            maxIdx = std::max(maxIdx, idx);
+        }
+
+        /**
+         * Sample the midpoint of each non-empty bucket into the stat,
+         * as many times as it was counted, and clear the buckets.
+         *
+         * @param stat Histogram or distribution to fold into
+         */
+        template <class Stat>
+        void
+        fold(Stat &stat)
+        {
+            for (unsigned idx = minIdx; idx <= maxIdx && idx < NumBuckets;
+                 ++idx) {
+                const double val = midpoint(idx);
+                for (uint64_t n = counts[idx]; n != 0; ) {
+                    const int chunk = std::min<uint64_t>(n, INT_MAX);
+                    stat.sample(val, chunk);
+                    n -= chunk;
+                }
+                counts[idx] = 0;
+            }
+            minIdx = NumBuckets;
+            maxIdx = 0;
+        }
+
+        /** Clear the buckets without folding them */
+        void
+        reset()
+        {
+            if (minIdx <= maxIdx)
+                std::fill(counts.begin() + minIdx,
+                          counts.begin() + maxIdx + 1, 0);
+            minIdx = NumBuckets;
+            maxIdx = 0;
+        }
+
+      private:
+
+        static constexpr unsigned SubBuckets = 1 << SigBits;
+        static constexpr unsigned NumBuckets =
+            SubBuckets + (64 - SigBits) * (SubBuckets / 2);
+
+        static unsigned
+        index(uint64_t val)
+        {
+            if (val < SubBuckets)
+                return val;
+            const unsigned shift = floorLog2(val) - SigBits + 1;
+            return SubBuckets + (shift - 1) * (SubBuckets / 2) +
+                (val >> shift) - SubBuckets / 2;
+        }
+
+        static double
+        midpoint(unsigned idx)
+        {
+            if (idx < SubBuckets)
+                return idx;
+            const unsigned shift = (idx - SubBuckets) / (SubBuckets / 2) + 1;
+            const uint64_t mantissa =
+                (idx - SubBuckets) % (SubBuckets / 2) + SubBuckets / 2;
+            return (mantissa << shift) + ((uint64_t(1) << shift) - 1) / 2.0;
+        }
+
+        std::vector<uint64_t> counts;
+
+        /** Range of buckets that may be non-zero */
+        unsigned minIdx = NumBuckets;
+        unsigned maxIdx = 0;
+    };
+
     /** Stats declarations, all in a struct for convenience. */
     struct MonitorStats : public statistics::Group
     {
@@ -378,6 +498,22 @@ class CommMonitor : public SimObject
          */
         statistics::SparseHistogram writeAddrDist;
 
+        /**
+         * Count the burst lengths, latencies and inter transaction
+         * times in buckets, and fold them into their stats only when
+         * the stats are dumped.
+         */
+        const bool bucketedHists;
+
+        /** Buckets behind the stats of the same name */
+        BucketedSamples readBurstLengthBuckets;
+        BucketedSamples writeBurstLengthBuckets;
+        BucketedSamples readLatencyBuckets;
+        BucketedSamples writeLatencyBuckets;
+        BucketedSamples ittReadReadBuckets;
+        BucketedSamples ittWriteWriteBuckets;
+        BucketedSamples ittReqReqBuckets;
+
         /**
          * Create the monitor stats and initialise all the members
          * that are not statistics themselves, but used to control the
@@ -386,12 +522,37 @@ class CommMonitor : public SimObject
         MonitorStats(statistics::Group *parent,
             const CommMonitorParams &params);
 
+        void preDumpStats() override;
+        void resetStats() override;
+
+        /**
+         * Update the stats for a request. The distributions are only
+         * sampled if the request is sampled, while the counters are
+         * always updated.
+         */
         void updateReqStats(const probing::PacketInfo& pkt, bool is_atomic,
-                            bool expects_response);
+                            bool expects_response, bool sampled);
         void updateRespStats(const probing::PacketInfo& pkt, Tick latency,
-                             bool is_atomic);
+                             bool is_atomic, bool sampled);
+
+        /** Sample a value into a stat or its buckets */
+        template <class Stat>
+        void
+        sample(Stat &stat, BucketedSamples &buckets, uint64_t val)
+        {
+            if (bucketedHists)
+                buckets.sample(val);
+            else
+                stat.sample(val);
+        }
     };
 
+    /**
+     * Decide whether the distributions should sample the request being
+     * forwarded.
+     */
+    bool sampleRequest();
+
     /** This function is called periodically at the end of each time bin */
     void samplePeriodic();
 
@@ -408,8 +569,23 @@ class CommMonitor : public SimObject
     /** Sample period in seconds */
     const double samplePeriod;
 
+    /** Sample one in this many requests */
+    const unsigned sampleRatio;
+
+    /** Only sample the requests this early in each sample period */
+    const Tick sampleWindowTicks;
+
+    /** True if some requests are not sampled */
+    const bool sampling;
+
     /** @} */
 
+    /** Requests left until the next sampled one */
+    unsigned sampleCountdown;
+
+    /** Start of the current sample period */
+    Tick periodStart;
+
     /** Instantiate stats */
     MonitorStats stats;
 
@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "mem/cxl_mem_ctrl.hh"
+
+#include <algorithm>
+#include <cmath>
+
+#include "base/trace.hh"
+#include "debug/CXLMemCtrl.hh"
+#include "debug/Drain.hh"
+
+namespace gem5
+{
+
+namespace memory
+{
+
+Tick
+CXLMemCtrl::FlitLink::transmit(unsigned slots, Tick when, unsigned &flits)
+{
+    // Once the last flit is on the wire nothing else can be packed
+    // into it
+    if (when + flitTime > busyUntil)
+        spareSlots = 0;
+
+    unsigned packed = std::min(spareSlots, slots);
+    spareSlots -= packed;
+    slots -= packed;
+
+    flits = divCeil(slots, slotsPerFlit);
+    if (flits) {
+        spareSlots = flits * slotsPerFlit - slots;
+        busyUntil = std::max(when, busyUntil) + flits * flitTime;
+    }
+
+    return busyUntil + latency;
+}
+
+CXLMemCtrl::CXLMemCtrl(const CXLMemCtrlParams &p) :
+    MemCtrl(p),
+    downLink(std::ceil((p.flit_slots * p.slot_size + p.flit_overhead) *
+                       p.link_bandwidth),
+             p.link_latency, p.flit_slots),
+    upLink(std::ceil((p.flit_slots * p.slot_size + p.flit_overhead) *
+                     p.link_bandwidth),
+           p.link_latency, p.flit_slots),
+    slotSize(p.slot_size), requestCredits(p.request_credits),
+    deviceBlocked(false), retryLinkReq(false),
+    linkEvent([this] { processLinkEvent(); }, name() + ".linkEvent"),
+    linkStats(*this, p.flit_slots)
+{
+    fatal_if(p.flit_slots == 0 || p.slot_size == 0,
+             "%s: flits must have a non-zero number of slots.\n", name());
+    fatal_if(requestCredits == 0,
+             "%s: the device must advertise request credits.\n", name());
+}
+
+unsigned
+CXLMemCtrl::messageSlots(PacketPtr pkt) const
+{
+    return 1 + (pkt->hasData() ? divCeil(pkt->getSize(), slotSize) : 0);
+}
+
+bool
+CXLMemCtrl::recvTimingReq(PacketPtr pkt)
+{
+    if (linkQueue.size() >= requestCredits) {
+        DPRINTF(CXLMemCtrl, "No request credit for %s\n", pkt->print());
+        linkStats.creditStalls++;
+        retryLinkReq = true;
+        return false;
+    }
+
+    // The link pays for the delay accumulated in the crossbar
+    Tick ready = curTick() + pkt->headerDelay + pkt->payloadDelay;
+    pkt->headerDelay = pkt->payloadDelay = 0;
+
+    unsigned slots = messageSlots(pkt);
+    unsigned flits;
+    Tick arrival = downLink.transmit(slots, ready, flits);
+
+    DPRINTF(CXLMemCtrl, "%s crosses the link in %d slots, arrives at %d\n",
+            pkt->print(), slots, arrival);
+
+    linkStats.downMsgs++;
+    linkStats.downSlots += slots;
+    linkStats.downFlits += flits;
+    linkStats.totDownLat += arrival - curTick();
+
+    linkQueue.push_back({arrival, pkt});
+    if (!deviceBlocked && !linkEvent.scheduled())
+        schedule(linkEvent, linkQueue.front().tick);
+
+    return true;
+}
+
+void
+CXLMemCtrl::processLinkEvent()
+{
+    bool credit_returned = false;
+
+    while (!linkQueue.empty() && linkQueue.front().tick <= curTick()) {
+        if (!MemCtrl::recvTimingReq(linkQueue.front().pkt)) {
+            // wait for the controller to ask for a retry
+            DPRINTF(CXLMemCtrl, "Device queues full, holding the link\n");
+            deviceBlocked = true;
+            break;
+        }
+        linkQueue.pop_front();
+        credit_returned = true;
+    }
+
+    if (deviceBlocked) {
+        // sendRetryReq restarts the link
+    } else if (!linkQueue.empty()) {
+        if (!linkEvent.scheduled())
+            schedule(linkEvent, linkQueue.front().tick);
+    } else if (drainState() == DrainState::Draining &&
+               drain() == DrainState::Drained) {
+        DPRINTF(Drain, "CXL link done draining\n");
+        signalDrainDone();
+    }
+
+    // The credits of the delivered requests are returned to the host
+    // last, as it may send a new request into the link right away
+    if (credit_returned && retryLinkReq) {
+        retryLinkReq = false;
+        port.sendRetryReq();
+    }
+}
+
+void
+CXLMemCtrl::sendRetryReq()
+{
+    // only requests delivered by the link are ever refused by the
+    // controller, the host is held back by the credits instead
+    if (deviceBlocked) {
+        deviceBlocked = false;
+        if (!linkEvent.scheduled())
+            schedule(linkEvent, curTick());
+    }
+}
+
+void
+CXLMemCtrl::schedTimingResp(PacketPtr pkt, Tick when)
+{
+    unsigned slots = messageSlots(pkt);
+    unsigned flits;
+    Tick arrival = upLink.transmit(slots, when, flits);
+
+    linkStats.upMsgs++;
+    linkStats.upSlots += slots;
+    linkStats.upFlits += flits;
+    linkStats.totUpLat += arrival - when;
+
+    MemCtrl::schedTimingResp(pkt, arrival);
+}
+
+Tick
+CXLMemCtrl::recvAtomic(PacketPtr pkt)
+{
+    bool needs_response = pkt->needsResponse();
+    Tick latency = downLink.unloadedLatency(messageSlots(pkt));
+
+    latency += MemCtrl::recvAtomic(pkt);
+    if (needs_response)
+        latency += upLink.unloadedLatency(messageSlots(pkt));
+
+    return latency;
+}
+
+void
+CXLMemCtrl::recvFunctional(PacketPtr pkt)
+{
+    for (const auto &deferred : linkQueue) {
+        if (pkt->trySatisfyFunctional(deferred.pkt)) {
+            pkt->makeResponse();
+            return;
+        }
+    }
+
+    MemCtrl::recvFunctional(pkt);
+}
+
+bool
+CXLMemCtrl::allIntfDrained() const
+{
+    return linkQueue.empty() && MemCtrl::allIntfDrained();
+}
+
+CXLMemCtrl::LinkStats::LinkStats(CXLMemCtrl &ctrl, unsigned slots_per_flit)
+    : statistics::Group(&ctrl, "link"),
+
+    ADD_STAT(downMsgs, statistics::units::Count::get(),
+             "Number of requests sent from the host to the device"),
+    ADD_STAT(upMsgs, statistics::units::Count::get(),
+             "Number of responses sent from the device to the host"),
+    ADD_STAT(downFlits, statistics::units::Count::get(),
+             "Number of flits sent from the host to the device"),
+    ADD_STAT(upFlits, statistics::units::Count::get(),
+             "Number of flits sent from the device to the host"),
+    ADD_STAT(downSlots, statistics::units::Count::get(),
+             "Number of flit slots used by requests"),
+    ADD_STAT(upSlots, statistics::units::Count::get(),
+             "Number of flit slots used by responses"),
+    ADD_STAT(creditStalls, statistics::units::Count::get(),
+             "Number of requests refused for lack of credits"),
+    ADD_STAT(totDownLat, statistics::units::Tick::get(),
+             "Total time requests spent crossing the link"),
+    ADD_STAT(totUpLat, statistics::units::Tick::get(),
+             "Total time responses spent crossing the link"),
+
+    ADD_STAT(downPacking, statistics::units::Ratio::get(),
+             "Fraction of the downstream flit slots carrying messages"),
+    ADD_STAT(upPacking, statistics::units::Ratio::get(),
+             "Fraction of the upstream flit slots carrying messages"),
+    ADD_STAT(avgDownLat, statistics::units::Rate<
+                statistics::units::Tick, statistics::units::Count>::get(),
+             "Average time for a request to cross the link"),
+    ADD_STAT(avgUpLat, statistics::units::Rate<
+                statistics::units::Tick, statistics::units::Count>::get(),
+             "Average time for a response to cross the link"),
+
+    slotsPerFlit(slots_per_flit)
+{
+}
+
+void
+CXLMemCtrl::LinkStats::regStats()
+{
+    using namespace statistics;
+
+    downPacking.precision(4);
+    upPacking.precision(4);
+    avgDownLat.flags(nonan).precision(2);
+    avgUpLat.flags(nonan).precision(2);
+
+    downPacking = downSlots / (downFlits * slotsPerFlit);
+    upPacking = upSlots / (upFlits * slotsPerFlit);
+
+    avgDownLat = totDownLat / downMsgs;
+    avgUpLat = totUpLat / upMsgs;
+}
+
+} // namespace memory
+} // namespace gem5
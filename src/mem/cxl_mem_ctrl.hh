@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/**
+ * @file
+ * CXLMemCtrl declaration
+ */
+
+#ifndef __MEM_CXL_MEM_CTRL_HH__
+#define __MEM_CXL_MEM_CTRL_HH__
+
+#include <deque>
+
+#include "base/statistics.hh"
+#include "mem/mem_ctrl.hh"
+#include "params/CXLMemCtrl.hh"
+
+namespace gem5
+{
+
+namespace memory
+{
+
+/**
+ * A CXL.mem type 3 device: a memory controller and its media reached
+ * through a CXL link. Requests travel the downstream half of the link
+ * before they enter the controller queues, and responses travel the
+ * upstream half once the controller has serviced them. Messages are
+ * packed into fixed size flits made of slots, so that small messages
+ * share flits while the link is backlogged. The number of requests on
+ * the link is bounded by the request credits advertised by the device.
+ */
+class CXLMemCtrl : public MemCtrl
+{
+  private:
+
+    /**
+     * One direction of the link. Messages are serialized in order and
+     * may use the spare slots of the last flit as long as that flit is
+     * still waiting for the link.
+     */
+    class FlitLink
+    {
+      public:
+
+        FlitLink(Tick flit_time, Tick latency, unsigned slots_per_flit)
+            : flitTime(flit_time), latency(latency),
+              slotsPerFlit(slots_per_flit)
+        {}
+
+        /**
+         * Reserve the link for a message.
+         *
+         * @param slots Number of slots taken by the message
+         * @param when Tick at which the message is ready to be sent
+         * @param flits Number of new flits the message needed
+         * @return Tick at which the message is available at the far end
+         */
+        Tick transmit(unsigned slots, Tick when, unsigned &flits);
+
+        /** Time for a message of the given size on an idle link. */
+        Tick
+        unloadedLatency(unsigned slots) const
+        {
+            return divCeil(slots, slotsPerFlit) * flitTime + latency;
+        }
+
+      private:
+
+        const Tick flitTime;
+        const Tick latency;
+        const unsigned slotsPerFlit;
+
+        /** Tick at which the last reserved flit has left. */
+        Tick busyUntil = 0;
+
+        /** Unused slots in the last reserved flit. */
+        unsigned spareSlots = 0;
+    };
+
+    struct DeferredPacket
+    {
+        Tick tick;
+        PacketPtr pkt;
+    };
+
+    FlitLink downLink;
+    FlitLink upLink;
+
+    /** Size of a flit slot in bytes. */
+    const unsigned slotSize;
+
+    /** Number of requests the device accepts onto the link. */
+    const unsigned requestCredits;
+
+    /** Requests in flight on the downstream link, in arrival order. */
+    std::deque<DeferredPacket> linkQueue;
+
+    /** The controller refused the request at the head of the link. */
+    bool deviceBlocked;
+
+    /** A request was refused for lack of credits. */
+    bool retryLinkReq;
+
+    void processLinkEvent();
+    EventFunctionWrapper linkEvent;
+
+    /** Slots taken by a message, a header slot plus any data. */
+    unsigned messageSlots(PacketPtr pkt) const;
+
+    struct LinkStats : public statistics::Group
+    {
+        LinkStats(CXLMemCtrl &ctrl, unsigned slots_per_flit);
+
+        void regStats() override;
+
+        statistics::Scalar downMsgs;
+        statistics::Scalar upMsgs;
+        statistics::Scalar downFlits;
+        statistics::Scalar upFlits;
+        statistics::Scalar downSlots;
+        statistics::Scalar upSlots;
+        statistics::Scalar creditStalls;
+        statistics::Scalar totDownLat;
+        statistics::Scalar totUpLat;
+
+        statistics::Formula downPacking;
+        statistics::Formula upPacking;
+        statistics::Formula avgDownLat;
+        statistics::Formula avgUpLat;
+
+        const unsigned slotsPerFlit;
+    };
+
+    LinkStats linkStats;
+
+  protected:
+
+    void schedTimingResp(PacketPtr pkt, Tick when) override;
+    void sendRetryReq() override;
+
+    Tick recvAtomic(PacketPtr pkt) override;
+    void recvFunctional(PacketPtr pkt) override;
+    bool recvTimingReq(PacketPtr pkt) override;
+
+  public:
+
+    CXLMemCtrl(const CXLMemCtrlParams &p);
+
+    bool allIntfDrained() const override;
+};
+
+} // namespace memory
+} // namespace gem5
+
+#endif //__MEM_CXL_MEM_CTRL_HH__
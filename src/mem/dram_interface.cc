@@ -58,6 +58,135 @@ namespace memory
 
 std::pair<MemPacketQueue::iterator, Tick>
 DRAMInterface::chooseNextFRFCFS(MemPacketQueue& queue, Tick min_col_at) const
+{
+    auto selected = chooseNextIndexed(queue, min_col_at);
+
+    if (checkFRFCFS) {
+        auto expected = chooseNextScan(queue, min_col_at);
+        auto addr = [&queue](MemPacketQueue::iterator it) {
+            return it == queue.end() ? MaxAddr : (*it)->getAddr();
+        };
+        panic_if(selected != expected,
+                 "FR-FCFS picked %#x issuing at %d instead of %#x "
+                 "issuing at %d\n", addr(selected.first), selected.second,
+                 addr(expected.first), expected.second);
+    }
+
+    return selected;
+}
+
+std::pair<MemPacketQueue::iterator, Tick>
+DRAMInterface::chooseNextIndexed(MemPacketQueue& queue, Tick min_col_at) const
+{
+    // The selection is that of a first-come first-served scan through the
+    // queue, which, in order of preference, picks:
+    // 1) the oldest row hit that can issue seamlessly, without additional
+    //    delay, such as same rank accesses and/or different bank-group
+    //    accesses
+    // 2) the oldest packet to a closed row in one of the banks that can
+    //    be prepared earliest, if the PRE/ACT sequence can be done
+    //    without impacting utilization
+    // 3) the oldest row hit, which is not seamless but bank prepped
+    // 4) the oldest packet to a closed row in one of the earliest banks
+    // Rather than visiting every packet, only the oldest packet of each
+    // bank and row is considered, using the bank index of the queue.
+    const MemPacketQueue::Entry *seamless_hit = nullptr;
+    const MemPacketQueue::Entry *prepped_hit = nullptr;
+    bool got_conflict = false;
+
+    auto older = [](const MemPacketQueue::Entry *a,
+                    const MemPacketQueue::Entry *b) {
+        return !b || (a && a->seq < b->seq) ? a : b;
+    };
+
+    auto col_allowed_at = [this](const MemPacketQueue::Entry *entry) {
+        const MemPacket *pkt = *entry->pkt;
+        const Bank& bank = ranks[pkt->rank]->banks[pkt->bank];
+        return pkt->isRead() ? bank.rdAllowedAt : bank.wrAllowedAt;
+    };
+
+    for (int i = 0; i < ranksPerChannel; i++) {
+        // check if rank is not doing a refresh and thus is available,
+        // if not, skip all its banks
+        if (!ranks[i]->inRefIdleState()) {
+            DPRINTF(DRAM, "%s Rank %d not available\n", __func__, i);
+            continue;
+        }
+
+        for (int j = 0; j < banksPerRank; j++) {
+            const MemPacketQueue::BankQueue *bank_queue =
+                queue.bankQueue(pseudoChannel, i * banksPerRank + j);
+            if (!bank_queue)
+                continue;
+
+            const uint32_t open_row = ranks[i]->banks[j].openRow;
+            const MemPacketQueue::Entry *hit = bank_queue->oldest(open_row);
+            if (hit) {
+                // no additional rank-to-rank or same bank-group delays,
+                // or we switched read/write and might as well go for the
+                // row hit
+                if (col_allowed_at(hit) <= min_col_at)
+                    seamless_hit = older(hit, seamless_hit);
+                else
+                    prepped_hit = older(hit, prepped_hit);
+            }
+
+            got_conflict |= bank_queue->hasConflict(open_row);
+        }
+    }
+
+    const MemPacketQueue::Entry *selected = nullptr;
+
+    if (seamless_hit) {
+        DPRINTF(DRAM, "%s Seamless buffer hit\n", __func__);
+        selected = seamless_hit;
+    } else {
+        const MemPacketQueue::Entry *earliest = nullptr;
+        bool hidden_bank_prep = false;
+
+        if (got_conflict) {
+            // determine the banks with the earliest bank delay, minBankPrep
+            // gives priority to banks that can issue seamlessly
+            std::vector<uint32_t> earliest_banks;
+            std::tie(earliest_banks, hidden_bank_prep) =
+                minBankPrep(queue, min_col_at);
+
+            for (int i = 0; i < ranksPerChannel; i++) {
+                for (int j = 0; j < banksPerRank; j++) {
+                    if (!bits(earliest_banks[i], j, j))
+                        continue;
+                    const MemPacketQueue::BankQueue *bank_queue =
+                        queue.bankQueue(pseudoChannel, i * banksPerRank + j);
+                    earliest = older(bank_queue->oldestConflict(
+                        ranks[i]->banks[j].openRow), earliest);
+                }
+            }
+        }
+
+        // give priority to packets that can issue bank commands 'behind
+        // the scenes', any additional delay if any will be due to
+        // col-to-col command requirements
+        if (earliest && (hidden_bank_prep || !prepped_hit)) {
+            selected = earliest;
+        } else if (prepped_hit) {
+            DPRINTF(DRAM, "%s Prepped row buffer hit\n", __func__);
+            selected = prepped_hit;
+        }
+    }
+
+    if (!selected) {
+        DPRINTF(DRAM, "%s no available DRAM ranks found\n", __func__);
+        return std::make_pair(queue.end(), MaxTick);
+    }
+
+    DPRINTF(DRAM, "%s selected DRAM packet in bank %d, row %d\n", __func__,
+            (*selected->pkt)->bank, (*selected->pkt)->row);
+
+    return std::make_pair(selected->pkt, col_allowed_at(selected));
+}
+
+std::pair<MemPacketQueue::iterator, Tick>
+DRAMInterface::chooseNextScan(MemPacketQueue& queue, Tick min_col_at) const
 {
     std::vector<uint32_t> earliest_banks(ranksPerChannel, 0);
 
@@ -66,19 +195,8 @@ DRAMInterface::chooseNextFRFCFS(MemPacketQueue& queue, Tick min_col_at) const
     // can the PRE/ACT sequence be done without impacting utlization?
     bool hidden_bank_prep = false;
 
-    // search for seamless row hits first, if no seamless row hit is
-    // found then determine if there are other packets that can be issued
-    // without incurring additional bus delay due to bank timing
-    // Will select closed rows first to enable more open row possibilies
-    // in future selections
     bool found_hidden_bank = false;
-
-    // remember if we found a row hit, not seamless, but bank prepped
-    // and ready
     bool found_prepped_pkt = false;
-
-    // if we have no row hit, prepped or not, and no seamless packet,
-    // just go for the earliest possible
     bool found_earliest_pkt = false;
 
     Tick selected_col_at = MaxTick;
@@ -87,87 +205,45 @@ DRAMInterface::chooseNextFRFCFS(MemPacketQueue& queue, Tick min_col_at) const
     for (auto i = queue.begin(); i != queue.end() ; ++i) {
         MemPacket* pkt = *i;
 
-        // select optimal DRAM packet in Q
-        if (pkt->isDram() && (pkt->pseudoChannel == pseudoChannel)) {
-            const Bank& bank = ranks[pkt->rank]->banks[pkt->bank];
-            const Tick col_allowed_at = pkt->isRead() ? bank.rdAllowedAt :
-                                                        bank.wrAllowedAt;
-
-            DPRINTF(DRAM, "%s checking DRAM packet in bank %d, row %d\n",
-                    __func__, pkt->bank, pkt->row);
-
-            // check if rank is not doing a refresh and thus is available,
-            // if not, jump to the next packet
-            if (burstReady(pkt)) {
-
-                DPRINTF(DRAM,
-                        "%s bank %d - Rank %d available\n", __func__,
-                        pkt->bank, pkt->rank);
-
-                // check if it is a row hit
-                if (bank.openRow == pkt->row) {
-                    // no additional rank-to-rank or same bank-group
-                    // delays, or we switched read/write and might as well
-                    // go for the row hit
-                    if (col_allowed_at <= min_col_at) {
-                        // FCFS within the hits, giving priority to
-                        // commands that can issue seamlessly, without
-                        // additional delay, such as same rank accesses
-                        // and/or different bank-group accesses
-                        DPRINTF(DRAM, "%s Seamless buffer hit\n", __func__);
-                        selected_pkt_it = i;
-                        selected_col_at = col_allowed_at;
-                        // no need to look through the remaining queue entries
-                        break;
-                    } else if (!found_hidden_bank && !found_prepped_pkt) {
-                        // if we did not find a packet to a closed row that can
-                        // issue the bank commands without incurring delay, and
-                        // did not yet find a packet to a prepped row, remember
-                        // the current one
-                        selected_pkt_it = i;
-                        selected_col_at = col_allowed_at;
-                        found_prepped_pkt = true;
-                        DPRINTF(DRAM, "%s Prepped row buffer hit\n", __func__);
-                    }
-                } else if (!found_earliest_pkt) {
-                    // if we have not initialised the bank status, do it
-                    // now, and only once per scheduling decisions
-                    if (!filled_earliest_banks) {
-                        // determine entries with earliest bank delay
-                        std::tie(earliest_banks, hidden_bank_prep) =
-                            minBankPrep(queue, min_col_at);
-                        filled_earliest_banks = true;
-                    }
+        if (!pkt->isDram() || pkt->pseudoChannel != pseudoChannel ||
+            !burstReady(pkt)) {
+            continue;
+        }
 
-                    // bank is amongst first available banks
-                    // minBankPrep will give priority to packets that can
-                    // issue seamlessly
-                    if (bits(earliest_banks[pkt->rank],
-                             pkt->bank, pkt->bank)) {
-                        found_earliest_pkt = true;
-                        found_hidden_bank = hidden_bank_prep;
-
-                        // give priority to packets that can issue
-                        // bank commands 'behind the scenes'
-                        // any additional delay if any will be due to
-                        // col-to-col command requirements
-                        if (hidden_bank_prep || !found_prepped_pkt) {
-                            selected_pkt_it = i;
-                            selected_col_at = col_allowed_at;
-                        }
-                    }
+        const Bank& bank = ranks[pkt->rank]->banks[pkt->bank];
+        const Tick col_allowed_at = pkt->isRead() ? bank.rdAllowedAt :
+                                                    bank.wrAllowedAt;
+
+        if (bank.openRow == pkt->row) {
+            if (col_allowed_at <= min_col_at) {
+                // seamless row hit, no need to look any further
+                selected_pkt_it = i;
+                selected_col_at = col_allowed_at;
+                break;
+            } else if (!found_hidden_bank && !found_prepped_pkt) {
+                selected_pkt_it = i;
+                selected_col_at = col_allowed_at;
+                found_prepped_pkt = true;
+            }
+        } else if (!found_earliest_pkt) {
+            if (!filled_earliest_banks) {
+                std::tie(earliest_banks, hidden_bank_prep) =
+                    minBankPrep(queue, min_col_at);
+                filled_earliest_banks = true;
+            }
+
+            if (bits(earliest_banks[pkt->rank], pkt->bank, pkt->bank)) {
+                found_earliest_pkt = true;
+                found_hidden_bank = hidden_bank_prep;
+
+                if (hidden_bank_prep || !found_prepped_pkt) {
+                    selected_pkt_it = i;
+                    selected_col_at = col_allowed_at;
                 }
-            } else {
-                DPRINTF(DRAM, "%s bank %d - Rank %d not available\n", __func__,
-                        pkt->bank, pkt->rank);
             }
         }
     }
 
-    if (selected_pkt_it == queue.end()) {
-        DPRINTF(DRAM, "%s no available DRAM ranks found\n", __func__);
-    }
-
     return std::make_pair(selected_pkt_it, selected_col_at);
 }
 
@@ -657,6 +733,8 @@ DRAMInterface::DRAMInterface(const DRAMInterfaceParams &_p)
       maxAccessesPerRow(_p.max_accesses_per_row),
       timeStampOffset(0), activeRank(0),
       enableDRAMPowerdown(_p.enable_dram_powerdown),
+      lazyRefresh(_p.lazy_refresh),
+      checkFRFCFS(_p.check_frfcfs),
       lastStatsResetTick(0),
       stats(*this)
 {
@@ -919,6 +997,11 @@ DRAMInterface::decodePacket(const PacketPtr pkt, Addr pkt_addr,
 
 void DRAMInterface::setupRank(const uint8_t rank, const bool is_read)
 {
+    // the channel is no longer idle, catch up on deferred refreshes
+    for (auto r : ranks) {
+        r->resumeRefresh();
+    }
+
     // increment entry count of the rank based on packet type
     if (is_read) {
         ++ranks[rank]->readEntries;
@@ -1038,27 +1121,19 @@ DRAMInterface::minBankPrep(const MemPacketQueue& queue,
     // delay on the data bus
     bool hidden_bank_prep = false;
 
-    // determine if we have queued transactions targetting the
-    // bank in question
-    std::vector<bool> got_waiting(ranksPerChannel * banksPerRank, false);
-    for (const auto& p : queue) {
-        if (p->pseudoChannel != pseudoChannel)
-            continue;
-        if (p->isDram() && ranks[p->rank]->inRefIdleState())
-            got_waiting[p->bankId] = true;
-    }
-
     // Find command with optimal bank timing
     // Will prioritize commands that can issue seamlessly.
     for (int i = 0; i < ranksPerChannel; i++) {
+        // only consider ranks that are not currently refreshing
+        if (!ranks[i]->inRefIdleState())
+            continue;
+
         for (int j = 0; j < banksPerRank; j++) {
             uint16_t bank_id = i * banksPerRank + j;
 
             // if we have waiting requests for the bank, and it is
             // amongst the first available, update the mask
-            if (got_waiting[bank_id]) {
-                // make sure this rank is not currently refreshing.
-                assert(ranks[i]->inRefIdleState());
+            if (queue.bankQueue(pseudoChannel, bank_id)) {
                 // simplistic approximation of when the bank can issue
                 // an activate, ignoring any rank-to-rank switching
                 // cost in this calculation
@@ -1119,7 +1194,8 @@ DRAMInterface::Rank::Rank(const DRAMInterfaceParams &_p,
                          int _rank, DRAMInterface& _dram)
     : EventManager(&_dram), dram(_dram),
       pwrStateTrans(PWR_IDLE), pwrStatePostRefresh(PWR_IDLE),
-      pwrStateTick(0), refreshDueAt(0), pwrState(PWR_IDLE),
+      pwrStateTick(0), refreshDueAt(0), refreshDeferred(false),
+      deferredRefreshAt(0), pwrState(PWR_IDLE),
       refreshState(REF_IDLE), inLowPowerState(false), rank(_rank),
       readEntries(0), writeEntries(0), outstandingEvents(0),
       wakeUpAllowedAt(0), power(_p, false), banks(_p.banks_per_rank),
@@ -1168,6 +1244,7 @@ DRAMInterface::Rank::startup(Tick ref_tick)
 void
 DRAMInterface::Rank::suspend()
 {
+    resumeRefresh();
     deschedule(refreshEvent);
 
     // Update the stats
@@ -1481,13 +1558,95 @@ DRAMInterface::Rank::processRefreshEvent()
         // refresh STM and therefore can always schedule next event.
         // Compensate for the delay in actually performing the refresh
         // when scheduling the next one
-        schedule(refreshEvent, refreshDueAt - dram.tRP);
+        if (canDeferRefresh()) {
+            DPRINTF(DRAMState, "Rank %d idle, deferring refreshes\n", rank);
+            refreshDeferred = true;
+            deferredRefreshAt = refreshDueAt - dram.tRP;
+        } else {
+            schedule(refreshEvent, refreshDueAt - dram.tRP);
+        }
 
         DPRINTF(DRAMState, "Refresh done at %llu and next refresh"
                 " at %llu\n", curTick(), refreshDueAt);
     }
 }
 
+bool
+DRAMInterface::Rank::canDeferRefresh() const
+{
+    // Only defer if the rank goes back to the idle power state after
+    // this refresh, with nothing queued or in flight for the whole
+    // channel. The refreshes that follow then all take the same path
+    // through the refresh and power state machines, which
+    // resumeRefresh() replays without events. With power-down enabled,
+    // an idle rank enters self-refresh instead and has no events anyway.
+    return dram.lazyRefresh && !dram.enableDRAMPowerdown &&
+        pwrStatePostRefresh == PWR_IDLE && outstandingEvents == 1 &&
+        readEntries == 0 && writeEntries == 0 &&
+        dram.readQueueSize == 0 && dram.writeQueueSize == 0 &&
+        dram.ctrl->drainState() == DrainState::Running;
+}
+
+void
+DRAMInterface::Rank::resumeRefresh()
+{
+    if (!refreshDeferred)
+        return;
+
+    refreshDeferred = false;
+
+    Tick ref_at = deferredRefreshAt;
+
+    // account for the refreshes that started before now, each of them
+    // taking the rank from the idle power state into refresh and back
+    while (ref_at < curTick()) {
+        assert(pwrState == PWR_IDLE && refreshState == REF_IDLE);
+        assert(outstandingEvents == 0 && numBanksActive == 0);
+        assert(!powerEvent.scheduled());
+
+        stats.pwrStateTime[PWR_IDLE] += ref_at - pwrStateTick;
+
+        Tick ref_done_at = ref_at + dram.tRFC;
+        for (auto &b : banks) {
+            b.actAllowedAt = ref_done_at;
+        }
+
+        cmdList.push_back(Command(MemCommand::REF, 0, ref_at));
+
+        DPRINTF(DRAMPower, "%llu,REF,0,%d\n", divCeil(ref_at, dram.tCK) -
+                dram.timeStampOffset, rank);
+
+        // as in processRefreshEvent, the next refresh is due tREFI after
+        // this one started, i.e. when its event would have fired, tRP
+        // ahead of the previous due time
+        refreshDueAt = ref_at + dram.tREFI;
+
+        if (ref_done_at > curTick()) {
+            // still refreshing, let the event loop finish this one
+            pwrState = PWR_REF;
+            pwrStateTick = ref_at;
+            refreshState = REF_RUN;
+            ++outstandingEvents;
+            schedule(refreshEvent, ref_done_at);
+            flushCmdList();
+            return;
+        }
+
+        stats.pwrStateTime[PWR_REF] += dram.tRFC;
+        pwrStateTick = ref_done_at;
+
+        ref_at = refreshDueAt - dram.tRP;
+    }
+
+    DPRINTF(DRAMState, "Rank %d resuming refreshes at %llu\n", rank,
+            ref_at);
+
+    // hand the accumulated commands to DRAMPower
+    flushCmdList();
+
+    schedule(refreshEvent, ref_at);
+}
+
 void
 DRAMInterface::Rank::schedulePowerEvent(PowerState pwr_state, Tick tick)
 {
@@ -1811,6 +1970,9 @@ DRAMInterface::Rank::computeStats()
 {
     DPRINTF(DRAM,"Computing stats due to a dump callback\n");
 
+    // account for any refreshes done since the rank went idle
+    resumeRefresh();
+
     // Update the stats
     updatePowerStats();
 
@@ -2016,6 +2178,9 @@ DRAMInterface::RankStats::regStats()
 void
 DRAMInterface::RankStats::resetStats()
 {
+    // make sure refreshes before the reset are not counted after it
+    rank.resumeRefresh();
+
     statistics::Group::resetStats();
 
     rank.resetStats();
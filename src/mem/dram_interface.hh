@@ -256,6 +256,23 @@ class DRAMInterface : public MemInterface
          */
         Tick refreshDueAt;
 
+        /**
+         * Set when the rank is idle and its refreshes are not scheduled as
+         * events, but computed when the rank is next needed.
+         */
+        bool refreshDeferred;
+
+        /**
+         * When the next deferred refresh would have started.
+         */
+        Tick deferredRefreshAt;
+
+        /**
+         * Check if the refreshes following the one that just completed
+         * can be deferred.
+         */
+        bool canDeferRefresh() const;
+
         /**
          * Function to update Power Stats
          */
@@ -365,6 +382,13 @@ class DRAMInterface : public MemInterface
          */
         void suspend();
 
+        /**
+         * Bring a rank with deferred refreshes up to date, accounting for
+         * all refreshes it would have done by now, and go back to
+         * scheduling refresh events.
+         */
+        void resumeRefresh();
+
         /**
          * Check if there is no refresh and no preparation of refresh ongoing
          * i.e. the refresh state machine is in idle
@@ -544,6 +568,12 @@ class DRAMInterface : public MemInterface
     /** Enable or disable DRAM powerdown states. */
     bool enableDRAMPowerdown;
 
+    /** Compute the refreshes of idle ranks lazily. */
+    const bool lazyRefresh;
+
+    /** Check every FR-FCFS decision against a scan of the queue. */
+    const bool checkFRFCFS;
+
     /** The time when stats were last reset used to calculate average power */
     Tick lastStatsResetTick;
 
@@ -649,6 +679,20 @@ class DRAMInterface : public MemInterface
     std::pair<std::vector<uint32_t>, bool>
     minBankPrep(const MemPacketQueue& queue, Tick min_col_at) const;
 
+    /**
+     * FR-FCFS selection using the bank and row index of the queue,
+     * looking only at the oldest packet of every bank and row.
+     */
+    std::pair<MemPacketQueue::iterator, Tick>
+    chooseNextIndexed(MemPacketQueue& queue, Tick min_col_at) const;
+
+    /**
+     * Reference FR-FCFS selection, going through the whole queue in
+     * arrival order. Only used to check chooseNextIndexed.
+     */
+    std::pair<MemPacketQueue::iterator, Tick>
+    chooseNextScan(MemPacketQueue& queue, Tick min_col_at) const;
+
     /*
      * @return time to send a burst of data without gaps
      */
@@ -40,6 +40,8 @@
 
 #include "mem/mem_ctrl.hh"
 
+#include <algorithm>
+
 #include "base/trace.hh"
 #include "debug/DRAM.hh"
 #include "debug/Drain.hh"
@@ -57,6 +59,61 @@ namespace gem5
 namespace memory
 {
 
+const MemPacketQueue::Entry *
+MemPacketQueue::BankQueue::oldestConflict(uint32_t row) const
+{
+    const Entry *oldest = nullptr;
+    for (const auto &bucket : rows) {
+        if (bucket.first == row)
+            continue;
+        const Entry &front = bucket.second.front();
+        if (!oldest || front.seq < oldest->seq)
+            oldest = &front;
+    }
+    return oldest;
+}
+
+void
+MemPacketQueue::push_back(MemPacket *pkt)
+{
+    iterator it = packets.insert(packets.end(), pkt);
+
+    if (pkt->isDram()) {
+        if (banks.size() <= pkt->pseudoChannel)
+            banks.resize(pkt->pseudoChannel + 1);
+        auto &channel_banks = banks[pkt->pseudoChannel];
+        if (channel_banks.size() <= pkt->bankId)
+            channel_banks.resize(pkt->bankId + 1);
+
+        channel_banks[pkt->bankId].rows[pkt->row].push_back({nextSeq++, it});
+    }
+}
+
+MemPacketQueue::iterator
+MemPacketQueue::erase(iterator it)
+{
+    MemPacket *pkt = *it;
+
+    if (pkt->isDram()) {
+        BankQueue &bank = banks[pkt->pseudoChannel][pkt->bankId];
+        auto row = bank.rows.find(pkt->row);
+        assert(row != bank.rows.end());
+
+        // The scheduler picks the oldest packet of a row in all but the
+        // QoS escalation case, so this is typically the first entry
+        auto &entries = row->second;
+        auto entry = std::find_if(entries.begin(), entries.end(),
+            [it](const Entry &e) { return e.pkt == it; });
+        assert(entry != entries.end());
+        entries.erase(entry);
+
+        if (entries.empty())
+            bank.rows.erase(row);
+    }
+
+    return packets.erase(it);
+}
+
 MemCtrl::MemCtrl(const MemCtrlParams &p) :
     qos::MemCtrl(p),
     port(name() + ".port", *this), isTimingMode(false),
@@ -486,7 +543,7 @@ MemCtrl::recvTimingReq(PacketPtr pkt)
 
 void
 MemCtrl::processRespondEvent(MemInterface* mem_intr,
-                        MemPacketQueue& queue,
+                        std::deque<MemPacket*>& queue,
                         EventFunctionWrapper& resp_event,
                         bool& retry_rd_req)
 {
@@ -549,7 +606,7 @@ MemCtrl::processRespondEvent(MemInterface* mem_intr,
     // so if there is a read that was forced to wait, retry now
     if (retry_rd_req) {
         retry_rd_req = false;
-        port.sendRetryReq();
+        sendRetryReq();
     }
 }
 
@@ -618,6 +675,18 @@ MemCtrl::chooseNextFRFCFS(MemPacketQueue& queue, Tick extra_col_delay,
     return std::make_pair(selected_pkt_it, col_allowed_at);
 }
 
+void
+MemCtrl::schedTimingResp(PacketPtr pkt, Tick when)
+{
+    port.schedTimingResp(pkt, when);
+}
+
+void
+MemCtrl::sendRetryReq()
+{
+    port.sendRetryReq();
+}
+
 void
 MemCtrl::accessAndRespond(PacketPtr pkt, Tick static_latency,
                                                 MemInterface* mem_intr)
@@ -646,7 +715,7 @@ MemCtrl::accessAndRespond(PacketPtr pkt, Tick static_latency,
 
         // queue the packet in the response queue to be sent out after
         // the static latency has passed
-        port.schedTimingResp(pkt, response_time);
+        schedTimingResp(pkt, response_time);
     } else {
         // @todo the packet is going to be deleted, and the MemPacket
         // is still having a pointer to it
@@ -879,7 +948,7 @@ MemCtrl::nonDetermReads(MemInterface* mem_intr) {
 
 void
 MemCtrl::processNextReqEvent(MemInterface* mem_intr,
-                        MemPacketQueue& resp_queue,
+                        std::deque<MemPacket*>& resp_queue,
                         EventFunctionWrapper& resp_event,
                         EventFunctionWrapper& next_req_event,
                         bool& retry_wr_req) {
@@ -1144,7 +1213,7 @@ MemCtrl::processNextReqEvent(MemInterface* mem_intr,
 
     if (retry_wr_req && mem_intr->writeQueueSize < writeBufferSize) {
         retry_wr_req = false;
-        port.sendRetryReq();
+        sendRetryReq();
     }
 }
 
@@ -47,7 +47,9 @@
 #define __MEM_CTRL_HH__
 
 #include <deque>
+#include <list>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -215,9 +217,107 @@ class MemPacket
 
 };
 
-// The memory packets are store in a multiple dequeue structure,
-// based on their QoS priority
-typedef std::deque<MemPacket*> MemPacketQueue;
+/**
+ * The memory packets are stored in a multiple queue structure, based on
+ * their QoS priority. Each queue keeps its packets in arrival order and
+ * additionally indexes the DRAM packets by pseudo channel, bank and row,
+ * so that the scheduler can find the oldest packet to a bank or row
+ * without scanning the whole queue.
+ */
+class MemPacketQueue
+{
+  private:
+    typedef std::list<MemPacket*> PacketList;
+
+  public:
+    typedef PacketList::iterator iterator;
+    typedef PacketList::const_iterator const_iterator;
+
+    /** A DRAM packet in the index, with its position in arrival order */
+    struct Entry
+    {
+        uint64_t seq;
+        iterator pkt;
+    };
+
+    /** The queued DRAM packets to one bank, bucketed by row */
+    class BankQueue
+    {
+      private:
+        friend class MemPacketQueue;
+
+        std::unordered_map<uint32_t, std::deque<Entry>> rows;
+
+      public:
+        bool empty() const { return rows.empty(); }
+
+        /** Oldest packet to the given row, nullptr if there is none */
+        const Entry *
+        oldest(uint32_t row) const
+        {
+            auto it = rows.find(row);
+            return it == rows.end() ? nullptr : &it->second.front();
+        }
+
+        /** Oldest packet to any row but the given one, if there is any */
+        const Entry *oldestConflict(uint32_t row) const;
+
+        /** Are there packets to rows other than the given one? */
+        bool
+        hasConflict(uint32_t row) const
+        {
+            return rows.size() > rows.count(row);
+        }
+    };
+
+    MemPacketQueue() = default;
+    MemPacketQueue(MemPacketQueue &&) = default;
+
+    // The index refers to the packet list, do not copy it
+    MemPacketQueue(const MemPacketQueue &) = delete;
+    MemPacketQueue &operator=(const MemPacketQueue &) = delete;
+
+    iterator begin() { return packets.begin(); }
+    iterator end() { return packets.end(); }
+    const_iterator begin() const { return packets.begin(); }
+    const_iterator end() const { return packets.end(); }
+
+    size_t size() const { return packets.size(); }
+    bool empty() const { return packets.empty(); }
+
+    MemPacket *front() const { return packets.front(); }
+    MemPacket *back() const { return packets.back(); }
+
+    void push_back(MemPacket *pkt);
+    iterator erase(iterator it);
+
+    /**
+     * Get the DRAM packets queued for a bank.
+     *
+     * @param pseudo_channel Pseudo channel of the bank
+     * @param bank_id Bank id, counting the banks of all ranks
+     * @return The queued packets, nullptr if there are none
+     */
+    const BankQueue *
+    bankQueue(uint8_t pseudo_channel, uint16_t bank_id) const
+    {
+        if (pseudo_channel >= banks.size() ||
+            bank_id >= banks[pseudo_channel].size()) {
+            return nullptr;
+        }
+        const BankQueue &bank = banks[pseudo_channel][bank_id];
+        return bank.empty() ? nullptr : &bank;
+    }
+
+  private:
+    PacketList packets;
+
+    /** Per pseudo channel, the queued DRAM packets of every bank */
+    std::vector<std::vector<BankQueue>> banks;
+
+    /** Sequence number of the next packet */
+    uint64_t nextSeq = 0;
+};
 
 
 /**
@@ -300,14 +400,14 @@ class MemCtrl : public qos::MemCtrl
      * in these methods
      */
     virtual void processNextReqEvent(MemInterface* mem_intr,
-                          MemPacketQueue& resp_queue,
+                          std::deque<MemPacket*>& resp_queue,
                           EventFunctionWrapper& resp_event,
                           EventFunctionWrapper& next_req_event,
                           bool& retry_wr_req);
     EventFunctionWrapper nextReqEvent;
 
     virtual void processRespondEvent(MemInterface* mem_intr,
-                        MemPacketQueue& queue,
+                        std::deque<MemPacket*>& queue,
                         EventFunctionWrapper& resp_event,
                         bool& retry_rd_req);
     EventFunctionWrapper respondEvent;
@@ -384,6 +484,21 @@ class MemCtrl : public qos::MemCtrl
     virtual void accessAndRespond(PacketPtr pkt, Tick static_latency,
                                                 MemInterface* mem_intr);
 
+    /**
+     * Queue a response to be sent out of the port. Controllers that
+     * sit behind a link override this to account for the way back.
+     *
+     * @param pkt The response packet
+     * @param when Tick at which the response leaves the controller
+     */
+    virtual void schedTimingResp(PacketPtr pkt, Tick when);
+
+    /**
+     * Tell the requestor that a request refused earlier may be
+     * retried now.
+     */
+    virtual void sendRetryReq();
+
     /**
      * Determine if there is a packet that can issue.
      *
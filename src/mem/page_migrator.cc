@@ -0,0 +1,613 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "mem/page_migrator.hh"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+#include "base/cast.hh"
+#include "base/intmath.hh"
+#include "base/trace.hh"
+#include "debug/Drain.hh"
+#include "debug/PageMigrator.hh"
+#include "sim/system.hh"
+
+namespace gem5
+{
+
+PageMigrator::PageMigrator(const PageMigratorParams &p)
+    : AddrMapper(p),
+      system(p.system),
+      requestorId(p.system->getRequestorId(this)),
+      range(p.range), nearRange(p.near_range), farRange(p.far_range),
+      pageSize(p.page_size), pageShift(floorLog2(p.page_size)),
+      numNearFrames(p.near_range.size() / p.page_size),
+      epoch(p.epoch),
+      hotThreshold(std::min<unsigned>(p.hot_threshold,
+                                      std::numeric_limits<uint16_t>::max())),
+      maxMigrations(p.max_migrations),
+      victimHand(0), waitingForRetry(false), retryDemand(false),
+      epochEvent([this] { processEpochEvent(); }, name() + ".epochEvent"),
+      sendEvent([this] { processSendEvent(); }, name() + ".sendEvent"),
+      stats(*this)
+{
+    fatal_if(!isPowerOf2(pageSize), "%s: page size must be a power of 2.\n",
+             name());
+    fatal_if(range.interleaved() || nearRange.interleaved() ||
+             farRange.interleaved(),
+             "%s: interleaved ranges are not supported.\n", name());
+    fatal_if(range.start() % pageSize || nearRange.start() % pageSize ||
+             farRange.start() % pageSize || nearRange.size() % pageSize ||
+             farRange.size() % pageSize,
+             "%s: ranges must be page aligned.\n", name());
+    fatal_if(range.size() != nearRange.size() + farRange.size(),
+             "%s: the range must be as large as near and far memory "
+             "together.\n", name());
+    fatal_if(numNearFrames == 0, "%s: near memory is empty.\n", name());
+    fatal_if(pageSize % system->cacheLineSize(),
+             "%s: pages must be made of whole cache lines.\n", name());
+
+    uint64_t num_pages = range.size() / pageSize;
+    fatal_if(num_pages > std::numeric_limits<uint32_t>::max(),
+             "%s: too many pages, use larger pages.\n", name());
+
+    frameOf.resize(num_pages);
+    std::iota(frameOf.begin(), frameOf.end(), 0);
+    pageIn = frameOf;
+    hotness.assign(num_pages, 0);
+}
+
+AddrRangeList
+PageMigrator::getAddrRanges() const
+{
+    return AddrRangeList({range});
+}
+
+void
+PageMigrator::init()
+{
+    AddrMapper::init();
+    cpuSidePort.sendRangeChange();
+}
+
+void
+PageMigrator::startup()
+{
+    schedule(epochEvent, nextEpochAt ? nextEpochAt : curTick() + epoch);
+}
+
+uint32_t
+PageMigrator::pageOf(Addr addr) const
+{
+    return (addr - range.start()) >> pageShift;
+}
+
+Addr
+PageMigrator::frameAddr(uint32_t frame) const
+{
+    if (frame < numNearFrames)
+        return nearRange.start() + (Addr(frame) << pageShift);
+    return farRange.start() + (Addr(frame - numNearFrames) << pageShift);
+}
+
+Addr
+PageMigrator::remapAddr(Addr addr) const
+{
+    return frameAddr(frameOf[pageOf(addr)]) + (addr & (pageSize - 1));
+}
+
+void
+PageMigrator::touch(uint32_t page)
+{
+    if (hotness[page] == 0)
+        activePages.push_back(page);
+    if (hotness[page] < std::numeric_limits<uint16_t>::max())
+        ++hotness[page];
+
+    if (isNear(page))
+        stats.nearAccesses++;
+    else
+        stats.farAccesses++;
+}
+
+bool
+PageMigrator::recvTimingReq(PacketPtr pkt)
+{
+    // demand requests never overtake the requests queued ahead of them
+    if (waitingForRetry || !sendQueue.empty()) {
+        retryDemand = true;
+        return false;
+    }
+
+    uint32_t page = pageOf(pkt->getAddr());
+    bool expects_response = pkt->needsResponse() && !pkt->cacheResponding();
+
+    if (migration && migration->slot(page) >= 0) {
+        DPRINTF(PageMigrator, "Holding %s while page %d moves\n",
+                pkt->print(), page);
+        if (expects_response)
+            pkt->pushSenderState(new AddrMapperSenderState(pkt->getAddr()));
+        migration->parked.push_back(pkt);
+        stats.parkedRequests++;
+        touch(page);
+        return true;
+    }
+
+    if (!AddrMapper::recvTimingReq(pkt)) {
+        waitingForRetry = true;
+        retryDemand = true;
+        return false;
+    }
+
+    if (expects_response)
+        ++inflight[page];
+    touch(page);
+    return true;
+}
+
+bool
+PageMigrator::recvTimingResp(PacketPtr pkt)
+{
+    auto *state = dynamic_cast<MigrationState *>(pkt->senderState);
+    if (!state) {
+        auto *mapper_state =
+            safe_cast<AddrMapperSenderState *>(pkt->senderState);
+        uint32_t page = pageOf(mapper_state->origAddr);
+        if (!AddrMapper::recvTimingResp(pkt))
+            return false;
+
+        auto it = inflight.find(page);
+        assert(it != inflight.end());
+        if (--it->second == 0) {
+            inflight.erase(it);
+            if (migration && migration->slot(page) >= 0)
+                startWrites();
+        }
+        return true;
+    }
+
+    assert(migration);
+    pkt->popSenderState();
+    if (pkt->isRead()) {
+        pkt->writeData(migration->data[state->which].data() +
+                       state->offset);
+        migration->copied[state->which]
+                         [state->offset / system->cacheLineSize()] = true;
+    }
+    delete state;
+    delete pkt;
+
+    assert(migration->outstanding);
+    if (--migration->outstanding == 0) {
+        if (migration->writing)
+            finishMigration();
+        else
+            startWrites();
+    }
+    return true;
+}
+
+void
+PageMigrator::recvReqRetry()
+{
+    waitingForRetry = false;
+    processSendEvent();
+}
+
+void
+PageMigrator::queueSend(PacketPtr pkt)
+{
+    sendQueue.push_back(pkt);
+    if (!waitingForRetry && !sendEvent.scheduled())
+        schedule(sendEvent, curTick());
+}
+
+void
+PageMigrator::processSendEvent()
+{
+    while (!sendQueue.empty()) {
+        if (!memSidePort.sendTimingReq(sendQueue.front())) {
+            waitingForRetry = true;
+            return;
+        }
+        sendQueue.pop_front();
+    }
+
+    if (retryDemand) {
+        retryDemand = false;
+        cpuSidePort.sendRetryReq();
+    }
+
+    checkDrained();
+}
+
+PacketPtr
+PageMigrator::createPacket(MemCmd cmd, Addr addr, int which, Addr offset)
+{
+    RequestPtr req = std::make_shared<Request>(
+        addr, system->cacheLineSize(), 0, requestorId);
+    PacketPtr pkt = new Packet(req, cmd);
+    if (pkt->isRead())
+        pkt->allocate();
+    else
+        pkt->dataStatic(migration->data[which].data() + offset);
+    pkt->pushSenderState(new MigrationState(which, offset));
+    return pkt;
+}
+
+void
+PageMigrator::startMigration()
+{
+    while (!migration && !plan.empty()) {
+        auto [hot, cold] = plan.front();
+        plan.pop_front();
+
+        // an earlier swap may have moved the pages already
+        if (isNear(hot) || !isNear(cold))
+            continue;
+
+        if (!system->isTimingMode()) {
+            swapFunctional(hot, cold);
+            continue;
+        }
+
+        DPRINTF(PageMigrator, "Promoting page %d, demoting page %d\n",
+                hot, cold);
+
+        migration = std::make_unique<Migration>();
+        migration->pages[0] = hot;
+        migration->pages[1] = cold;
+
+        const unsigned blk = system->cacheLineSize();
+        for (int which = 0; which < 2; ++which) {
+            migration->data[which].resize(pageSize);
+            migration->copied[which].assign(pageSize / blk, false);
+            Addr base = frameAddr(frameOf[migration->pages[which]]);
+            for (Addr offset = 0; offset < pageSize; offset += blk) {
+                queueSend(createPacket(MemCmd::ReadReq, base + offset,
+                                       which, offset));
+                ++migration->outstanding;
+            }
+        }
+    }
+}
+
+void
+PageMigrator::startWrites()
+{
+    // the memory controllers perform writes as they arrive, so demand
+    // reads still in flight to the old frames must complete first
+    if (migration->writing || migration->outstanding ||
+        inflight.count(migration->pages[0]) ||
+        inflight.count(migration->pages[1])) {
+        return;
+    }
+
+    migration->writing = true;
+
+    const unsigned blk = system->cacheLineSize();
+    for (int which = 0; which < 2; ++which) {
+        Addr base = frameAddr(frameOf[migration->pages[1 - which]]);
+        for (Addr offset = 0; offset < pageSize; offset += blk) {
+            queueSend(createPacket(MemCmd::WriteReq, base + offset,
+                                   which, offset));
+            ++migration->outstanding;
+        }
+    }
+}
+
+void
+PageMigrator::finishMigration()
+{
+    swapFrames(migration->pages[0], migration->pages[1]);
+
+    stats.migrations++;
+    stats.bytesMigrated += 2 * pageSize;
+
+    for (auto *pkt : migration->parked) {
+        if (pkt->needsResponse() && !pkt->cacheResponding())
+            ++inflight[pageOf(pkt->getAddr())];
+        pkt->setAddr(remapAddr(pkt->getAddr()));
+        queueSend(pkt);
+    }
+    migration.reset();
+
+    if (drainState() == DrainState::Running)
+        startMigration();
+
+    checkDrained();
+}
+
+void
+PageMigrator::swapFrames(uint32_t a, uint32_t b)
+{
+    std::swap(frameOf[a], frameOf[b]);
+    pageIn[frameOf[a]] = a;
+    pageIn[frameOf[b]] = b;
+}
+
+void
+PageMigrator::swapFunctional(uint32_t hot, uint32_t cold)
+{
+    DPRINTF(PageMigrator, "Swapping pages %d and %d\n", hot, cold);
+
+    std::vector<uint8_t> data[2];
+    const uint32_t pages[2] = {hot, cold};
+
+    for (int which = 0; which < 2; ++which) {
+        data[which].resize(pageSize);
+        auto req = std::make_shared<Request>(
+            frameAddr(frameOf[pages[which]]), pageSize, 0, requestorId);
+        Packet pkt(req, MemCmd::ReadReq);
+        pkt.dataStatic(data[which].data());
+        memSidePort.sendFunctional(&pkt);
+    }
+
+    for (int which = 0; which < 2; ++which) {
+        auto req = std::make_shared<Request>(
+            frameAddr(frameOf[pages[1 - which]]), pageSize, 0, requestorId);
+        Packet pkt(req, MemCmd::WriteReq);
+        pkt.dataStatic(data[which].data());
+        memSidePort.sendFunctional(&pkt);
+    }
+
+    swapFrames(hot, cold);
+
+    stats.migrations++;
+    stats.bytesMigrated += 2 * pageSize;
+}
+
+void
+PageMigrator::planMigrations()
+{
+    plan.clear();
+
+    auto hotter = [this](uint32_t a, uint32_t b) {
+        return hotness[a] != hotness[b] ? hotness[a] > hotness[b] : a < b;
+    };
+    auto colder = [this](uint32_t a, uint32_t b) {
+        return hotness[a] != hotness[b] ? hotness[a] < hotness[b] : a < b;
+    };
+
+    std::vector<uint32_t> hot;
+    for (auto page : activePages) {
+        if (!isNear(page) && hotness[page] >= hotThreshold)
+            hot.push_back(page);
+    }
+    size_t count = std::min<size_t>(hot.size(), maxMigrations);
+    std::partial_sort(hot.begin(), hot.begin() + count, hot.end(), hotter);
+    hot.resize(count);
+
+    // prefer victims that were not accessed recently, found by a clock
+    // hand over the near frames, then fall back to the coldest of the
+    // recently accessed ones
+    std::vector<uint32_t> cold;
+    for (uint32_t i = 0; i < numNearFrames && cold.size() < count; ++i) {
+        uint32_t page = pageIn[victimHand];
+        victimHand = (victimHand + 1) % numNearFrames;
+        if (hotness[page] == 0)
+            cold.push_back(page);
+    }
+    if (cold.size() < count) {
+        std::vector<uint32_t> warm;
+        for (auto page : activePages) {
+            if (isNear(page))
+                warm.push_back(page);
+        }
+        size_t needed = std::min(count - cold.size(), warm.size());
+        std::partial_sort(warm.begin(), warm.begin() + needed, warm.end(),
+                          colder);
+        cold.insert(cold.end(), warm.begin(), warm.begin() + needed);
+    }
+
+    for (size_t i = 0; i < std::min(hot.size(), cold.size()); ++i) {
+        if (hotness[hot[i]] > hotness[cold[i]])
+            plan.emplace_back(hot[i], cold[i]);
+    }
+
+    DPRINTF(PageMigrator, "Epoch: %d active pages, %d swaps planned\n",
+            activePages.size(), plan.size());
+
+    // age the counters
+    auto end = std::remove_if(activePages.begin(), activePages.end(),
+        [this](uint32_t page) {
+            hotness[page] >>= 1;
+            return hotness[page] == 0;
+        });
+    activePages.erase(end, activePages.end());
+}
+
+void
+PageMigrator::processEpochEvent()
+{
+    stats.epochs++;
+
+    planMigrations();
+    if (drainState() == DrainState::Running)
+        startMigration();
+
+    schedule(epochEvent, curTick() + epoch);
+}
+
+Tick
+PageMigrator::recvAtomic(PacketPtr pkt)
+{
+    touch(pageOf(pkt->getAddr()));
+    return AddrMapper::recvAtomic(pkt);
+}
+
+void
+PageMigrator::recvFunctional(PacketPtr pkt)
+{
+    Addr addr = pkt->getAddr();
+    int which = migration ? migration->slot(pageOf(addr)) : -1;
+
+    if (which >= 0) {
+        for (auto *parked : migration->parked) {
+            if (pkt->trySatisfyFunctional(parked)) {
+                pkt->makeResponse();
+                return;
+            }
+        }
+
+        Addr offset = addr & (pageSize - 1);
+        uint8_t *buffer = migration->data[which].data() + offset;
+        if (migration->writing) {
+            // the page only exists in the buffer and at its destination
+            if (pkt->isRead()) {
+                pkt->setData(buffer);
+                pkt->makeResponse();
+                return;
+            }
+            pkt->writeData(buffer);
+            pkt->setAddr(frameAddr(frameOf[migration->pages[1 - which]]) +
+                         offset);
+            memSidePort.sendFunctional(pkt);
+            pkt->setAddr(addr);
+            return;
+        }
+
+        if (pkt->isWrite() &&
+            migration->copied[which][offset / system->cacheLineSize()]) {
+            pkt->writeData(buffer);
+        }
+    }
+
+    pkt->setAddr(remapAddr(addr));
+    for (auto *queued : sendQueue) {
+        if (pkt->trySatisfyFunctional(queued)) {
+            pkt->setAddr(addr);
+            pkt->makeResponse();
+            return;
+        }
+    }
+    memSidePort.sendFunctional(pkt);
+    pkt->setAddr(addr);
+}
+
+void
+PageMigrator::checkDrained()
+{
+    if (drainState() == DrainState::Draining && !migration &&
+        sendQueue.empty()) {
+        DPRINTF(Drain, "PageMigrator done draining\n");
+        signalDrainDone();
+    }
+}
+
+DrainState
+PageMigrator::drain()
+{
+    // swaps that have not started are dropped, the next epoch plans
+    // again
+    plan.clear();
+    return migration || !sendQueue.empty() ? DrainState::Draining :
+                                             DrainState::Drained;
+}
+
+void
+PageMigrator::serialize(CheckpointOut &cp) const
+{
+    SERIALIZE_CONTAINER(frameOf);
+
+    // Only the active pages have a non-zero counter, save them sparsely
+    std::vector<uint16_t> active_hotness;
+    for (auto page : activePages)
+        active_hotness.push_back(hotness[page]);
+    SERIALIZE_CONTAINER(activePages);
+    SERIALIZE_CONTAINER(active_hotness);
+
+    SERIALIZE_SCALAR(victimHand);
+
+    Tick next_epoch_at = epochEvent.when();
+    SERIALIZE_SCALAR(next_epoch_at);
+}
+
+void
+PageMigrator::unserialize(CheckpointIn &cp)
+{
+    UNSERIALIZE_CONTAINER(frameOf);
+    fatal_if(frameOf.size() != pageIn.size(),
+             "%s: checkpoint has %d pages, expected %d.\n", name(),
+             frameOf.size(), pageIn.size());
+    for (uint32_t page = 0; page < frameOf.size(); ++page)
+        pageIn[frameOf[page]] = page;
+
+    std::vector<uint16_t> active_hotness;
+    UNSERIALIZE_CONTAINER(activePages);
+    UNSERIALIZE_CONTAINER(active_hotness);
+    fatal_if(active_hotness.size() != activePages.size(),
+             "%s: checkpoint has %d counters for %d active pages.\n",
+             name(), active_hotness.size(), activePages.size());
+    hotness.assign(hotness.size(), 0);
+    for (size_t i = 0; i < activePages.size(); ++i)
+        hotness[activePages[i]] = active_hotness[i];
+
+    UNSERIALIZE_SCALAR(victimHand);
+    fatal_if(victimHand >= numNearFrames,
+             "%s: checkpoint has victim frame %d out of %d near frames.\n",
+             name(), victimHand, numNearFrames);
+
+    Tick next_epoch_at;
+    UNSERIALIZE_SCALAR(next_epoch_at);
+    nextEpochAt = next_epoch_at;
+}
+
+PageMigrator::PageMigratorStats::PageMigratorStats(PageMigrator &migrator)
+    : statistics::Group(&migrator),
+
+    ADD_STAT(nearAccesses, statistics::units::Count::get(),
+             "Number of accesses to pages held in near memory"),
+    ADD_STAT(farAccesses, statistics::units::Count::get(),
+             "Number of accesses to pages held in far memory"),
+    ADD_STAT(migrations, statistics::units::Count::get(),
+             "Number of page swaps between near and far memory"),
+    ADD_STAT(bytesMigrated, statistics::units::Byte::get(),
+             "Number of bytes moved by page swaps"),
+    ADD_STAT(parkedRequests, statistics::units::Count::get(),
+             "Number of requests held back by a page swap"),
+    ADD_STAT(epochs, statistics::units::Count::get(),
+             "Number of epochs"),
+    ADD_STAT(nearHitRate, statistics::units::Ratio::get(),
+             "Fraction of the accesses served by near memory")
+{
+}
+
+void
+PageMigrator::PageMigratorStats::regStats()
+{
+    using namespace statistics;
+
+    nearHitRate.flags(nonan).precision(4);
+    nearHitRate = nearAccesses / (nearAccesses + farAccesses);
+}
+
+} // namespace gem5
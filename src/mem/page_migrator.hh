@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __MEM_PAGE_MIGRATOR_HH__
+#define __MEM_PAGE_MIGRATOR_HH__
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "base/statistics.hh"
+#include "mem/addr_mapper.hh"
+#include "params/PageMigrator.hh"
+#include "sim/eventq.hh"
+#include "sim/serialize.hh"
+
+namespace gem5
+{
+
+class System;
+
+/**
+ * Host-managed memory tiering without an operating system. The
+ * migrator exposes a single range backed by a near and a far memory
+ * and maps every page of the range to a frame in either of them. It
+ * counts the accesses to every page, and at the end of each epoch it
+ * swaps the hottest pages held in far memory with the coldest pages
+ * held in near memory. The counters are halved every epoch so that
+ * hotness follows the recent behaviour.
+ *
+ * In timing mode a swap reads both pages and writes them back to the
+ * exchanged frames through the memory-side port, so the migration
+ * traffic competes with the demand traffic. Accesses to the two pages
+ * are held back while they move.
+ */
+class PageMigrator : public AddrMapper
+{
+  public:
+    PageMigrator(const PageMigratorParams &p);
+
+    AddrRangeList getAddrRanges() const override;
+
+    void init() override;
+    void startup() override;
+
+    DrainState drain() override;
+
+    void serialize(CheckpointOut &cp) const override;
+    void unserialize(CheckpointIn &cp) override;
+
+  protected:
+    Addr remapAddr(Addr addr) const override;
+
+    void recvFunctional(PacketPtr pkt) override;
+    Tick recvAtomic(PacketPtr pkt) override;
+    bool recvTimingReq(PacketPtr pkt) override;
+    bool recvTimingResp(PacketPtr pkt) override;
+    void recvReqRetry() override;
+
+    void
+    recvRangeChange() override
+    {
+    }
+
+  private:
+    /** A swap of a far page with a near page in progress. */
+    struct Migration
+    {
+        /** The far page to promote and the near page to demote. */
+        uint32_t pages[2];
+
+        /** Contents of both pages while they move. */
+        std::vector<uint8_t> data[2];
+
+        /** Blocks of each page read so far. */
+        std::vector<bool> copied[2];
+
+        unsigned outstanding = 0;
+        bool writing = false;
+
+        /** Demand requests held back until the pages have moved. */
+        std::vector<PacketPtr> parked;
+
+        int
+        slot(uint32_t page) const
+        {
+            return page == pages[0] ? 0 : page == pages[1] ? 1 : -1;
+        }
+    };
+
+    /** Identifies the responses to the migration traffic. */
+    struct MigrationState : public Packet::SenderState
+    {
+        int which;
+        Addr offset;
+
+        MigrationState(int _which, Addr _offset)
+            : which(_which), offset(_offset)
+        {}
+    };
+
+    System *system;
+    const RequestorID requestorId;
+
+    const AddrRange range;
+    const AddrRange nearRange;
+    const AddrRange farRange;
+
+    const Addr pageSize;
+    const unsigned pageShift;
+    const uint32_t numNearFrames;
+
+    const Tick epoch;
+    const uint16_t hotThreshold;
+    const unsigned maxMigrations;
+
+    /** Frame holding each page, near frames come first. */
+    std::vector<uint32_t> frameOf;
+
+    /** Page held by each frame. */
+    std::vector<uint32_t> pageIn;
+
+    /** Decaying access counter of each page. */
+    std::vector<uint16_t> hotness;
+
+    /** Pages with a non-zero counter. */
+    std::vector<uint32_t> activePages;
+
+    /** Demand requests awaiting a response, per page. */
+    std::unordered_map<uint32_t, unsigned> inflight;
+
+    /** Next near frame to consider as a victim. */
+    uint32_t victimHand;
+
+    /** When the next epoch starts, if restored from a checkpoint. */
+    Tick nextEpochAt = 0;
+
+    std::unique_ptr<Migration> migration;
+
+    /** Swaps chosen at the last epoch and not started yet. */
+    std::deque<std::pair<uint32_t, uint32_t>> plan;
+
+    /** Requests that leave the migrator ahead of any demand request. */
+    std::deque<PacketPtr> sendQueue;
+
+    /** The memory side refused a request and will send a retry. */
+    bool waitingForRetry;
+
+    /** A demand request was refused and the requestor must be retried. */
+    bool retryDemand;
+
+    void processEpochEvent();
+    EventFunctionWrapper epochEvent;
+
+    void processSendEvent();
+    EventFunctionWrapper sendEvent;
+
+    uint32_t pageOf(Addr addr) const;
+    Addr frameAddr(uint32_t frame) const;
+    bool isNear(uint32_t page) const { return frameOf[page] < numNearFrames; }
+
+    void touch(uint32_t page);
+
+    /** Choose the swaps for the next epoch and age the counters. */
+    void planMigrations();
+
+    void startMigration();
+    void startWrites();
+    void finishMigration();
+
+    /** Exchange the contents and frames of two pages functionally. */
+    void swapFunctional(uint32_t hot, uint32_t cold);
+
+    void swapFrames(uint32_t a, uint32_t b);
+
+    void queueSend(PacketPtr pkt);
+
+    void checkDrained();
+
+    PacketPtr createPacket(MemCmd cmd, Addr addr, int which, Addr offset);
+
+    struct PageMigratorStats : public statistics::Group
+    {
+        PageMigratorStats(PageMigrator &migrator);
+
+        void regStats() override;
+
+        statistics::Scalar nearAccesses;
+        statistics::Scalar farAccesses;
+        statistics::Scalar migrations;
+        statistics::Scalar bytesMigrated;
+        statistics::Scalar parkedRequests;
+        statistics::Scalar epochs;
+
+        statistics::Formula nearHitRate;
+    } stats;
+};
+
+} // namespace gem5
+
+#endif //__MEM_PAGE_MIGRATOR_HH__
@@ -52,6 +52,7 @@
 
 #include "base/intmath.hh"
 #include "base/trace.hh"
+#include "config/have_zstd.hh"
 #include "debug/AddrRanges.hh"
 #include "debug/Checkpoint.hh"
 #include "mem/abstract_mem.hh"
@@ -80,10 +81,24 @@ PhysicalMemory::PhysicalMemory(const std::string& _name,
                                const std::vector<AbstractMemory*>& _memories,
                                bool mmap_using_noreserve,
                                const std::string& shared_backstore,
-                               bool auto_unlink_shared_backstore) :
+                               bool auto_unlink_shared_backstore,
+                               bool chunked_checkpoints,
+                               unsigned checkpoint_threads,
+                               int checkpoint_compression,
+                               bool incremental_checkpoints,
+                               bool verify_checkpoints) :
     _name(_name), size(0), mmapUsingNoReserve(mmap_using_noreserve),
     sharedBackstore(shared_backstore), sharedBackstoreSize(0),
-    pageSize(sysconf(_SC_PAGE_SIZE))
+    pageSize(sysconf(_SC_PAGE_SIZE)),
+    // Without zstd, compressed checkpoints are written as a single gzip
+    // stream unless incremental checkpoints need chunks
+    chunkedCheckpoints(chunked_checkpoints &&
+                       (HAVE_ZSTD || checkpoint_compression <= 0 ||
+                        incremental_checkpoints)),
+    checkpointThreads(checkpoint_threads),
+    checkpointCompression(checkpoint_compression),
+    incrementalCheckpoints(incremental_checkpoints),
+    verifyCheckpoints(verify_checkpoints)
 {
     // Register cleanup callback if requested.
     if (auto_unlink_shared_backstore && !sharedBackstore.empty()) {
@@ -93,6 +108,11 @@ PhysicalMemory::PhysicalMemory(const std::string& _name,
     if (mmap_using_noreserve)
         warn("Not reserving swap space. May cause SIGSEGV on actual usage\n");
 
+    if (chunked_checkpoints && !chunkedCheckpoints) {
+        warn("gem5 was built without zstd, memory checkpoints will be "
+             "written in the gzip format.\n");
+    }
+
     // add the memories from the system to the address map as
     // appropriate
     for (const auto& m : _memories) {
@@ -366,8 +386,10 @@ PhysicalMemory::serializeStore(CheckpointOut &cp, unsigned int store_id,
     // we cannot use the address range for the name as the
     // memories that are not part of the address map can overlap
     std::string filename =
-        name() + ".store" + std::to_string(store_id) + ".pmem";
+        name() + ".store" + std::to_string(store_id) +
+        (chunkedCheckpoints ? ".pmemc" : ".pmem");
     long range_size = range.size();
+    std::string format = chunkedCheckpoints ? "chunked" : "gzip";
 
     DPRINTF(Checkpoint, "Serializing physical memory %s with size %d\n",
             filename, range_size);
@@ -375,9 +397,28 @@ PhysicalMemory::serializeStore(CheckpointOut &cp, unsigned int store_id,
     SERIALIZE_SCALAR(store_id);
     SERIALIZE_SCALAR(filename);
     SERIALIZE_SCALAR(range_size);
+    SERIALIZE_SCALAR(format);
 
     // write memory file
     std::string filepath = CheckpointIn::dir() + "/" + filename.c_str();
+    if (chunkedCheckpoints) {
+        if (checkpointDigests.size() <= store_id)
+            checkpointDigests.resize(store_id + 1);
+        chunked_store::Digest &digest = checkpointDigests[store_id];
+
+        const chunked_store::Digest *parent = nullptr;
+        if (incrementalCheckpoints && digest.valid()) {
+            DPRINTF(Checkpoint, "Storing changes since %s\n", digest.path);
+            parent = &digest;
+        }
+
+        digest = chunked_store::write(filepath, pmem, range.size(),
+                                      checkpointThreads,
+                                      checkpointCompression, parent,
+                                      verifyCheckpoints);
+        return;
+    }
+
     gzFile compressed_mem = gzopen(filepath.c_str(), "wb");
     if (compressed_mem == NULL)
         fatal("Can't open physical memory checkpoint file '%s'\n",
@@ -443,10 +484,9 @@ PhysicalMemory::unserializeStore(CheckpointIn &cp)
     UNSERIALIZE_SCALAR(filename);
     std::string filepath = cp.getCptDir() + "/" + filename;
 
-    // mmap memoryfile
-    gzFile compressed_mem = gzopen(filepath.c_str(), "rb");
-    if (compressed_mem == NULL)
-        fatal("Can't open physical memory checkpoint file '%s'", filename);
+    // checkpoints that predate the chunked format don't name it
+    std::string format = "gzip";
+    UNSERIALIZE_OPT_SCALAR(format);
 
     // we've already got the actual backing store mapped
     uint8_t* pmem = backingStore[store_id].pmem;
@@ -455,13 +495,30 @@ PhysicalMemory::unserializeStore(CheckpointIn &cp)
     long range_size;
     UNSERIALIZE_SCALAR(range_size);
 
-    DPRINTF(Checkpoint, "Unserializing physical memory %s with size %d\n",
-            filename, range_size);
+    DPRINTF(Checkpoint, "Unserializing physical memory %s with size %d "
+            "(%s)\n", filename, range_size, format);
 
     if (range_size != range.size())
         fatal("Memory range size has changed! Saw %lld, expected %lld\n",
               range_size, range.size());
 
+    if (format == "chunked") {
+        if (checkpointDigests.size() <= store_id)
+            checkpointDigests.resize(store_id + 1);
+        checkpointDigests[store_id] =
+            chunked_store::read(filepath, pmem, range.size(),
+                                checkpointThreads, pageSize);
+        return;
+    }
+
+    fatal_if(format != "gzip",
+             "Unknown physical memory checkpoint format '%s'\n", format);
+
+    // mmap memoryfile
+    gzFile compressed_mem = gzopen(filepath.c_str(), "rb");
+    if (compressed_mem == NULL)
+        fatal("Can't open physical memory checkpoint file '%s'", filename);
+
     uint64_t curr_size = 0;
     long* temp_page = new long[chunk_size];
     long* pmem_current;
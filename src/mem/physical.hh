@@ -44,6 +44,7 @@
 
 #include "base/addr_range.hh"
 #include "base/addr_range_map.hh"
+#include "mem/chunked_store.hh"
 #include "mem/packet.hh"
 #include "sim/serialize.hh"
 
@@ -158,6 +159,28 @@ class PhysicalMemory : public Serializable
 
     long pageSize;
 
+    // Write memory checkpoints in the chunked format (see
+    // chunked_store.hh) rather than as a single gzip stream
+    const bool chunkedCheckpoints;
+
+    // Number of threads used to write and read chunked checkpoints, 0
+    // to use one per host core
+    const unsigned checkpointThreads;
+
+    // zstd compression level of chunked checkpoints
+    const int checkpointCompression;
+
+    // Only store the chunks that changed since the last chunked
+    // checkpoint this memory was written to or restored from
+    const bool incrementalCheckpoints;
+
+    // Compare unchanged chunks with the previous checkpoint rather than
+    // only their hashes
+    const bool verifyCheckpoints;
+
+    // Chunk hashes of the last checkpoint of every backing store
+    mutable std::vector<chunked_store::Digest> checkpointDigests;
+
     // The physical memory used to provide the memory in the simulated
     // system
     std::vector<BackingStoreEntry> backingStore;
@@ -191,7 +214,12 @@ class PhysicalMemory : public Serializable
                    const std::vector<AbstractMemory*>& _memories,
                    bool mmap_using_noreserve,
                    const std::string& shared_backstore,
-                   bool auto_unlink_shared_backstore);
+                   bool auto_unlink_shared_backstore,
+                   bool chunked_checkpoints = false,
+                   unsigned checkpoint_threads = 0,
+                   int checkpoint_compression = 1,
+                   bool incremental_checkpoints = false,
+                   bool verify_checkpoints = false);
 
     /**
      * Unmap all the backing store we have used.
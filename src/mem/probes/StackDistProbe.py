@@ -58,6 +58,14 @@ class StackDistProbe(BaseMemProbe):
         False, "Verify behaviuor with reference implementation"
     )
 
+    # SHARDS-style spatial sampling
+    sampling_ratio = Param.Unsigned(
+        1,
+        "Only track the cache lines whose address hash is a multiple of "
+        "this ratio, and scale the stack distances and the counts by it to "
+        "estimate the full distribution (1 tracks all lines)",
+    )
+
     # linear histogram bins and enable/disable
     linear_hist_bins = Param.Unsigned("16", "Bins in linear histograms")
     disable_linear_hists = Param.Bool(False, "Disable linear histograms")
@@ -43,17 +43,39 @@
 namespace gem5
 {
 
+namespace
+{
+
+/**
+ * Mix the bits of a line address so that any subset of the hash
+ * values selects lines uniformly, whatever the stride of the accesses.
+ */
+uint64_t
+hashLine(Addr addr)
+{
+    // splitmix64 finalizer
+    uint64_t h = addr;
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+}
+
+} // anonymous namespace
+
 StackDistProbe::StackDistProbe(const StackDistProbeParams &p)
     : BaseMemProbe(p),
       lineSize(p.line_size),
       disableLinearHists(p.disable_linear_hists),
       disableLogHists(p.disable_log_hists),
+      samplingRatio(p.sampling_ratio),
       calc(p.verify),
       stats(this)
 {
     fatal_if(p.system->cacheLineSize() > p.line_size,
              "The stack distance probe must use a cache line size that is "
              "larger or equal to the system's cahce line size.");
+    fatal_if(p.sampling_ratio == 0,
+             "The stack distance probe sampling ratio must be at least 1.");
 }
 
 StackDistProbe::StackDistProbeStats::StackDistProbeStats(
@@ -106,19 +128,28 @@ StackDistProbe::handleRequest(const probing::PacketInfo &pkt_info)
     // Align the address to a cache line size
     const Addr aligned_addr(roundDown(pkt_info.addr, lineSize));
 
+    // Spatial sampling as in SHARDS (Waldspurger et al., FAST'15): a
+    // line is either always or never tracked, depending on a hash of
+    // its address. The sampled lines see the reuse pattern of all
+    // lines scaled down by the sampling ratio, so their distances and
+    // counts are scaled back up by it.
+    if (samplingRatio > 1 && hashLine(aligned_addr) % samplingRatio != 0)
+        return;
+
     // Calculate the stack distance
-    const uint64_t sd(calc.calcStackDistAndUpdate(aligned_addr).first);
+    uint64_t sd(calc.calcStackDistAndUpdate(aligned_addr).first);
     if (sd == StackDistCalc::Infinity) {
-        stats.infiniteSD++;
+        stats.infiniteSD += samplingRatio;
         return;
     }
+    sd *= samplingRatio;
 
     // Sample the stack distance of the address in linear bins
     if (!disableLinearHists) {
         if (pkt_info.cmd.isRead())
-            stats.readLinearHist.sample(sd);
+            stats.readLinearHist.sample(sd, samplingRatio);
         else
-            stats.writeLinearHist.sample(sd);
+            stats.writeLinearHist.sample(sd, samplingRatio);
     }
 
     if (!disableLogHists) {
@@ -126,9 +157,9 @@ StackDistProbe::handleRequest(const probing::PacketInfo &pkt_info)
 
         // Sample the stack distance of the address in log bins
         if (pkt_info.cmd.isRead())
-            stats.readLogHist.sample(sd_lg2);
+            stats.readLogHist.sample(sd_lg2, samplingRatio);
         else
-            stats.writeLogHist.sample(sd_lg2);
+            stats.writeLogHist.sample(sd_lg2, samplingRatio);
     }
 }
 
@@ -66,6 +66,9 @@ class StackDistProbe : public BaseMemProbe
     // Disable the logarithmic histograms
     const bool disableLogHists;
 
+    // Track one in this many cache lines, chosen by address hash
+    const unsigned samplingRatio;
+
   protected:
     StackDistCalc calc;
 
@@ -40,6 +40,8 @@
 
 #include "mem/ruby/common/Consumer.hh"
 
+#include "base/logging.hh"
+
 namespace gem5
 {
 
@@ -62,11 +64,39 @@ Consumer::scheduleEvent(Cycles timeDelta)
 void
 Consumer::scheduleEventAbsolute(Tick evt_time)
 {
+    if (isRemote()) {
+        scheduleRemote(evt_time, [this, evt_time]
+            { scheduleEventAbsolute(evt_time); });
+        return;
+    }
+
     m_wakeup_ticks.insert(
         divCeil(evt_time, em->clockPeriod()) * em->clockPeriod());
     scheduleNextWakeup();
 }
 
+bool
+Consumer::isRemote() const
+{
+    return inParallelMode && curEventQueue() != em->eventQueue();
+}
+
+void
+Consumer::scheduleRemote(Tick when, std::function<void()> callback)
+{
+    panic_if(when < curTick() + simQuantum,
+             "Cross-partition wakeup of %s at %d does not cover the "
+             "simulation quantum (%d) from %d.\n",
+             *this, when, simQuantum, curTick());
+
+    // Posted events must be observed before the consumer wakes up
+    // in the same tick, hence the minimum priority.
+    auto *evt = new EventFunctionWrapper(std::move(callback),
+                                         "Consumer Remote Event", true,
+                                         Event::Minimum_Pri);
+    em->eventQueue()->schedule(evt, when, true);
+}
+
 void
 Consumer::scheduleNextWakeup()
 {
@@ -47,6 +47,7 @@
 #ifndef __MEM_RUBY_COMMON_CONSUMER_HH__
 #define __MEM_RUBY_COMMON_CONSUMER_HH__
 
+#include <functional>
 #include <iostream>
 #include <set>
 
@@ -87,6 +88,23 @@ class Consumer
     void scheduleEventAbsolute(Tick timeAbs);
     void scheduleEvent(Cycles timeDelta);
 
+    /**
+     * Returns true if the calling thread is not the one servicing the
+     * event queue of this consumer, i.e., the caller belongs to another
+     * partition of a parallel Ruby simulation.
+     */
+    bool isRemote() const;
+
+    /**
+     * Run a callback at tick when on the event queue of this consumer.
+     * This is how objects in other partitions hand data over to this
+     * consumer: the callback is posted through the asynchronous queue and
+     * executes on the consumer thread before any wakeup of that tick. The
+     * delay up to when is the lookahead and must cover a full simulation
+     * quantum.
+     */
+    void scheduleRemote(Tick when, std::function<void()> callback);
+
   private:
     std::set<Tick> m_wakeup_ticks;
     EventFunctionWrapper m_wakeup_event;
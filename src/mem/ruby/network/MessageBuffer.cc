@@ -43,6 +43,7 @@
 #include <cassert>
 
 #include "base/cprintf.hh"
+#include "base/intmath.hh"
 #include "base/logging.hh"
 #include "base/random.hh"
 #include "base/stl_helpers.hh"
@@ -58,7 +59,8 @@ namespace ruby
 using stl_helpers::operator<<;
 
 MessageBuffer::MessageBuffer(const Params &p)
-    : SimObject(p), m_stall_map_size(0), m_max_size(p.buffer_size),
+    : SimObject(p), m_free_stall_node(-1), m_stall_map_size(0),
+    m_max_size(p.buffer_size),
     m_max_dequeue_rate(p.max_dequeue_rate), m_dequeues_this_cy(0),
     m_time_last_time_size_checked(0),
     m_time_last_time_enqueue(0), m_time_last_time_pop(0),
@@ -277,6 +279,25 @@ MessageBuffer::enqueue(MsgPtr message, Tick current_time, Tick delta)
     msg_ptr->setLastEnqueueTime(arrival_time);
     msg_ptr->setMsgCounter(m_msg_counter);
 
+    assert(m_consumer != NULL);
+    if (m_consumer->isRemote()) {
+        // The consumer runs in another partition. Everything above only
+        // touches sender-side state; the heap belongs to the consumer
+        // thread, so hand the message over at its arrival time.
+        fatal_if(m_max_size != 0, "%s: buffers crossing Ruby partitions "
+                 "must have an infinite size.\n", name());
+        m_consumer->scheduleRemote(arrival_time,
+            [this, message, arrival_time]
+            { insertMessage(message, arrival_time); });
+        return;
+    }
+
+    insertMessage(message, arrival_time);
+}
+
+void
+MessageBuffer::insertMessage(MsgPtr message, Tick arrival_time)
+{
     // Insert the message into the priority heap
     m_prio_heap.push_back(message);
     push_heap(m_prio_heap.begin(), m_prio_heap.end(), std::greater<MsgPtr>());
@@ -290,7 +311,6 @@ MessageBuffer::enqueue(MsgPtr message, Tick current_time, Tick delta)
             arrival_time, *(message.get()));
 
     // Schedule the wakeup
-    assert(m_consumer != NULL);
     m_consumer->scheduleEventAbsolute(arrival_time);
     m_consumer->storeEventInfo(m_vnet_id);
 }
@@ -380,41 +400,67 @@ MessageBuffer::recycle(Tick current_time, Tick recycle_latency)
 }
 
 void
-MessageBuffer::reanalyzeList(std::list<MsgPtr> &lt, Tick schdTick)
+MessageBuffer::reanalyzeList(StallQueue &queue, Tick schdTick)
 {
-    while (!lt.empty()) {
-        MsgPtr m = lt.front();
-        assert(m->getLastEnqueueTime() <= schdTick);
+    for (int idx = queue.head; idx != -1; ) {
+        StallNode &node = m_stall_nodes[idx];
+        assert(node.msg->getLastEnqueueTime() <= schdTick);
 
-        m_prio_heap.push_back(m);
-        push_heap(m_prio_heap.begin(), m_prio_heap.end(),
-                  std::greater<MsgPtr>());
+        DPRINTF(RubyQueue, "Requeue arrival_time: %lld, Message: %s\n",
+            schdTick, *(node.msg.get()));
 
-        m_consumer->scheduleEventAbsolute(schdTick);
+        m_prio_heap.push_back(std::move(node.msg));
+        node.msg = nullptr;
 
-        DPRINTF(RubyQueue, "Requeue arrival_time: %lld, Message: %s\n",
-            schdTick, *(m.get()));
+        int next = node.next;
+        node.next = m_free_stall_node;
+        m_free_stall_node = idx;
+        idx = next;
+    }
+}
 
-        lt.pop_front();
+void
+MessageBuffer::reinsertMessages(size_t heap_size, Tick schdTick)
+{
+    size_t num_added = m_prio_heap.size() - heap_size;
+    if (num_added == 0)
+        return;
+
+    // Pushing the messages one at a time costs O(k log n), rebuilding the
+    // heap costs O(n). Many requestors waiting on one line make the batch
+    // large, so pick whichever is cheaper.
+    if (num_added * floorLog2(m_prio_heap.size()) > m_prio_heap.size()) {
+        std::make_heap(m_prio_heap.begin(), m_prio_heap.end(),
+                       std::greater<MsgPtr>());
+    } else {
+        for (auto it = m_prio_heap.begin() + heap_size;
+             it != m_prio_heap.end(); ++it) {
+            push_heap(m_prio_heap.begin(), it + 1, std::greater<MsgPtr>());
+        }
     }
+
+    m_consumer->scheduleEventAbsolute(schdTick);
 }
 
 void
 MessageBuffer::reanalyzeMessages(Addr addr, Tick current_time)
 {
     DPRINTF(RubyQueue, "ReanalyzeMessages %#x\n", addr);
-    assert(m_stall_msg_map.count(addr) > 0);
+    auto it = m_stall_msg_map.find(addr);
+    assert(it != m_stall_msg_map.end());
 
     //
     // Put all stalled messages associated with this address back on the
-    // prio heap.  The reanalyzeList call will make sure the consumer is
-    // scheduled for the current cycle so that the previously stalled messages
-    // will be observed before any younger messages that may arrive this cycle
+    // prio heap.  The consumer is scheduled for the current cycle so that
+    // the previously stalled messages will be observed before any younger
+    // messages that may arrive this cycle
     //
-    m_stall_map_size -= m_stall_msg_map[addr].size();
+    size_t heap_size = m_prio_heap.size();
+    m_stall_map_size -= it->second.size;
     assert(m_stall_map_size >= 0);
-    reanalyzeList(m_stall_msg_map[addr], current_time);
-    m_stall_msg_map.erase(addr);
+    reanalyzeList(it->second, current_time);
+    m_stall_msg_map.erase(it);
+    reinsertMessages(heap_size, current_time);
 }
 
 void
@@ -423,18 +469,19 @@ MessageBuffer::reanalyzeAllMessages(Tick current_time)
     DPRINTF(RubyQueue, "ReanalyzeAllMessages\n");
 
     //
-    // Put all stalled messages associated with this address back on the
-    // prio heap.  The reanalyzeList call will make sure the consumer is
-    // scheduled for the current cycle so that the previously stalled messages
-    // will be observed before any younger messages that may arrive this cycle.
+    // Put all stalled messages back on the prio heap.  The consumer is
+    // scheduled for the current cycle so that the previously stalled
+    // messages will be observed before any younger messages that may
+    // arrive this cycle.
     //
-    for (StallMsgMapType::iterator map_iter = m_stall_msg_map.begin();
-         map_iter != m_stall_msg_map.end(); ++map_iter) {
-        m_stall_map_size -= map_iter->second.size();
+    size_t heap_size = m_prio_heap.size();
+    for (auto &entry : m_stall_msg_map) {
+        m_stall_map_size -= entry.second.size;
         assert(m_stall_map_size >= 0);
-        reanalyzeList(map_iter->second, current_time);
+        reanalyzeList(entry.second, current_time);
     }
     m_stall_msg_map.clear();
+    reinsertMessages(heap_size, current_time);
 }
 
 void
@@ -449,12 +496,28 @@ MessageBuffer::stallMessage(Addr addr, Tick current_time)
     // buffer should not decrement the m_buf_msgs statistic
     dequeue(current_time, false);
 
+    int idx = m_free_stall_node;
+    if (idx == -1) {
+        idx = m_stall_nodes.size();
+        m_stall_nodes.emplace_back();
+    } else {
+        m_free_stall_node = m_stall_nodes[idx].next;
+    }
+    m_stall_nodes[idx].msg = std::move(message);
+    m_stall_nodes[idx].next = -1;
+
     //
     // Note: no event is scheduled to analyze the map at a later time.
     // Instead the controller is responsible to call reanalyzeMessages when
     // these addresses change state.
     //
-    (m_stall_msg_map[addr]).push_back(message);
+    auto res = m_stall_msg_map.try_emplace(addr, StallQueue{idx, idx, 0});
+    StallQueue &queue = res.first->second;
+    if (!res.second) {
+        m_stall_nodes[queue.tail].next = idx;
+        queue.tail = idx;
+    }
+    queue.size++;
     m_stall_map_size++;
     m_stall_count++;
 }
@@ -555,14 +618,11 @@ MessageBuffer::functionalAccess(Packet *pkt, bool is_read, WriteMask *mask)
 
     // Check the stall queue and write any messages that may
     // correspond to the address in the packet.
-    for (StallMsgMapType::iterator map_iter = m_stall_msg_map.begin();
-         map_iter != m_stall_msg_map.end();
-         ++map_iter) {
-
-        for (std::list<MsgPtr>::iterator it = (map_iter->second).begin();
-            it != (map_iter->second).end(); ++it) {
+    for (const auto &entry : m_stall_msg_map) {
+        for (int idx = entry.second.head; idx != -1;
+             idx = m_stall_nodes[idx].next) {
 
-            Message *msg = (*it).get();
+            Message *msg = m_stall_nodes[idx].msg.get();
             if (is_read && !mask && msg->functionalRead(pkt))
                 return 1;
             else if (is_read && mask && msg->functionalRead(pkt, *mask))
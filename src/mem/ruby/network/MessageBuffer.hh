@@ -193,7 +193,18 @@ class MessageBuffer : public SimObject
     int routingPriority() const { return m_routing_priority; }
 
   private:
-    void reanalyzeList(std::list<MsgPtr> &, Tick);
+    struct StallQueue;
+
+    //! Moves the messages of a stall queue to the end of the priority
+    //! heap storage and releases their nodes. The heap property has to be
+    //! restored afterwards with reinsertMessages().
+    void reanalyzeList(StallQueue &, Tick);
+    void reinsertMessages(size_t heap_size, Tick schdTick);
+
+    //! Places a message whose arrival time has already been computed in
+    //! the priority heap and wakes up the consumer. Always runs on the
+    //! consumer thread.
+    void insertMessage(MsgPtr message, Tick arrival_time);
 
     uint32_t functionalAccess(Packet *pkt, bool is_read, WriteMask *mask);
 
@@ -205,12 +216,32 @@ class MessageBuffer : public SimObject
 
     std::function<void()> m_dequeue_callback;
 
-    // use a std::map for the stalled messages as this container is
-    // sorted and ensures a well-defined iteration order
-    typedef std::map<Addr, std::list<MsgPtr> > StallMsgMapType;
+    //! A stalled message, linked to the next younger message stalled on
+    //! the same address. Nodes live in m_stall_nodes and are recycled
+    //! through a free list, so stalling does not allocate in steady state.
+    struct StallNode
+    {
+        MsgPtr msg;
+        int next;
+    };
+
+    //! FIFO of the messages stalled on one address, as indices into
+    //! m_stall_nodes.
+    struct StallQueue
+    {
+        int head;
+        int tail;
+        int size;
+    };
+
+    // The priority heap orders messages by their enqueue time and message
+    // counter, which stalling preserves. The order in which stalled
+    // messages are put back is therefore irrelevant and a hash table can
+    // be used without affecting determinism.
+    typedef std::unordered_map<Addr, StallQueue> StallMsgMapType;
 
     /**
-     * A map from line addresses to lists of stalled messages for that line.
+     * A map from line addresses to queues of stalled messages for that line.
      * If this buffer allows the receiver to stall messages, on a stall
      * request, the stalled message is removed from the m_prio_heap and placed
      * in the m_stall_msg_map. Messages are held there until the receiver
@@ -223,6 +254,9 @@ class MessageBuffer : public SimObject
      * older requests with younger ones.
      */
     StallMsgMapType m_stall_msg_map;
+    std::vector<StallNode> m_stall_nodes;
+    //! Head of the list of unused entries of m_stall_nodes, -1 if empty
+    int m_free_stall_node;
 
     /**
      * A map from line addresses to corresponding vectors of messages that
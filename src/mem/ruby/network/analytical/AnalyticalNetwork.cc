@@ -0,0 +1,402 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "mem/ruby/network/analytical/AnalyticalNetwork.hh"
+
+#include <algorithm>
+#include <cmath>
+
+#include "base/cast.hh"
+#include "base/logging.hh"
+#include "base/trace.hh"
+#include "debug/RubyNetwork.hh"
+#include "mem/ruby/network/BasicLink.hh"
+#include "mem/ruby/network/BasicRouter.hh"
+#include "mem/ruby/network/MessageBuffer.hh"
+
+namespace gem5
+{
+
+namespace ruby
+{
+
+AnalyticalNetwork::AnalyticalNetwork(const Params &p)
+    : Network(p), Consumer(this),
+      m_window(p.utilization_window),
+      m_smoothing(p.utilization_smoothing),
+      m_max_utilization(p.max_utilization),
+      networkStats(this, p.number_of_virtual_networks)
+{
+    fatal_if(m_window == 0, "%s: utilization_window must be > 0", name());
+    fatal_if(m_smoothing <= 0 || m_smoothing > 1,
+             "%s: utilization_smoothing must be in (0, 1]", name());
+    fatal_if(m_max_utilization <= 0 || m_max_utilization >= 1,
+             "%s: max_utilization must be in (0, 1)", name());
+
+    m_router_links.resize(p.routers.size());
+    m_router_latency.resize(p.routers.size());
+    for (auto *router : p.routers) {
+        auto id = static_cast<size_t>(router->params().router_id);
+        fatal_if(id >= p.routers.size(), "Router ids must be contiguous");
+        m_router_latency[id] = router->params().latency;
+    }
+
+    m_ext_in_router.resize(m_nodes, -1);
+    m_last_arrival.resize(m_nodes,
+                          std::vector<Tick>(m_virtual_networks, 0));
+}
+
+void
+AnalyticalNetwork::init()
+{
+    Network::init();
+
+    // The topology pointer should have already been initialized in
+    // the parent class network constructor.
+    assert(m_topology_ptr != NULL);
+    m_topology_ptr->createLinks(this);
+
+    // Links are tried in order of weight when routing, which is how the
+    // simple network picks among equally short paths.
+    for (auto &links : m_router_links) {
+        std::stable_sort(links.begin(), links.end(),
+            [this](int a, int b)
+            { return m_links[a].weight < m_links[b].weight; });
+    }
+}
+
+// From a switch to an endpoint node
+void
+AnalyticalNetwork::makeExtOutLink(SwitchID src, NodeID global_dest,
+                                  BasicLink* link,
+                                  std::vector<NetDest>& routing_table_entry)
+{
+    NodeID local_dest = getLocalNodeID(global_dest);
+    assert(local_dest < m_nodes);
+
+    Link l{};
+    l.latency = link->m_latency;
+    l.bandwidth = link->m_bandwidth_factor;
+    l.weight = link->m_weight;
+    l.dstRouter = -1;
+    l.routerLatency = 0;
+    l.dstNode = local_dest;
+    l.routes = routing_table_entry;
+
+    m_router_links[src].push_back(m_links.size());
+    m_links.push_back(l);
+}
+
+// From an endpoint node to a switch
+void
+AnalyticalNetwork::makeExtInLink(NodeID global_src, SwitchID dest,
+                                 BasicLink* link,
+                                 std::vector<NetDest>& routing_table_entry)
+{
+    NodeID local_src = getLocalNodeID(global_src);
+    assert(local_src < m_nodes);
+
+    // Injection into the first router is modeled like any other hop
+    Link l{};
+    l.latency = link->m_latency;
+    l.bandwidth = link->m_bandwidth_factor;
+    l.weight = link->m_weight;
+    l.dstRouter = dest;
+    l.routerLatency = m_router_latency[dest];
+    l.dstNode = local_src;
+
+    m_ext_in_router[local_src] = m_links.size();
+    m_links.push_back(l);
+
+    for (auto *buffer : m_toNetQueues[local_src]) {
+        if (buffer)
+            buffer->setConsumer(this);
+    }
+}
+
+// From a switch to a switch
+void
+AnalyticalNetwork::makeInternalLink(SwitchID src, SwitchID dest,
+                                    BasicLink* link,
+                                    std::vector<NetDest>& routing_table_entry,
+                                    PortDirection src_outport,
+                                    PortDirection dst_inport)
+{
+    Link l{};
+    l.latency = link->m_latency;
+    l.bandwidth = link->m_bandwidth_factor;
+    l.weight = link->m_weight;
+    l.dstRouter = dest;
+    l.routerLatency = m_router_latency[dest];
+    l.routes = routing_table_entry;
+
+    m_router_links[src].push_back(m_links.size());
+    m_links.push_back(l);
+}
+
+uint64_t
+AnalyticalNetwork::serialization(const Link &link, int msg_size) const
+{
+    return divCeil(msg_size, std::max<uint64_t>(link.bandwidth, 1));
+}
+
+void
+AnalyticalNetwork::updateUtilization(Link &link, uint64_t now)
+{
+    if (now < link.windowStart + m_window)
+        return;
+
+    uint64_t elapsed = (now - link.windowStart) / m_window;
+    double sample = std::min(1.0, double(link.busy) / m_window);
+    link.utilization = m_smoothing * sample +
+                       (1 - m_smoothing) * link.utilization;
+
+    // Windows without any traffic decay the estimate further
+    if (elapsed > 1)
+        link.utilization *= std::pow(1 - m_smoothing, elapsed - 1);
+
+    link.busy = 0;
+    link.windowStart += elapsed * m_window;
+}
+
+uint64_t
+AnalyticalNetwork::contention(Link &link, uint64_t service)
+{
+    updateUtilization(link, curCycle());
+
+    // Mean waiting time of an M/D/1 queue with deterministic service
+    // time equal to the serialization delay of the message
+    double rho = std::min(link.utilization, m_max_utilization);
+    return std::llround(service * rho / (2 * (1 - rho)));
+}
+
+void
+AnalyticalNetwork::route(const Message &msg, int vnet, int src_link,
+                         uint64_t latency, uint64_t queueing, int hops,
+                         std::vector<Delivery> &deliveries,
+                         std::vector<int> &used_links)
+{
+    struct Hop
+    {
+        int link;
+        NetDest destinations;
+        uint64_t latency;
+        uint64_t queueing;
+        int hops;
+    };
+
+    int msg_size = MessageSizeType_to_int(msg.getMessageSize());
+    std::vector<Hop> pending{
+        {src_link, msg.getDestination(), latency, queueing, hops}};
+
+    while (!pending.empty()) {
+        Hop hop = pending.back();
+        pending.pop_back();
+
+        Link &link = m_links[hop.link];
+        uint64_t service = serialization(link, msg_size);
+        hop.latency += link.latency + service + link.routerLatency;
+        hop.queueing += contention(link, service);
+        used_links.push_back(hop.link);
+
+        if (link.dstRouter < 0) {
+            deliveries.push_back({link.dstNode, hop.destinations,
+                                  hop.latency, hop.queueing, hop.hops});
+            continue;
+        }
+
+        // Split the destinations among the outgoing links of the router
+        NetDest remaining = hop.destinations;
+        for (int next : m_router_links[link.dstRouter]) {
+            NetDest subset = remaining.AND(m_links[next].routes[vnet]);
+            if (subset.isEmpty())
+                continue;
+
+            remaining.removeNetDest(subset);
+            pending.push_back({next, subset, hop.latency, hop.queueing,
+                               hop.hops + 1});
+            if (remaining.isEmpty())
+                break;
+        }
+
+        panic_if(!remaining.isEmpty(), "%s: no route to %s on vnet %d",
+                 name(), remaining, vnet);
+    }
+}
+
+void
+AnalyticalNetwork::injectFrom(NodeID node, int vnet, MessageBuffer *buffer)
+{
+    static thread_local std::vector<Delivery> deliveries;
+    static thread_local std::vector<int> used_links;
+
+    Tick current_time = clockEdge();
+
+    while (buffer->isReady(current_time)) {
+        MsgPtr msg_ptr = buffer->peekMsgPtr();
+        DPRINTF(RubyNetwork, "Injecting from node %d vnet %d: %s\n",
+                node, vnet, *msg_ptr);
+
+        deliveries.clear();
+        used_links.clear();
+        route(*msg_ptr, vnet, m_ext_in_router[node], 0, 0, 0,
+              deliveries, used_links);
+
+        // Check for resources in all destination buffers
+        bool enough = true;
+        for (const auto &d : deliveries) {
+            MessageBuffer *out = m_fromNetQueues[d.node][vnet];
+            if (!out->areNSlotsAvailable(1, current_time))
+                enough = false;
+        }
+
+        if (!enough) {
+            DPRINTF(RubyNetwork, "Can't deliver message since a node "
+                    "is blocked\n");
+            scheduleEvent(Cycles(1));
+            return;
+        }
+
+        // The message is accepted, account for the link occupancy
+        int msg_size = MessageSizeType_to_int(msg_ptr->getMessageSize());
+        for (int l : used_links)
+            m_links[l].busy += serialization(m_links[l], msg_size);
+
+        MsgPtr unmodified_msg_ptr;
+        if (deliveries.size() > 1)
+            unmodified_msg_ptr = msg_ptr->clone();
+
+        buffer->dequeue(current_time);
+        networkStats.packetsInjected[vnet]++;
+
+        for (int i = 0; i < deliveries.size(); i++) {
+            const Delivery &d = deliveries[i];
+            if (i > 0)
+                msg_ptr = unmodified_msg_ptr->clone();
+            msg_ptr->getDestination() = d.destinations;
+
+            MessageBuffer *out = m_fromNetQueues[d.node][vnet];
+            Tick arrival = current_time +
+                cyclesToTicks(Cycles(d.networkLatency + d.queueingLatency));
+
+            // Contention estimates change over time, so a message may be
+            // computed to arrive before an older one. Keep FIFO order on
+            // ordered buffers.
+            Tick &last_arrival = m_last_arrival[d.node][vnet];
+            if (out->getOrdered())
+                arrival = std::max(arrival, last_arrival);
+            last_arrival = arrival;
+
+            DPRINTF(RubyNetwork, "Delivering to node %d at %d after %d "
+                    "hops\n", d.node, arrival, d.hops);
+
+            out->enqueue(msg_ptr, current_time, arrival - current_time);
+
+            networkStats.packetsReceived[vnet]++;
+            networkStats.packetNetworkLatency[vnet] +=
+                cyclesToTicks(Cycles(d.networkLatency));
+            networkStats.packetQueueingLatency[vnet] +=
+                arrival - current_time -
+                cyclesToTicks(Cycles(d.networkLatency));
+            networkStats.totalHops += d.hops;
+        }
+    }
+}
+
+void
+AnalyticalNetwork::wakeup()
+{
+    for (NodeID node = 0; node < m_nodes; node++) {
+        for (int vnet = 0; vnet < m_toNetQueues[node].size(); vnet++) {
+            MessageBuffer *buffer = m_toNetQueues[node][vnet];
+            if (buffer)
+                injectFrom(node, vnet, buffer);
+        }
+    }
+}
+
+void
+AnalyticalNetwork::print(std::ostream& out) const
+{
+    out << "[AnalyticalNetwork]";
+}
+
+AnalyticalNetwork::
+NetworkStats::NetworkStats(statistics::Group *parent, int vnets)
+    : statistics::Group(parent),
+      ADD_STAT(packetsInjected, statistics::units::Count::get(),
+               "Number of packets injected"),
+      ADD_STAT(packetsReceived, statistics::units::Count::get(),
+               "Number of packets delivered to endpoints"),
+      ADD_STAT(packetNetworkLatency, statistics::units::Tick::get(),
+               "Zero-load latency of the delivered packets"),
+      ADD_STAT(packetQueueingLatency, statistics::units::Tick::get(),
+               "Estimated contention latency of the delivered packets"),
+      ADD_STAT(totalHops, statistics::units::Count::get(),
+               "Total number of router hops of the delivered packets"),
+      ADD_STAT(avgPacketNetworkLatency, statistics::units::Rate<
+                  statistics::units::Tick, statistics::units::Count>::get(),
+               "Average zero-load packet latency",
+               sum(packetNetworkLatency) / sum(packetsReceived)),
+      ADD_STAT(avgPacketQueueingLatency, statistics::units::Rate<
+                  statistics::units::Tick, statistics::units::Count>::get(),
+               "Average estimated contention latency",
+               sum(packetQueueingLatency) / sum(packetsReceived)),
+      ADD_STAT(avgPacketLatency, statistics::units::Rate<
+                  statistics::units::Tick, statistics::units::Count>::get(),
+               "Average packet latency",
+               avgPacketNetworkLatency + avgPacketQueueingLatency),
+      ADD_STAT(avgHops, statistics::units::Rate<
+                  statistics::units::Count, statistics::units::Count>::get(),
+               "Average number of hops per packet",
+               totalHops / sum(packetsReceived))
+{
+    packetsInjected
+        .init(vnets)
+        .flags(statistics::total | statistics::nozero);
+    packetsReceived
+        .init(vnets)
+        .flags(statistics::total | statistics::nozero);
+    packetNetworkLatency
+        .init(vnets)
+        .flags(statistics::nozero);
+    packetQueueingLatency
+        .init(vnets)
+        .flags(statistics::nozero);
+
+    for (int i = 0; i < vnets; i++) {
+        packetsInjected.subname(i, csprintf("vnet-%i", i));
+        packetsReceived.subname(i, csprintf("vnet-%i", i));
+        packetNetworkLatency.subname(i, csprintf("vnet-%i", i));
+        packetQueueingLatency.subname(i, csprintf("vnet-%i", i));
+    }
+}
+
+} // namespace ruby
+} // namespace gem5
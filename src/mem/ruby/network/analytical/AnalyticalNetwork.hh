@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ * A fast, analytical on-chip network model. Instead of moving messages
+ * hop by hop through routers, the latency of a message is computed when it
+ * is injected: the zero-load latency of its path (link, serialization and
+ * router delays) plus a queueing delay per link estimated from the recent
+ * utilization of that link. The message is then enqueued directly into the
+ * destination buffer, so each message costs a single event.
+ */
+
+#ifndef __MEM_RUBY_NETWORK_ANALYTICAL_ANALYTICALNETWORK_HH__
+#define __MEM_RUBY_NETWORK_ANALYTICAL_ANALYTICALNETWORK_HH__
+
+#include <iostream>
+#include <vector>
+
+#include "base/statistics.hh"
+#include "mem/ruby/common/Consumer.hh"
+#include "mem/ruby/common/NetDest.hh"
+#include "mem/ruby/network/Network.hh"
+#include "params/AnalyticalNetwork.hh"
+
+namespace gem5
+{
+
+namespace ruby
+{
+
+class AnalyticalNetwork : public Network, public Consumer
+{
+  public:
+    PARAMS(AnalyticalNetwork);
+
+    AnalyticalNetwork(const Params &p);
+    ~AnalyticalNetwork() = default;
+
+    void init() override;
+    void wakeup() override;
+
+    // Methods used by Topology to setup the network
+    void makeExtOutLink(SwitchID src, NodeID dest, BasicLink* link,
+                        std::vector<NetDest>& routing_table_entry) override;
+    void makeExtInLink(NodeID src, SwitchID dest, BasicLink* link,
+                       std::vector<NetDest>& routing_table_entry) override;
+    void makeInternalLink(SwitchID src, SwitchID dest, BasicLink* link,
+                          std::vector<NetDest>& routing_table_entry,
+                          PortDirection src_outport,
+                          PortDirection dst_inport) override;
+
+    void collateStats() override {}
+    void print(std::ostream& out) const override;
+
+    // Messages never wait inside the network: they are enqueued into the
+    // destination buffers as soon as they are injected, so there is
+    // nothing to access functionally here.
+    bool functionalRead(Packet *pkt) override { return false; }
+    bool functionalRead(Packet *pkt, WriteMask &mask) override
+    { return false; }
+    uint32_t functionalWrite(Packet *pkt) override { return 0; }
+
+  private:
+    /** Static description and utilization estimate of a link. */
+    struct Link
+    {
+        // Link latency and width in bytes per cycle
+        uint64_t latency;
+        uint64_t bandwidth;
+        int weight;
+
+        // Router reached by the link and its pipeline latency, or the
+        // endpoint node for links leaving the network
+        int dstRouter;
+        uint64_t routerLatency;
+        NodeID dstNode;
+
+        // Destinations routed through this link, for each vnet
+        std::vector<NetDest> routes;
+
+        // Smoothed utilization and cycles the link was busy in the
+        // current sampling window
+        double utilization;
+        uint64_t busy;
+        uint64_t windowStart;
+    };
+
+    /** A copy of a message heading to one endpoint. */
+    struct Delivery
+    {
+        NodeID node;
+        NetDest destinations;
+        uint64_t networkLatency;
+        uint64_t queueingLatency;
+        int hops;
+    };
+
+    /**
+     * Walks the routing tables starting from the injection link of a
+     * message, splitting multicast destinations along the way. Fills
+     * deliveries and the list of links the message occupies.
+     */
+    void route(const Message &msg, int vnet, int src_link,
+               uint64_t latency, uint64_t queueing, int hops,
+               std::vector<Delivery> &deliveries,
+               std::vector<int> &used_links);
+
+    /** Serialization delay of a message on a link, in cycles. */
+    uint64_t serialization(const Link &link, int msg_size) const;
+
+    /** Estimated queueing delay on a link, in cycles (M/D/1). */
+    uint64_t contention(Link &link, uint64_t service);
+
+    /** Rolls the sampling window of a link forward to now. */
+    void updateUtilization(Link &link, uint64_t now);
+
+    /** Inject all ready messages of a buffer. */
+    void injectFrom(NodeID node, int vnet, MessageBuffer *buffer);
+
+    std::vector<Link> m_links;
+    // Outgoing links of each router, sorted by weight, and the link
+    // each endpoint injects into
+    std::vector<std::vector<int>> m_router_links;
+    std::vector<int> m_ext_in_router;
+    std::vector<uint64_t> m_router_latency;
+
+    // Last arrival time in every destination buffer, used to preserve
+    // ordering on ordered buffers
+    std::vector<std::vector<Tick>> m_last_arrival;
+
+    const uint64_t m_window;
+    const double m_smoothing;
+    const double m_max_utilization;
+
+    struct NetworkStats : public statistics::Group
+    {
+        NetworkStats(statistics::Group *parent, int vnets);
+
+        statistics::Vector packetsInjected;
+        statistics::Vector packetsReceived;
+        statistics::Vector packetNetworkLatency;
+        statistics::Vector packetQueueingLatency;
+        statistics::Scalar totalHops;
+
+        statistics::Formula avgPacketNetworkLatency;
+        statistics::Formula avgPacketQueueingLatency;
+        statistics::Formula avgPacketLatency;
+        statistics::Formula avgHops;
+    } networkStats;
+};
+
+inline std::ostream&
+operator<<(std::ostream& out, const AnalyticalNetwork& obj)
+{
+    obj.print(out);
+    out << std::flush;
+    return out;
+}
+
+} // namespace ruby
+} // namespace gem5
+
+#endif // __MEM_RUBY_NETWORK_ANALYTICAL_ANALYTICALNETWORK_HH__
@@ -0,0 +1,58 @@
+# Copyright (c) 2024 The gem5 contributors
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+from m5.params import *
+from m5.proxy import *
+
+from m5.objects.Network import RubyNetwork
+
+
+class AnalyticalNetwork(RubyNetwork):
+    """Fast on-chip network model computing the latency of each message
+    analytically from the topology: the zero-load latency of the path plus
+    an M/D/1 queueing delay per link derived from the recent utilization
+    of that link. It uses the BasicRouter, BasicExtLink and BasicIntLink
+    objects as is. The bandwidth_factor of a link is its width in bytes
+    per cycle and the latency of a router is its pipeline depth.
+    """
+
+    type = "AnalyticalNetwork"
+    cxx_header = "mem/ruby/network/analytical/AnalyticalNetwork.hh"
+    cxx_class = "gem5::ruby::AnalyticalNetwork"
+
+    utilization_window = Param.Cycles(
+        1000, "Cycles over which link utilization is sampled"
+    )
+    utilization_smoothing = Param.Float(
+        0.5,
+        "Weight of the last window in the exponentially smoothed "
+        "utilization of a link",
+    )
+    max_utilization = Param.Float(
+        0.95,
+        "Utilization at which the contention estimate saturates. Must be "
+        "lower than 1 for the queueing delay to stay finite.",
+    )
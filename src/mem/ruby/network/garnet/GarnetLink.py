@@ -52,6 +52,9 @@ class NetworkLink(ClockedObject):
         Parent.supported_vnets, "Vnets supported"
     )
     width = Param.UInt32(Parent.width, "bit-width of the link")
+    idle_sleep = Param.Bool(
+        Parent.idle_sleep, "sleep until the next flit is ready"
+    )
 
 
 class CreditLink(NetworkLink):
@@ -35,6 +35,7 @@
 #include <iostream>
 #include <vector>
 
+#include "base/uncontended_mutex.hh"
 #include "mem/ruby/network/Network.hh"
 #include "mem/ruby/network/fault_model/FaultModel.hh"
 #include "mem/ruby/network/garnet/CommonTypes.hh"
@@ -157,6 +158,11 @@ class GarnetNetwork : public Network
     void update_traffic_distribution(RouteInfo route);
     int getNextPacketID() { return m_next_packet_id++; }
 
+    // Network-wide counters are updated by all NIs. When Ruby is
+    // partitioned across event queues, the updates are serialized
+    // through this mutex.
+    UncontendedMutex &statsMutex() { return m_stats_mutex; }
+
   protected:
     // Configuration
     int m_num_rows;
@@ -214,6 +220,7 @@ class GarnetNetwork : public Network
     std::vector<CreditLink *> m_creditlinks; // All credit links in the network
     std::vector<NetworkInterface *> m_nis;   // All NI's in Network
     int m_next_packet_id; // static vairable for packet id allocation
+    UncontendedMutex m_stats_mutex;
 };
 
 inline std::ostream&
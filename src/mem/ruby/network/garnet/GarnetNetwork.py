@@ -51,6 +51,11 @@ class GarnetNetwork(RubyNetwork):
     garnet_deadlock_threshold = Param.UInt32(
         50000, "network-level deadlock threshold"
     )
+    idle_sleep = Param.Bool(
+        True,
+        "let routers, NIs and links whose traffic is stalled sleep "
+        "instead of polling every cycle",
+    )
 
 
 class GarnetNetworkInterface(ClockedObject):
@@ -68,6 +73,9 @@ class GarnetNetworkInterface(ClockedObject):
     garnet_deadlock_threshold = Param.UInt32(
         Parent.garnet_deadlock_threshold, "network-level deadlock threshold"
     )
+    idle_sleep = Param.Bool(
+        Parent.idle_sleep, "sleep while the output VCs are stalled"
+    )
 
 
 class GarnetRouter(BasicRouter):
@@ -83,3 +91,6 @@ class GarnetRouter(BasicRouter):
     width = Param.UInt32(
         Parent.ni_flit_size, "bit width supported by the router"
     )
+    idle_sleep = Param.Bool(
+        Parent.idle_sleep, "sleep while the switch allocation is stalled"
+    )
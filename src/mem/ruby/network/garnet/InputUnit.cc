@@ -31,8 +31,11 @@
 
 #include "mem/ruby/network/garnet/InputUnit.hh"
 
+#include <algorithm>
+
 #include "debug/RubyNetwork.hh"
 #include "mem/ruby/network/garnet/Credit.hh"
+#include "mem/ruby/network/garnet/GarnetNetwork.hh"
 #include "mem/ruby/network/garnet/Router.hh"
 
 namespace gem5
@@ -56,10 +59,15 @@ InputUnit::InputUnit(int id, PortDirection direction, Router *router)
         m_num_buffer_writes[i] = 0;
     }
 
-    // Instantiating the virtual channels
+    // Instantiating the virtual channels. Their buffers never hold more
+    // flits than the upstream router has credits for, so size them for
+    // the deepest VC right away.
+    GarnetNetwork *net_ptr = m_router->get_net_ptr();
+    const int buffer_depth = std::max(net_ptr->getBuffersPerDataVC(),
+                                      net_ptr->getBuffersPerCtrlVC());
     virtualChannels.reserve(m_num_vcs);
     for (int i=0; i < m_num_vcs; i++) {
-        virtualChannels.emplace_back();
+        virtualChannels.emplace_back(buffer_depth);
     }
 }
 
@@ -34,6 +34,7 @@
 
 #include <cassert>
 #include <cmath>
+#include <mutex>
 
 #include "base/cast.hh"
 #include "debug/RubyNetwork.hh"
@@ -56,6 +57,7 @@ NetworkInterface::NetworkInterface(const Params &p)
     m_virtual_networks(p.virt_nets), m_vc_per_vnet(0),
     m_vc_allocator(m_virtual_networks, 0),
     m_deadlock_threshold(p.garnet_deadlock_threshold),
+    m_idle_sleep(p.idle_sleep),
     vc_busy_counter(m_virtual_networks, 0)
 {
     m_stall_count.resize(m_virtual_networks);
@@ -154,6 +156,7 @@ void
 NetworkInterface::incrementStats(flit *t_flit)
 {
     int vnet = t_flit->get_vnet();
+    std::lock_guard<UncontendedMutex> lock(m_net_ptr->statsMutex());
 
     // Latency
     m_net_ptr->increment_received_flits(vnet);
@@ -434,6 +437,7 @@ NetworkInterface::flitisizeMessage(MsgPtr msg_ptr, int vnet)
         // so that the first router increments it to 0
         route.hops_traversed = -1;
 
+        std::lock_guard<UncontendedMutex> lock(m_net_ptr->statsMutex());
         m_net_ptr->increment_injected_packets(vnet);
         m_net_ptr->update_traffic_distribution(route);
         int packet_id = m_net_ptr->getNextPacketID();
@@ -618,7 +622,7 @@ NetworkInterface::get_vnet(int vc)
 
 // Wakeup the NI in the next cycle if there are waiting
 // messages in the protocol buffer, or waiting flits in the
-// output VC buffer.
+// output VC buffer that can be sent.
 // Also check if we have to reschedule because of a clock period
 // difference.
 void
@@ -635,8 +639,11 @@ NetworkInterface::checkReschedule()
         }
     }
 
-    for (auto& ni_out_vc : niOutVcs) {
-        if (ni_out_vc.isReady(clockEdge(Cycles(1)))) {
+    // Flits waiting for credits do not need to be polled: the credit
+    // link wakes the NI up when the downstream router frees a slot.
+    for (int vc = 0; vc < niOutVcs.size(); vc++) {
+        if (niOutVcs[vc].isReady(clockEdge(Cycles(1))) &&
+            (!m_idle_sleep || outVcState[vc].has_credit())) {
             scheduleEvent(Cycles(1));
             return;
         }
@@ -277,6 +277,7 @@ class NetworkInterface : public ClockedObject, public Consumer
     std::vector<OutputPort *> outPorts;
     std::vector<InputPort *> inPorts;
     int m_deadlock_threshold;
+    bool m_idle_sleep;
     std::vector<OutVcState> outVcState;
 
     std::vector<int> m_stall_count;
@@ -32,6 +32,8 @@
 
 #include "mem/ruby/network/garnet/NetworkLink.hh"
 
+#include <algorithm>
+
 #include "base/trace.hh"
 #include "debug/RubyNetwork.hh"
 #include "mem/ruby/network/garnet/CreditLink.hh"
@@ -48,7 +50,8 @@ namespace garnet
 NetworkLink::NetworkLink(const Params &p)
     : ClockedObject(p), Consumer(this), m_id(p.link_id),
       m_type(NUM_LINK_TYPES_),
-      m_latency(p.link_latency), m_link_utilized(0),
+      m_latency(p.link_latency), m_idle_sleep(p.idle_sleep),
+      m_link_utilized(0),
       m_virt_nets(p.virt_nets), linkBuffer(),
       link_consumer(nullptr), link_srcQueue(nullptr)
 {
@@ -98,14 +101,34 @@ NetworkLink::wakeup()
                 (mVnets.size() == 0));
         }
         t_flit->set_time(clockEdge(m_latency));
-        linkBuffer.insert(t_flit);
-        link_consumer->scheduleEventAbsolute(clockEdge(m_latency));
+        if (link_consumer->isRemote()) {
+            // The link runs with its source. When the consumer belongs
+            // to another partition, the flit only becomes visible there
+            // once the link latency has elapsed.
+            link_consumer->scheduleRemote(clockEdge(m_latency),
+                [this, t_flit]
+                {
+                    linkBuffer.insert(t_flit);
+                    link_consumer->scheduleEventAbsolute(curTick());
+                });
+        } else {
+            linkBuffer.insert(t_flit);
+            link_consumer->scheduleEventAbsolute(clockEdge(m_latency));
+        }
         m_link_utilized++;
         m_vc_load[t_flit->get_vc()]++;
     }
 
+    // Sleep until the next flit of the source queue is ready rather
+    // than polling it every cycle.
     if (!link_srcQueue->isEmpty()) {
-        scheduleEvent(Cycles(1));
+        if (m_idle_sleep) {
+            Tick next_ready = link_srcQueue->peekTopFlit()->get_time();
+            scheduleEventAbsolute(
+                std::max(clockEdge(Cycles(1)), next_ready));
+        } else {
+            scheduleEvent(Cycles(1));
+        }
     }
 }
 
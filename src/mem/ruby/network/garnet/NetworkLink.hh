@@ -92,6 +92,7 @@ class NetworkLink : public ClockedObject, public Consumer
     const int m_id;
     link_type m_type;
     const Cycles m_latency;
+    const bool m_idle_sleep;
 
     ClockedObject *src_object;
 
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __MEM_RUBY_NETWORK_GARNET_0_OBJECTPOOL_HH__
+#define __MEM_RUBY_NETWORK_GARNET_0_OBJECTPOOL_HH__
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace gem5
+{
+
+namespace ruby
+{
+
+namespace garnet
+{
+
+/**
+ * Recycles the storage of objects of type T, which are created and
+ * destroyed at a very high rate (e.g., flits and credits). A class routes
+ * its operator new/delete through allocate()/release(). Released storage
+ * is kept in a free list and handed out again instead of going back to
+ * the heap, so no allocation happens once the number of live objects has
+ * reached its steady state.
+ *
+ * Every thread allocates from its own pool. When the network is
+ * partitioned over several event queues, objects can be released by
+ * another thread than the one that allocated them (e.g., a flit crossing
+ * partitions). Such objects are handed back to the pool they came from,
+ * so the storage of each pool is bounded by the peak number of objects
+ * its thread had live at once, no matter where they are released.
+ */
+template <class T>
+class ObjectPool
+{
+  private:
+    struct Pool;
+
+    /** Prepended to every pooled object to find its pool. */
+    struct alignas(alignof(std::max_align_t)) Header
+    {
+        Pool *owner;
+    };
+
+  public:
+    static void *
+    allocate(std::size_t size)
+    {
+        static_assert(alignof(T) <= alignof(Header),
+                      "Pooled objects must not be over-aligned");
+
+        // Classes deriving from T that do not have a pool of their own
+        // go to the heap.
+        if (size != sizeof(T))
+            return ::operator new(size);
+
+        Pool *&local_pool = localPool();
+        if (!local_pool)
+            local_pool = new Pool;
+
+        Pool &pool = *local_pool;
+        if (pool.freeList.empty())
+            pool.reclaim();
+
+        Header *header;
+        if (pool.freeList.empty()) {
+            header = static_cast<Header *>(
+                ::operator new(sizeof(Header) + sizeof(T)));
+            header->owner = &pool;
+        } else {
+            header = pool.freeList.back();
+            pool.freeList.pop_back();
+        }
+        return header + 1;
+    }
+
+    static void
+    release(void *p, std::size_t size)
+    {
+        if (size != sizeof(T)) {
+            ::operator delete(p);
+            return;
+        }
+
+        Header *header = static_cast<Header *>(p) - 1;
+        if (header->owner == localPool())
+            header->owner->freeList.push_back(header);
+        else
+            header->owner->giveBack(header);
+    }
+
+  private:
+    struct Pool
+    {
+        /** Storage ready to be reused, only touched by the owner. */
+        std::vector<Header *> freeList;
+
+        /** Storage released by other threads. */
+        std::mutex remoteMutex;
+        std::vector<Header *> remoteList;
+        std::atomic<bool> hasRemote{false};
+
+        void
+        giveBack(Header *header)
+        {
+            std::lock_guard<std::mutex> lock(remoteMutex);
+            remoteList.push_back(header);
+            hasRemote.store(true, std::memory_order_release);
+        }
+
+        /** Move the storage released by other threads to the free list. */
+        void
+        reclaim()
+        {
+            if (!hasRemote.load(std::memory_order_acquire))
+                return;
+
+            std::lock_guard<std::mutex> lock(remoteMutex);
+            freeList.swap(remoteList);
+            hasRemote.store(false, std::memory_order_relaxed);
+        }
+    };
+
+    /**
+     * The pool of the calling thread, created on its first allocation.
+     * Pools are never destroyed since their objects can outlive the
+     * thread that allocated them, and still need to be returned.
+     */
+    static Pool *&
+    localPool()
+    {
+        static thread_local Pool *pool = nullptr;
+        return pool;
+    }
+};
+
+} // namespace garnet
+} // namespace ruby
+} // namespace gem5
+
+#endif // __MEM_RUBY_NETWORK_GARNET_0_OBJECTPOOL_HH__
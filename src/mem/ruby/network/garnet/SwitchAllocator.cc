@@ -352,7 +352,12 @@ SwitchAllocator::vc_allocate(int outport, int inport, int invc)
 }
 
 // Wakeup the router next cycle to perform SA again
-// if there are flits ready.
+// if there are flits ready that can be sent.
+// Flits blocked on a free output VC or on credits are not considered:
+// both only become available when a credit arrives from downstream, and
+// the credit link wakes the router up when that happens. This way,
+// routers with stalled traffic sleep instead of re-arbitrating in vain
+// every cycle.
 void
 SwitchAllocator::check_for_wakeup()
 {
@@ -363,8 +368,12 @@ SwitchAllocator::check_for_wakeup()
     }
 
     for (int i = 0; i < m_num_inports; i++) {
+        auto input_unit = m_router->getInputUnit(i);
         for (int j = 0; j < m_num_vcs; j++) {
-            if (m_router->getInputUnit(i)->need_stage(j, SA_, nextCycle)) {
+            if (input_unit->need_stage(j, SA_, nextCycle) &&
+                (!m_router->idle_sleep() ||
+                 send_allowed(i, j, input_unit->get_outport(j),
+                              input_unit->get_outvc(j)))) {
                 m_router->schedule_wakeup(Cycles(1));
                 return;
             }
@@ -46,6 +46,12 @@ VirtualChannel::VirtualChannel()
 {
 }
 
+VirtualChannel::VirtualChannel(int buffer_depth)
+  : VirtualChannel()
+{
+    inputBuffer.reserve(buffer_depth);
+}
+
 void
 VirtualChannel::set_idle(Tick curTime)
 {
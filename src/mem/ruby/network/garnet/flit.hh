@@ -36,6 +36,7 @@
 
 #include "base/types.hh"
 #include "mem/ruby/network/garnet/CommonTypes.hh"
+#include "mem/ruby/network/garnet/ObjectPool.hh"
 #include "mem/ruby/slicc_interface/Message.hh"
 
 namespace gem5
@@ -56,6 +57,20 @@ class flit
 
     virtual ~flit(){};
 
+    // A flit is created and destroyed for every hop of every packet, so
+    // recycle their storage instead of going to the heap each time.
+    static void *
+    operator new(std::size_t size)
+    {
+        return ObjectPool<flit>::allocate(size);
+    }
+
+    static void
+    operator delete(void *p, std::size_t size)
+    {
+        ObjectPool<flit>::release(p, size);
+    }
+
     int get_outport() {return m_outport; }
     int get_size() { return m_size; }
     Tick get_enqueue_time() { return m_enqueue_time; }
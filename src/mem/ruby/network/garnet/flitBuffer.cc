@@ -41,25 +41,48 @@ namespace garnet
 {
 
 flitBuffer::flitBuffer()
+    : m_buffer(1), m_head(0), m_size(0), max_size(INFINITE_)
 {
-    max_size = INFINITE_;
 }
 
 flitBuffer::flitBuffer(int maximum_size)
+    : m_buffer(1), m_head(0), m_size(0), max_size(maximum_size)
 {
-    max_size = maximum_size;
+}
+
+void
+flitBuffer::reserve(int num_flits)
+{
+    if (num_flits > m_buffer.size())
+        grow(num_flits);
+}
+
+void
+flitBuffer::grow(int min_size)
+{
+    size_t capacity = m_buffer.size();
+    while (capacity < min_size)
+        capacity *= 2;
+
+    // Unwrap the ring so that the oldest flit ends up at index zero.
+    std::vector<flit *> buffer(capacity);
+    for (int i = 0; i < m_size; ++i)
+        buffer[i] = at(i);
+
+    m_buffer.swap(buffer);
+    m_head = 0;
 }
 
 bool
 flitBuffer::isEmpty()
 {
-    return (m_buffer.size() == 0);
+    return (m_size == 0);
 }
 
 bool
 flitBuffer::isReady(Tick curTime)
 {
-    if (m_buffer.size() != 0 ) {
+    if (m_size != 0 ) {
         flit *t_flit = peekTopFlit();
         if (t_flit->get_time() <= curTime)
             return true;
@@ -70,13 +93,13 @@ flitBuffer::isReady(Tick curTime)
 void
 flitBuffer::print(std::ostream& out) const
 {
-    out << "[flitBuffer: " << m_buffer.size() << "] " << std::endl;
+    out << "[flitBuffer: " << m_size << "] " << std::endl;
 }
 
 bool
 flitBuffer::isFull()
 {
-    return (m_buffer.size() >= max_size);
+    return (m_size >= max_size);
 }
 
 void
@@ -89,8 +112,8 @@ bool
 flitBuffer::functionalRead(Packet *pkt, WriteMask &mask)
 {
     bool read = false;
-    for (unsigned int i = 0; i < m_buffer.size(); ++i) {
-        if (m_buffer[i]->functionalRead(pkt, mask)) {
+    for (int i = 0; i < m_size; ++i) {
+        if (at(i)->functionalRead(pkt, mask)) {
             read = true;
         }
     }
@@ -103,8 +126,8 @@ flitBuffer::functionalWrite(Packet *pkt)
 {
     uint32_t num_functional_writes = 0;
 
-    for (unsigned int i = 0; i < m_buffer.size(); ++i) {
-        if (m_buffer[i]->functionalWrite(pkt)) {
+    for (int i = 0; i < m_size; ++i) {
+        if (at(i)->functionalWrite(pkt)) {
             num_functional_writes++;
         }
     }
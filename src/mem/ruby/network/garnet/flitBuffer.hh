@@ -32,6 +32,7 @@
 #define __MEM_RUBY_NETWORK_GARNET_0_FLITBUFFER_HH__
 
 #include <algorithm>
+#include <cassert>
 #include <iostream>
 #include <vector>
 
@@ -47,6 +48,12 @@ namespace ruby
 namespace garnet
 {
 
+/**
+ * FIFO of flits, kept in a power-of-two ring that only grows when it is
+ * full. Buffers with a known depth (e.g., the input VCs of a router) can
+ * reserve it upfront so that flits are never copied or allocated on the
+ * critical path.
+ */
 class flitBuffer
 {
   public:
@@ -58,33 +65,54 @@ class flitBuffer
     void print(std::ostream& out) const;
     bool isFull();
     void setMaxSize(int maximum);
-    int getSize() const { return m_buffer.size(); }
+    int getSize() const { return m_size; }
+
+    /** Make room for at least the given number of flits. */
+    void reserve(int num_flits);
 
     flit *
     getTopFlit()
     {
-        flit *f = m_buffer.front();
-        m_buffer.pop_front();
+        assert(m_size > 0);
+        flit *f = m_buffer[m_head];
+        m_head = (m_head + 1) & (m_buffer.size() - 1);
+        m_size--;
         return f;
     }
 
     flit *
     peekTopFlit()
     {
-        return m_buffer.front();
+        assert(m_size > 0);
+        return m_buffer[m_head];
     }
 
     void
     insert(flit *flt)
     {
-        m_buffer.push_back(flt);
+        if (m_size == m_buffer.size())
+            grow(m_size + 1);
+        m_buffer[(m_head + m_size) & (m_buffer.size() - 1)] = flt;
+        m_size++;
     }
 
     bool functionalRead(Packet *pkt, WriteMask &mask);
     uint32_t functionalWrite(Packet *pkt);
 
   private:
-    std::deque<flit *> m_buffer;
+    flit *
+    at(int idx) const
+    {
+        return m_buffer[(m_head + idx) & (m_buffer.size() - 1)];
+    }
+
+    /** Resize the ring to hold at least min_size flits. */
+    void grow(int min_size);
+
+    // The capacity of the ring is always a power of two.
+    std::vector<flit *> m_buffer;
+    int m_head;
+    int m_size;
     int max_size;
 };
 
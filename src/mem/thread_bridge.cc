@@ -27,6 +27,9 @@
 
 #include "mem/thread_bridge.hh"
 
+#include <algorithm>
+
+#include "base/cast.hh"
 #include "base/trace.hh"
 #include "sim/eventq.hh"
 
@@ -34,8 +37,77 @@ namespace gem5
 {
 
 ThreadBridge::ThreadBridge(const ThreadBridgeParams &p)
-    : SimObject(p), in_port_("in_port", *this), out_port_("out_port", *this)
+    : SimObject(p), in_port_("in_port", *this), out_port_("out_port", *this),
+      requestDelay(p.request_delay), responseDelay(p.response_delay)
+{
+}
+
+void
+ThreadBridge::post(EventQueue *q, Tick delay, std::function<void()> callback)
+{
+    bool remote = inParallelMode && curEventQueue() != q;
+    panic_if(remote && delay < simQuantum,
+             "%s: crossing delay %d does not cover the simulation "
+             "quantum (%d).\n", name(), delay, simQuantum);
+
+    auto *evt = new EventFunctionWrapper(std::move(callback),
+                                         name() + ".crossing", true);
+    q->schedule(evt, curTick() + delay, remote);
+}
+
+void
+ThreadBridge::arrive(PacketPtr pkt, std::deque<PacketPtr> &queue)
+{
+    std::lock_guard<std::recursive_mutex> lock(queueMutex);
+    auto it = std::find(inTransit.begin(), inTransit.end(), pkt);
+    assert(it != inTransit.end());
+    inTransit.erase(it);
+    queue.push_back(pkt);
+}
+
+void
+ThreadBridge::trySendTiming()
 {
+    std::lock_guard<std::recursive_mutex> lock(queueMutex);
+    while (!reqQueue.empty() && !waitingForReqRetry) {
+        PacketPtr pkt = reqQueue.front();
+        bool expects_response = pkt->needsResponse() &&
+                                !pkt->cacheResponding();
+        if (!out_port_.sendTimingReq(pkt)) {
+            waitingForReqRetry = true;
+            return;
+        }
+        reqQueue.pop_front();
+        if (!expects_response)
+            retire();
+    }
+}
+
+void
+ThreadBridge::trySendResp()
+{
+    std::lock_guard<std::recursive_mutex> lock(queueMutex);
+    while (!respQueue.empty() && !waitingForRespRetry) {
+        if (!in_port_.sendTimingResp(respQueue.front())) {
+            waitingForRespRetry = true;
+            return;
+        }
+        respQueue.pop_front();
+        retire();
+    }
+}
+
+void
+ThreadBridge::retire()
+{
+    if (--outstanding == 0 && drainState() == DrainState::Draining)
+        signalDrainDone();
+}
+
+DrainState
+ThreadBridge::drain()
+{
+    return outstanding == 0 ? DrainState::Drained : DrainState::Draining;
 }
 
 ThreadBridge::IncomingPort::IncomingPort(const std::string &name,
@@ -54,12 +126,25 @@ ThreadBridge::IncomingPort::getAddrRanges() const
 bool
 ThreadBridge::IncomingPort::recvTimingReq(PacketPtr pkt)
 {
-    panic("ThreadBridge only supports atomic/functional access.");
+    if (pkt->needsResponse() && !pkt->cacheResponding())
+        pkt->pushSenderState(new OriginState(curEventQueue()));
+
+    ++device_.outstanding;
+    {
+        std::lock_guard<std::recursive_mutex> lock(device_.queueMutex);
+        device_.inTransit.push_back(pkt);
+    }
+    device_.post(device_.eventQueue(), device_.requestDelay, [this, pkt] {
+        device_.arrive(pkt, device_.reqQueue);
+        device_.trySendTiming();
+    });
+    return true;
 }
 void
 ThreadBridge::IncomingPort::recvRespRetry()
 {
-    panic("ThreadBridge only supports atomic/functional access.");
+    device_.waitingForRespRetry = false;
+    device_.trySendResp();
 }
 
 // AtomicResponseProtocol
@@ -74,6 +159,24 @@ ThreadBridge::IncomingPort::recvAtomic(PacketPtr pkt)
 void
 ThreadBridge::IncomingPort::recvFunctional(PacketPtr pkt)
 {
+    // The threads on both sides may be moving packets through the
+    // bridge, including the ones still crossing in posted events
+    {
+        std::lock_guard<std::recursive_mutex> lock(device_.queueMutex);
+        for (auto *queued : device_.respQueue) {
+            if (pkt->trySatisfyFunctional(queued))
+                return;
+        }
+        for (auto *queued : device_.inTransit) {
+            if (pkt->trySatisfyFunctional(queued))
+                return;
+        }
+        for (auto *queued : device_.reqQueue) {
+            if (pkt->trySatisfyFunctional(queued))
+                return;
+        }
+    }
+
     EventQueue::ScopedMigration migrate(device_.eventQueue());
     device_.out_port_.sendFunctional(pkt);
 }
@@ -94,12 +197,25 @@ ThreadBridge::OutgoingPort::recvRangeChange()
 bool
 ThreadBridge::OutgoingPort::recvTimingResp(PacketPtr pkt)
 {
-    panic("ThreadBridge only supports atomic/functional access.");
+    auto *state = safe_cast<OriginState *>(pkt->popSenderState());
+    EventQueue *origin = state->origin;
+    delete state;
+
+    {
+        std::lock_guard<std::recursive_mutex> lock(device_.queueMutex);
+        device_.inTransit.push_back(pkt);
+    }
+    device_.post(origin, device_.responseDelay, [this, pkt] {
+        device_.arrive(pkt, device_.respQueue);
+        device_.trySendResp();
+    });
+    return true;
 }
 void
 ThreadBridge::OutgoingPort::recvReqRetry()
 {
-    panic("ThreadBridge only supports atomic/functional access.");
+    device_.waitingForReqRetry = false;
+    device_.trySendTiming();
 }
 
 Port &
@@ -28,8 +28,14 @@
 #ifndef __MEM_THREAD_BRIDGE_HH__
 #define __MEM_THREAD_BRIDGE_HH__
 
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+
 #include "mem/port.hh"
 #include "params/ThreadBridge.hh"
+#include "sim/eventq.hh"
 #include "sim/sim_object.hh"
 
 namespace gem5
@@ -43,7 +49,19 @@ class ThreadBridge : public SimObject
     Port &getPort(const std::string &if_name,
                   PortID idx = InvalidPortID) override;
 
+    DrainState drain() override;
+
   private:
+    /**
+     * Remembers the event queue a request came from so that the
+     * response can be handed back to it.
+     */
+    struct OriginState : public Packet::SenderState
+    {
+        EventQueue *origin;
+        explicit OriginState(EventQueue *q) : origin(q) {}
+    };
+
     class IncomingPort : public ResponsePort
     {
       public:
@@ -78,8 +96,68 @@ class ThreadBridge : public SimObject
         ThreadBridge &device_;
     };
 
+    /**
+     * Run a callback on the given queue after the given delay. When
+     * the queue belongs to another thread the callback is posted
+     * through the asynchronous queue, which is only safe if the delay
+     * covers the simulation quantum.
+     */
+    void post(EventQueue *q, Tick delay, std::function<void()> callback);
+
+    /** Forward queued requests, runs on the bridge's event queue. */
+    void trySendTiming();
+
+    /** Forward queued responses, runs on the requestor's event queue. */
+    void trySendResp();
+
+    /** Account for a packet leaving the bridge. */
+    void retire();
+
+    /**
+     * Move a packet that has crossed from the packets in transit to
+     * the given queue.
+     */
+    void arrive(PacketPtr pkt, std::deque<PacketPtr> &queue);
+
     IncomingPort in_port_;
     OutgoingPort out_port_;
+
+    /** Delay applied to requests crossing to the bridge's queue. */
+    const Tick requestDelay;
+
+    /** Delay applied to responses crossing back to the requestor. */
+    const Tick responseDelay;
+
+    /**
+     * Packets that have crossed and are waiting for the receiving
+     * port. They are only sent and removed by the thread on the
+     * receiving side. The sending side never observes them, so the
+     * bridge always accepts and the queues are unbounded.
+     */
+    std::deque<PacketPtr> reqQueue;
+    std::deque<PacketPtr> respQueue;
+
+    /**
+     * Packets in either direction whose crossing event has not fired
+     * yet, in the order they entered the bridge.
+     */
+    std::deque<PacketPtr> inTransit;
+
+    /**
+     * Protects the packet queues, which functional accesses search
+     * from any thread while the threads on both sides update them. It
+     * is held while a queued packet is sent so that functional
+     * accesses never look at a packet the receiver is consuming. The
+     * receiver may send a new packet into the bridge from the same
+     * call, hence the recursive mutex.
+     */
+    std::recursive_mutex queueMutex;
+
+    bool waitingForReqRetry = false;
+    bool waitingForRespRetry = false;
+
+    /** Packets anywhere inside the bridge, used for draining. */
+    std::atomic<unsigned> outstanding{0};
 };
 
 }  // namespace gem5
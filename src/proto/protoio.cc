@@ -37,16 +37,156 @@
 
 #include "proto/protoio.hh"
 
+#include <algorithm>
 #include <string>
 
 #include "base/logging.hh"
 
 using namespace google::protobuf;
 
+/**
+ * A zero-copy stream of the data that a background thread reads
+ * ahead, and decompresses if needed, from another stream. The thread
+ * fills one chunk while the previous one is being parsed.
+ */
+class ProtoInputStream::Prefetcher : public io::ZeroCopyInputStream
+{
+  private:
+
+    /// Amount of data read ahead at a time
+    static const size_t chunkSize = 1 << 20;
+
+    /// Stream to read from
+    io::ZeroCopyInputStream* source;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+
+    /// Chunk read ahead, waiting to be parsed
+    std::string ready;
+    bool hasReady = false;
+
+    /// Has the reader thread reached the end of the stream?
+    bool finished = false;
+
+    /// Is the stream being destroyed?
+    bool stopping = false;
+
+    /// Chunk being parsed, and how much of it was consumed
+    std::string current;
+    size_t pos = 0;
+    int64_t consumed = 0;
+
+    std::thread reader;
+
+    void
+    readChunks()
+    {
+        std::string chunk;
+        bool done = false;
+        while (!done) {
+            chunk.clear();
+            const void* data;
+            int size;
+            while (chunk.size() < chunkSize) {
+                if (!source->Next(&data, &size)) {
+                    done = true;
+                    break;
+                }
+                chunk.append(static_cast<const char*>(data), size);
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            cond.wait(lock, [this]() { return !hasReady || stopping; });
+            if (stopping)
+                return;
+            ready.swap(chunk);
+            hasReady = true;
+            finished = done;
+            cond.notify_all();
+        }
+    }
+
+    /**
+     * Move on to the next chunk read ahead.
+     *
+     * @return False at the end of the stream
+     */
+    bool
+    nextChunk()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            cond.wait(lock, [this]() { return hasReady || finished; });
+            if (!hasReady)
+                return false;
+            current.swap(ready);
+            hasReady = false;
+            pos = 0;
+            cond.notify_all();
+            if (!current.empty())
+                return true;
+        }
+    }
+
+  public:
+
+    Prefetcher(io::ZeroCopyInputStream* source)
+        : source(source), reader([this]() { readChunks(); })
+    {}
+
+    ~Prefetcher()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cond.notify_all();
+        reader.join();
+    }
+
+    bool
+    Next(const void** data, int* size) override
+    {
+        if (pos == current.size() && !nextChunk())
+            return false;
+        *data = current.data() + pos;
+        *size = current.size() - pos;
+        consumed += *size;
+        pos = current.size();
+        return true;
+    }
+
+    void
+    BackUp(int count) override
+    {
+        pos -= count;
+        consumed -= count;
+    }
+
+    bool
+    Skip(int count) override
+    {
+        while (count > 0) {
+            if (pos == current.size() && !nextChunk())
+                return false;
+            const size_t skipped =
+                std::min<size_t>(count, current.size() - pos);
+            pos += skipped;
+            consumed += skipped;
+            count -= skipped;
+        }
+        return true;
+    }
+
+    int64_t ByteCount() const override { return consumed; }
+};
+
 ProtoOutputStream::ProtoOutputStream(const std::string& filename) :
     fileStream(filename.c_str(),
             std::ios::out | std::ios::binary | std::ios::trunc),
-    wrappedFileStream(NULL), gzipStream(NULL), zeroCopyStream(NULL)
+    wrappedFileStream(NULL), gzipStream(NULL), zeroCopyStream(NULL),
+    hasPending(false), stopping(false)
 {
     if (!fileStream.good())
         panic("Could not open %s for writing\n", filename);
@@ -64,15 +204,30 @@ ProtoOutputStream::ProtoOutputStream(const std::string& filename) :
     }
 
     // Write the magic number to the file
-    io::CodedOutputStream codedStream(zeroCopyStream);
-    codedStream.WriteLittleEndian32(magicNumber);
+    {
+        io::CodedOutputStream codedStream(zeroCopyStream);
+        codedStream.WriteLittleEndian32(magicNumber);
+    }
 
     // Note that each type of stream (packet, instruction etc) should
     // add its own header and perform the appropriate checks
+
+    buffer.reserve(bufferSize);
+    writer = std::thread([this]() { writeBuffers(); });
 }
 
 ProtoOutputStream::~ProtoOutputStream()
 {
+    // Write out what is left before closing the streams
+    if (!buffer.empty())
+        submit();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cond.notify_all();
+    writer.join();
+
     // As the compression is optional, see if the stream exists
     if (gzipStream != NULL)
         delete gzipStream;
@@ -83,21 +238,59 @@ ProtoOutputStream::~ProtoOutputStream()
 void
 ProtoOutputStream::write(const Message& msg)
 {
-    // Due to the byte limit of the coded stream we create it for
-    // every single mesage (based on forum discussions around the size
-    // limitation)
-    io::CodedOutputStream codedStream(zeroCopyStream);
-
-    // Write the size of the message to the stream
+    // Serialise the message, preceded by its size, into the buffer
 #   if GOOGLE_PROTOBUF_VERSION < 3001000
         auto msg_size = msg.ByteSize();
 #   else
         auto msg_size = msg.ByteSizeLong();
 #   endif
-    codedStream.WriteVarint32(msg_size);
+    const size_t start = buffer.size();
+    buffer.resize(start + io::CodedOutputStream::VarintSize32(msg_size) +
+                  msg_size);
+    uint8_t* out = reinterpret_cast<uint8_t*>(&buffer[start]);
+    out = io::CodedOutputStream::WriteVarint32ToArray(msg_size, out);
+    msg.SerializeWithCachedSizesToArray(out);
+
+    if (buffer.size() >= bufferSize)
+        submit();
+}
+
+void
+ProtoOutputStream::submit()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    cond.wait(lock, [this]() { return !hasPending; });
+    buffer.swap(pending);
+    hasPending = true;
+    lock.unlock();
+    cond.notify_all();
+
+    // The writer thread left the other buffer empty
+    buffer.reserve(bufferSize);
+}
+
+void
+ProtoOutputStream::writeBuffers()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        cond.wait(lock, [this]() { return hasPending || stopping; });
+        if (!hasPending)
+            return;
+        lock.unlock();
 
-    // Write the message itself to the stream
-    msg.SerializeWithCachedSizes(&codedStream);
+        // Due to the byte limit of the coded stream we create it for
+        // every buffer
+        {
+            io::CodedOutputStream codedStream(zeroCopyStream);
+            codedStream.WriteRaw(pending.data(), pending.size());
+        }
+        pending.clear();
+
+        lock.lock();
+        hasPending = false;
+        cond.notify_all();
+    }
 }
 
 ProtoInputStream::ProtoInputStream(const std::string& filename) :
@@ -138,17 +331,25 @@ ProtoInputStream::createStreams()
         zeroCopyStream = wrappedFileStream;
     }
 
-    uint32_t magic_check;
-    io::CodedInputStream codedStream(zeroCopyStream);
-    if (!codedStream.ReadLittleEndian32(&magic_check) ||
-        magic_check != magicNumber)
-        panic("Input file %s is not a valid gem5 proto format.\n",
-              fileName);
+    {
+        uint32_t magic_check;
+        io::CodedInputStream codedStream(zeroCopyStream);
+        if (!codedStream.ReadLittleEndian32(&magic_check) ||
+            magic_check != magicNumber)
+            panic("Input file %s is not a valid gem5 proto format.\n",
+                  fileName);
+    }
+
+    // Read the messages ahead from here on
+    prefetcher.reset(new Prefetcher(zeroCopyStream));
 }
 
 void
 ProtoInputStream::destroyStreams()
 {
+    // Stop reading ahead before the streams go away
+    prefetcher.reset();
+
     // As the compression is optional, see if the stream exists
     if (gzipStream != NULL) {
         delete gzipStream;
@@ -188,7 +389,7 @@ ProtoInputStream::read(Message& msg)
     // Due to the byte limit of the coded stream we create it for
     // every single mesage (based on forum discussions around the size
     // limitation)
-    io::CodedInputStream codedStream(zeroCopyStream);
+    io::CodedInputStream codedStream(prefetcher.get());
     if (codedStream.ReadVarint32(&size)) {
         io::CodedInputStream::Limit limit = codedStream.PushLimit(size);
         if (msg.ParseFromCodedStream(&codedStream)) {
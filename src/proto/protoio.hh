@@ -49,7 +49,12 @@
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 #include <google/protobuf/message.h>
 
+#include <condition_variable>
 #include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 
 /**
  * A ProtoStream provides the shared functionality of the input and
@@ -116,6 +121,20 @@ class ProtoOutputStream : public ProtoStream
 
   private:
 
+    /// Size of the buffer handed over to the writer thread
+    static const size_t bufferSize = 1 << 20;
+
+    /**
+     * Hand the current buffer over to the writer thread, waiting for
+     * it to finish the previous one.
+     */
+    void submit();
+
+    /**
+     * Body of the writer thread, writing out submitted buffers.
+     */
+    void writeBuffers();
+
     /// Underlying file output stream
     std::ofstream fileStream;
 
@@ -128,6 +147,24 @@ class ProtoOutputStream : public ProtoStream
     /// Top-level zero-copy stream, either with compression or not
     google::protobuf::io::ZeroCopyOutputStream* zeroCopyStream;
 
+    /// Buffer the messages are serialised into
+    std::string buffer;
+
+    /// Buffer being written by the writer thread
+    std::string pending;
+
+    /// Does the pending buffer hold data to write?
+    bool hasPending;
+
+    /// Is the stream being closed?
+    bool stopping;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+
+    /// Thread compressing and writing the pending buffer
+    std::thread writer;
+
 };
 
 /**
@@ -136,6 +173,9 @@ class ProtoOutputStream : public ProtoStream
  * stream is done on a per-message basis to avoid having to deal with
  * huge data structures. The latter assumes the length of each message
  * is encoded in the stream when it is written.
+ *
+ * A background thread reads and decompresses the file ahead of the
+ * messages being parsed.
  */
 class ProtoInputStream : public ProtoStream
 {
@@ -171,6 +211,9 @@ class ProtoInputStream : public ProtoStream
 
   private:
 
+    /// Reads ahead on a background thread
+    class Prefetcher;
+
     /**
      * Create the internal streams that are wrapping the input file.
      */
@@ -199,6 +242,9 @@ class ProtoInputStream : public ProtoStream
     /// Top-level zero-copy stream, either with compression or not
     google::protobuf::io::ZeroCopyInputStream* zeroCopyStream;
 
+    /// Stream of the data read ahead from the zero-copy stream
+    std::unique_ptr<Prefetcher> prefetcher;
+
 };
 
 #endif //__PROTO_PROTOIO_HH
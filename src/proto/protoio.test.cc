@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/gzip_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "proto/packet.pb.h"
+#include "proto/protoio.hh"
+
+using namespace google::protobuf;
+
+namespace
+{
+
+/** The ASCII characters gem5, at the start of every stream */
+constexpr uint32_t magicNumber = 0x356d6567;
+
+/**
+ * Tests of the buffered streams, which write and read on background
+ * threads, against streams written and read one message at a time
+ * with the protobuf library.
+ */
+class ProtoIOTest : public testing::TestWithParam<const char *>
+{
+  protected:
+    std::filesystem::path dir;
+
+    void
+    SetUp() override
+    {
+        char tmpl[] = "/tmp/protoio_test.XXXXXX";
+        ASSERT_NE(mkdtemp(tmpl), nullptr);
+        dir = tmpl;
+    }
+
+    void TearDown() override { std::filesystem::remove_all(dir); }
+
+    /** Path of a file, with the suffix of the test parameter */
+    std::string
+    path(const std::string &name)
+    {
+        return dir / (name + GetParam());
+    }
+
+    static bool
+    isGzip(const std::string &file)
+    {
+        return std::filesystem::path(file).extension() == ".gz";
+    }
+
+    /**
+     * Messages of varying sizes, several megabytes in total so that
+     * the streams go through several buffers.
+     */
+    static std::vector<ProtoMessage::Packet>
+    makePackets()
+    {
+        std::mt19937_64 rng(1);
+        std::vector<ProtoMessage::Packet> packets(300000);
+        for (size_t i = 0; i < packets.size(); ++i) {
+            auto &pkt = packets[i];
+            pkt.set_tick(i * 500);
+            pkt.set_cmd(rng() % 4);
+            pkt.set_addr(rng() >> (rng() % 64));
+            pkt.set_size(64);
+            if (rng() % 2)
+                pkt.set_pc(rng());
+        }
+        return packets;
+    }
+
+    static void
+    writeSync(const std::string &file,
+              const std::vector<ProtoMessage::Packet> &packets)
+    {
+        std::ofstream stream(file, std::ios::out | std::ios::binary);
+        io::OstreamOutputStream wrapped(&stream);
+        // The gzip stream writes its trailer when it is destroyed
+        std::unique_ptr<io::GzipOutputStream> gzip;
+        if (isGzip(file))
+            gzip = std::make_unique<io::GzipOutputStream>(&wrapped);
+        io::ZeroCopyOutputStream *out = gzip ?
+            static_cast<io::ZeroCopyOutputStream *>(gzip.get()) : &wrapped;
+
+        io::CodedOutputStream(out).WriteLittleEndian32(magicNumber);
+        for (const auto &pkt : packets) {
+            io::CodedOutputStream coded(out);
+            coded.WriteVarint32(pkt.ByteSizeLong());
+            pkt.SerializeWithCachedSizes(&coded);
+        }
+    }
+
+    static std::vector<ProtoMessage::Packet>
+    readSync(const std::string &file)
+    {
+        std::ifstream stream(file, std::ios::in | std::ios::binary);
+        io::IstreamInputStream wrapped(&stream);
+        std::unique_ptr<io::GzipInputStream> gzip;
+        if (isGzip(file))
+            gzip = std::make_unique<io::GzipInputStream>(&wrapped);
+        io::ZeroCopyInputStream *in = gzip ?
+            static_cast<io::ZeroCopyInputStream *>(gzip.get()) : &wrapped;
+
+        std::vector<ProtoMessage::Packet> packets;
+        uint32_t magic = 0;
+        EXPECT_TRUE(io::CodedInputStream(in).ReadLittleEndian32(&magic));
+        EXPECT_EQ(magic, magicNumber);
+
+        while (true) {
+            io::CodedInputStream coded(in);
+            uint32_t size;
+            if (!coded.ReadVarint32(&size))
+                break;
+            auto limit = coded.PushLimit(size);
+            packets.emplace_back();
+            EXPECT_TRUE(packets.back().ParseFromCodedStream(&coded));
+            coded.PopLimit(limit);
+        }
+        return packets;
+    }
+
+    static void
+    expectEqual(const std::vector<ProtoMessage::Packet> &a,
+                const std::vector<ProtoMessage::Packet> &b)
+    {
+        ASSERT_EQ(a.size(), b.size());
+        for (size_t i = 0; i < a.size(); ++i) {
+            ASSERT_EQ(a[i].SerializeAsString(), b[i].SerializeAsString())
+                << "message " << i;
+        }
+    }
+};
+
+} // anonymous namespace
+
+/** Test that a buffered output stream writes what is written directly. */
+TEST_P(ProtoIOTest, WriteRoundTrip)
+{
+    const auto packets = makePackets();
+    {
+        ProtoOutputStream out(path("async"));
+        for (const auto &pkt : packets)
+            out.write(pkt);
+    }
+
+    expectEqual(readSync(path("async")), packets);
+}
+
+/**
+ * Test that a prefetching input stream reads a stream written directly,
+ * also after it has been reset.
+ */
+TEST_P(ProtoIOTest, ReadRoundTrip)
+{
+    const auto packets = makePackets();
+    writeSync(path("sync"), packets);
+
+    ProtoInputStream in(path("sync"));
+    for (int pass = 0; pass < 2; ++pass) {
+        std::vector<ProtoMessage::Packet> read;
+        ProtoMessage::Packet pkt;
+        while (in.read(pkt))
+            read.push_back(pkt);
+        expectEqual(read, packets);
+        in.reset();
+    }
+}
+
+/** Test that a stream can be reset before it is read to the end. */
+TEST_P(ProtoIOTest, ResetEarly)
+{
+    const auto packets = makePackets();
+    writeSync(path("sync"), packets);
+
+    ProtoInputStream in(path("sync"));
+    ProtoMessage::Packet pkt;
+    for (int i = 0; i < 1000; ++i)
+        ASSERT_TRUE(in.read(pkt));
+    in.reset();
+    ASSERT_TRUE(in.read(pkt));
+    ASSERT_EQ(pkt.SerializeAsString(), packets[0].SerializeAsString());
+}
+
+INSTANTIATE_TEST_SUITE_P(Compression, ProtoIOTest,
+                         testing::Values("", ".gz"));
@@ -25,7 +25,7 @@
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 from abc import ABCMeta, abstractmethod
-from typing import Tuple, Sequence, List
+from typing import Tuple, Sequence, List, Optional
 
 
 from ..boards.abstract_board import AbstractBoard
@@ -72,6 +72,18 @@ class AbstractMemorySystem(SubSystem):
         """
         raise NotImplementedError
 
+    def get_lookahead(self) -> Optional[int]:
+        """Get the minimum latency, in ticks, of any crossing between this
+        memory system and another event queue.
+
+        Memory systems that place their controllers on event queues of
+        their own return the value the simulation quantum must not exceed.
+        The global frequency must be fixed before this is called. By
+        default the memory shares the board's event queue and None is
+        returned.
+        """
+        return None
+
     def _post_instantiate(self) -> None:
         """Called to set up anything needed after m5.instantiate"""
         pass
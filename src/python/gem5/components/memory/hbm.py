@@ -52,6 +52,7 @@ class HighBandwidthMemory(ChanneledMemory):
         interleaving_size: Union[int, str],
         size: Optional[str] = None,
         addr_mapping: Optional[str] = None,
+        parallel_channels: bool = False,
     ) -> None:
         """
         :param dram_interface_class: The DRAM interface type to create with
@@ -66,6 +67,9 @@ class HighBandwidthMemory(ChanneledMemory):
         :param interleaving_size: Defines the interleaving size of the multi-
             channel memory system. By default, it is equivalent to the atom
             size, i.e., 64.
+        :param parallel_channels: If True, each channel is simulated on an
+            event queue of its own. Timing under load differs slightly from
+            the serial configuration, see ChanneledMemory.
         """
         super().__init__(
             dram_interface_class,
@@ -73,6 +77,7 @@ class HighBandwidthMemory(ChanneledMemory):
             interleaving_size,
             size,
             addr_mapping,
+            parallel_channels,
         )
 
         _num_channels = _try_convert(num_channels, int)
@@ -154,11 +159,19 @@ class HighBandwidthMemory(ChanneledMemory):
                 )
             )
         return [
-            (addr_ranges[i], ctrl.port) for i, ctrl in enumerate(self.mem_ctrl)
+            (addr_ranges[i], self._get_channel_port(i))
+            for i in range(len(self.mem_ctrl))
         ]
 
 
 def HBM2Stack(
     size: Optional[str] = "4GiB",
+    parallel_channels: bool = False,
 ) -> AbstractMemorySystem:
-    return HighBandwidthMemory(HBM_2000_4H_1x64, 8, 128, size=size)
+    return HighBandwidthMemory(
+        HBM_2000_4H_1x64,
+        8,
+        128,
+        size=size,
+        parallel_channels=parallel_channels,
+    )
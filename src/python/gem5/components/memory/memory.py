@@ -32,7 +32,13 @@ from ...utils.override import overrides
 from m5.util.convert import toMemorySize
 from ..boards.abstract_board import AbstractBoard
 from .abstract_memory_system import AbstractMemorySystem
-from m5.objects import AddrRange, DRAMInterface, MemCtrl, Port
+from m5.objects import (
+    AddrRange,
+    DRAMInterface,
+    MemCtrl,
+    Port,
+    ThreadBridge,
+)
 from typing import Type, Sequence, Tuple, List, Optional, Union
 
 
@@ -65,6 +71,7 @@ class ChanneledMemory(AbstractMemorySystem):
         interleaving_size: Union[int, str],
         size: Optional[str] = None,
         addr_mapping: Optional[str] = None,
+        parallel_channels: bool = False,
     ) -> None:
         """
         :param dram_interface_class: The DRAM interface type to create with
@@ -79,6 +86,17 @@ class ChanneledMemory(AbstractMemorySystem):
         :param interleaving_size: Defines the interleaving size of the multi-
             channel memory system. By default, it is equivalent to the atom
             size, i.e., 64.
+        :param parallel_channels: If True, each channel's controller and
+            interface are placed on an event queue of their own so that the
+            channels are simulated on separate host threads. The channels
+            are reached through a ThreadBridge which takes over the static
+            frontend and backend latencies of the controller, and the
+            shorter of the two bounds the simulation quantum. The unloaded
+            latency is unchanged, but requests now enter the controller's
+            queues after the frontend latency rather than on arrival, so
+            queue occupancy, retries and scheduling decisions under load,
+            and therefore the stats, differ slightly from the serial
+            configuration.
         """
         num_channels = _try_convert(num_channels, int)
         interleaving_size = _try_convert(interleaving_size, int)
@@ -92,6 +110,7 @@ class ChanneledMemory(AbstractMemorySystem):
         super().__init__()
         self._dram_class = dram_interface_class
         self._num_channels = num_channels
+        self._parallel_channels = parallel_channels
 
         if not _isPow2(interleaving_size):
             raise ValueError("Memory interleaving size should be a power of 2")
@@ -109,6 +128,11 @@ class ChanneledMemory(AbstractMemorySystem):
 
         self._create_mem_interfaces_controller()
 
+        # Subclasses only create their controllers, the bridges in front of
+        # them are created once here
+        if self._parallel_channels:
+            self._create_channel_bridges()
+
     def _create_mem_interfaces_controller(self):
         self._dram = [
             self._dram_class(addr_mapping=self._addr_mapping)
@@ -119,6 +143,30 @@ class ChanneledMemory(AbstractMemorySystem):
             MemCtrl(dram=self._dram[i]) for i in range(self._num_channels)
         ]
 
+    def _create_channel_bridges(self):
+        # Event queue 0 is left to the rest of the system. The controller
+        # pipeline latencies move to the bridge so that the end-to-end
+        # latency of an unloaded access is unchanged while giving the
+        # crossing its lookahead. Requests reach the queues later though, so
+        # timing under load is only approximately the same.
+        self.bridge = []
+        for i, ctrl in enumerate(self.mem_ctrl):
+            ctrl.eventq_index = i + 1
+            bridge = ThreadBridge(
+                eventq_index=i + 1,
+                request_delay=ctrl.static_frontend_latency,
+                response_delay=ctrl.static_backend_latency,
+            )
+            ctrl.static_frontend_latency = "0ns"
+            ctrl.static_backend_latency = "0ns"
+            bridge.out_port = ctrl.port
+            self.bridge.append(bridge)
+
+    def _get_channel_port(self, channel: int) -> Port:
+        if self._parallel_channels:
+            return self.bridge[channel].in_port
+        return self.mem_ctrl[channel].port
+
     def _get_dram_size(self, num_channels: int, dram: DRAMInterface) -> int:
         return num_channels * (
             dram.device_size.value
@@ -164,12 +212,27 @@ class ChanneledMemory(AbstractMemorySystem):
 
     @overrides(AbstractMemorySystem)
     def get_mem_ports(self) -> Sequence[Tuple[AddrRange, Port]]:
-        return [(ctrl.dram.range, ctrl.port) for ctrl in self.mem_ctrl]
+        return [
+            (ctrl.dram.range, self._get_channel_port(i))
+            for i, ctrl in enumerate(self.mem_ctrl)
+        ]
 
     @overrides(AbstractMemorySystem)
     def get_memory_controllers(self) -> List[MemCtrl]:
         return [ctrl for ctrl in self.mem_ctrl]
 
+    @overrides(AbstractMemorySystem)
+    def get_lookahead(self) -> Optional[int]:
+        if not self._parallel_channels:
+            return None
+        return min(
+            min(
+                bridge.request_delay.getValue(),
+                bridge.response_delay.getValue(),
+            )
+            for bridge in self.bridge
+        )
+
     @overrides(AbstractMemorySystem)
     def get_size(self) -> int:
         return self._size
@@ -36,32 +36,60 @@ from .dram_interfaces.hbm import HBM_1000_4H_1x64
 
 def DualChannelDDR3_1600(
     size: Optional[str] = None,
+    parallel_channels: bool = False,
 ) -> AbstractMemorySystem:
     """
     A dual channel memory system using DDR3_1600_8x8 based DIMM
     """
-    return ChanneledMemory(DDR3_1600_8x8, 2, 64, size=size)
+    return ChanneledMemory(
+        DDR3_1600_8x8,
+        2,
+        64,
+        size=size,
+        parallel_channels=parallel_channels,
+    )
 
 
 def DualChannelDDR3_2133(
     size: Optional[str] = None,
+    parallel_channels: bool = False,
 ) -> AbstractMemorySystem:
     """
     A dual channel memory system using DDR3_2133_8x8 based DIMM
     """
-    return ChanneledMemory(DDR3_2133_8x8, 2, 64, size=size)
+    return ChanneledMemory(
+        DDR3_2133_8x8,
+        2,
+        64,
+        size=size,
+        parallel_channels=parallel_channels,
+    )
 
 
 def DualChannelDDR4_2400(
     size: Optional[str] = None,
+    parallel_channels: bool = False,
 ) -> AbstractMemorySystem:
     """
     A dual channel memory system using DDR4_2400_8x8 based DIMM
     """
-    return ChanneledMemory(DDR4_2400_8x8, 2, 64, size=size)
+    return ChanneledMemory(
+        DDR4_2400_8x8,
+        2,
+        64,
+        size=size,
+        parallel_channels=parallel_channels,
+    )
 
 
 def DualChannelLPDDR3_1600(
     size: Optional[str] = None,
+    parallel_channels: bool = False,
 ) -> AbstractMemorySystem:
-    return ChanneledMemory(LPDDR3_1600_1x32, 2, 64, size=size)
+    return ChanneledMemory(
+        LPDDR3_1600_1x32,
+        2,
+        64,
+        size=size,
+        parallel_channels=parallel_channels,
+    )
@@ -410,6 +410,15 @@ class Simulator:
                 m5.ticks.fixGlobalFrequency()
                 root.sim_quantum = m5.ticks.fromSeconds(0.001)
 
+            # A memory system simulated on event queues of its own bounds
+            # the quantum by the latency of its crossings.
+            m5.ticks.fixGlobalFrequency()
+            lookahead = self._board.get_memory().get_lookahead()
+            if lookahead is not None:
+                if int(root.sim_quantum):
+                    lookahead = min(lookahead, int(root.sim_quantum))
+                root.sim_quantum = lookahead
+
             # m5.instantiate() takes a parameter specifying the path to the
             # checkpoint directory. If the parameter is None, no checkpoint
             # will be restored.
@@ -282,6 +282,24 @@ def parse_options():
         help="Sets the output file for debug. Append '.gz' to the name for it"
         " to be compressed automatically [Default: %default]",
     )
+    option(
+        "--debug-format",
+        metavar="{text,binary}",
+        choices=["text", "binary"],
+        default="text",
+        help="Format of the debug output. Binary traces are much faster to"
+        " write, go to --debug-file (or debug.trace) and are rendered to"
+        " text with the tracedecode tool [Default: %default]",
+    )
+    option(
+        "--debug-flight-recorder",
+        metavar="MB",
+        type="int",
+        default=0,
+        help="Keep the last MB megabytes of debug output of every thread in"
+        " memory and write them as a binary trace to --debug-file (or"
+        " debug-flight.trace) on exit, panic, fatal or a crash",
+    )
     option(
         "--debug-activate",
         metavar="EXPR[,EXPR]",
@@ -370,7 +388,7 @@ def main():
     from . import stats
     from . import trace
 
-    from .util import inform, panic, isInteractive
+    from .util import fatal, inform, panic, isInteractive
     from m5.util.terminal_formatter import TerminalFormatter
 
     options, arguments = parse_options()
@@ -583,7 +601,32 @@ def main():
         e = event.create(trace.disable, event.Event.Debug_Enable_Pri)
         event.mainq.schedule(e, options.debug_end)
 
-    trace.output(options.debug_file)
+    binary_trace = (
+        options.debug_flight_recorder or options.debug_format == "binary"
+    )
+    if binary_trace and options.debug_file.endswith(".gz"):
+        # tracedecode reads binary traces as they were written
+        fatal(
+            "Binary debug traces can't be compressed, use a --debug-file "
+            "name without '.gz'"
+        )
+
+    if options.debug_flight_recorder:
+        trace.flightRecorder(
+            options.debug_file
+            if options.debug_file != "cout"
+            else "debug-flight.trace",
+            options.debug_flight_recorder << 20,
+        )
+    elif options.debug_format == "binary":
+        # Binary records would be mixed with the simulator's output
+        trace.binaryOutput(
+            options.debug_file
+            if options.debug_file != "cout"
+            else "debug.trace"
+        )
+    else:
+        trace.output(options.debug_file)
 
     for activate in options.debug_activate:
         _check_tracing()
@@ -130,23 +130,29 @@ def _url_factory(schemes, enable=True):
 
 
 @_url_factory([None, "", "text", "file"])
-def _textFactory(fn, desc=True, spaces=True):
+def _textFactory(fn, desc=True, spaces=True, changed=False):
     """Output stats in text format.
 
     Text stat files contain one stat per line with an optional
     description. The description is enabled by default, but can be
     disabled by setting the desc parameter to False.
 
+    With changed=True, only stats that changed since the previous dump
+    are output. This keeps periodic dumps of large, mostly idle systems
+    small. Stats that don't track updates (e.g., Value stats and
+    formulas that depend on them) are always output.
+
     Parameters:
       * desc (bool): Output stat descriptions (default: True)
       * spaces (bool): Output alignment spaces (default: True)
+      * changed (bool): Only output changed stats (default: False)
 
     Example:
       text://stats.txt?desc=False;spaces=False
 
     """
 
-    return _m5.stats.initText(fn, desc, spaces)
+    return _m5.stats.initText(fn, desc, spaces, changed)
 
 
 @_url_factory(["h5"], enable=hasattr(_m5.stats, "initHDF5"))
@@ -186,6 +192,73 @@ def _hdf5Factory(fn, chunking=10, desc=True, formulas=True):
     return _m5.stats.initHDF5(fn, chunking, desc, formulas)
 
 
+@_url_factory(["col"])
+def _columnarFactory(fn, formulas=True, compression=0):
+    """Output stats in a binary, columnar format.
+
+    Columnar stat files are designed for frequent periodic dumps. The
+    names of all stats are written once, and each dump appends a row
+    with the current tick and the value of every stat. Dumps are much
+    cheaper than text dumps since no values are formatted.
+
+    Distributions are stored as their samples, sum, squares, min/max
+    values, underflows, overflows and buckets. Sparse histograms are
+    unsupported.
+
+    Files can be read with m5.stats.columnar.ColumnarReader.
+
+    Parameters:
+      * formulas (bool): Output derived stats (default: True)
+      * compression (int): zstd compression level, 0 to disable
+                           (default: 0)
+
+    Example:
+      col://stats.col?compression=3
+
+    """
+
+    return _m5.stats.initColumnar(fn, formulas, compression)
+
+
+@_url_factory(["stream"])
+def _streamFactory(fn, period="1ms", filter="", formulas=True, compression=0):
+    """Publish stats over a Unix domain socket for live monitoring.
+
+    The output listens on a socket and sends the records of a columnar
+    stat file to every client that connects: the header and the
+    current schema, followed by one row per sample. Stats are sampled
+    periodically while the simulation runs as well as on every stat
+    dump. Samples don't reset the stats.
+
+    Clients that don't keep up are disconnected rather than stalling
+    the simulation. Streams can be read with
+    m5.stats.columnar.ColumnarReader.connect().
+
+    Parameters:
+      * period (str|float): Sampling period in simulated time, either
+                            as a latency string or in seconds, 0 to
+                            only publish stat dumps (default: "1ms")
+      * filter (str): Only publish stats whose name matches this
+                      regular expression (default: all stats)
+      * formulas (bool): Publish derived stats (default: True)
+      * compression (int): zstd compression level, 0 to disable
+                           (default: 0)
+
+    Example:
+      stream:///tmp/gem5.sock?period="100us"&filter="\.ipc$"
+
+    """
+
+    from m5.util.convert import toLatency
+
+    if isinstance(period, str):
+        period = toLatency(period)
+
+    return _m5.stats.initStream(
+        fn, float(period), filter, formulas, compression
+    )
+
+
 @_url_factory(["json"])
 def _jsonFactory(fn):
     """Output stats in JSON format.
@@ -349,7 +422,9 @@ def prepare():
         stat.prepare()
 
     # New stats
-    _visit_stats(lambda g, s: s.prepare())
+    root = Root.getInstance()
+    if root:
+        root.prepareStats()
 
 
 def _dump_to_visitor(visitor, roots=None):
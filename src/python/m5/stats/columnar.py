@@ -0,0 +1,279 @@
+# Copyright (c) 2024 The gem5 contributors
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+"""Reader for columnar stat files.
+
+Columnar stat files are written by the ``col://`` stat output (see
+``m5.stats.addStatVisitor``). This module only depends on the Python
+standard library, and optionally on the ``zstandard`` package for
+compressed files, so it can also be used outside of gem5:
+
+    python3 columnar.py m5out/stats.col system.cpu.numCycles
+
+Example:
+
+    reader = ColumnarReader("m5out/stats.col")
+    for tick, values in reader.rows():
+        print(tick, values["system.cpu.ipc"])
+
+    ticks, ipc = reader.column("system.cpu.ipc")
+
+Live stats published by the ``stream://`` stat output are read the
+same way, rows are returned as they arrive:
+
+    reader = ColumnarReader.connect("/tmp/gem5.sock")
+    for tick, values in reader.rows():
+        print(tick, values["system.cpu.ipc"])
+"""
+
+import socket
+import struct
+import sys
+from array import array
+from typing import (
+    BinaryIO,
+    Dict,
+    Iterator,
+    List,
+    Optional,
+    Tuple,
+)
+
+MAGIC = b"gem5col\0"
+VERSION = 1
+
+SCHEMA = 1
+ROW = 2
+COMPRESSED = 0x100
+
+
+class ColumnarReader:
+    """Streaming reader for a columnar stat file.
+
+    Rows are read lazily, so files that are still being written by a
+    running simulation can be read. Every row is returned together
+    with the schema (list of column names) that was current when it
+    was written.
+    """
+
+    def __init__(self, path: str):
+        self._path = path
+        self._decompressor = None
+        self._stream = None
+        with open(path, "rb") as f:
+            self._endian = self._read_header(f)
+            self._data_offset = f.tell()
+
+    @classmethod
+    def connect(cls, path: str) -> "ColumnarReader":
+        """Read the stats published on a Unix domain socket.
+
+        The returned reader blocks until new rows arrive and can only
+        be iterated over once.
+        """
+
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        sock.connect(path)
+
+        reader = cls.__new__(cls)
+        reader._path = path
+        reader._decompressor = None
+        reader._stream = sock.makefile("rb")
+        sock.close()
+        reader._endian = reader._read_header(reader._stream)
+        reader._data_offset = 0
+        return reader
+
+    def _read_header(self, f: BinaryIO) -> str:
+        header = f.read(len(MAGIC) + 8)
+        if len(header) < len(MAGIC) + 8 or header[: len(MAGIC)] != MAGIC:
+            raise ValueError(f"{self._path} is not a columnar stat file")
+
+        bom = header[len(MAGIC) + 4 :]
+        if struct.unpack("<I", bom)[0] == 0x01020304:
+            endian = "<"
+        elif struct.unpack(">I", bom)[0] == 0x01020304:
+            endian = ">"
+        else:
+            raise ValueError(f"{self._path}: invalid byte order mark")
+
+        (version,) = struct.unpack(
+            endian + "I", header[len(MAGIC) : len(MAGIC) + 4]
+        )
+        if version != VERSION:
+            raise ValueError(
+                f"{self._path}: unsupported version {version}"
+            )
+
+        return endian
+
+    def _decompress(self, data: bytes, raw_size: int) -> bytes:
+        if self._decompressor is None:
+            try:
+                import zstandard
+            except ImportError:
+                raise RuntimeError(
+                    f"{self._path} is compressed, the zstandard Python "
+                    "package is required to read it"
+                )
+            self._decompressor = zstandard.ZstdDecompressor()
+
+        return self._decompressor.decompress(data, max_output_size=raw_size)
+
+    def _records(self) -> Iterator[Tuple[int, bytes]]:
+        if self._stream is not None:
+            yield from self._read_records(self._stream)
+            return
+
+        with open(self._path, "rb") as f:
+            f.seek(self._data_offset)
+            yield from self._read_records(f)
+
+    def _read_records(self, f: BinaryIO) -> Iterator[Tuple[int, bytes]]:
+        record = struct.Struct(self._endian + "III")
+        while True:
+            header = f.read(record.size)
+            if len(header) < record.size:
+                return
+
+            kind, size, raw_size = record.unpack(header)
+            payload = f.read(size)
+            if len(payload) < size:
+                # Partially written record at the end of a file that
+                # is still being written, or a closed stream.
+                return
+
+            if kind & COMPRESSED:
+                payload = self._decompress(payload, raw_size)
+                kind &= ~COMPRESSED
+
+            yield kind, payload
+
+    def _parse_schema(self, payload: bytes) -> List[str]:
+        (count,) = struct.unpack_from(self._endian + "I", payload)
+        offset = 4
+        names = []
+        for _ in range(count):
+            (length,) = struct.unpack_from(self._endian + "I", payload, offset)
+            offset += 4
+            names.append(payload[offset : offset + length].decode())
+            offset += length
+
+        return names
+
+    def _parse_row(self, payload: bytes) -> Tuple[int, array]:
+        (tick,) = struct.unpack_from(self._endian + "Q", payload)
+        values = array("d")
+        values.frombytes(payload[8:])
+        if self._endian != ("<" if sys.byteorder == "little" else ">"):
+            values.byteswap()
+
+        return tick, values
+
+    def raw_rows(self) -> Iterator[Tuple[List[str], int, array]]:
+        """Iterate over (columns, tick, values) for every dump.
+
+        The columns list is shared between all rows that use the same
+        schema, and values is an array of doubles in column order.
+        """
+
+        columns = []
+        for kind, payload in self._records():
+            if kind == SCHEMA:
+                columns = self._parse_schema(payload)
+            elif kind == ROW:
+                tick, values = self._parse_row(payload)
+                if len(values) != len(columns):
+                    raise ValueError(
+                        f"{self._path}: row at tick {tick} doesn't match "
+                        "the schema"
+                    )
+                yield columns, tick, values
+
+    def rows(self) -> Iterator[Tuple[int, Dict[str, float]]]:
+        """Iterate over (tick, {name: value}) for every dump."""
+
+        for columns, tick, values in self.raw_rows():
+            yield tick, dict(zip(columns, values))
+
+    def columns(self) -> List[str]:
+        """Names of all columns that appear in the file."""
+
+        seen = {}
+        for kind, payload in self._records():
+            if kind == SCHEMA:
+                seen.update(dict.fromkeys(self._parse_schema(payload)))
+
+        return list(seen)
+
+    def column(self, name: str) -> Tuple[List[int], List[float]]:
+        """Time series of a single column.
+
+        Dumps that don't include the column are skipped.
+
+        :returns: A tuple of ticks and values.
+        """
+
+        ticks = []
+        values = []
+        index: Optional[int] = None
+        schema = None
+        for columns, tick, row in self.raw_rows():
+            if columns is not schema:
+                schema = columns
+                try:
+                    index = columns.index(name)
+                except ValueError:
+                    index = None
+            if index is not None:
+                ticks.append(tick)
+                values.append(row[index])
+
+        return ticks, values
+
+
+def _main(argv: List[str]) -> int:
+    if len(argv) < 2:
+        print(f"Usage: {argv[0]} FILE [COLUMN...]", file=sys.stderr)
+        return 1
+
+    reader = ColumnarReader(argv[1])
+    if len(argv) == 2:
+        for name in reader.columns():
+            print(name)
+        return 0
+
+    for tick, values in reader.rows():
+        print(
+            tick,
+            *(repr(values.get(name, float("nan"))) for name in argv[2:]),
+        )
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(_main(sys.argv))
@@ -25,4 +25,12 @@
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 # Export native methods to Python
-from _m5.trace import output, activate, ignore, disable, enable
+from _m5.trace import (
+    activate,
+    binaryOutput,
+    disable,
+    enable,
+    flightRecorder,
+    ignore,
+    output,
+)
@@ -45,8 +45,10 @@
 #include <map>
 #include <vector>
 
+#include "base/binary_trace.hh"
 #include "base/compiler.hh"
 #include "base/debug.hh"
+#include "base/flight_recorder.hh"
 #include "base/output.hh"
 #include "base/trace.hh"
 #include "sim/debug.hh"
@@ -67,6 +69,25 @@ output(const char *filename)
     trace::setDebugLogger(new trace::OstreamLogger(*file_stream->stream()));
 }
 
+static void
+binaryOutput(const char *filename)
+{
+    OutputStream *file_stream = simout.find(filename);
+
+    if (!file_stream)
+        file_stream = simout.create(filename, true, true);
+
+    // The logger flushes itself on exit and when gem5 crashes.
+    trace::setDebugLogger(new trace::BinaryLogger(*file_stream->stream()));
+}
+
+static void
+flightRecorder(const char *filename, size_t buffer_size)
+{
+    trace::setDebugLogger(new trace::FlightRecorder(
+                simout.resolve(filename), buffer_size));
+}
+
 static void
 activate(const char *expr)
 {
@@ -129,6 +150,8 @@ pybind_init_debug(py::module_ &m_native)
     py::module_ m_trace = m_native.def_submodule("trace");
     m_trace
         .def("output", &output)
+        .def("binaryOutput", &binaryOutput)
+        .def("flightRecorder", &flightRecorder)
         .def("activate", &activate)
         .def("ignore", &ignore)
         .def("enable", &trace::enable)
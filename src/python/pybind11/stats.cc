@@ -42,6 +42,7 @@
 #include "pybind11/stl.h"
 
 #include "base/statistics.hh"
+#include "base/stats/columnar.hh"
 #include "base/stats/text.hh"
 #include "config/have_hdf5.hh"
 
@@ -51,6 +52,7 @@
 #endif
 #include "sim/stat_control.hh"
 #include "sim/stat_register.hh"
+#include "sim/stat_stream.hh"
 
 namespace py = pybind11;
 
@@ -111,6 +113,8 @@ pybind_init_stats(py::module_ &m_native)
         .def("initSimStats", &statistics::initSimStats)
         .def("initText", &statistics::initText,
             py::return_value_policy::reference)
+        .def("initColumnar", &statistics::initColumnar)
+        .def("initStream", &statistics::initStream)
 #if HAVE_HDF5
         .def("initHDF5", &statistics::initHDF5)
 #endif
@@ -151,6 +155,7 @@ pybind_init_stats(py::module_ &m_native)
         .def("prepare", &statistics::Info::prepare)
         .def("reset", &statistics::Info::reset)
         .def("zero", &statistics::Info::zero)
+        .def("changed", &statistics::Info::changed)
         .def("visit", &statistics::Info::visit)
         ;
 
@@ -221,6 +226,7 @@ pybind_init_stats(py::module_ &m_native)
         .def("regStats", &statistics::Group::regStats)
         .def("resetStats", &statistics::Group::resetStats)
         .def("preDumpStats", &statistics::Group::preDumpStats)
+        .def("prepareStats", &statistics::Group::prepareStats)
         .def("getStats", [](const statistics::Group &self)
              -> std::vector<py::object> {
 
@@ -105,6 +105,42 @@ class System(SimObject):
         "shared_backstore is non-empty.",
     )
 
+    # Memory is checkpointed in chunks that are compressed and
+    # restored by several threads. Disable this to write checkpoints
+    # that older versions of gem5 can read. Builds without zstd can't
+    # compress chunks and write compressed checkpoints in the older
+    # gzip format, unless they are incremental.
+    memory_checkpoint_chunked = Param.Bool(
+        True, "Checkpoint memory as chunks that are written in parallel"
+    )
+    memory_checkpoint_threads = Param.Unsigned(
+        0,
+        "Threads used to write and restore memory checkpoints, "
+        "0 to use one per host core",
+    )
+    memory_checkpoint_compression = Param.Int(
+        1,
+        "zstd compression level of memory checkpoints, 0 to store "
+        "the chunks uncompressed",
+    )
+    # Incremental checkpoints only store the memory chunks that changed
+    # since the previous checkpoint taken or restored by this
+    # simulation, and refer to that checkpoint for the others. Restoring
+    # them requires all the checkpoints of the chain.
+    memory_checkpoint_incremental = Param.Bool(
+        False,
+        "Only store memory that changed since the previous checkpoint "
+        "(requires memory_checkpoint_chunked)",
+    )
+    # Chunks are left to the previous checkpoint when their hashes
+    # match. Verifying them reads the chunks back from that checkpoint,
+    # which costs about as much as storing them.
+    memory_checkpoint_verify = Param.Bool(
+        False,
+        "Compare the chunks of incremental checkpoints with the previous "
+        "checkpoint byte by byte rather than trusting their hashes",
+    )
+
     cache_line_size = Param.Unsigned(64, "Cache line size in bytes")
 
     redirect_paths = VectorParam.RedirectPath([], "Path redirections")
@@ -54,7 +54,9 @@
 #endif
 
 #include "base/atomicio.hh"
+#include "base/binary_trace.hh"
 #include "base/cprintf.hh"
+#include "base/flight_recorder.hh"
 #include "base/logging.hh"
 #include "sim/async.hh"
 #include "sim/backtrace.hh"
@@ -97,6 +99,13 @@ installSignalHandler(int signal, void (*handler)(int sigtype),
         panic("Failed to setup handler for signal %i\n", signal);
 }
 
+static void
+dumpFlightRecorder()
+{
+    if (const char *path = trace::dumpFlightRecorder())
+        ccprintf(std::cerr, "Debug flight recorder dumped to %s\n", path);
+}
+
 static void
 raiseFatalSignal(int signo)
 {
@@ -155,6 +164,8 @@ abortHandler(int sigtype)
         STATIC_ERR("Program aborted\n\n");
     }
 
+    dumpFlightRecorder();
+    trace::flushBinaryTrace(false);
     print_backtrace();
     raiseFatalSignal(sigtype);
 }
@@ -165,6 +176,8 @@ segvHandler(int sigtype)
 {
     STATIC_ERR("gem5 has encountered a segmentation fault!\n\n");
 
+    dumpFlightRecorder();
+    trace::flushBinaryTrace(false);
     print_backtrace();
     raiseFatalSignal(SIGSEGV);
 }
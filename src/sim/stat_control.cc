@@ -53,6 +53,7 @@
 #include "base/statistics.hh"
 #include "base/time.hh"
 #include "sim/global_event.hh"
+#include "sim/stat_stream.hh"
 
 namespace gem5
 {
@@ -156,6 +157,8 @@ updateEvents()
         Tick _when = dumpEvent->when();
         dumpEvent->reschedule(_when + curTick());
     }
+
+    StreamOutput::updateEvents();
 }
 
 } // namespace statistics
@@ -58,7 +58,9 @@ void initSimStats();
  * Update the events after resuming from a checkpoint. When resuming from a
  * checkpoint, curTick will be updated, and any already scheduled events can
  * end up scheduled in the past. This function checks if the dumpEvent is
- * scheduled in the past, and reschedules it appropriately.
+ * scheduled in the past, and reschedules it appropriately. It also starts
+ * the sampling events of stat streams created before the simulation was
+ * set up.
  */
 void updateEvents();
 
@@ -0,0 +1,395 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "sim/stat_stream.hh"
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+
+#include "base/logging.hh"
+#include "base/pollevent.hh"
+#include "base/statistics.hh"
+#include "base/stats/group.hh"
+#include "base/stats/info.hh"
+#include "sim/core.hh"
+#include "sim/cur_tick.hh"
+#include "sim/global_event.hh"
+#include "sim/root.hh"
+
+// MSG_NOSIGNAL does not exists on OS X
+#if defined(__APPLE__) || defined(__MACH__)
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL SO_NOSIGPIPE
+#endif
+#endif
+
+namespace gem5
+{
+
+namespace statistics
+{
+
+namespace
+{
+
+class StreamEvent : public GlobalEvent
+{
+  private:
+    StreamOutput &output;
+
+  public:
+    StreamEvent(StreamOutput &_output)
+        : GlobalEvent(Stat_Event_Pri, 0), output(_output)
+    {
+    }
+
+    void process() override { output.sample(); }
+
+    const char *description() const override { return "StatStreamEvent"; }
+};
+
+class ListenEvent : public PollEvent
+{
+  private:
+    StreamOutput &output;
+
+  public:
+    ListenEvent(int fd, StreamOutput &_output)
+        : PollEvent(fd, POLLIN), output(_output)
+    {
+    }
+
+    void process(int revent) override { output.acceptClients(); }
+};
+
+bool
+setNonBlocking(int fd)
+{
+    const int flags = fcntl(fd, F_GETFL, 0);
+    return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+/** Order legacy stats like the Python dump code does. */
+bool
+legacyOrder(const Info *a, const Info *b)
+{
+    size_t pos_a = 0, pos_b = 0;
+    while (pos_a != std::string::npos && pos_b != std::string::npos) {
+        const size_t end_a = a->name.find('.', pos_a);
+        const size_t end_b = b->name.find('.', pos_b);
+        const int cmp = a->name.compare(
+            pos_a, end_a == std::string::npos ? end_a : end_a - pos_a,
+            b->name, pos_b,
+            end_b == std::string::npos ? end_b : end_b - pos_b);
+        if (cmp != 0)
+            return cmp < 0;
+        pos_a = end_a == std::string::npos ? end_a : end_a + 1;
+        pos_b = end_b == std::string::npos ? end_b : end_b + 1;
+    }
+    return pos_a == std::string::npos && pos_b != std::string::npos;
+}
+
+} // anonymous namespace
+
+std::vector<StreamOutput *> &
+StreamOutput::streams()
+{
+    static std::vector<StreamOutput *> all;
+    return all;
+}
+
+StreamOutput::StreamOutput(const std::string &_path, double period,
+                           const std::string &_filter, bool formulas,
+                           int compression)
+    : Columnar(nullptr, formulas, compression),
+      path(_path), periodSeconds(period), period(0),
+      filter(_filter.empty() ? ".*" : _filter), listenFd(-1)
+{
+    fatal_if(periodSeconds < 0, "Invalid stat stream period: %f\n",
+             periodSeconds);
+
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    fatal_if(path.empty() || path.size() >= sizeof(addr.sun_path),
+             "Invalid stat stream socket path '%s'.\n", path);
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    fatal_if(listenFd == -1, "Failed to create stat stream socket: %s\n",
+             strerror(errno));
+
+    // Remove the socket left behind by a previous run.
+    unlink(path.c_str());
+    fatal_if(bind(listenFd, (sockaddr *)&addr, sizeof(addr)) == -1 ||
+             listen(listenFd, 8) == -1 || !setNonBlocking(listenFd),
+             "Failed to listen on stat stream socket '%s': %s\n", path,
+             strerror(errno));
+
+    appendHeader(preamble);
+    headerSize = preamble.size();
+
+    streams().push_back(this);
+
+    // Clients that connect while the simulation runs are accepted
+    // right away, so that they get samples before the next dump.
+    listenEvent.reset(new ListenEvent(listenFd, *this));
+    pollQueue.schedule(listenEvent.get());
+}
+
+StreamOutput::~StreamOutput()
+{
+    if (event && event->scheduled())
+        event->deschedule();
+
+    auto &all = streams();
+    all.erase(std::remove(all.begin(), all.end(), this), all.end());
+
+    while (!clients.empty())
+        dropClient(clients.size() - 1);
+
+    listenEvent.reset();
+    if (listenFd != -1) {
+        close(listenFd);
+        unlink(path.c_str());
+    }
+}
+
+void
+StreamOutput::schedule(Tick now)
+{
+    if (!event) {
+        // The number of event queues is known once the simulation has
+        // been set up, so is the tick frequency.
+        period = std::max<Tick>(
+            std::llround(periodSeconds * sim_clock::Frequency), 1);
+        event.reset(new StreamEvent(*this));
+    }
+
+    if (event->scheduled())
+        event->reschedule(now + period);
+    else
+        event->schedule(now + period);
+}
+
+void
+StreamOutput::startSampling()
+{
+    // Simulations that aren't set up yet start sampling in
+    // updateEvents().
+    if (periodSeconds == 0 || !enabled())
+        return;
+
+    if (!event || !event->scheduled())
+        schedule(curTick());
+}
+
+void
+StreamOutput::updateEvents()
+{
+    for (auto *stream : streams()) {
+        if (stream->periodSeconds == 0 || stream->clients.empty())
+            continue;
+
+        if (!stream->event || !stream->event->scheduled() ||
+            stream->event->when() < curTick()) {
+            stream->schedule(curTick());
+        }
+    }
+}
+
+void
+StreamOutput::visitGroup(const Group &group)
+{
+    for (auto *info : group.getStats())
+        info->visit(*this);
+
+    for (const auto &g : group.getStatGroups()) {
+        beginGroup(g.first.c_str());
+        visitGroup(*g.second);
+        endGroup();
+    }
+}
+
+void
+StreamOutput::sample()
+{
+    // Don't spend any time on samples nobody reads.
+    acceptClients();
+    if (!clients.empty()) {
+        Root *root = Root::root();
+
+        std::vector<Info *> legacy(statsList().begin(), statsList().end());
+        std::sort(legacy.begin(), legacy.end(), legacyOrder);
+
+        {
+            // Samples must not consume the changes reported by the
+            // next stat dump.
+            SamplingScope sampling;
+            for (auto *info : legacy)
+                info->prepare();
+            root->prepareStats();
+        }
+
+        begin();
+        visitGroup(*root);
+        for (auto *info : legacy)
+            info->visit(*this);
+        end();
+    }
+
+    // Stop sampling with the last client, the next client to connect
+    // starts it again.
+    if (!clients.empty())
+        schedule(curTick());
+}
+
+void
+StreamOutput::begin()
+{
+    acceptClients();
+    Columnar::begin();
+}
+
+bool
+StreamOutput::valid() const
+{
+    return listenFd != -1;
+}
+
+bool
+StreamOutput::selected(const std::string &name) const
+{
+    return std::regex_search(name, filter);
+}
+
+void
+StreamOutput::acceptClients()
+{
+    while (true) {
+        const int fd = accept(listenFd, nullptr, nullptr);
+        if (fd == -1) {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                warn("Failed to accept a stat stream client: %s\n",
+                     strerror(errno));
+            }
+            break;
+        }
+
+        if (!setNonBlocking(fd)) {
+            warn("Failed to set up a stat stream client: %s\n",
+                 strerror(errno));
+            close(fd);
+            continue;
+        }
+
+        inform("Stat stream client connected to '%s'.\n", path);
+        clients.push_back(Client{fd, preamble});
+    }
+
+    if (!clients.empty())
+        startSampling();
+}
+
+void
+StreamOutput::dropClient(size_t idx)
+{
+    close(clients[idx].fd);
+    clients.erase(clients.begin() + idx);
+}
+
+void
+StreamOutput::emit(uint32_t kind, const char *data, size_t size)
+{
+    // Keep the latest schema for clients that connect later.
+    if ((kind & ~Compressed) == Schema) {
+        preamble.resize(headerSize);
+        preamble.insert(preamble.end(), data, data + size);
+    }
+
+    for (auto &client : clients)
+        client.pending.insert(client.pending.end(), data, data + size);
+}
+
+void
+StreamOutput::flush()
+{
+    for (size_t i = 0; i < clients.size();) {
+        Client &client = clients[i];
+
+        size_t sent = 0;
+        bool failed = false;
+        while (sent < client.pending.size()) {
+            const ssize_t ret = send(client.fd, client.pending.data() + sent,
+                                     client.pending.size() - sent,
+                                     MSG_NOSIGNAL);
+            if (ret >= 0) {
+                sent += ret;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            } else if (errno != EINTR) {
+                failed = true;
+                break;
+            }
+        }
+        client.pending.erase(client.pending.begin(),
+                             client.pending.begin() + sent);
+
+        if (failed) {
+            inform("Stat stream client disconnected from '%s'.\n", path);
+            dropClient(i);
+        } else if (client.pending.size() > maxPending) {
+            warn("Stat stream client on '%s' is too slow, "
+                 "disconnecting it.\n", path);
+            dropClient(i);
+        } else {
+            ++i;
+        }
+    }
+}
+
+std::unique_ptr<Output>
+initStream(const std::string &path, double period, const std::string &filter,
+           bool formulas, int compression)
+{
+    return std::make_unique<StreamOutput>(path, period, filter, formulas,
+                                          compression);
+}
+
+} // namespace statistics
+} // namespace gem5
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2024 The gem5 contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __SIM_STAT_STREAM_HH__
+#define __SIM_STAT_STREAM_HH__
+
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "base/stats/columnar.hh"
+#include "base/types.hh"
+
+namespace gem5
+{
+
+class GlobalEvent;
+class PollEvent;
+
+namespace statistics
+{
+
+class Group;
+
+/**
+ * Publish stats to live consumers over a Unix domain socket.
+ *
+ * The output listens on a socket and sends the same records as a
+ * columnar stat file (see Columnar) to every connected client: the
+ * file header and the current schema when the client connects,
+ * followed by one row per sample. Besides regular stat dumps, the
+ * stats are sampled periodically while the simulation runs and a
+ * client is connected. Samples don't reset the stats and don't affect
+ * the changes reported to the other outputs.
+ *
+ * Sockets are non-blocking. Data a client doesn't read immediately
+ * is buffered, and a client that falls too far behind is
+ * disconnected rather than stalling the simulation.
+ */
+class StreamOutput : public Columnar
+{
+  public:
+    /**
+     * @param path Path of the listening socket.
+     * @param period Sampling period in seconds of simulated time, 0
+     * to only publish stat dumps.
+     * @param filter Only publish stats with a matching name.
+     * @param formulas Publish derived stats.
+     * @param compression zstd compression level, 0 to disable.
+     */
+    StreamOutput(const std::string &path, double period,
+                 const std::string &filter, bool formulas,
+                 int compression);
+    ~StreamOutput();
+
+    /** Sample the selected stats and publish them. */
+    void sample();
+
+    /**
+     * Start the sampling events once the simulation has been set up,
+     * and move them forward after resuming from a checkpoint.
+     */
+    static void updateEvents();
+
+    /**
+     * Accept pending connections and send them the schema. Sampling
+     * starts with the first client.
+     */
+    void acceptClients();
+
+  public: // Output interface
+    void begin() override;
+    bool valid() const override;
+
+  protected:
+    bool selected(const std::string &name) const override;
+    void emit(uint32_t kind, const char *data, size_t size) override;
+    void flush() override;
+
+  private:
+    struct Client
+    {
+        int fd;
+        /** Data the client hasn't read yet */
+        std::vector<char> pending;
+    };
+
+    /** Disconnect a client. */
+    void dropClient(size_t idx);
+    /** Visit the stats of a group and its subgroups. */
+    void visitGroup(const Group &group);
+    /** Schedule the next sample. */
+    void schedule(Tick when);
+    /** Start sampling unless it is running or can't run yet. */
+    void startSampling();
+
+    /** All stream outputs, used to start their events */
+    static std::vector<StreamOutput *> &streams();
+
+    /** Maximum amount of data buffered for a single client */
+    static constexpr size_t maxPending = 16 * 1024 * 1024;
+
+    const std::string path;
+    const double periodSeconds;
+    Tick period;
+    const std::regex filter;
+
+    int listenFd;
+    /** Accepts clients while the simulation runs */
+    std::unique_ptr<PollEvent> listenEvent;
+    std::vector<Client> clients;
+    /** Header and latest schema record, sent to new clients */
+    std::vector<char> preamble;
+    size_t headerSize;
+
+    std::unique_ptr<GlobalEvent> event;
+};
+
+std::unique_ptr<Output> initStream(const std::string &path, double period,
+                                   const std::string &filter,
+                                   bool formulas = true,
+                                   int compression = 0);
+
+} // namespace statistics
+} // namespace gem5
+
+#endif // __SIM_STAT_STREAM_HH__
@@ -0,0 +1,213 @@
+# Copyright (c) 2024 The gem5 contributors
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+"""
+Run a config script several times with different arguments and check that
+the selected stats are the same in every run.
+
+This is used to check that host-side optimizations that can be switched
+off (e.g., lazy DRAM refresh or garnet idle sleep) do not change the
+simulated behaviour. Every variant runs in its own process so that it
+starts from a pristine simulator, and dumps its stats to its own file in
+the output directory. The stats of the first variant are the reference,
+and every stats dump is compared. The host time of every variant is
+reported, to show what the optimizations save.
+
+Example:
+
+    gem5.opt compare_stats_run.py \\
+        --variant="" --variant="--garnet-no-idle-sleep" \\
+        configs/example/garnet_synth_traffic.py --sim-cycles=10000
+"""
+
+import argparse
+import os
+import re
+import runpy
+import shlex
+import sys
+import time
+from multiprocessing import Process
+
+import m5
+
+parser = argparse.ArgumentParser(
+    description=__doc__, formatter_class=argparse.RawTextHelpFormatter
+)
+parser.add_argument(
+    "--variant",
+    action="append",
+    required=True,
+    help="extra arguments of one run (at least two variants are needed)",
+)
+parser.add_argument(
+    "--stat",
+    action="append",
+    default=[],
+    help="regex of the stats to compare (default: all simulated stats)",
+)
+parser.add_argument(
+    "--ignore",
+    action="append",
+    default=[],
+    help="regex of stats to leave out of the comparison",
+)
+parser.add_argument(
+    "--rel-tol",
+    type=float,
+    default=0.0,
+    help="relative tolerance when comparing numerical values",
+)
+parser.add_argument("script", help="config script to run")
+parser.add_argument(
+    "script_args", nargs=argparse.REMAINDER, help="common script arguments"
+)
+
+args = parser.parse_args()
+
+if len(args.variant) < 2:
+    parser.error("At least two variants are needed")
+
+# Host stats depend on the machine running the simulation.
+_host_stats = re.compile(r"(^|\.)host[A-Z]")
+
+
+def _run_variant(argv, stats_file):
+    sys.argv = [args.script] + argv
+    sys.path[0] = os.path.dirname(os.path.abspath(args.script))
+    m5.stats.addStatVisitor(stats_file)
+
+    try:
+        runpy.run_path(args.script, run_name="__m5_main__")
+    except SystemExit as e:
+        if e.code:
+            raise
+
+    # The process exits without running the atexit handlers, so the stats
+    # need to be dumped explicitly.
+    m5.stats.dump()
+    sys.exit(0)
+
+
+def _parse_stats(stats_file):
+    """Return the stats of every dump in a text stats file."""
+
+    dumps = []
+    with open(stats_file) as f:
+        for line in f:
+            line = line.split("#")[0].split()
+            if not line:
+                continue
+            if line[0] == "----------":
+                if "Begin" in line:
+                    dumps.append({})
+                continue
+            dumps[-1][line[0]] = line[1:]
+    return dumps
+
+
+def _selected(name):
+    if _host_stats.search(name):
+        return False
+    if any(re.search(r, name) for r in args.ignore):
+        return False
+    return not args.stat or any(re.search(r, name) for r in args.stat)
+
+
+def _equal(ref, val):
+    if ref == val:
+        return True
+    try:
+        ref, val = float(ref), float(val)
+    except ValueError:
+        return False
+    return abs(ref - val) <= args.rel_tol * max(abs(ref), abs(val))
+
+
+def _compare(ref, stats, variant, dump):
+    errors = 0
+    for name in sorted(set(ref) | set(stats)):
+        if not _selected(name):
+            continue
+        ref_val = ref.get(name)
+        val = stats.get(name)
+        if (
+            ref_val is None
+            or val is None
+            or len(ref_val) != len(val)
+            or not all(_equal(r, v) for r, v in zip(ref_val, val))
+        ):
+            print(
+                f"Mismatch with '{variant}' in dump {dump}, {name}: "
+                f"{ref_val} != {val}",
+                file=sys.stderr,
+            )
+            errors += 1
+    return errors
+
+
+results = []
+for i, variant in enumerate(args.variant):
+    stats_file = os.path.join(m5.options.outdir, f"stats-variant{i}.txt")
+    p = Process(
+        target=_run_variant,
+        args=(args.script_args + shlex.split(variant), stats_file),
+    )
+    start = time.monotonic()
+    p.start()
+    p.join()
+    host_seconds = time.monotonic() - start
+
+    if p.exitcode != 0:
+        print(f"Variant '{variant}' failed", file=sys.stderr)
+        sys.exit(1)
+    print(f"Variant '{variant}' ran in {host_seconds:.2f} host seconds")
+    results.append((variant, _parse_stats(stats_file)))
+
+ref_variant, ref = results[0]
+if not any(_selected(name) for dump in ref for name in dump):
+    print("No stats to compare", file=sys.stderr)
+    sys.exit(1)
+
+errors = 0
+for variant, dumps in results[1:]:
+    if len(dumps) != len(ref):
+        print(
+            f"Variant '{variant}' dumped the stats {len(dumps)} times "
+            f"instead of {len(ref)}",
+            file=sys.stderr,
+        )
+        errors += 1
+    for i, (ref_stats, stats) in enumerate(zip(ref, dumps)):
+        errors += _compare(ref_stats, stats, variant, i)
+
+if errors:
+    print(
+        f"{errors} stats differ from variant '{ref_variant}'", file=sys.stderr
+    )
+    sys.exit(1)
+
+print(f"Stats of {len(results)} variants match.")
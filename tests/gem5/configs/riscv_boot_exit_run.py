@@ -88,6 +88,15 @@ parser.add_argument(
     help="The tick to exit the simulation.",
 )
 
+parser.add_argument(
+    "-l",
+    "--disk-latency",
+    type=str,
+    required=False,
+    help="The latency of disk requests, which are then served by a host "
+    "I/O thread.",
+)
+
 parser.add_argument(
     "-r",
     "--resource-directory",
@@ -159,6 +168,9 @@ board = RiscvBoard(
     cache_hierarchy=cache_hierarchy,
 )
 
+if args.disk_latency:
+    board.disk.vio.latency = args.disk_latency
+
 # Set the workload.
 workload = Workload(
     "riscv-ubuntu-20.04-boot", resource_directory=args.resource_directory
@@ -0,0 +1,130 @@
+# Copyright (c) 2024 The gem5 contributors
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+"""
+Save and reload the sectors of a copy-on-write disk image.
+
+A COW file is written with sectors spread over several pages of the
+layer, including runs across page boundaries. The image loads it when
+it is created, and saves it again into a checkpoint, which must hold
+the same sectors.
+"""
+
+import os
+import random
+import struct
+import sys
+
+import m5
+from m5.objects import *
+
+SECTOR_SIZE = 512
+NUM_SECTORS = 256
+
+outdir = m5.options.outdir
+raw_path = os.path.join(outdir, "disk.img")
+cow_path = os.path.join(outdir, "disk.cow")
+cpt_dir = os.path.join(outdir, "disk.cpt")
+
+
+def fail(msg):
+    print(f"Test failed: {msg}", file=sys.stderr)
+    sys.exit(1)
+
+
+def write_cow(path, sectors):
+    with open(path, "wb") as f:
+        f.write(b"COWDISK!")
+        f.write(struct.pack("<IIQ", 1, 0, len(sectors)))
+        for offset, data in sectors.items():
+            f.write(struct.pack("<Q", offset))
+            f.write(data)
+
+
+def read_cow(path):
+    sectors = {}
+    with open(path, "rb") as f:
+        if f.read(8) != b"COWDISK!":
+            fail(f"{path} has a bad magic")
+        major, minor, count = struct.unpack("<IIQ", f.read(16))
+        if (major, minor) != (1, 0):
+            fail(f"{path} has version {major}.{minor}")
+        for _ in range(count):
+            (offset,) = struct.unpack("<Q", f.read(8))
+            if offset in sectors:
+                fail(f"sector {offset} saved twice")
+            sectors[offset] = f.read(SECTOR_SIZE)
+        if f.read():
+            fail(f"{path} has trailing data")
+    return sectors
+
+
+rng = random.Random(49)
+
+
+def random_bytes(size):
+    return bytes(rng.getrandbits(8) for _ in range(size))
+
+
+with open(raw_path, "wb") as f:
+    f.write(random_bytes(NUM_SECTORS * SECTOR_SIZE))
+
+offsets = [0, 7, 8, 9, 42] + list(range(100, 121)) + [NUM_SECTORS - 1]
+rng.shuffle(offsets)
+sectors = {offset: random_bytes(SECTOR_SIZE) for offset in offsets}
+write_cow(cow_path, sectors)
+
+system = System(
+    clk_domain=SrcClockDomain(clock="1GHz", voltage_domain=VoltageDomain()),
+    mem_ranges=[AddrRange("64MB")],
+    membus=SystemXBar(),
+)
+system.mem = SimpleMemory(range=system.mem_ranges[0])
+system.mem.port = system.membus.mem_side_ports
+system.system_port = system.membus.cpu_side_ports
+system.disk = CowDiskImage(
+    child=RawDiskImage(image_file=raw_path, read_only=True),
+    image_file=cow_path,
+    read_only=False,
+)
+
+root = Root(full_system=False, system=system)
+m5.instantiate()
+
+cause = m5.simulate(1000000).getCause()
+if cause != "simulate() limit reached":
+    fail(f"unexpected exit: {cause}")
+
+m5.checkpoint(cpt_dir)
+saved = read_cow(os.path.join(cpt_dir, "system.disk.cow"))
+if saved != sectors:
+    fail(
+        f"saved sectors {sorted(saved)} don't match the loaded sectors "
+        f"{sorted(sectors)}"
+    )
+
+print("Test done.", file=sys.stderr)
+sys.exit(0)
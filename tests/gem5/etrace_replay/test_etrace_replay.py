@@ -0,0 +1,79 @@
+# Copyright (c) 2024 The gem5 contributors
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+"""
+Replay small synthetic elastic traces on two Trace CPUs with
+configs/example/etrace_replay.py, with the CPUs on the event queue of the
+rest of the system and with each CPU and its private caches on an event
+queue of its own (--parallel-cpus). Both runs must replay the traces of
+both CPUs to the end.
+
+The traces have 2000 nodes per CPU, and half of their accesses go to lines
+that both CPUs use, so coherence requests cross the bridges of the
+parallel run.
+"""
+
+import os
+import re
+
+from testlib import *
+
+trace_dir = os.path.join(os.path.dirname(__file__), "traces")
+
+common_args = [
+    "--cpu-type=TraceCPU",
+    "--num-cpus=2",
+    "--caches",
+    "--l2cache",
+    "--inst-trace-file="
+    + ",".join(os.path.join(trace_dir, f"inst{i}.proto.gz") for i in range(2)),
+    "--data-trace-file="
+    + ",".join(os.path.join(trace_dir, f"data{i}.proto.gz") for i in range(2)),
+]
+
+variants = {
+    "serial": [],
+    "parallel": ["--parallel-cpus"],
+}
+
+for variant, args in variants.items():
+    gem5_verify_config(
+        name=f"etrace_replay-2cpus-{variant}",
+        fixtures=(),
+        verifiers=(
+            verifier.MatchRegex(
+                re.compile(r"Exiting @ tick \d+ because end of all traces"),
+                match_stderr=False,
+            ),
+        ),
+        config=joinpath(
+            config.base_dir, "configs", "example", "etrace_replay.py"
+        ),
+        config_args=common_args + args,
+        valid_isas=(constants.all_compiled_tag,),
+        valid_hosts=constants.supported_hosts,
+        length=constants.quick_tag,
+    )
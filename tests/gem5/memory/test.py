@@ -29,6 +29,8 @@ Test file for simple memory test
 TODO: Add stats checking
 """
 
+import re
+
 from testlib import *
 
 gem5_verify_config(
@@ -72,6 +74,33 @@ gem5_verify_config(
 
 null_tests = [
     ("garnet_synth_traffic", None, ["--sim-cycles", "5000000"]),
+    (
+        "garnet_synth_traffic-partitioned",
+        "garnet_synth_traffic",
+        [
+            "--sim-cycles",
+            "5000000",
+            "--network=garnet",
+            "--topology=Mesh_XY",
+            "--mesh-rows=2",
+            "--num-cpus=4",
+            "--num-dirs=4",
+            "--ruby-partitions=2",
+        ],
+    ),
+    (
+        "garnet_synth_traffic-analytical",
+        "garnet_synth_traffic",
+        [
+            "--sim-cycles",
+            "5000000",
+            "--network=analytical",
+            "--topology=Mesh_XY",
+            "--mesh-rows=2",
+            "--num-cpus=4",
+            "--num-dirs=4",
+        ],
+    ),
     ("memcheck", None, ["--maxtick", "2000000000", "--prefetchers"]),
     (
         "ruby_mem_test-garnet",
@@ -120,6 +149,11 @@ null_tests = [
     ),
     ("ruby_random_test", None, ["--maxloads", "5000"]),
     ("ruby_direct_test", None, ["--requests", "50000"]),
+    (
+        "ruby_lock_test",
+        None,
+        ["--num-cpus=8", "--acquisitions", "200"],
+    ),
 ]
 
 for test_name, basename_noext, args in null_tests:
@@ -137,3 +171,137 @@ for test_name, basename_noext, args in null_tests:
         valid_hosts=constants.supported_hosts,
         length=constants.long_tag,
     )
+
+# Host-side optimizations that can be switched off must not change the
+# simulated behaviour: run the same config with and without them and
+# compare the stats of the runs.
+compare_tests = [
+    (
+        "garnet_synth_traffic-partitions",
+        ("configs", "example", "garnet_synth_traffic.py"),
+        ["--variant=", "--variant=--ruby-partitions=2"],
+        [
+            "--sim-cycles",
+            "1000000",
+            "--network=garnet",
+            "--topology=Mesh_XY",
+            "--mesh-rows=2",
+            "--num-cpus=4",
+            "--num-dirs=4",
+            "--injectionrate=0.5",
+        ],
+    ),
+    (
+        "garnet_synth_traffic-idle_sleep",
+        ("configs", "example", "garnet_synth_traffic.py"),
+        ["--variant=", "--variant=--garnet-no-idle-sleep"],
+        [
+            "--sim-cycles",
+            "1000000",
+            "--network=garnet",
+            "--topology=Mesh_XY",
+            "--mesh-rows=2",
+            "--num-cpus=4",
+            "--num-dirs=4",
+            "--injectionrate=0.5",
+        ],
+    ),
+    # Low injection rates are where idle sleep saves the most host time
+    (
+        "garnet_synth_traffic-idle_sleep-low_injection",
+        ("configs", "example", "garnet_synth_traffic.py"),
+        ["--variant=", "--variant=--garnet-no-idle-sleep"],
+        [
+            "--sim-cycles",
+            "1000000",
+            "--network=garnet",
+            "--topology=Mesh_XY",
+            "--mesh-rows=4",
+            "--num-cpus=16",
+            "--num-dirs=16",
+            "--synthetic=uniform_random",
+            "--injectionrate=0.01",
+        ],
+    ),
+    (
+        "dram_low_power_sweep-lazy_refresh",
+        ("configs", "dram", "low_power_sweep.py"),
+        # Energy is integrated over different windows, which only changes
+        # the floating point summation order
+        ["--variant=", "--variant=--lazy-refresh", "--rel-tol=1e-9"],
+        [
+            "--disable-powerdown",
+            "--mem-ranks=2",
+            "--rd-perc=70",
+            "--itt-list=1 200",
+            "--idle-end=1000000000",
+        ],
+    ),
+]
+
+for test_name, script, compare_args, args in compare_tests:
+    gem5_verify_config(
+        name=test_name,
+        fixtures=(),
+        verifiers=(),
+        config=joinpath(
+            config.base_dir,
+            "tests",
+            "gem5",
+            "configs",
+            "compare_stats_run.py",
+        ),
+        config_args=compare_args
+        + [joinpath(config.base_dir, *script)]
+        + args,
+        valid_isas=(constants.null_tag,),
+        valid_hosts=constants.supported_hosts,
+        length=constants.long_tag,
+    )
+
+# Check the decisions of the indexed FR-FCFS scheduler against a scan of
+# the whole queue, with deep queues and a mix of reads and writes so that
+# there are many packets to choose from.
+for mode in ("DRAM", "DRAM_ROTATE"):
+    gem5_verify_config(
+        name=f"dram_sweep-check_frfcfs-{mode}",
+        fixtures=(),
+        verifiers=(),
+        config=joinpath(config.base_dir, "configs", "dram", "sweep.py"),
+        config_args=[
+            "--mode",
+            mode,
+            "--mem-ranks",
+            "2",
+            "--rd_perc",
+            "70",
+            "--queue-size",
+            "128",
+            "--check-scheduler",
+        ],
+        valid_isas=(constants.all_compiled_tag,),
+        valid_hosts=constants.supported_hosts,
+        length=constants.long_tag,
+    )
+
+# Hot pages in the CXL expander must be migrated to the local DRAM, and the
+# accesses that follow must then be served from there.
+gem5_verify_config(
+    name="dram_cxl_tiering",
+    fixtures=(),
+    verifiers=(
+        verifier.MatchFileRegex(
+            re.compile(r"system\.migrator\.migrations\s+[1-9]"),
+            ["stats.txt"],
+        ),
+        verifier.MatchFileRegex(
+            re.compile(r"system\.migrator\.nearAccesses\s+[1-9]"),
+            ["stats.txt"],
+        ),
+    ),
+    config=joinpath(config.base_dir, "configs", "dram", "cxl_tiering.py"),
+    config_args=["--duration=200us", "--epoch=20us"],
+    valid_isas=(constants.null_tag,),
+    valid_hosts=constants.supported_hosts,
+    length=constants.quick_tag,
+)
@@ -43,6 +43,7 @@ def test_boot(
     memory_class: str,
     length: str,
     to_tick: Optional[int] = None,
+    disk_latency: Optional[str] = None,
 ):
 
     name = "{}-cpu_{}-cores_{}_{}_riscv-boot-test".format(
@@ -50,9 +51,15 @@ def test_boot(
     )
 
     verifiers = []
-    exit_regex = re.compile(
-        f"Exiting @ tick {str(to_tick)} because simulate\\(\\) limit reached"
-    )
+    if to_tick:
+        exit_regex = re.compile(
+            f"Exiting @ tick {str(to_tick)} because simulate\\(\\) limit "
+            "reached"
+        )
+    else:
+        exit_regex = re.compile(
+            "Exiting @ tick [0-9]+ because m5_exit instruction encountered"
+        )
     verifiers.append(verifier.MatchRegex(exit_regex))
 
     config_args = [
@@ -72,6 +79,10 @@ def test_boot(
         name += "_to-tick"
         config_args += ["--tick-exit", str(to_tick)]
 
+    if disk_latency:
+        name += "_disk-latency"
+        config_args += ["--disk-latency", disk_latency]
+
     gem5_verify_config(
         name=name,
         verifiers=verifiers,
@@ -185,6 +196,18 @@ test_boot(
 
 #### The long (Nightly) tests ####
 
+# Boot with the disk requests served by the host I/O thread of the
+# VirtIO block device, which the boot uses to read and write the root
+# file system.
+test_boot(
+    cpu="atomic",
+    num_cpus=1,
+    cache_type="classic",
+    memory_class="SingleChannelDDR3_1600",
+    length=constants.long_tag,
+    disk_latency="100us",
+)
+
 # Due to Nightly test timeout issues, outlined here:
 # https://gem5.atlassian.net/browse/GEM5-1120, these tests have been disabled
 # until the exact error causing the Nightly tests to timeout is established.
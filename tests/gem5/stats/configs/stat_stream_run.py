@@ -0,0 +1,159 @@
+# Copyright (c) 2024 The gem5 contributors
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+"""
+Check the samples published by the stream:// stat output.
+
+Clients connect to the stat stream between simulation phases, and the
+rows they receive are checked: samples start one period after a client
+connects, are spaced by the sampling period, and stop with the last
+client. A checkpoint is taken while a client is connected, sampling
+must carry on after it.
+"""
+
+import os
+import shutil
+import socket
+import sys
+import tempfile
+
+import m5
+from m5.objects import *
+from m5.stats.columnar import ColumnarReader
+from m5.ticks import fromSeconds
+
+# Unix socket paths are short, so the socket doesn't go in the output
+# directory.
+sock_dir = tempfile.mkdtemp(prefix="gem5-stream")
+sock_path = os.path.join(sock_dir, "stats.sock")
+
+system = System(
+    clk_domain=SrcClockDomain(clock="1GHz", voltage_domain=VoltageDomain()),
+    mem_ranges=[AddrRange("64MB")],
+    membus=SystemXBar(),
+)
+system.mem = SimpleMemory(range=system.mem_ranges[0])
+system.mem.port = system.membus.mem_side_ports
+system.system_port = system.membus.cpu_side_ports
+
+root = Root(full_system=False, system=system)
+
+m5.stats.addStatVisitor(
+    f'stream://{sock_path}?period="10us"&filter="finalTick"'
+)
+m5.instantiate()
+
+period = fromSeconds(10e-6)
+
+
+class Client:
+    def __init__(self):
+        self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self.sock.connect(sock_path)
+        self.sock.setblocking(False)
+        self.data = bytearray()
+        self.connected_at = m5.curTick()
+
+    def receive(self):
+        while True:
+            try:
+                data = self.sock.recv(65536)
+            except BlockingIOError:
+                return
+            if not data:
+                return
+            self.data += data
+
+    def close(self):
+        self.receive()
+        self.sock.close()
+
+    def ticks(self):
+        path = os.path.join(m5.options.outdir, "stream.bin")
+        with open(path, "wb") as f:
+            f.write(self.data)
+
+        ticks = []
+        for tick, values in ColumnarReader(path).rows():
+            final_tick = values["finalTick"]
+            if final_tick != tick:
+                fail(f"row of tick {tick} has finalTick {final_tick}")
+            ticks.append(tick)
+        return ticks
+
+
+def fail(msg):
+    print(f"Test failed: {msg}", file=sys.stderr)
+    shutil.rmtree(sock_dir)
+    sys.exit(1)
+
+
+def run(duration):
+    cause = m5.simulate(duration).getCause()
+    if cause != "simulate() limit reached":
+        fail(f"unexpected exit: {cause}")
+
+
+def check_samples(client, first, until):
+    """Check that client got one sample per period in [first, until]."""
+
+    expected = list(range(first, until + 1, period))
+    ticks = client.ticks()
+    if ticks != expected:
+        fail(f"expected samples at {expected}, got {ticks}")
+
+
+# Nobody is listening to the first phase
+run(fromSeconds(35e-6))
+
+first = Client()
+run(fromSeconds(100e-6))
+first.close()
+check_samples(first, first.connected_at + period, m5.curTick())
+
+# Sampling stops with the last client: the disconnection is noticed by the
+# next sample, after which a new client must not get any sample for a whole
+# period. A sample at the old phase would come earlier than that.
+run(2 * period)
+probe = Client()
+run(period - 1)
+probe.close()
+if probe.data:
+    fail(f"sampling went on without clients, got {probe.ticks()}")
+
+# Sampling starts over one period after the next client connects.
+run(fromSeconds(105e-6))
+
+second = Client()
+run(fromSeconds(100e-6))
+m5.checkpoint(os.path.join(m5.options.outdir, "stream.cpt"))
+run(fromSeconds(100e-6))
+second.close()
+check_samples(second, second.connected_at + period, m5.curTick())
+
+shutil.rmtree(sock_dir)
+print("Test done.", file=sys.stderr)
+sys.exit(0)
@@ -130,3 +130,25 @@ def create_dual_core_tests(module, memory_classes):
 
 create_single_core_tests("gem5.components.memory", memory_classes)
 create_dual_core_tests("gem5.components.memory", memory_classes)
+
+
+# Multi-channel memories with every channel on an event queue of its own.
+# The crossings change the timing under load, so these runs check that the
+# traffic completes on every channel rather than matching trusted stats.
+for memory_class in ["DualChannelDDR4_2400", "HBM2Stack"]:
+    gem5_verify_config(
+        name=f"test-memory-parallel-channels-{memory_class}",
+        fixtures=(),
+        verifiers=(),
+        config=joinpath(
+            config.base_dir,
+            "tests",
+            "gem5",
+            "traffic_gen",
+            "parallel_channels_run.py",
+        ),
+        config_args=[memory_class],
+        valid_isas=(constants.all_compiled_tag,),
+        valid_hosts=constants.supported_hosts,
+        length=constants.quick_tag,
+    )
@@ -0,0 +1,197 @@
+#!/usr/bin/env python3
+
+# Copyright (c) 2024 The gem5 contributors
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+# This script measures how fast the TraceCPU replays elastic traces. It
+# generates a synthetic elastic data trace, with a matching instruction
+# fetch trace, replays it with configs/example/etrace_replay.py and
+# reports the replay rate in nodes per second and the peak resident
+# memory of gem5. It is executed from the gem5 root, for example:
+#
+# util/bench_elastic_trace_replay.py --gem5 build/ARM/gem5.opt \
+#     --nodes 10000000
+
+import argparse
+import gzip
+import os
+import random
+import re
+import resource
+import subprocess
+import sys
+import tempfile
+
+import protolib
+
+# Import the proto definitions. If they are not found, attempt to
+# generate them.
+try:
+    import inst_dep_record_pb2
+    import packet_pb2
+except ImportError:
+    print("Did not find proto definitions, attempting to generate")
+    error = subprocess.call(
+        [
+            "protoc",
+            "--python_out=util",
+            "--proto_path=src/proto",
+            "src/proto/inst_dep_record.proto",
+            "src/proto/packet.proto",
+        ]
+    )
+    if error:
+        print("Failed to import proto definitions")
+        exit(-1)
+    import inst_dep_record_pb2
+    import packet_pb2
+
+DepRecord = inst_dep_record_pb2.InstDepRecord
+
+TICK_FREQ = 1000000000000
+
+
+def write_data_trace(path, nodes, window, seed):
+    """Write a trace of loads, stores and compute nodes that depend on
+    recent nodes, with gaps in the sequence numbers as in real traces."""
+    rng = random.Random(seed)
+    with gzip.open(path, "wb") as out:
+        out.write(b"gem5")
+        header = inst_dep_record_pb2.InstDepRecordHeader()
+        header.obj_id = "Synthetic elastic trace"
+        header.tick_freq = TICK_FREQ
+        header.window_size = window
+        protolib.encodeMessage(out, header)
+
+        recent = []
+        seq_num = 1
+        for _ in range(nodes):
+            record = DepRecord()
+            record.seq_num = seq_num
+            kind = rng.randrange(100)
+            if kind < 40:
+                record.type = DepRecord.LOAD if kind < 25 else DepRecord.STORE
+                record.p_addr = 0x100000 + 64 * rng.randrange(65536)
+                record.size = 8
+                record.flags = 0
+                if len(recent) > 8 and rng.randrange(4) == 0:
+                    record.rob_dep.append(recent[-1 - rng.randrange(8)])
+            else:
+                record.type = DepRecord.COMP
+            record.comp_delay = rng.randrange(2000)
+            for _ in range(min(2, len(recent))):
+                dep = recent[-1 - rng.randrange(min(len(recent), 48))]
+                if dep not in record.rob_dep:
+                    record.reg_dep.append(dep)
+            record.weight = rng.randrange(3)
+            protolib.encodeMessage(out, record)
+
+            recent.append(seq_num)
+            del recent[:-64]
+            seq_num += 2 if rng.randrange(5) == 0 else 1
+
+
+def write_inst_trace(path, nodes):
+    """Write an instruction fetch trace, one fetch per 16 nodes."""
+    with gzip.open(path, "wb") as out:
+        out.write(b"gem5")
+        header = packet_pb2.PacketHeader()
+        header.obj_id = "Synthetic fetch trace"
+        header.tick_freq = TICK_FREQ
+        protolib.encodeMessage(out, header)
+
+        for i in range(max(1, nodes // 16)):
+            packet = packet_pb2.Packet()
+            packet.tick = i * 8000
+            packet.cmd = 1
+            packet.addr = 0x1000 + 64 * (i % 1024)
+            packet.size = 64
+            protolib.encodeMessage(out, packet)
+
+
+def read_stat(stats, name):
+    match = re.search(r"^%s\s+(\S+)" % re.escape(name), stats, re.M)
+    return float(match.group(1)) if match else None
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Benchmark the replay of elastic traces."
+    )
+    parser.add_argument("--gem5", required=True, help="gem5 binary")
+    parser.add_argument(
+        "--nodes", type=int, default=1000000, help="nodes in the trace"
+    )
+    parser.add_argument(
+        "--window", type=int, default=3000, help="dependency window size"
+    )
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument(
+        "--trace-dir",
+        help="directory of the traces, they are reused if present",
+    )
+    args = parser.parse_args()
+
+    trace_dir = args.trace_dir or tempfile.mkdtemp(prefix="etrace-bench-")
+    os.makedirs(trace_dir, exist_ok=True)
+    data_trace = os.path.join(trace_dir, "data.proto.gz")
+    inst_trace = os.path.join(trace_dir, "inst.proto.gz")
+    if not os.path.exists(data_trace):
+        print("Generating a trace of", args.nodes, "nodes in", trace_dir)
+        write_data_trace(data_trace, args.nodes, args.window, args.seed)
+        write_inst_trace(inst_trace, args.nodes)
+
+    out_dir = os.path.join(trace_dir, "m5out")
+    error = subprocess.call(
+        [
+            args.gem5,
+            "--outdir=" + out_dir,
+            "configs/example/etrace_replay.py",
+            "--cpu-type=TraceCPU",
+            "--caches",
+            "--mem-size=4GB",
+            "--inst-trace-file=" + inst_trace,
+            "--data-trace-file=" + data_trace,
+        ]
+    )
+    if error:
+        print("gem5 failed")
+        exit(-1)
+
+    with open(os.path.join(out_dir, "stats.txt")) as stats_file:
+        stats = stats_file.read()
+    host_seconds = read_stat(stats, "hostSeconds")
+    # ru_maxrss is in KiB on Linux
+    peak_rss = resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss
+
+    print("Nodes replayed:", args.nodes)
+    print("Host seconds:", host_seconds)
+    print("Replay rate: %.0f nodes/s" % (args.nodes / host_seconds))
+    print("Peak RSS: %.1f MiB" % (peak_rss / 1024.0))
+
+
+if __name__ == "__main__":
+    main()
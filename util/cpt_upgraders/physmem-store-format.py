@@ -0,0 +1,10 @@
+# Physical memory stores can be checkpointed in a chunked format that
+# is written and restored in parallel. Every store now names its
+# format, stores in older checkpoints are single gzip streams.
+def upgrader(cpt):
+    import re
+
+    for sec in cpt.sections():
+        if re.search(r".*\.physmem\.store\d+$", sec):
+            if not cpt.has_option(sec, "format"):
+                cpt.set(sec, "format", "gzip")
@@ -0,0 +1,309 @@
+#!/usr/bin/env python3
+
+# Copyright (c) 2024 The gem5 contributors
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+# This script converts the compact instruction traces written by the
+# CompactInstTrace tracer to text, or to the protobuf instruction trace
+# format of InstPBTrace, which util/decode_inst_trace.py can read:
+#
+# decode_compact_inst_trace.py [--proto] <trace input> <output>
+#
+# Compressed traces need the zstandard Python module.
+
+import argparse
+import struct
+import sys
+
+RECORD_STREAM = 1
+RECORD_CHUNK = 2
+
+CODEC_RAW = 0
+CODEC_ZSTD = 1
+
+COLUMNS = ("defs", "ids", "ticks", "contexts", "mem", "data")
+
+# Result kinds of InstRecord::DataStatus
+DATA_INVALID = 0
+DATA_DOUBLE = 3
+DATA_REG = 5
+
+
+class Column:
+    """A column of a chunk, read front to back."""
+
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def varint(self):
+        value = 0
+        shift = 0
+        while True:
+            byte = self.data[self.pos]
+            self.pos += 1
+            value |= (byte & 0x7F) << shift
+            if byte < 0x80:
+                return value
+            shift += 7
+
+    def delta(self, base):
+        value = self.varint()
+        return (base + ((value >> 1) ^ -(value & 1))) & (2**64 - 1)
+
+    def bytes(self, size):
+        value = self.data[self.pos : self.pos + size]
+        self.pos += size
+        return value
+
+    def string(self):
+        return self.bytes(self.varint()).decode(errors="replace")
+
+
+class StaticInst:
+    """An entry of the instruction dictionary of a stream."""
+
+    def __init__(self, defs, base_pc):
+        self.pc = defs.delta(base_pc)
+        self.code = defs.bytes(defs.varint())
+        self.op_class = defs.string()
+        self.srcs = [
+            (defs.string(), defs.varint()) for _ in range(defs.varint())
+        ]
+        self.dests = [
+            (defs.string(), defs.varint()) for _ in range(defs.varint())
+        ]
+        self.disasm = defs.string()
+
+
+class Inst:
+    """An executed instruction."""
+
+    __slots__ = ("tick", "context", "static", "mem", "status", "data")
+
+
+class Stream:
+    """The instructions traced by one tracer."""
+
+    def __init__(self, index):
+        self.index = index
+        self.name = "stream%d" % index
+        self.dict = []
+
+    def decode(self, count, data):
+        sizes = struct.unpack_from("<%dI" % len(COLUMNS), data)
+        columns = []
+        pos = 4 * len(COLUMNS)
+        for size in sizes:
+            columns.append(Column(data[pos : pos + size]))
+            pos += size
+        defs, ids, ticks, contexts, mem, results = columns
+
+        last_pc = 0
+        while defs.pos < len(defs.data):
+            inst = StaticInst(defs, last_pc)
+            last_pc = inst.pc
+            self.dict.append(inst)
+
+        last_id = -1
+        last_tick = 0
+        last_mem_end = 0
+        for _ in range(count):
+            inst = Inst()
+            last_id = ids.delta(last_id + 1)
+            inst.static = self.dict[last_id]
+            last_tick = ticks.delta(last_tick)
+            inst.tick = last_tick
+            inst.context = contexts.varint()
+
+            inst.mem = []
+            for _ in range(mem.varint()):
+                addr = mem.delta(last_mem_end)
+                size = mem.varint()
+                flags = mem.varint()
+                inst.mem.append((addr, size, flags))
+                last_mem_end = addr + size
+
+            inst.status = results.bytes(1)[0]
+            kind = inst.status & 0xF
+            if kind == DATA_INVALID:
+                inst.data = None
+            elif kind == DATA_DOUBLE:
+                inst.data = struct.unpack("<Q", results.bytes(8))[0]
+            elif kind == DATA_REG and results.bytes(1)[0]:
+                inst.data = results.string()
+            else:
+                inst.data = results.varint()
+            yield inst
+
+
+def decompress(codec, raw_size, data):
+    if codec == CODEC_RAW:
+        return data
+    if codec != CODEC_ZSTD:
+        print("Unknown chunk codec", codec)
+        exit(-1)
+    try:
+        import zstandard
+    except ImportError:
+        print("Please install the zstandard Python module")
+        exit(-1)
+    return zstandard.ZstdDecompressor().decompress(
+        data, max_output_size=raw_size
+    )
+
+
+def read_trace(trace_in):
+    """Generate the header and then the (stream, instruction) pairs."""
+    header = trace_in.read(20)
+    if len(header) != 20 or header[:8] != b"gem5itr\0":
+        print("Unrecognized file")
+        exit(-1)
+    version, tick_freq = struct.unpack("<IQ", header[8:])
+    if version != 1:
+        print("Warning: file version newer than decoder:", version)
+    yield tick_freq
+
+    streams = {}
+    while True:
+        record = trace_in.read(5)
+        if len(record) < 5:
+            break
+        kind, index = struct.unpack("<BI", record)
+        stream = streams.setdefault(index, Stream(index))
+        if kind == RECORD_STREAM:
+            (size,) = struct.unpack("<I", trace_in.read(4))
+            stream.name = trace_in.read(size).decode()
+        elif kind == RECORD_CHUNK:
+            count, codec, raw_size, size = struct.unpack(
+                "<IBII", trace_in.read(13)
+            )
+            data = decompress(codec, raw_size, trace_in.read(size))
+            for inst in stream.decode(count, data):
+                yield stream, inst
+        else:
+            print("Unknown record kind", kind)
+            exit(-1)
+
+
+def write_text(trace, text_out):
+    next(trace)
+    for stream, inst in trace:
+        static = inst.static
+        line = "%7d: %s: T%d : %#x : %-26s : %s" % (
+            inst.tick,
+            stream.name,
+            inst.context,
+            static.pc,
+            static.disasm,
+            static.op_class,
+        )
+        if inst.status & 0x10:
+            line += " : Predicated False"
+        elif inst.data is not None:
+            if isinstance(inst.data, str):
+                line += " :  D=%s" % inst.data
+            else:
+                line += " :  D=%#018x" % inst.data
+        for addr, size, flags in inst.mem:
+            line += " A=%#x" % addr
+        text_out.write(line + "\n")
+
+
+def write_proto(trace, proto_out):
+    import protolib
+
+    # Import the instruction proto definitions
+    try:
+        import inst_pb2
+    except ImportError:
+        print("Please generate the inst proto definitions with:")
+        print("protoc --python_out=util --proto_path=src/proto inst.proto")
+        exit(-1)
+
+    proto_out.write(b"gem5")
+    header = inst_pb2.InstHeader()
+    header.obj_id = "gem5 generated instruction trace"
+    header.ver = 0
+    header.tick_freq = next(trace)
+    header.has_mem = True
+    protolib.encodeMessage(proto_out, header)
+
+    for stream, inst in trace:
+        static = inst.static
+        msg = inst_pb2.Inst()
+        msg.pc = static.pc
+        if len(static.code) == 4:
+            msg.inst = struct.unpack("<I", static.code)[0]
+        elif static.code:
+            msg.inst_bytes = static.code
+        msg.cpuid = inst.context
+        msg.tick = inst.tick
+        if static.op_class in inst_pb2.Inst.InstType.keys():
+            msg.type = inst_pb2.Inst.InstType.Value(static.op_class)
+        for addr, size, flags in inst.mem:
+            mem_msg = msg.mem_access.add()
+            mem_msg.addr = addr
+            mem_msg.size = size
+            mem_msg.mem_flags = flags
+        protolib.encodeMessage(proto_out, msg)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Convert a compact instruction trace."
+    )
+    parser.add_argument(
+        "--proto",
+        action="store_true",
+        help="write a protobuf instruction trace instead of text",
+    )
+    parser.add_argument("input", help="compact instruction trace")
+    parser.add_argument("output", help="converted trace")
+    args = parser.parse_args()
+
+    try:
+        trace_in = open(args.input, "rb")
+    except IOError:
+        print("Failed to open", args.input, "for reading")
+        exit(-1)
+    try:
+        out = open(args.output, "wb" if args.proto else "w")
+    except IOError:
+        print("Failed to open", args.output, "for writing")
+        exit(-1)
+
+    if args.proto:
+        write_proto(read_trace(trace_in), out)
+    else:
+        write_text(read_trace(trace_in), out)
+
+    out.close()
+    trace_in.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,177 @@
+#! /usr/bin/env python3
+
+# Copyright (c) 2024 The gem5 contributors
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+"""
+Calibrate the analytical on-chip network against garnet.
+
+The script runs configs/example/garnet_synth_traffic.py with the garnet
+network and with the analytical network over a range of injection rates,
+and reports the average packet latency of both models, the relative error
+of the analytical model and the host time of each run. When several
+smoothing factors are given, the one with the lowest mean error is
+reported so it can be used with --analytical-smoothing.
+
+The gem5 binary must be built with the Garnet_standalone protocol, e.g.:
+
+    util/noc-calibrate.py build/NULL/gem5.opt --mesh-rows 8 \\
+        --rates 0.01 0.05 0.1 0.2 --smoothing 0.25 0.5 0.75
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+import tempfile
+import time
+
+LATENCY_STATS = {
+    "garnet": "system.ruby.network.average_packet_latency",
+    "analytical": "system.ruby.network.avgPacketLatency",
+}
+
+
+def read_stat(stats_file, name):
+    pattern = re.compile(r"^%s\s+(\S+)" % re.escape(name))
+    with open(stats_file) as f:
+        for line in f:
+            match = pattern.match(line)
+            if match:
+                return float(match.group(1))
+    return None
+
+
+def run(args, network, rate, extra_args, outdir):
+    cmd = [
+        args.binary,
+        "-d",
+        outdir,
+        os.path.join(
+            args.gem5_root, "configs", "example", "garnet_synth_traffic.py"
+        ),
+        "--network=%s" % network,
+        "--topology=Mesh_XY",
+        "--mesh-rows=%d" % args.mesh_rows,
+        "--num-cpus=%d" % (args.mesh_rows * args.mesh_rows),
+        "--num-dirs=%d" % (args.mesh_rows * args.mesh_rows),
+        "--synthetic=%s" % args.synthetic,
+        "--injectionrate=%f" % rate,
+        "--sim-cycles=%d" % args.sim_cycles,
+    ] + extra_args
+
+    start = time.time()
+    status = subprocess.call(
+        cmd, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL
+    )
+    host_seconds = time.time() - start
+    if status != 0:
+        print("Error: '%s' failed" % " ".join(cmd))
+        sys.exit(1)
+
+    latency = read_stat(
+        os.path.join(outdir, "stats.txt"), LATENCY_STATS[network]
+    )
+    return latency, host_seconds
+
+
+parser = argparse.ArgumentParser(
+    description=__doc__, formatter_class=argparse.RawTextHelpFormatter
+)
+parser.add_argument("binary", help="gem5 binary to run")
+parser.add_argument(
+    "--gem5-root",
+    default=os.path.dirname(os.path.dirname(os.path.abspath(__file__))),
+    help="root of the gem5 source tree",
+)
+parser.add_argument("--mesh-rows", type=int, default=4)
+parser.add_argument("--synthetic", default="uniform_random")
+parser.add_argument("--sim-cycles", type=int, default=100000)
+parser.add_argument(
+    "--rates", type=float, nargs="+", default=[0.01, 0.05, 0.1, 0.2, 0.3]
+)
+parser.add_argument("--smoothing", type=float, nargs="+", default=[0.5])
+parser.add_argument("--window", type=int, default=1000)
+
+args = parser.parse_args()
+
+with tempfile.TemporaryDirectory() as tmp:
+    reference = {}
+    for rate in args.rates:
+        reference[rate] = run(
+            args, "garnet", rate, [], os.path.join(tmp, "garnet-%f" % rate)
+        )
+
+    best = None
+    for smoothing in args.smoothing:
+        print("\nsmoothing=%.3f window=%d" % (smoothing, args.window))
+        print(
+            "%8s %12s %12s %8s %10s %10s"
+            % ("rate", "garnet", "analytical", "error", "t_garnet", "t_anlt")
+        )
+
+        errors = []
+        for rate in args.rates:
+            latency, host_seconds = run(
+                args,
+                "analytical",
+                rate,
+                [
+                    "--analytical-smoothing=%f" % smoothing,
+                    "--analytical-window=%d" % args.window,
+                ],
+                os.path.join(tmp, "analytical-%f-%f" % (smoothing, rate)),
+            )
+            ref_latency, ref_seconds = reference[rate]
+            if latency is None or not ref_latency:
+                print("%8.3f %12s" % (rate, "no packets"))
+                continue
+
+            error = (latency - ref_latency) / ref_latency
+            errors.append(abs(error))
+            print(
+                "%8.3f %12.1f %12.1f %7.1f%% %10.2f %10.2f"
+                % (
+                    rate,
+                    ref_latency,
+                    latency,
+                    error * 100,
+                    ref_seconds,
+                    host_seconds,
+                )
+            )
+
+        if errors:
+            mean_error = sum(errors) / len(errors)
+            if best is None or mean_error < best[1]:
+                best = (smoothing, mean_error)
+
+    if best is not None:
+        print(
+            "\nBest smoothing: %.3f (mean absolute error %.1f%%)"
+            % (best[0], best[1] * 100)
+        )